@@ -1297,6 +1297,662 @@ static int json_decode(lua_State *l)
     return 1;
 }
 
+/* ===== FILTERED DECODING ===== */
+
+/* cjson.decode_fields() takes a field spec table. Object keys are only
+ * decoded when the spec has a true value for them, or a table spec to
+ * apply to the value. The value of spec["*"] is used for keys not in the
+ * spec. Arrays apply the spec to each element. Skipped values are
+ * checked for syntax, but no Lua values are created for them. */
+
+static void json_skip_value(lua_State *l, json_parse_t *json,
+                            json_token_t *token);
+
+static void json_skip_container(lua_State *l, json_parse_t *json,
+                                json_token_type_t end)
+{
+    json_token_t token;
+
+    json_decode_descend(l, json, 0);
+
+    json_next_token(json, &token);
+
+    /* Handle empty containers */
+    if (token.type == end) {
+        json_decode_ascend(json);
+        return;
+    }
+
+    while (1) {
+        if (end == T_OBJ_END) {
+            if (token.type != T_STRING)
+                json_throw_parse_error(l, json, "object key string", &token);
+
+            json_next_token(json, &token);
+            if (token.type != T_COLON)
+                json_throw_parse_error(l, json, "colon", &token);
+
+            json_next_token(json, &token);
+        }
+
+        json_skip_value(l, json, &token);
+
+        json_next_token(json, &token);
+
+        if (token.type == end) {
+            json_decode_ascend(json);
+            return;
+        }
+
+        if (token.type != T_COMMA) {
+            json_throw_parse_error(l, json, end == T_OBJ_END ?
+                                   "comma or object end" : "comma or array end",
+                                   &token);
+        }
+
+        json_next_token(json, &token);
+    }
+}
+
+static void json_skip_value(lua_State *l, json_parse_t *json,
+                            json_token_t *token)
+{
+    switch (token->type) {
+    case T_STRING:
+    case T_NUMBER:
+    case T_BOOLEAN:
+    case T_NULL:
+        break;
+    case T_OBJ_BEGIN:
+        json_skip_container(l, json, T_OBJ_END);
+        break;
+    case T_ARR_BEGIN:
+        json_skip_container(l, json, T_ARR_END);
+        break;
+    default:
+        json_throw_parse_error(l, json, "value", token);
+    }
+}
+
+static void json_filter_value(lua_State *l, json_parse_t *json,
+                              json_token_t *token, int spec);
+
+static void json_filter_object(lua_State *l, json_parse_t *json, int spec)
+{
+    json_token_t token;
+    int wanted;
+
+    /* 4 slots required:
+     * .., table, key, spec, value */
+    json_decode_descend(l, json, 4);
+
+    lua_newtable(l);
+
+    json_next_token(json, &token);
+
+    /* Handle empty objects */
+    if (token.type == T_OBJ_END) {
+        json_decode_ascend(json);
+        return;
+    }
+
+    while (1) {
+        if (token.type != T_STRING)
+            json_throw_parse_error(l, json, "object key string", &token);
+
+        /* Push key and its spec */
+        lua_pushlstring(l, token.value.string, token.string_len);
+        lua_pushvalue(l, -1);
+        lua_rawget(l, spec);
+        if (lua_isnil(l, -1)) {
+            lua_pop(l, 1);
+            lua_getfield(l, spec, "*");
+        }
+        wanted = lua_toboolean(l, -1);
+
+        json_next_token(json, &token);
+        if (token.type != T_COLON)
+            json_throw_parse_error(l, json, "colon", &token);
+
+        /* Fetch or skip value */
+        json_next_token(json, &token);
+        if (wanted) {
+            json_filter_value(l, json, &token, lua_gettop(l));
+            lua_remove(l, -2);
+            lua_rawset(l, -3);
+        } else {
+            lua_pop(l, 2);
+            json_skip_value(l, json, &token);
+        }
+
+        json_next_token(json, &token);
+
+        if (token.type == T_OBJ_END) {
+            json_decode_ascend(json);
+            return;
+        }
+
+        if (token.type != T_COMMA)
+            json_throw_parse_error(l, json, "comma or object end", &token);
+
+        json_next_token(json, &token);
+    }
+}
+
+static void json_filter_array(lua_State *l, json_parse_t *json, int spec)
+{
+    json_token_t token;
+    int i;
+
+    /* 2 slots required:
+     * .., table, value */
+    json_decode_descend(l, json, 2);
+
+    lua_newtable(l);
+
+    json_next_token(json, &token);
+
+    /* Handle empty arrays */
+    if (token.type == T_ARR_END) {
+        json_decode_ascend(json);
+        return;
+    }
+
+    for (i = 1; ; i++) {
+        json_filter_value(l, json, &token, spec);
+        lua_rawseti(l, -2, i);            /* arr[i] = value */
+
+        json_next_token(json, &token);
+
+        if (token.type == T_ARR_END) {
+            json_decode_ascend(json);
+            return;
+        }
+
+        if (token.type != T_COMMA)
+            json_throw_parse_error(l, json, "comma or array end", &token);
+
+        json_next_token(json, &token);
+    }
+}
+
+/* Decode a value using the spec at stack index spec. Values without a
+ * table spec are decoded in full. */
+static void json_filter_value(lua_State *l, json_parse_t *json,
+                              json_token_t *token, int spec)
+{
+    if (lua_type(l, spec) != LUA_TTABLE) {
+        json_process_value(l, json, token);
+        return;
+    }
+
+    switch (token->type) {
+    case T_OBJ_BEGIN:
+        json_filter_object(l, json, spec);
+        break;
+    case T_ARR_BEGIN:
+        json_filter_array(l, json, spec);
+        break;
+    default:
+        json_process_value(l, json, token);
+    }
+}
+
+static int json_decode_fields(lua_State *l)
+{
+    json_parse_t json;
+    json_token_t token;
+    size_t json_len;
+
+    luaL_argcheck(l, lua_gettop(l) == 2, 2, "expected 2 arguments");
+    luaL_checktype(l, 2, LUA_TTABLE);
+
+    json.cfg = json_fetch_config(l);
+    json.data = luaL_checklstring(l, 1, &json_len);
+    json.current_depth = 0;
+    json.ptr = json.data;
+
+    /* See json_decode() */
+    if (json_len >= 2 && (!json.data[0] || !json.data[1]))
+        luaL_error(l, "JSON parser does not support UTF-16 or UTF-32");
+
+    json.tmp = strbuf_new(json_len);
+
+    json_next_token(&json, &token);
+    json_filter_value(l, &json, &token, 2);
+
+    /* Ensure there is no more input left */
+    json_next_token(&json, &token);
+
+    if (token.type != T_END)
+        json_throw_parse_error(l, &json, "the end", &token);
+
+    strbuf_free(json.tmp);
+
+    return 1;
+}
+
+/* ===== INCREMENTAL DECODING ===== */
+
+/* A decoder object accepts JSON text in arbitrary chunks and builds the
+ * Lua value as input arrives. Open containers are kept between calls, so
+ * a large array can be decoded a few elements at a time.
+ *
+ *   local d = cjson.decoder()
+ *   d:feed(chunk)             -- any number of times
+ *   d:finish()                -- no more input
+ *   local done, value = d:decode(budget)
+ *
+ * decode() returns true and the value once the input is complete. It
+ * returns false, "input" when more input is required, or false, "budget"
+ * when the given number of tables have been completed and more work
+ * remains. Syntax errors are thrown as with cjson.decode(). */
+
+#define JSON_DECODER_MT     "cjson.decoder"
+
+typedef enum {
+    D_VALUE,            /* Value (root, array element or object value) */
+    D_ARRAY_FIRST,      /* Value or array end */
+    D_OBJECT_FIRST,     /* Key or object end */
+    D_KEY,              /* Key after comma */
+    D_COLON,            /* Colon after key */
+    D_NEXT,             /* Comma or container end, end of input at root */
+} json_decoder_state_t;
+
+typedef struct {
+    json_token_type_t type;     /* T_ARR_BEGIN or T_OBJ_BEGIN, T_END for root */
+    json_decoder_state_t state;
+    int index;                  /* Array elements stored */
+} json_decoder_frame_t;
+
+/* The decoder environment table holds the config userdata, the decoded
+ * value and for each open container at depth d the table at [2d-1] and
+ * the pending object key at [2d]. */
+typedef struct {
+    json_config_t *cfg;
+    strbuf_t buf;               /* Unprocessed input */
+    int pos;                    /* Next token in buf */
+    int offset;                 /* Input discarded from buf */
+    int finished;
+    int done;
+    int failed;
+    int depth;
+    int frames_size;
+    json_decoder_frame_t *frames;
+} json_decoder_t;
+
+static int json_decoder_new(lua_State *l)
+{
+    json_decoder_t *dec;
+
+    luaL_argcheck(l, lua_gettop(l) == 0, 1, "expected 0 arguments");
+
+    dec = lua_newuserdata(l, sizeof(*dec));
+    memset(dec, 0, sizeof(*dec));
+    dec->cfg = json_fetch_config(l);
+
+    dec->frames_size = 16;
+    dec->frames = malloc(dec->frames_size * sizeof(*dec->frames));
+    if (!dec->frames)
+        return luaL_error(l, "Out of memory");
+    dec->frames[0].type = T_END;
+    dec->frames[0].state = D_VALUE;
+    dec->frames[0].index = 0;
+
+    strbuf_init(&dec->buf, 0);
+
+    luaL_getmetatable(l, JSON_DECODER_MT);
+    lua_setmetatable(l, -2);
+
+    /* Keep the config alive as long as the decoder */
+    lua_newtable(l);
+    lua_pushvalue(l, lua_upvalueindex(1));
+    lua_setfield(l, -2, "config");
+    lua_setfenv(l, -2);
+
+    return 1;
+}
+
+static int json_decoder_gc(lua_State *l)
+{
+    json_decoder_t *dec = luaL_checkudata(l, 1, JSON_DECODER_MT);
+
+    strbuf_free(&dec->buf);
+    free(dec->frames);
+    dec->frames = NULL;
+
+    return 0;
+}
+
+static int json_decoder_feed(lua_State *l)
+{
+    json_decoder_t *dec = luaL_checkudata(l, 1, JSON_DECODER_MT);
+    size_t len;
+    const char *chunk = luaL_checklstring(l, 2, &len);
+
+    if (dec->finished)
+        return luaL_error(l, "JSON decoder input is finished");
+
+    strbuf_append_mem(&dec->buf, chunk, len);
+    strbuf_ensure_null(&dec->buf);
+
+    return 0;
+}
+
+static int json_decoder_finish(lua_State *l)
+{
+    json_decoder_t *dec = luaL_checkudata(l, 1, JSON_DECODER_MT);
+
+    dec->finished = 1;
+
+    return 0;
+}
+
+/* Returns true when the next token ends before the end of the buffered
+ * input, and so can't be changed by further input. */
+static int json_decoder_token_complete(json_decoder_t *dec, const char *p,
+                                       const char *end)
+{
+    const json_token_type_t *ch2token = dec->cfg->ch2token;
+    json_token_type_t type;
+
+    while (p < end && ch2token[(unsigned char)*p] == T_WHITESPACE)
+        p++;
+
+    if (p == end)
+        return 0;
+
+    if (ch2token[(unsigned char)*p] != T_UNKNOWN)
+        return 1;
+
+    if (*p == '"') {
+        for (p++; p < end; p++) {
+            if (*p == '\\')
+                p++;
+            else if (*p == '"')
+                return 1;
+        }
+        return 0;
+    }
+
+    /* Numbers and literals end at whitespace or a structural character */
+    for (p++; p < end; p++) {
+        type = ch2token[(unsigned char)*p];
+        if (type != T_UNKNOWN && type != T_ERROR)
+            return 1;
+    }
+
+    return 0;
+}
+
+static void json_decoder_throw(lua_State *l, json_decoder_t *dec,
+                               json_parse_t *json, const char *exp,
+                               json_token_t *token)
+{
+    dec->failed = 1;
+    token->index += dec->offset;
+    json_throw_parse_error(l, json, exp, token);
+}
+
+/* Open a new container. The decoder table is at stack index 3 and the
+ * innermost open container at index 4. */
+static void json_decoder_descend(lua_State *l, json_decoder_t *dec,
+                                 json_parse_t *json, json_token_type_t type)
+{
+    json_decoder_frame_t *frame;
+
+    if (dec->depth >= dec->cfg->decode_max_depth) {
+        dec->failed = 1;
+        strbuf_free(json->tmp);
+        luaL_error(l, "Found too many nested data structures (%d) at character %d",
+            dec->depth + 1, dec->offset + (int)(json->ptr - json->data));
+    }
+
+    if (dec->depth + 1 >= dec->frames_size) {
+        frame = realloc(dec->frames, 2 * dec->frames_size * sizeof(*frame));
+        if (!frame) {
+            dec->failed = 1;
+            strbuf_free(json->tmp);
+            luaL_error(l, "Out of memory");
+        }
+        dec->frames = frame;
+        dec->frames_size *= 2;
+    }
+
+    dec->depth++;
+    frame = &dec->frames[dec->depth];
+    frame->type = type;
+    frame->state = (type == T_ARR_BEGIN) ? D_ARRAY_FIRST : D_OBJECT_FIRST;
+    frame->index = 0;
+
+    lua_newtable(l);
+    lua_pushvalue(l, -1);
+    lua_rawseti(l, 3, 2 * dec->depth - 1);
+    lua_replace(l, 4);
+}
+
+/* Store the value on the top of the stack in the innermost container */
+static void json_decoder_store(lua_State *l, json_decoder_t *dec)
+{
+    json_decoder_frame_t *frame = &dec->frames[dec->depth];
+
+    if (frame->type == T_ARR_BEGIN) {
+        lua_rawseti(l, 4, ++frame->index);
+    } else if (frame->type == T_OBJ_BEGIN) {
+        lua_rawgeti(l, 3, 2 * dec->depth);
+        lua_insert(l, -2);
+        lua_rawset(l, 4);
+    } else {
+        lua_setfield(l, 3, "value");
+    }
+
+    frame->state = D_NEXT;
+}
+
+/* Close the innermost container and store it in its parent */
+static void json_decoder_ascend(lua_State *l, json_decoder_t *dec)
+{
+    lua_pushnil(l);
+    lua_rawseti(l, 3, 2 * dec->depth - 1);
+    lua_pushnil(l);
+    lua_rawseti(l, 3, 2 * dec->depth);
+
+    lua_pushvalue(l, 4);
+    dec->depth--;
+    if (dec->depth > 0)
+        lua_rawgeti(l, 3, 2 * dec->depth - 1);
+    else
+        lua_pushnil(l);
+    lua_replace(l, 4);
+
+    json_decoder_store(l, dec);
+}
+
+static int json_decoder_decode(lua_State *l)
+{
+    json_decoder_t *dec = luaL_checkudata(l, 1, JSON_DECODER_MT);
+    int budget = luaL_optint(l, 2, 0);
+    json_decoder_frame_t *frame;
+    json_parse_t json;
+    json_token_t token;
+    const char *end;
+    int scalar;
+
+    lua_settop(l, 2);
+    lua_getfenv(l, 1);
+
+    if (dec->failed)
+        return luaL_error(l, "JSON decoder has failed");
+
+    if (dec->done) {
+        lua_pushboolean(l, 1);
+        lua_getfield(l, 3, "value");
+        return 2;
+    }
+
+    if (dec->depth > 0)
+        lua_rawgeti(l, 3, 2 * dec->depth - 1);
+    else
+        lua_pushnil(l);
+
+    if (budget <= 0)
+        budget = INT_MAX;
+
+    /* See json_decode() */
+    if (dec->offset == 0 && dec->buf.length >= 2 &&
+        (!dec->buf.buf[0] || !dec->buf.buf[1])) {
+        dec->failed = 1;
+        return luaL_error(l, "JSON parser does not support UTF-16 or UTF-32");
+    }
+
+    json.cfg = dec->cfg;
+    json.data = dec->buf.buf;
+    json.ptr = dec->buf.buf + dec->pos;
+    json.current_depth = 0;
+    json.tmp = strbuf_new(dec->buf.length - dec->pos);
+    end = dec->buf.buf + dec->buf.length;
+
+    while (1) {
+        if (!dec->finished && !json_decoder_token_complete(dec, json.ptr, end))
+            break;
+
+        json_next_token(&json, &token);
+        frame = &dec->frames[dec->depth];
+        scalar = 0;
+
+        switch (frame->state) {
+        case D_ARRAY_FIRST:
+            if (token.type == T_ARR_END) {
+                json_decoder_ascend(l, dec);
+                budget--;
+                break;
+            }
+            /* Fall through */
+        case D_VALUE:
+            switch (token.type) {
+            case T_STRING:
+                lua_pushlstring(l, token.value.string, token.string_len);
+                scalar = 1;
+                break;
+            case T_NUMBER:
+                lua_pushnumber(l, token.value.number);
+                scalar = 1;
+                break;
+            case T_BOOLEAN:
+                lua_pushboolean(l, token.value.boolean);
+                scalar = 1;
+                break;
+            case T_NULL:
+                lua_pushlightuserdata(l, NULL);
+                scalar = 1;
+                break;
+            case T_OBJ_BEGIN:
+            case T_ARR_BEGIN:
+                json_decoder_descend(l, dec, &json, token.type);
+                break;
+            default:
+                json_decoder_throw(l, dec, &json, "value", &token);
+            }
+            if (scalar)
+                json_decoder_store(l, dec);
+            break;
+        case D_OBJECT_FIRST:
+            if (token.type == T_OBJ_END) {
+                json_decoder_ascend(l, dec);
+                budget--;
+                break;
+            }
+            /* Fall through */
+        case D_KEY:
+            if (token.type != T_STRING)
+                json_decoder_throw(l, dec, &json, "object key string", &token);
+            lua_pushlstring(l, token.value.string, token.string_len);
+            lua_rawseti(l, 3, 2 * dec->depth);
+            frame->state = D_COLON;
+            break;
+        case D_COLON:
+            if (token.type != T_COLON)
+                json_decoder_throw(l, dec, &json, "colon", &token);
+            frame->state = D_VALUE;
+            break;
+        case D_NEXT:
+            if (frame->type == T_END) {
+                if (token.type != T_END)
+                    json_decoder_throw(l, dec, &json, "the end", &token);
+                dec->done = 1;
+            } else if (token.type == T_COMMA) {
+                frame->state = (frame->type == T_ARR_BEGIN) ? D_VALUE : D_KEY;
+            } else if (frame->type == T_ARR_BEGIN && token.type == T_ARR_END) {
+                json_decoder_ascend(l, dec);
+                budget--;
+            } else if (frame->type == T_OBJ_BEGIN && token.type == T_OBJ_END) {
+                json_decoder_ascend(l, dec);
+                budget--;
+            } else if (frame->type == T_ARR_BEGIN) {
+                json_decoder_throw(l, dec, &json, "comma or array end", &token);
+            } else {
+                json_decoder_throw(l, dec, &json, "comma or object end", &token);
+            }
+            break;
+        }
+
+        if (dec->done || budget == 0)
+            break;
+    }
+
+    strbuf_free(json.tmp);
+
+    if (dec->done) {
+        strbuf_free(&dec->buf);
+        lua_pushboolean(l, 1);
+        lua_getfield(l, 3, "value");
+        return 2;
+    }
+
+    /* Discard processed input once it is most of the buffer */
+    dec->pos = json.ptr - dec->buf.buf;
+    if (dec->pos > dec->buf.length / 2) {
+        dec->buf.length -= dec->pos;
+        memmove(dec->buf.buf, dec->buf.buf + dec->pos, dec->buf.length);
+        strbuf_ensure_null(&dec->buf);
+        dec->offset += dec->pos;
+        dec->pos = 0;
+    }
+
+    lua_pushboolean(l, 0);
+    if (budget == 0)
+        lua_pushliteral(l, "budget");
+    else
+        lua_pushliteral(l, "input");
+    return 2;
+}
+
+static void json_decoder_register(lua_State *l)
+{
+    luaL_Reg reg[] = {
+        { "feed", json_decoder_feed },
+        { "finish", json_decoder_finish },
+        { "decode", json_decoder_decode },
+        { "__gc", json_decoder_gc },
+        { NULL, NULL }
+    };
+    int i;
+
+    if (!luaL_newmetatable(l, JSON_DECODER_MT)) {
+        lua_pop(l, 1);
+        return;
+    }
+
+    for (i = 0; reg[i].name; i++) {
+        lua_pushcfunction(l, reg[i].func);
+        lua_setfield(l, -2, reg[i].name);
+    }
+
+    lua_pushvalue(l, -1);
+    lua_setfield(l, -2, "__index");
+    lua_pop(l, 1);
+}
+
 /* ===== INITIALISATION ===== */
 
 #if !defined(LUA_VERSION_NUM) || LUA_VERSION_NUM < 502
@@ -1357,6 +2013,8 @@ static int lua_cjson_new(lua_State *l)
     luaL_Reg reg[] = {
         { "encode", json_encode },
         { "decode", json_decode },
+        { "decode_fields", json_decode_fields },
+        { "decoder", json_decoder_new },
         { "encode_sparse_array", json_cfg_encode_sparse_array },
         { "encode_max_depth", json_cfg_encode_max_depth },
         { "decode_max_depth", json_cfg_decode_max_depth },
@@ -1371,6 +2029,9 @@ static int lua_cjson_new(lua_State *l)
     /* Initialise number conversions */
     fpconv_init();
 
+    /* Incremental decoder methods */
+    json_decoder_register(l);
+
     /* cjson module table */
     lua_newtable(l);
 
@@ -83,6 +83,42 @@ function test_decode_cycle(filename)
     return util.compare_values(obj1, obj2)
 end
 
+-- Decode with cjson.decoder(), feeding size bytes at a time and
+-- calling decode() with the given budget after each chunk.
+-- Returns the value and the number of decode() calls, or nil and
+-- the error message.
+function decode_chunked(text, size, budget)
+    local decoder = json.decoder()
+    local steps = 0
+
+    local function step()
+        local done, value = decoder:decode(budget)
+        steps = steps + 1
+        return done, value
+    end
+
+    local ok, value = pcall(function ()
+        local done, value
+        for i = 1, #text, size do
+            decoder:feed(text:sub(i, i + size - 1))
+            repeat
+                done, value = step()
+            until done or value == "input"
+        end
+        decoder:finish()
+        repeat
+            done, value = step()
+        until done
+        return value
+    end)
+
+    if not ok then
+        -- Discard the position added by some Lua implementations
+        return nil, (value:gsub("^[^:]*:%d+: ", ""))
+    end
+    return value, steps
+end
+
 -- Set up data used in tests
 local Inf = math.huge;
 local NaN = math.huge * 0;
@@ -382,6 +418,52 @@ local cjson_tests = {
       json.encode_sparse_array, { "not quite on" },
       false, { "bad argument #1 to '?' (invalid option 'not quite on')" } },
 
+    -- Test filtered decoding
+    { "Decode fields from nested objects",
+      json.decode_fields, { '{ "a": 1, "b": [ 1, 2 ], "c": { "d": 1, "e": 2 } }',
+                            { a = true, c = { e = true } } },
+      true, { { a = 1, c = { e = 2 } } } },
+    { "Decode fields from array of objects",
+      json.decode_fields, { '[ { "id": 1, "x": { "y": [] } }, { "id": 2 } ]',
+                            { id = true } },
+      true, { { { id = 1 }, { id = 2 } } } },
+    { "Decode fields with default",
+      json.decode_fields, { '{ "a": 1, "b": { "c": 3 }, "d": "4" }',
+                            { ["*"] = true, b = false } },
+      true, { { a = 1, d = "4" } } },
+    { "Decode fields from skipped invalid value [throw error]",
+      json.decode_fields, { '{ "a": 1, "b": [ 1, } }', { a = true } },
+      false, { "Expected value but found T_OBJ_END at character 21" } },
+    { "Decode fields from skipped deeply nested array [throw error]",
+      json.decode_fields, { '{ "a": ' .. string.rep("[", 1100) .. string.rep("]", 1100) .. ' }', {} },
+      false, { "Found too many nested data structures (1001) at character 1007" } },
+
+    -- Test incremental decoding
+    { "Decode incrementally one byte at a time",
+      decode_chunked, { '{ "a": [ 1, -2.5e1, "x\\"y", true, null ], "b": {} }', 1 },
+      true, { { a = { 1, -25, 'x"y', true, json.null }, b = {} }, 52 } },
+    { "Decode incrementally with a budget",
+      decode_chunked, { '[ [1], [2], [3], [4], [5] ]', 100, 2 },
+      true, { { { 1 }, { 2 }, { 3 }, { 4 }, { 5 } }, 5 } },
+    { "Decode incrementally number split over chunks",
+      decode_chunked, { '[123456789]', 4 }, true, { { 123456789 }, 4 } },
+    { "Decode incrementally scalar at end of input",
+      decode_chunked, { '12', 1 }, true, { 12, 3 } },
+    { "Decode incrementally unicode escape split over chunks",
+      decode_chunked, { '["\\u00e9\\u00e9"]', 3 }, true, { { "\195\169\195\169" }, 7 } },
+    { "Decode incrementally truncated input [throw error]",
+      decode_chunked, { '{ "a": [ 1, 2', 5 },
+      true, { nil, "Expected comma or array end but found T_END at character 14" } },
+    { "Decode incrementally invalid token [throw error]",
+      decode_chunked, { '[ 1, 2, ]', 2 },
+      true, { nil, "Expected value but found T_ARR_END at character 9" } },
+    { "Decode incrementally trailing data [throw error]",
+      decode_chunked, { '[] []', 2 },
+      true, { nil, "Expected the end but found T_ARR_BEGIN at character 4" } },
+    { "Decode incrementally deeply nested array [throw error]",
+      decode_chunked, { string.rep("[", 1100) .. string.rep("]", 1100), 64 },
+      true, { nil, "Found too many nested data structures (1001) at character 1001" } },
+
     { "Reset Lua CJSON configuration", function () json = json.new() end },
     -- Wrap in a function to ensure the table returned by json.new() is used
     { "Check encode_sparse_array()",
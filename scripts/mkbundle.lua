@@ -0,0 +1,155 @@
+--[[
+
+Builds jive.bundle, the precompiled lua modules loaded at startup.
+
+	luajit mkbundle.lua <bundle> <root>... < files
+
+Each file is compiled to bytecode and stored under its module name, its
+path relative to its root without .lua and with / replaced by dots. The
+bytecode must be made by the same luajit version jivelite is linked with.
+
+The path of each source relative to the bundle, its mtime and its size are
+stored with the bytecode. At startup a module whose source no longer
+matches is loaded from the source instead, so a stale bundle never hides
+an edited file. Needs lfs, from lib/lua/5.1.
+
+The bundle is "JIVEBC02", the module count, then an index sorted by
+module name of name offset, name length, bytecode offset, bytecode length,
+source path offset, source path length, source mtime and source size,
+followed by the names, bytecode and source paths. All numbers are 32 bit
+little endian, offsets are from the start of the file. See bundle_open in
+src/jive.c.
+
+--]]
+
+local lfs = require("lfs")
+
+local output = ...
+local roots = { select(2, ...) }
+
+if not output or #roots == 0 then
+	io.stderr:write("usage: mkbundle.lua <bundle> <root>... < files\n")
+	os.exit(1)
+end
+
+for i, root in ipairs(roots) do
+	roots[i] = root:gsub("/*$", "/")
+end
+
+-- the loader binary searches the index with memcmp
+os.setlocale("C", "collate")
+
+
+-- path of file relative to directory dir
+local function relpath(dir, file)
+	local from, to = {}, {}
+	for c in dir:gmatch("[^/]+") do
+		if c ~= "." then from[#from + 1] = c end
+	end
+	for c in file:gmatch("[^/]+") do
+		if c ~= "." then to[#to + 1] = c end
+	end
+
+	local i = 1
+	while i < #to and from[i] == to[i] do
+		i = i + 1
+	end
+
+	local path = {}
+	for j = i, #from do
+		path[#path + 1] = ".."
+	end
+	for j = i, #to do
+		path[#path + 1] = to[j]
+	end
+
+	return table.concat(path, "/")
+end
+
+
+local function u32(n)
+	return string.char(n % 256, math.floor(n / 256) % 256, math.floor(n / 65536) % 256, math.floor(n / 16777216) % 256)
+end
+
+
+local bundledir = output:match("^(.*)/") or "."
+local modules = {}
+
+for file in io.lines() do
+	local root
+	for _, r in ipairs(roots) do
+		if file:sub(1, #r) == r then
+			root = r
+		end
+	end
+
+	if not root or not file:match("%.lua$") then
+		io.stderr:write("mkbundle: ", file, " is not a lua file in ", table.concat(roots, " "), "\n")
+		os.exit(1)
+	end
+
+	local name = file:sub(#root + 1, -5):gsub("/", ".")
+
+	local f, err = loadfile(file)
+	if not f then
+		io.stderr:write("mkbundle: ", err, "\n")
+		os.exit(1)
+	end
+
+	local attr = assert(lfs.attributes(file))
+
+	-- keep debug info for error messages and tracebacks
+	modules[#modules + 1] = {
+		name = name,
+		code = string.dump(f),
+		source = relpath(bundledir, file),
+		mtime = attr.modification,
+		size = attr.size,
+	}
+end
+
+table.sort(modules, function(a, b) return a.name < b.name end)
+
+
+local offset = 8 + 4 + #modules * 32
+local index, data = {}, {}
+
+for i, m in ipairs(modules) do
+	if i > 1 and modules[i - 1].name == m.name then
+		io.stderr:write("mkbundle: duplicate module ", m.name, "\n")
+		os.exit(1)
+	end
+
+	index[#index + 1] = u32(offset) .. u32(#m.name)
+	data[#data + 1] = m.name
+	offset = offset + #m.name
+
+	index[#index + 1] = u32(offset) .. u32(#m.code)
+	data[#data + 1] = m.code
+	offset = offset + #m.code
+
+	index[#index + 1] = u32(offset) .. u32(#m.source) .. u32(m.mtime) .. u32(m.size)
+	data[#data + 1] = m.source
+	offset = offset + #m.source
+end
+
+
+local fh = assert(io.open(output .. ".new", "wb"))
+fh:write("JIVEBC02", u32(#modules), table.concat(index), table.concat(data))
+fh:close()
+
+assert(os.rename(output .. ".new", output))
+
+print("mkbundle: " .. #modules .. " modules, " .. offset .. " bytes in " .. output)
+
+
+--[[
+
+=head1 LICENSE
+
+Copyright 2010 Logitech. All Rights Reserved.
+
+This file is licensed under BSD. Please see the LICENSE file for details.
+
+=cut
+--]]
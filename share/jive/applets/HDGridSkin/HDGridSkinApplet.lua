@@ -29,6 +29,7 @@ local Window                 = require("jive.ui.Window")
 local table                  = require("jive.utils.table")
 local debug                  = require("jive.utils.debug")
 local autotable              = require("jive.utils.autotable")
+local lazystyle              = require("jive.utils.lazystyle")
 
 local log                    = require("jive.utils.log").logger("applet.HDGridSkin")
 
@@ -2385,21 +2386,20 @@ function skin(self, s)
 		img = false,
 	}
 
-	s.region_US = _uses(_buttonicon, { 
-		img = _loadImage(self, "IconsResized/icon_region_americas" .. skinSuffix),
-	})
-	s.region_XX = _uses(_buttonicon, { 
-		img = _loadImage(self, "IconsResized/icon_region_other" .. skinSuffix),
-	})
-	s.icon_help = _uses(_buttonicon, { 
-		img = _loadImage(self, "IconsResized/icon_help" .. skinSuffix),
-	})
-	s.wlan = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_wireless" .. skinSuffix),
-	})
-	s.wired = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ethernet" .. skinSuffix),
-	})
+	-- menu icon styles are built when first shown, most never are
+	local function _buttoniconStyle(name, file)
+		lazystyle.define(s, name, function()
+			return _uses(_buttonicon, {
+				img = _loadImage(self, file),
+			})
+		end)
+	end
+
+	_buttoniconStyle("region_US", "IconsResized/icon_region_americas" .. skinSuffix)
+	_buttoniconStyle("region_XX", "IconsResized/icon_region_other" .. skinSuffix)
+	_buttoniconStyle("icon_help", "IconsResized/icon_help" .. skinSuffix)
+	_buttoniconStyle("wlan", "IconsResized/icon_wireless" .. skinSuffix)
+	_buttoniconStyle("wired", "IconsResized/icon_ethernet" .. skinSuffix)
 
 
 --------- ICONS --------
@@ -2562,183 +2562,77 @@ function skin(self, s)
         img = false,
 	})
 
-	s.player_transporter = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_transporter" .. skinSuffix),
-	})
-	s.player_squeezebox = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_SB1n2" .. skinSuffix),
-	})
-	s.player_squeezebox2 = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_SB1n2" .. skinSuffix),
-	})
-	s.player_squeezebox3 = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_SB3" .. skinSuffix),
-	})
-	s.player_boom = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_boom" .. skinSuffix),
-	})
-	s.player_slimp3 = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_slimp3" .. skinSuffix),
-	})
-	s.player_softsqueeze = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_softsqueeze" .. skinSuffix),
-	})
-	s.player_controller = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_controller" .. skinSuffix),
-	})
-	s.player_receiver = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_receiver" .. skinSuffix),
-	})
-	s.player_squeezeplay = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_squeezeplay" .. skinSuffix),
-	})
-	s.player_http = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_tunein_url" .. skinSuffix),
-	})
-	s.player_baby = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_baby" .. skinSuffix),
-	})
-	s.player_fab4 = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_fab4" .. skinSuffix),
-	})
+	_buttoniconStyle("player_transporter", "IconsResized/icon_transporter" .. skinSuffix)
+	_buttoniconStyle("player_squeezebox", "IconsResized/icon_SB1n2" .. skinSuffix)
+	_buttoniconStyle("player_squeezebox2", "IconsResized/icon_SB1n2" .. skinSuffix)
+	_buttoniconStyle("player_squeezebox3", "IconsResized/icon_SB3" .. skinSuffix)
+	_buttoniconStyle("player_boom", "IconsResized/icon_boom" .. skinSuffix)
+	_buttoniconStyle("player_slimp3", "IconsResized/icon_slimp3" .. skinSuffix)
+	_buttoniconStyle("player_softsqueeze", "IconsResized/icon_softsqueeze" .. skinSuffix)
+	_buttoniconStyle("player_controller", "IconsResized/icon_controller" .. skinSuffix)
+	_buttoniconStyle("player_receiver", "IconsResized/icon_receiver" .. skinSuffix)
+	_buttoniconStyle("player_squeezeplay", "IconsResized/icon_squeezeplay" .. skinSuffix)
+	_buttoniconStyle("player_http", "IconsResized/icon_tunein_url" .. skinSuffix)
+	_buttoniconStyle("player_baby", "IconsResized/icon_baby" .. skinSuffix)
+	_buttoniconStyle("player_fab4", "IconsResized/icon_fab4" .. skinSuffix)
 
 	-- misc home menu icons
-	s.hm_appletImageViewer = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_image_viewer" .. skinSuffix),
-	})
-	s.hm_eject = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_eject" .. skinSuffix),
-	})
-	s.hm_sdcard = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_device_SDcard" .. skinSuffix),
-	})
-	s.hm_usbdrive = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_device_USB" .. skinSuffix),
-	})
-	s.hm_appletNowPlaying = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_nowplaying" .. skinSuffix),
-	})
-	s.hm_settings = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_settings" .. skinSuffix),
-	})
-	s.hm_advancedSettings = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_settings_adv" .. skinSuffix),
-	})
-	s.hm_radio = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_internet_radio" .. skinSuffix),
-	})
-	s.hm_radios = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_internet_radio" .. skinSuffix),
-	})
-	s.hm_myApps = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_my_apps" .. skinSuffix),
-	})
-	s.hm_myMusic = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_mymusic" .. skinSuffix),
-	})
-	s.hm__myMusic = _uses(s.hm_myMusic)
-   	s.hm_otherLibrary = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_other_library" .. skinSuffix),
-	})
-	s.hm_myMusicSelector = _uses(s.hm_myMusic)
-
-	s.hm_favorites = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_favorites" .. skinSuffix),
-	})
-	s.hm_settingsAlarm = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_alarm" .. skinSuffix),
-	})
-	s.hm_settingsPlayerNameChange = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_settings_name" .. skinSuffix),
-	})
-	s.hm_settingsBrightness = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_settings_brightness" .. skinSuffix),
-	})
-	s.hm_settingsSync = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_sync" .. skinSuffix),
-	})
-	s.hm_selectPlayer = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_choose_player" .. skinSuffix),
-	})
-	s.hm_quit = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_power_off" .. skinSuffix),
-	})
-	s.hm_playerpower = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_power_off" .. skinSuffix),
-	})
-	s.hm_settingsScreen = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_blank" .. skinSuffix),
-	})
-	s.hm_myMusicArtists = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_artist" .. skinSuffix),
-	})
-	s.hm_myMusicAlbums = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_albums" .. skinSuffix),
-	})
-	s.hm_myMusicGenres = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_genres" .. skinSuffix),
-	})
-	s.hm_myMusicYears = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_years" .. skinSuffix),
-	})
-
-	s.hm_myMusicNewMusic = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_new_music" .. skinSuffix),
-	})
-	s.hm_myMusicPlaylists = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_playlist" .. skinSuffix),
-	})
-	s.hm_myMusicSearch = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_search" .. skinSuffix),
-	})
-	s.hm_myMusicSearchArtists   = _uses(s.hm_myMusicSearch)
-	s.hm_myMusicSearchAlbums    = _uses(s.hm_myMusicSearch)
-	s.hm_myMusicSearchSongs     = _uses(s.hm_myMusicSearch)
-	s.hm_myMusicSearchPlaylists = _uses(s.hm_myMusicSearch)
-	s.hm_myMusicSearchRecent    = _uses(s.hm_myMusicSearch)
-	s.hm_homeSearchRecent       = _uses(s.hm_myMusicSearch)
-	s.hm_globalSearch           = _uses(s.hm_myMusicSearch)
-
-	s.hm_myMusicMusicFolder = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_folder" .. skinSuffix),
-	})
-	s.hm_randomplay = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_random" .. skinSuffix),
-	})
-	s.hm_skinTest = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_blank" .. skinSuffix),
-	})
-
-	s.hm_settingsRepeat = _uses(_buttonicon, {
-    	img = _loadImage(self, "IconsResized/icon_settings_repeat" .. skinSuffix),
-	})
-	s.hm_settingsShuffle = _uses(_buttonicon, {
-    	img = _loadImage(self, "IconsResized/icon_settings_shuffle" .. skinSuffix),
-	})
-	s.hm_settingsSleep = _uses(_buttonicon, {
-    	img = _loadImage(self, "IconsResized/icon_settings_sleep" .. skinSuffix),
-	})
-	s.hm_settingsScreen = _uses(_buttonicon, {
-    	img = _loadImage(self, "IconsResized/icon_settings_screen" .. skinSuffix),
-	})
-	s.hm_appletCustomizeHome = _uses(_buttonicon, {
-    	img = _loadImage(self, "IconsResized/icon_settings_home" .. skinSuffix),
-	})
-	s.hm_settingsAudio = _uses(_buttonicon, {
-    	img = _loadImage(self, "IconsResized/icon_settings_audio" .. skinSuffix),
-	})
-	s.hm_linein = _uses(_buttonicon, {
-    	img = _loadImage(self, "IconsResized/icon_linein" .. skinSuffix),
-	})
+	_buttoniconStyle("hm_appletImageViewer", "IconsResized/icon_image_viewer" .. skinSuffix)
+	_buttoniconStyle("hm_eject", "IconsResized/icon_eject" .. skinSuffix)
+	_buttoniconStyle("hm_sdcard", "IconsResized/icon_device_SDcard" .. skinSuffix)
+	_buttoniconStyle("hm_usbdrive", "IconsResized/icon_device_USB" .. skinSuffix)
+	_buttoniconStyle("hm_appletNowPlaying", "IconsResized/icon_nowplaying" .. skinSuffix)
+	_buttoniconStyle("hm_settings", "IconsResized/icon_settings" .. skinSuffix)
+	_buttoniconStyle("hm_advancedSettings", "IconsResized/icon_settings_adv" .. skinSuffix)
+	_buttoniconStyle("hm_radio", "IconsResized/icon_internet_radio" .. skinSuffix)
+	_buttoniconStyle("hm_radios", "IconsResized/icon_internet_radio" .. skinSuffix)
+	_buttoniconStyle("hm_myApps", "IconsResized/icon_my_apps" .. skinSuffix)
+	_buttoniconStyle("hm_myMusic", "IconsResized/icon_mymusic" .. skinSuffix)
+	lazystyle.define(s, "hm__myMusic", function() return _uses(s.hm_myMusic) end)
+	_buttoniconStyle("hm_otherLibrary", "IconsResized/icon_ml_other_library" .. skinSuffix)
+	lazystyle.define(s, "hm_myMusicSelector", function() return _uses(s.hm_myMusic) end)
+
+	_buttoniconStyle("hm_favorites", "IconsResized/icon_favorites" .. skinSuffix)
+	_buttoniconStyle("hm_settingsAlarm", "IconsResized/icon_alarm" .. skinSuffix)
+	_buttoniconStyle("hm_settingsPlayerNameChange", "IconsResized/icon_settings_name" .. skinSuffix)
+	_buttoniconStyle("hm_settingsBrightness", "IconsResized/icon_settings_brightness" .. skinSuffix)
+	_buttoniconStyle("hm_settingsSync", "IconsResized/icon_sync" .. skinSuffix)
+	_buttoniconStyle("hm_selectPlayer", "IconsResized/icon_choose_player" .. skinSuffix)
+	_buttoniconStyle("hm_quit", "IconsResized/icon_power_off" .. skinSuffix)
+	_buttoniconStyle("hm_playerpower", "IconsResized/icon_power_off" .. skinSuffix)
+	_buttoniconStyle("hm_settingsScreen", "IconsResized/icon_blank" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicArtists", "IconsResized/icon_ml_artist" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicAlbums", "IconsResized/icon_ml_albums" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicGenres", "IconsResized/icon_ml_genres" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicYears", "IconsResized/icon_ml_years" .. skinSuffix)
+
+	_buttoniconStyle("hm_myMusicNewMusic", "IconsResized/icon_ml_new_music" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicPlaylists", "IconsResized/icon_ml_playlist" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicSearch", "IconsResized/icon_ml_search" .. skinSuffix)
+	lazystyle.define(s, "hm_myMusicSearchArtists", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_myMusicSearchAlbums", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_myMusicSearchSongs", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_myMusicSearchPlaylists", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_myMusicSearchRecent", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_homeSearchRecent", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_globalSearch", function() return _uses(s.hm_myMusicSearch) end)
+
+	_buttoniconStyle("hm_myMusicMusicFolder", "IconsResized/icon_ml_folder" .. skinSuffix)
+	_buttoniconStyle("hm_randomplay", "IconsResized/icon_ml_random" .. skinSuffix)
+	_buttoniconStyle("hm_skinTest", "IconsResized/icon_blank" .. skinSuffix)
+
+	_buttoniconStyle("hm_settingsRepeat", "IconsResized/icon_settings_repeat" .. skinSuffix)
+	_buttoniconStyle("hm_settingsShuffle", "IconsResized/icon_settings_shuffle" .. skinSuffix)
+	_buttoniconStyle("hm_settingsSleep", "IconsResized/icon_settings_sleep" .. skinSuffix)
+	_buttoniconStyle("hm_settingsScreen", "IconsResized/icon_settings_screen" .. skinSuffix)
+	_buttoniconStyle("hm_appletCustomizeHome", "IconsResized/icon_settings_home" .. skinSuffix)
+	_buttoniconStyle("hm_settingsAudio", "IconsResized/icon_settings_audio" .. skinSuffix)
+	_buttoniconStyle("hm_linein", "IconsResized/icon_linein" .. skinSuffix)
 
         -- ??
-	s.hm_loading = _uses(_buttonicon, {
-    	img = _loadImage(self, "IconsResized/icon_loading" .. skinSuffix),
-	})
+	_buttoniconStyle("hm_loading", "IconsResized/icon_loading" .. skinSuffix)
         -- ??
-	s.hm_settingsPlugin = _uses(_buttonicon, {
-    	img = _loadImage(self, "IconsResized/icon_settings_plugin" .. skinSuffix),
-	})
+	_buttoniconStyle("hm_settingsPlugin", "IconsResized/icon_settings_plugin" .. skinSuffix)
 
 	-- indicator icons, on right of menus
 	local _indicator = {
@@ -2805,300 +2699,306 @@ function skin(self, s)
 
 	coverSize = math.floor(math.min((screenHeight - TITLE_HEIGHT - 20), screenWidth/2 - 50) / 10) * 10
 
-	local _tracklayout = {
-		border = { 10, 0, 10, 0 },
-		position = LAYOUT_NONE,
-		w = WH_FILL,
-		align = "left",
-		lineHeight = NP_TRACK_FONT_SIZE,
-		fg = TEXT_COLOR,
-		x = coverSize + math.floor(100 * screenWidth / 1920), 
-	}
+	-- the now playing styles are built when now playing is first shown
+	lazystyle.define(s, {
+		"nowplaying", "nowplaying_visualizer_common",
+		"nowplaying_spectrum_text",
+	}, function()
+		local _tracklayout = {
+			border = { 10, 0, 10, 0 },
+			position = LAYOUT_NONE,
+			w = WH_FILL,
+			align = "left",
+			lineHeight = NP_TRACK_FONT_SIZE,
+			fg = TEXT_COLOR,
+			x = coverSize + math.floor(100 * screenWidth / 1920), 
+		}
 
-	s.nowplaying = _uses(s.window, {
-		--title bar
-		title = _uses(s.title, {
-			zOrder = 1,
-			text = {
-				font = _boldfont(TITLE_FONT_SIZE),
-				--bgImg   = titlebarButtonBox,
-			},
-			--[[
-			rbutton  = {
-				font    = _font(14),
-				fg      = TEXT_COLOR,
-				bgImg   = titlebarButtonBox,
-				w       = TITLE_BUTTON_WIDTH,
-				padding = { 8, 0, 8, 0},
-				align   = 'center',
-			}
-			--]]
-		}),
+		s.nowplaying = _uses(s.window, {
+			--title bar
+			title = _uses(s.title, {
+				zOrder = 1,
+				text = {
+					font = _boldfont(TITLE_FONT_SIZE),
+					--bgImg   = titlebarButtonBox,
+				},
+				--[[
+				rbutton  = {
+					font    = _font(14),
+					fg      = TEXT_COLOR,
+					bgImg   = titlebarButtonBox,
+					w       = TITLE_BUTTON_WIDTH,
+					padding = { 8, 0, 8, 0},
+					align   = 'center',
+				}
+				--]]
+			}),
 	
-		-- Song metadata
-		nptitle = {
-			order = { 'nptrack' },
-			position   = _tracklayout.position,
-			border     = _tracklayout.border,
-			x          = _tracklayout.x,
-			y 	   = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 0 / 6,
-			h          = 90,
-			nptrack =  {
-				padding    = { 0, 20, 0, 0 },
-				w          = screenWidth - _tracklayout.x - math.floor(50 * screenWidth / 1920),
-				align      = _tracklayout.align,
-				lineHeight = _tracklayout.lineHeight,
-				fg         = _tracklayout.fg,
-				font       = _boldfont(NP_TRACK_FONT_SIZE), 
-				sh = TEXT_SH_COLOR,
+			-- Song metadata
+			nptitle = {
+				order = { 'nptrack' },
+				position   = _tracklayout.position,
+				border     = _tracklayout.border,
+				x          = _tracklayout.x,
+				y 	   = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 0 / 6,
+				h          = 90,
+				nptrack =  {
+					padding    = { 0, 20, 0, 0 },
+					w          = screenWidth - _tracklayout.x - math.floor(50 * screenWidth / 1920),
+					align      = _tracklayout.align,
+					lineHeight = _tracklayout.lineHeight,
+					fg         = _tracklayout.fg,
+					font       = _boldfont(NP_TRACK_FONT_SIZE), 
+					sh = TEXT_SH_COLOR,
+				},
 			},
-		},
-		npartistgroup = {
-			order = { 'npartist' },
-			position   = _tracklayout.position,
-			border     = _tracklayout.border,
-			x          = _tracklayout.x,
-			y 	   = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 1 / 6,
-			h          = 90,
-			npartist = {
-				padding    = { 0, 20, 0, 0 },
-				w          = screenWidth - _tracklayout.x - math.floor(50 * screenWidth / 1920),
-				align      = _tracklayout.align,
-				lineHeight = _tracklayout.lineHeight,
-				fg         = _tracklayout.fg,
-				font       = _font(NP_ARTISTALBUM_FONT_SIZE),
-				sh = TEXT_SH_COLOR,
+			npartistgroup = {
+				order = { 'npartist' },
+				position   = _tracklayout.position,
+				border     = _tracklayout.border,
+				x          = _tracklayout.x,
+				y 	   = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 1 / 6,
+				h          = 90,
+				npartist = {
+					padding    = { 0, 20, 0, 0 },
+					w          = screenWidth - _tracklayout.x - math.floor(50 * screenWidth / 1920),
+					align      = _tracklayout.align,
+					lineHeight = _tracklayout.lineHeight,
+					fg         = _tracklayout.fg,
+					font       = _font(NP_ARTISTALBUM_FONT_SIZE),
+					sh = TEXT_SH_COLOR,
+				},
 			},
-		},
-		npalbumgroup = {
-			order = {'npalbum' },
-			position   = _tracklayout.position,
-			border     = _tracklayout.border,
-			x          = _tracklayout.x,
-			y 	   = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 2 / 6,
-			h          = 90,
-			npalbum = {
-				w          = screenWidth - _tracklayout.x - math.floor(50 * screenWidth / 1920),
-				padding    = { 0, 20, 0, 0 },
-				align      = _tracklayout.align,
-				lineHeight = _tracklayout.lineHeight,
-				fg         = _tracklayout.fg,
-				font       = _font(NP_ARTISTALBUM_FONT_SIZE),
-				sh = TEXT_SH_COLOR,
+			npalbumgroup = {
+				order = {'npalbum' },
+				position   = _tracklayout.position,
+				border     = _tracklayout.border,
+				x          = _tracklayout.x,
+				y 	   = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 2 / 6,
+				h          = 90,
+				npalbum = {
+					w          = screenWidth - _tracklayout.x - math.floor(50 * screenWidth / 1920),
+					padding    = { 0, 20, 0, 0 },
+					align      = _tracklayout.align,
+					lineHeight = _tracklayout.lineHeight,
+					fg         = _tracklayout.fg,
+					font       = _font(NP_ARTISTALBUM_FONT_SIZE),
+					sh = TEXT_SH_COLOR,
+				},
+			},
+			npartistalbum = {
+				hidden = 1,
 			},
-		},
-		npartistalbum = {
-			hidden = 1,
-		},
 	
-		-- cover art
-		npartwork = {
-			w = coverSize,
-			position = LAYOUT_NONE,
-			x = math.floor(50 * screenWidth/1920),
-			y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2,
-			align = "center",
-			h = coverSize,
-
-			artwork = {
+			-- cover art
+			npartwork = {
 				w = coverSize,
-				h = coverSize,
+				position = LAYOUT_NONE,
+				x = math.floor(50 * screenWidth/1920),
+				y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2,
 				align = "center",
-				padding = 0,
-				img = false,
+				h = coverSize,
+
+				artwork = {
+					w = coverSize,
+					h = coverSize,
+					align = "center",
+					padding = 0,
+					img = false,
+				},
 			},
-		},
 
-		npvisu = { hidden = 1 },
-	
-		--transport controls - hidden
-		npcontrols = {
-			order = { 'repeatMode', 'shuffleMode' },
-			position = LAYOUT_NONE,
-			x = coverSize + math.floor(100 * screenWidth/1920) + (screenWidth - _tracklayout.x - math.floor(50 * screenWidth/1920) - 8)/2 - controlWidth,
-			y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 5.5 / 6,	
-			h = controlHeight,
-			w = WH_FILL,
-			shuffleMode = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_off.png"),
-			}),
-			shuffleOff = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_off.png"),
-			}),
-			shuffleSong = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_on.png"),
-			}),
-			shuffleAlbum = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_album_on.png"),
-			}),
-			repeatMode = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_off.png"),
-			}),
-			repeatOff = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_off.png"),
-			}),
-			repeatPlaylist = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_on.png"),
-			}),
-			repeatSong = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_song_on.png"),
-			}),
-			shuffleDisabled = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_dis.png"),
-			}),
-			repeatDisabled = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_dis.png"),
-			}),
-		},
+			npvisu = { hidden = 1 },
 	
-		-- Progress bar
-		npprogress = {
-			position = LAYOUT_NONE,
-			x = coverSize + math.floor(100 * screenWidth/1920),
-			y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 5 / 6,
-			padding = { 0, 10, 0, 0 },
-			order = { "elapsed", "slider", "remain" },
-			elapsed = {
-				w = math.floor(100 * screenWidth/1920),
-				align = 'left',
-				padding = { 0, 0, 4, 10 },
-				font = _boldfont(math.ceil(28 * screenWidth/1920)),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			remain = {
-				w = math.floor(100 * screenWidth/1920),
-				align = 'right',
-				padding = { 4, 0, 0, 10 },
-				font = _boldfont(math.ceil(28 * screenWidth/1920)),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			elapsedSmall = {
-				w = math.floor(100 * screenWidth/1920),
-				align = 'left',
-				padding = { 0, 0, 4, 20 },
-				font = _boldfont(math.ceil(28 * screenWidth/1920)),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			remainSmall = {
-				w = math.floor(100 * screenWidth/1920),
-				align = 'right',
-				padding = { 4, 0, 0, 20 },
-				font = _boldfont(math.ceil(28 * screenWidth/1920)),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
+			--transport controls - hidden
+			npcontrols = {
+				order = { 'repeatMode', 'shuffleMode' },
+				position = LAYOUT_NONE,
+				x = coverSize + math.floor(100 * screenWidth/1920) + (screenWidth - _tracklayout.x - math.floor(50 * screenWidth/1920) - 8)/2 - controlWidth,
+				y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 5.5 / 6,	
+				h = controlHeight,
+				w = WH_FILL,
+				shuffleMode = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_off.png"),
+				}),
+				shuffleOff = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_off.png"),
+				}),
+				shuffleSong = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_on.png"),
+				}),
+				shuffleAlbum = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_album_on.png"),
+				}),
+				repeatMode = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_off.png"),
+				}),
+				repeatOff = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_off.png"),
+				}),
+				repeatPlaylist = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_on.png"),
+				}),
+				repeatSong = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_song_on.png"),
+				}),
+				shuffleDisabled = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_dis.png"),
+				}),
+				repeatDisabled = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_dis.png"),
+				}),
 			},
-			npprogressB = {
-				w = screenWidth - _tracklayout.x - math.floor(250 * screenWidth/1920),
-				h = 50,
-				padding     = { 0, 0, 0, 0 },
-				position = LAYOUT_SOUTH,
-				horizontal = 1,
-				bgImg = _songProgressBackground,
-				img = _songProgressBar,
+	
+			-- Progress bar
+			npprogress = {
+				position = LAYOUT_NONE,
+				x = coverSize + math.floor(100 * screenWidth/1920),
+				y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 5 / 6,
+				padding = { 0, 10, 0, 0 },
+				order = { "elapsed", "slider", "remain" },
+				elapsed = {
+					w = math.floor(100 * screenWidth/1920),
+					align = 'left',
+					padding = { 0, 0, 4, 10 },
+					font = _boldfont(math.ceil(28 * screenWidth/1920)),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				remain = {
+					w = math.floor(100 * screenWidth/1920),
+					align = 'right',
+					padding = { 4, 0, 0, 10 },
+					font = _boldfont(math.ceil(28 * screenWidth/1920)),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				elapsedSmall = {
+					w = math.floor(100 * screenWidth/1920),
+					align = 'left',
+					padding = { 0, 0, 4, 20 },
+					font = _boldfont(math.ceil(28 * screenWidth/1920)),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				remainSmall = {
+					w = math.floor(100 * screenWidth/1920),
+					align = 'right',
+					padding = { 4, 0, 0, 20 },
+					font = _boldfont(math.ceil(28 * screenWidth/1920)),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				npprogressB = {
+					w = screenWidth - _tracklayout.x - math.floor(250 * screenWidth/1920),
+					h = 50,
+					padding     = { 0, 0, 0, 0 },
+					position = LAYOUT_SOUTH,
+					horizontal = 1,
+					bgImg = _songProgressBackground,
+					img = _songProgressBar,
+				},
 			},
-		},
 	
-		-- special style for when there shouldn't be a progress bar (e.g., internet radio streams)
-		npprogressNB = {
-			order = { "elapsed" },
-			position = LAYOUT_NONE,
-			x = coverSize + math.floor(100 * screenWidth/1920),
-			y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 5 / 6,
-			elapsed = {
-				w = math.floor(100 * screenWidth/1920),
-				align = "left",
-				padding = { 0, 0, 4, 10 },
-				font = _boldfont(math.ceil(28 * screenWidth/1920)),
-				fg = { 0xe7, 0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
+			-- special style for when there shouldn't be a progress bar (e.g., internet radio streams)
+			npprogressNB = {
+				order = { "elapsed" },
+				position = LAYOUT_NONE,
+				x = coverSize + math.floor(100 * screenWidth/1920),
+				y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 5 / 6,
+				elapsed = {
+					w = math.floor(100 * screenWidth/1920),
+					align = "left",
+					padding = { 0, 0, 4, 10 },
+					font = _boldfont(math.ceil(28 * screenWidth/1920)),
+					fg = { 0xe7, 0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
 			},
-		},
 
-	})
+		})
 
-	-- sliders
-	s.nowplaying.npprogress.npprogressB_disabled = _uses(s.nowplaying.npprogress.npprogressB, {
-		img = _songProgressBarDisabled,
-	})
+		-- sliders
+		s.nowplaying.npprogress.npprogressB_disabled = _uses(s.nowplaying.npprogress.npprogressB, {
+			img = _songProgressBarDisabled,
+		})
 
-	-- pressed styles
-	s.nowplaying.title.pressed = _uses(s.nowplaying.title, {
-		text = {
-			fg = { 0xB3, 0xB3, 0xB3 },
-			sh = { },
-			bgImg = pressedTitlebarButtonBox,
-		},
-		lbutton = {
-			bgImg = pressedTitlebarButtonBox,
-		},
-		rbutton = {
-			bgImg = pressedTitlebarButtonBox,
-		},
-	})
+		-- pressed styles
+		s.nowplaying.title.pressed = _uses(s.nowplaying.title, {
+			text = {
+				fg = { 0xB3, 0xB3, 0xB3 },
+				sh = { },
+				bgImg = pressedTitlebarButtonBox,
+			},
+			lbutton = {
+				bgImg = pressedTitlebarButtonBox,
+			},
+			rbutton = {
+				bgImg = pressedTitlebarButtonBox,
+			},
+		})
 
-	s.nowplaying.pressed = s.nowplaying
-	s.nowplaying.nptitle.pressed = _uses(s.nowplaying.nptitle)
-	s.nowplaying.npalbumgroup.pressed = _uses(s.nowplaying.npalbumgroup)
-	s.nowplaying.npartistgroup.pressed = _uses(s.nowplaying.npartistgroup)
-	s.nowplaying.npartwork.pressed = s.nowplaying.npartwork
+		s.nowplaying.pressed = s.nowplaying
+		s.nowplaying.nptitle.pressed = _uses(s.nowplaying.nptitle)
+		s.nowplaying.npalbumgroup.pressed = _uses(s.nowplaying.npalbumgroup)
+		s.nowplaying.npartistgroup.pressed = _uses(s.nowplaying.npartistgroup)
+		s.nowplaying.npartwork.pressed = s.nowplaying.npartwork
 
-	s.nowplaying.npcontrols.pressed = {
-		hidden = 1,
-	}
+		s.nowplaying.npcontrols.pressed = {
+			hidden = 1,
+		}
 
 	
-	-- Visualizer: Container with titlebar, progressbar and controls.
-	--  The space between title and controls is used for the visualizer.
-	s.nowplaying_visualizer_common = _uses(s.nowplaying, {
-		npartwork = { hidden = 1 },
-	})
-
-	s.nowplaying_visualizer_common.npprogress.npprogressB_disabled = s.nowplaying_visualizer_common.npprogress.npprogressB
-
-	-- Visualizer: Spectrum Visualizer
-	s.nowplaying_spectrum_text = _uses(s.nowplaying_visualizer_common, {
-		npvisu = {
-			hidden = 0,
-			position = LAYOUT_NONE,
-			x = math.floor(50 * screenWidth/1920),
-			y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 6 / 6 - coverSize,
-			align = "center",
-			w = coverSize,
-			h = coverSize,
-			border = { 0, 0, 0, 0 },
-			padding = { 0, 0, 0, 0 },
-			bgImg = _progressBackground,
-
-			spectrum = {
+		-- Visualizer: Container with titlebar, progressbar and controls.
+		--  The space between title and controls is used for the visualizer.
+		s.nowplaying_visualizer_common = _uses(s.nowplaying, {
+			npartwork = { hidden = 1 },
+		})
+
+		s.nowplaying_visualizer_common.npprogress.npprogressB_disabled = s.nowplaying_visualizer_common.npprogress.npprogressB
+
+		-- Visualizer: Spectrum Visualizer
+		s.nowplaying_spectrum_text = _uses(s.nowplaying_visualizer_common, {
+			npvisu = {
+				hidden = 0,
 				position = LAYOUT_NONE,
-				x = 0,
-				y = 0,
+				x = math.floor(50 * screenWidth/1920),
+				y = TITLE_HEIGHT + (screenHeight - TITLE_HEIGHT - coverSize) / 2 + coverSize * 6 / 6 - coverSize,
+				align = "center",
 				w = coverSize,
 				h = coverSize,
 				border = { 0, 0, 0, 0 },
 				padding = { 0, 0, 0, 0 },
+				bgImg = _progressBackground,
+
+				spectrum = {
+					position = LAYOUT_NONE,
+					x = 0,
+					y = 0,
+					w = coverSize,
+					h = coverSize,
+					border = { 0, 0, 0, 0 },
+					padding = { 0, 0, 0, 0 },
 
-				bg = { 0x00, 0x00, 0x00, 0x00 },
+					bg = { 0x00, 0x00, 0x00, 0x00 },
 
-				barColor = { 0x14, 0xbc, 0xbc, 0xff },
-				capColor = { 0xb4, 0x56, 0xa1, 0xff },
+					barColor = { 0x14, 0xbc, 0xbc, 0xff },
+					capColor = { 0xb4, 0x56, 0xa1, 0xff },
 
-				isMono = 0,				-- 0 / 1
+					isMono = 0,				-- 0 / 1
 
-				capHeight = { 4, 4 },			-- >= 0
-				capSpace = { 4, 4 },			-- >= 0
-				channelFlipped = { 0, 1 },		-- 0 / 1
-				barsInBin = { 2, 2 },			-- > 1
-				barWidth = { 1, 1 },			-- > 1
-				barSpace = { 3, 3 },			-- >= 0
-				binSpace = { 6, 6 },			-- >= 0
-				clipSubbands = { 1, 1 },		-- 0 / 1
-			}
-		},
-	})
+					capHeight = { 4, 4 },			-- >= 0
+					capSpace = { 4, 4 },			-- >= 0
+					channelFlipped = { 0, 1 },		-- 0 / 1
+					barsInBin = { 2, 2 },			-- > 1
+					barWidth = { 1, 1 },			-- > 1
+					barSpace = { 3, 3 },			-- >= 0
+					binSpace = { 6, 6 },			-- >= 0
+					clipSubbands = { 1, 1 },		-- 0 / 1
+				}
+			},
+		})
+	end)
 
 	s.brightness_group = {
 		order = {  'down', 'div1', 'slider', 'div2', 'up' },
@@ -24,6 +24,7 @@ local string        = require("jive.utils.string")
 local Textarea      = require("jive.ui.Textarea")
 local Window        = require("jive.ui.Window")
 local Icon          = require("jive.ui.Icon")
+local Surface       = require("jive.ui.Surface")
 local log           = require("jive.utils.log").logger("applet.ImageViewer")
 local jiveMain      = jiveMain
 
@@ -107,6 +108,18 @@ function useAutoZoom(self)
 	return true
 end
 
+-- decodes an image at about the size it is shown, the applet does the
+-- final zoom and rotation
+function loadImageData(self, data)
+	if self:useAutoZoom() then
+		local w, h, cover = self.applet:getImageBounds()
+		local image = Surface:loadImageScaled(data, w, h, cover)
+		return image
+	end
+
+	return Surface:loadImageData(data)
+end
+
 --optionally, image sources can modify the icon that appears on the loading page, to, for instance, show a Flickr icon instead
 function updateLoadingIcon(self, icon)
 	return Icon("icon_photo_loading")
@@ -124,7 +124,7 @@ function requestImage(self)
 	local http = SocketHttp(jnt, parsed.host, parsed.port, "ImageSourceHttp")
 	local req = RequestHttp(function(chunk, err)
 			if chunk then
-				local image = Surface:loadImageData(chunk, #chunk)
+				local image = self:loadImageData(chunk)
 				self.image = image
 				log:debug("image ready")
 			elseif err then
@@ -18,6 +18,7 @@ Applet related methods are described in L<jive.Applet>.
 
 -- stuff we use
 local pairs         = pairs
+local io            = require("io")
 local oo            = require("loop.simple")
 --local debug         = require("jive.utils.debug")
 local math          = require("math")
@@ -164,8 +165,12 @@ function getImage(self)
 	if self.imgFiles[self.currentImage] ~= nil then
 		local file = self.imgFiles[self.currentImage]
 		log:info("Next image in queue: ", file)
-		local image = Surface:loadImage(file)
-		return image
+		local fh = io.open(file, "rb")
+		if fh then
+			local data = fh:read("*a")
+			fh:close()
+			return self:loadImageData(data)
+		end
 	end
 end
 
@@ -253,7 +253,7 @@ function requestImage(self, imageData)
 	local http = SocketHttp(jnt, parsed.host, parsed.port, "ImageSourceServer")
 	local req = RequestHttp(function(chunk, err)
 			if chunk then
-				local image = Surface:loadImageData(chunk, #chunk)
+				local image = self:loadImageData(chunk)
 				self.image = image
 				log:debug("image ready")
 				self.error = nil
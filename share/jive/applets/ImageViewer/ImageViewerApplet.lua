@@ -705,6 +705,21 @@ function displaySlide(self)
 	self.task:addTask()
 end
 
+-- images are decoded at about this size, large enough for the zoom and
+-- rotation done in _renderImage
+function getImageBounds(self)
+	local screenWidth, screenHeight = Framework:getScreenSize()
+	local fullScreen = self:getSettings()["fullscreen"]
+
+	if self:getSettings()["rotation"] then
+		local size = math.max(screenWidth, screenHeight)
+		return size, size, fullScreen
+	end
+
+	return screenWidth, screenHeight, fullScreen
+end
+
+
 function _renderImage(self)
 	-- get device orientation and features
 	local screenWidth, screenHeight = Framework:getScreenSize()
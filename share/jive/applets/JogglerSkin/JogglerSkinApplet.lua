@@ -51,6 +51,7 @@ local Window                 = require("jive.ui.Window")
 local table                  = require("jive.utils.table")
 local debug                  = require("jive.utils.debug")
 local autotable              = require("jive.utils.autotable")
+local lazystyle              = require("jive.utils.lazystyle")
 
 local log                    = require("jive.utils.log").logger("applet.JogglerSkin")
 
@@ -149,6 +150,12 @@ function param(self)
 				localPlayerOnly = 1,
 				text = self:string("ANALOG_VU_METER"),
 			},
+			{
+				style = 'nowplaying_waterfall_text',
+				artworkSize = midArtwork,
+				localPlayerOnly = 1,
+				text = self:string("WATERFALL"),
+			},
 		},
 	}
 end
@@ -2413,21 +2420,20 @@ function skin(self, s, reload, useDefaultSize, w, h)
 		img = false,
 	}
 
-	s.region_US = _uses(_buttonicon, { 
-		img = _loadImage(self, "IconsResized/icon_region_americas" .. skinSuffix),
-	})
-	s.region_XX = _uses(_buttonicon, { 
-		img = _loadImage(self, "IconsResized/icon_region_other" .. skinSuffix),
-	})
-	s.icon_help = _uses(_buttonicon, { 
-		img = _loadImage(self, "IconsResized/icon_help" .. skinSuffix),
-	})
-	s.wlan = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_wireless" .. skinSuffix),
-	})
-	s.wired = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ethernet" .. skinSuffix),
-	})
+	-- menu icon styles are built when first shown, most never are
+	local function _buttoniconStyle(name, file)
+		lazystyle.define(s, name, function()
+			return _uses(_buttonicon, {
+				img = _loadImage(self, file),
+			})
+		end)
+	end
+
+	_buttoniconStyle("region_US", "IconsResized/icon_region_americas" .. skinSuffix)
+	_buttoniconStyle("region_XX", "IconsResized/icon_region_other" .. skinSuffix)
+	_buttoniconStyle("icon_help", "IconsResized/icon_help" .. skinSuffix)
+	_buttoniconStyle("wlan", "IconsResized/icon_wireless" .. skinSuffix)
+	_buttoniconStyle("wired", "IconsResized/icon_ethernet" .. skinSuffix)
 
 
 --------- ICONS --------
@@ -2580,183 +2586,77 @@ function skin(self, s, reload, useDefaultSize, w, h)
                 img = false,
         })
 
-	s.player_transporter = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_transporter" .. skinSuffix),
-	})
-	s.player_squeezebox = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_SB1n2" .. skinSuffix),
-	})
-	s.player_squeezebox2 = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_SB1n2" .. skinSuffix),
-	})
-	s.player_squeezebox3 = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_SB3" .. skinSuffix),
-	})
-	s.player_boom = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_boom" .. skinSuffix),
-	})
-	s.player_slimp3 = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_slimp3" .. skinSuffix),
-	})
-	s.player_softsqueeze = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_softsqueeze" .. skinSuffix),
-	})
-	s.player_controller = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_controller" .. skinSuffix),
-	})
-	s.player_receiver = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_receiver" .. skinSuffix),
-	})
-	s.player_squeezeplay = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_squeezeplay" .. skinSuffix),
-	})
-	s.player_http = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_tunein_url" .. skinSuffix),
-	})
-	s.player_baby = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_baby" .. skinSuffix),
-	})
-	s.player_fab4 = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_fab4" .. skinSuffix),
-	})
+	_buttoniconStyle("player_transporter", "IconsResized/icon_transporter" .. skinSuffix)
+	_buttoniconStyle("player_squeezebox", "IconsResized/icon_SB1n2" .. skinSuffix)
+	_buttoniconStyle("player_squeezebox2", "IconsResized/icon_SB1n2" .. skinSuffix)
+	_buttoniconStyle("player_squeezebox3", "IconsResized/icon_SB3" .. skinSuffix)
+	_buttoniconStyle("player_boom", "IconsResized/icon_boom" .. skinSuffix)
+	_buttoniconStyle("player_slimp3", "IconsResized/icon_slimp3" .. skinSuffix)
+	_buttoniconStyle("player_softsqueeze", "IconsResized/icon_softsqueeze" .. skinSuffix)
+	_buttoniconStyle("player_controller", "IconsResized/icon_controller" .. skinSuffix)
+	_buttoniconStyle("player_receiver", "IconsResized/icon_receiver" .. skinSuffix)
+	_buttoniconStyle("player_squeezeplay", "IconsResized/icon_squeezeplay" .. skinSuffix)
+	_buttoniconStyle("player_http", "IconsResized/icon_tunein_url" .. skinSuffix)
+	_buttoniconStyle("player_baby", "IconsResized/icon_baby" .. skinSuffix)
+	_buttoniconStyle("player_fab4", "IconsResized/icon_fab4" .. skinSuffix)
 
 	-- misc home menu icons
-	s.hm_appletImageViewer = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_image_viewer" .. skinSuffix),
-	})
-	s.hm_eject = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_eject" .. skinSuffix),
-	})
-	s.hm_sdcard = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_device_SDcard" .. skinSuffix),
-	})
-	s.hm_usbdrive = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_device_USB" .. skinSuffix),
-	})
-	s.hm_appletNowPlaying = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_nowplaying" .. skinSuffix),
-	})
-	s.hm_settings = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_settings" .. skinSuffix),
-	})
-	s.hm_advancedSettings = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_settings_adv" .. skinSuffix),
-	})
-	s.hm_settings_pcp = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_settings_pcp" .. skinSuffix),
-	})
-	s.hm_radio = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_tunein" .. skinSuffix),
-	})
-	s.hm_radios = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_tunein" .. skinSuffix),
-	})
-	s.hm_myApps = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_my_apps" .. skinSuffix),
-	})
-	s.hm_myMusic = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_mymusic" .. skinSuffix),
-	})
-	s.hm__myMusic = _uses(s.hm_myMusic)
-   	s.hm_otherLibrary = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_ml_other_library" .. skinSuffix),
-        })
-	s.hm_myMusicSelector = _uses(s.hm_myMusic)
-
-	s.hm_favorites = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_favorites" .. skinSuffix),
-	})
-	s.hm_settingsAlarm = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_alarm" .. skinSuffix),
-	})
-	s.hm_settingsPlayerNameChange = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_settings_name" .. skinSuffix),
-	})
-	s.hm_settingsBrightness = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_settings_brightness" .. skinSuffix),
-	})
-	s.hm_settingsSync = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_sync" .. skinSuffix),
-	})
-	s.hm_selectPlayer = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_choose_player" .. skinSuffix),
-	})
-	s.hm_quit = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_power_off" .. skinSuffix),
-	})
-	s.hm_playerpower = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_power_off" .. skinSuffix),
-	})
-	s.hm_myMusicArtists = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_artist" .. skinSuffix),
-	})
-	s.hm_myMusicAlbums = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_albums" .. skinSuffix),
-	})
-	s.hm_myMusicGenres = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_genres" .. skinSuffix),
-	})
-	s.hm_myMusicYears = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_years" .. skinSuffix),
-	})
-
-	s.hm_myMusicNewMusic = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_new_music" .. skinSuffix),
-	})
-	s.hm_myMusicPlaylists = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_playlist" .. skinSuffix),
-	})
-	s.hm_myMusicSearch = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_search" .. skinSuffix),
-	})
-	s.hm_myMusicSearchArtists   = _uses(s.hm_myMusicSearch)
-	s.hm_myMusicSearchAlbums    = _uses(s.hm_myMusicSearch)
-	s.hm_myMusicSearchSongs     = _uses(s.hm_myMusicSearch)
-	s.hm_myMusicSearchPlaylists = _uses(s.hm_myMusicSearch)
-	s.hm_myMusicSearchRecent    = _uses(s.hm_myMusicSearch)
-	s.hm_homeSearchRecent       = _uses(s.hm_myMusicSearch)
-	s.hm_globalSearch           = _uses(s.hm_myMusicSearch)
-
-	s.hm_myMusicMusicFolder = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_folder" .. skinSuffix),
-	})
-	s.hm_randomplay = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_ml_random" .. skinSuffix),
-	})
-	s.hm_skinTest = _uses(_buttonicon, {
-		img = _loadImage(self, "IconsResized/icon_blank" .. skinSuffix),
-	})
-
-        s.hm_settingsRepeat = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_settings_repeat" .. skinSuffix),
-        })
-        s.hm_settingsShuffle = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_settings_shuffle" .. skinSuffix),
-        })
-        s.hm_settingsSleep = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_settings_sleep" .. skinSuffix),
-        })
-        s.hm_settingsScreen = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_settings_screen" .. skinSuffix),
-        })
-        s.hm_appletCustomizeHome = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_settings_home" .. skinSuffix),
-        })
-        s.hm_settingsAudio = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_settings_audio" .. skinSuffix),
-        })
-        s.hm_linein = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_linein" .. skinSuffix),
-        })
+	_buttoniconStyle("hm_appletImageViewer", "IconsResized/icon_image_viewer" .. skinSuffix)
+	_buttoniconStyle("hm_eject", "IconsResized/icon_eject" .. skinSuffix)
+	_buttoniconStyle("hm_sdcard", "IconsResized/icon_device_SDcard" .. skinSuffix)
+	_buttoniconStyle("hm_usbdrive", "IconsResized/icon_device_USB" .. skinSuffix)
+	_buttoniconStyle("hm_appletNowPlaying", "IconsResized/icon_nowplaying" .. skinSuffix)
+	_buttoniconStyle("hm_settings", "IconsResized/icon_settings" .. skinSuffix)
+	_buttoniconStyle("hm_advancedSettings", "IconsResized/icon_settings_adv" .. skinSuffix)
+	_buttoniconStyle("hm_settings_pcp", "IconsResized/icon_settings_pcp" .. skinSuffix)
+	_buttoniconStyle("hm_radio", "IconsResized/icon_tunein" .. skinSuffix)
+	_buttoniconStyle("hm_radios", "IconsResized/icon_tunein" .. skinSuffix)
+	_buttoniconStyle("hm_myApps", "IconsResized/icon_my_apps" .. skinSuffix)
+	_buttoniconStyle("hm_myMusic", "IconsResized/icon_mymusic" .. skinSuffix)
+	lazystyle.define(s, "hm__myMusic", function() return _uses(s.hm_myMusic) end)
+	_buttoniconStyle("hm_otherLibrary", "IconsResized/icon_ml_other_library" .. skinSuffix)
+	lazystyle.define(s, "hm_myMusicSelector", function() return _uses(s.hm_myMusic) end)
+
+	_buttoniconStyle("hm_favorites", "IconsResized/icon_favorites" .. skinSuffix)
+	_buttoniconStyle("hm_settingsAlarm", "IconsResized/icon_alarm" .. skinSuffix)
+	_buttoniconStyle("hm_settingsPlayerNameChange", "IconsResized/icon_settings_name" .. skinSuffix)
+	_buttoniconStyle("hm_settingsBrightness", "IconsResized/icon_settings_brightness" .. skinSuffix)
+	_buttoniconStyle("hm_settingsSync", "IconsResized/icon_sync" .. skinSuffix)
+	_buttoniconStyle("hm_selectPlayer", "IconsResized/icon_choose_player" .. skinSuffix)
+	_buttoniconStyle("hm_quit", "IconsResized/icon_power_off" .. skinSuffix)
+	_buttoniconStyle("hm_playerpower", "IconsResized/icon_power_off" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicArtists", "IconsResized/icon_ml_artist" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicAlbums", "IconsResized/icon_ml_albums" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicGenres", "IconsResized/icon_ml_genres" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicYears", "IconsResized/icon_ml_years" .. skinSuffix)
+
+	_buttoniconStyle("hm_myMusicNewMusic", "IconsResized/icon_ml_new_music" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicPlaylists", "IconsResized/icon_ml_playlist" .. skinSuffix)
+	_buttoniconStyle("hm_myMusicSearch", "IconsResized/icon_ml_search" .. skinSuffix)
+	lazystyle.define(s, "hm_myMusicSearchArtists", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_myMusicSearchAlbums", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_myMusicSearchSongs", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_myMusicSearchPlaylists", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_myMusicSearchRecent", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_homeSearchRecent", function() return _uses(s.hm_myMusicSearch) end)
+	lazystyle.define(s, "hm_globalSearch", function() return _uses(s.hm_myMusicSearch) end)
+
+	_buttoniconStyle("hm_myMusicMusicFolder", "IconsResized/icon_ml_folder" .. skinSuffix)
+	_buttoniconStyle("hm_randomplay", "IconsResized/icon_ml_random" .. skinSuffix)
+	_buttoniconStyle("hm_skinTest", "IconsResized/icon_blank" .. skinSuffix)
+
+	_buttoniconStyle("hm_settingsRepeat", "IconsResized/icon_settings_repeat" .. skinSuffix)
+	_buttoniconStyle("hm_settingsShuffle", "IconsResized/icon_settings_shuffle" .. skinSuffix)
+	_buttoniconStyle("hm_settingsSleep", "IconsResized/icon_settings_sleep" .. skinSuffix)
+	_buttoniconStyle("hm_settingsScreen", "IconsResized/icon_settings_screen" .. skinSuffix)
+	_buttoniconStyle("hm_appletCustomizeHome", "IconsResized/icon_settings_home" .. skinSuffix)
+	_buttoniconStyle("hm_settingsAudio", "IconsResized/icon_settings_audio" .. skinSuffix)
+	_buttoniconStyle("hm_linein", "IconsResized/icon_linein" .. skinSuffix)
 
         -- ??
-        s.hm_loading = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_loading" .. skinSuffix),
-        })
+	_buttoniconStyle("hm_loading", "IconsResized/icon_loading" .. skinSuffix)
         -- ??
-        s.hm_settingsPlugin = _uses(_buttonicon, {
-                img = _loadImage(self, "IconsResized/icon_settings_plugin" .. skinSuffix),
-        })
+	_buttoniconStyle("hm_settingsPlugin", "IconsResized/icon_settings_plugin" .. skinSuffix)
 
 	-- indicator icons, on right of menus
 	local _indicator = {
@@ -2820,741 +2720,740 @@ function skin(self, s, reload, useDefaultSize, w, h)
 		w = WH_FILL,
 	})
 
-	local _tracklayout = {
-		border = { 4, 0, 4, 0 },
-		position = LAYOUT_NONE,
-		w = WH_FILL,
-		align = "left",
-		lineHeight = NP_TRACK_FONT_SIZE,
-		fg = TEXT_COLOR,
-		x = screenHeight - 160 + 5,
-	}
+	-- the now playing styles are built when now playing is first shown
+	lazystyle.define(s, {
+		"nowplaying", "npvolumeB", "npvolumeB_disabled",
+		"nowplaying_large_art", "nowplaying_art_only",
+		"nowplaying_text_only", "nowplaying_visualizer_common",
+		"nowplaying_spectrum_text", "nowplaying_waterfall_text",
+		"nowplaying_vuanalog_text",
+	}, function()
+		local _tracklayout = {
+			border = { 4, 0, 4, 0 },
+			position = LAYOUT_NONE,
+			w = WH_FILL,
+			align = "left",
+			lineHeight = NP_TRACK_FONT_SIZE,
+			fg = TEXT_COLOR,
+			x = screenHeight - 160 + 5,
+		}
 	
-	local maxArtwork = screenHeight - 180
+		local maxArtwork = screenHeight - 180
 
-	s.nowplaying = _uses(s.window, {
-		--title bar
-		title = _uses(s.title, {
-			zOrder = 1,
-			text = {
-				font = _boldfont(TITLEBAR_FONT_SIZE),
-				bgImg   = titlebarButtonBox,
-			},
-			rbutton  = {
-				font    = _font(14),
-				fg      = TEXT_COLOR,
-				bgImg   = titlebarButtonBox,
-				w       = TITLE_BUTTON_WIDTH,
-				padding = { 8, 0, 8, 0},
-				align   = 'center',
-			}
-		}),
+		s.nowplaying = _uses(s.window, {
+			--title bar
+			title = _uses(s.title, {
+				zOrder = 1,
+				text = {
+					font = _boldfont(TITLEBAR_FONT_SIZE),
+					bgImg   = titlebarButtonBox,
+				},
+				rbutton  = {
+					font    = _font(14),
+					fg      = TEXT_COLOR,
+					bgImg   = titlebarButtonBox,
+					w       = TITLE_BUTTON_WIDTH,
+					padding = { 8, 0, 8, 0},
+					align   = 'center',
+				}
+			}),
 	
-		-- Song metadata
-		nptitle = {
-			order = { 'nptrack' },
-			position   = _tracklayout.position,
-			border     = _tracklayout.border,
-			x          = _tracklayout.x,
-			y          = TITLE_HEIGHT + 65,
-			h          = NP_TRACK_FONT_SIZE,
-			nptrack =  {
-				w          = screenWidth - _tracklayout.x - 10,
-				h          = WH_FILL,
-				align      = _tracklayout.align,
-				lineHeight = _tracklayout.lineHeight,
-				fg         = _tracklayout.fg,
-				font       = _boldfont(NP_TRACK_FONT_SIZE), 
-				sh = TEXT_SH_COLOR,
+			-- Song metadata
+			nptitle = {
+				order = { 'nptrack' },
+				position   = _tracklayout.position,
+				border     = _tracklayout.border,
+				x          = _tracklayout.x,
+				y          = TITLE_HEIGHT + 65,
+				h          = NP_TRACK_FONT_SIZE,
+				nptrack =  {
+					w          = screenWidth - _tracklayout.x - 10,
+					h          = WH_FILL,
+					align      = _tracklayout.align,
+					lineHeight = _tracklayout.lineHeight,
+					fg         = _tracklayout.fg,
+					font       = _boldfont(NP_TRACK_FONT_SIZE), 
+					sh = TEXT_SH_COLOR,
+				},
 			},
-		},
-		npartistgroup = {
-			order = { 'npartist' },
-			position   = _tracklayout.position,
-			border     = _tracklayout.border,
-			x          = _tracklayout.x,
-			y          = TITLE_HEIGHT + 32 + 32 + 70,
-			h          = 32,
-			npartist = {
-				padding    = { 0, 6, 0, 0 },
-				w          = screenWidth - _tracklayout.x - 10,
-				align      = _tracklayout.align,
-				lineHeight = _tracklayout.lineHeight,
-				fg         = _tracklayout.fg,
-				font       = _font(NP_ARTISTALBUM_FONT_SIZE),
-				sh = TEXT_SH_COLOR,
+			npartistgroup = {
+				order = { 'npartist' },
+				position   = _tracklayout.position,
+				border     = _tracklayout.border,
+				x          = _tracklayout.x,
+				y          = TITLE_HEIGHT + 32 + 32 + 70,
+				h          = 32,
+				npartist = {
+					padding    = { 0, 6, 0, 0 },
+					w          = screenWidth - _tracklayout.x - 10,
+					align      = _tracklayout.align,
+					lineHeight = _tracklayout.lineHeight,
+					fg         = _tracklayout.fg,
+					font       = _font(NP_ARTISTALBUM_FONT_SIZE),
+					sh = TEXT_SH_COLOR,
+				},
 			},
-		},
-		npalbumgroup = {
-			order = {'npalbum' },
-			position   = _tracklayout.position,
-			border     = _tracklayout.border,
-			x          = _tracklayout.x,
-			y          = TITLE_HEIGHT + 32 + 32 + 32 + 70 + 10,
-			h          = 32,
-			npalbum = {
-				w          = screenWidth - _tracklayout.x - 10,
-				padding    = { 0, 6, 0, 0 },
-				align      = _tracklayout.align,
-				lineHeight = _tracklayout.lineHeight,
-				fg         = _tracklayout.fg,
-				font       = _font(NP_ARTISTALBUM_FONT_SIZE),
-				sh = TEXT_SH_COLOR,
+			npalbumgroup = {
+				order = {'npalbum' },
+				position   = _tracklayout.position,
+				border     = _tracklayout.border,
+				x          = _tracklayout.x,
+				y          = TITLE_HEIGHT + 32 + 32 + 32 + 70 + 10,
+				h          = 32,
+				npalbum = {
+					w          = screenWidth - _tracklayout.x - 10,
+					padding    = { 0, 6, 0, 0 },
+					align      = _tracklayout.align,
+					lineHeight = _tracklayout.lineHeight,
+					fg         = _tracklayout.fg,
+					font       = _font(NP_ARTISTALBUM_FONT_SIZE),
+					sh = TEXT_SH_COLOR,
+				},
+			},
+			npartistalbum = {
+				hidden = 1,
 			},
-		},
-		npartistalbum = {
-			hidden = 1,
-		},
 	
-		-- cover art
-		npartwork = {
-			w = maxArtwork,
-			position = LAYOUT_NONE,
-			x = 10,
-			y = TITLE_HEIGHT + 18,
-			align = "center",
-			h = maxArtwork,
-
-			artwork = {
+			-- cover art
+			npartwork = {
 				w = maxArtwork,
+				position = LAYOUT_NONE,
+				x = 10,
+				y = TITLE_HEIGHT + 18,
 				align = "center",
-				padding = 0,
-				img = false,
+				h = maxArtwork,
+
+				artwork = {
+					w = maxArtwork,
+					align = "center",
+					padding = 0,
+					img = false,
+				},
 			},
-		},
 
-		npvisu = { hidden = 1 },
+			npvisu = { hidden = 1 },
 	
-		--transport controls
-		npcontrols = {
-			order = { 'rew', 'div1', 'play', 'div2', 'fwd', 'div3', 'repeatMode', 'div4', 'shuffleMode', 
-					'div5', 'volDown', 'div6', 'volSlider', 'div7', 'volUp' },
-			position = LAYOUT_SOUTH,
-			h = controlHeight,
-			w = WH_FILL,
-			bgImg = touchToolbarBackground,
-
-			div1 = _uses(_transportControlBorder),
-			div2 = _uses(_transportControlBorder),
-			div3 = _uses(_transportControlBorder),
-			div4 = _uses(_transportControlBorder),
-			div5 = _uses(_transportControlBorder),
-			div6 = _uses(_transportControlBorder),
-			div7 = _uses(_transportControlBorder),
-
-			rew   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_rew.png"),
-			}),
-			play  = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_play.png"),
-			}),
-			pause = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_pause.png"),
-			}),
-			fwd   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_ffwd.png"),
-			}),
-			shuffleMode   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_off.png"),
-			}),
-			shuffleOff   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_off.png"),
-			}),
-			shuffleSong  = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_on.png"),
-			}),
-			shuffleAlbum = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_album_on.png"),
-			}),
-			repeatMode   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_off.png"),
-			}),
-			repeatOff   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_off.png"),
-			}),
-			repeatPlaylist = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_on.png"),
-			}),
-			repeatSong = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_song_on.png"),
-			}),
-			volDown   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_vol_down.png"),
-			}),
-			volUp   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_vol_up.png"),
-			}),
-			thumbsUp   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_thumbup.png"),
-			}),
-			thumbsDown   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_thumbdown.png"),
-			}),
-			thumbsUpDisabled   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_thumbup_dis.png"),
-			}),
-			thumbsDownDisabled   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_thumbdown_dis.png"),
-			}),
-			love   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_love_on.png"),
-			}),
-			hate   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_love_off.png"),
-			}),
-			fwdDisabled   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_ffwd_dis.png"),
-			}),
-			rewDisabled   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_rew_dis.png"),
-			}),
-			shuffleDisabled   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_shuffle_dis.png"),
-			}),
-			repeatDisabled   = _uses(_transportControlButton, {
-				img = _loadImage(self, "Icons/icon_toolbar_repeat_dis.png"),
-			}),
-		},
+			--transport controls
+			npcontrols = {
+				order = { 'rew', 'div1', 'play', 'div2', 'fwd', 'div3', 'repeatMode', 'div4', 'shuffleMode', 
+						'div5', 'volDown', 'div6', 'volSlider', 'div7', 'volUp' },
+				position = LAYOUT_SOUTH,
+				h = controlHeight,
+				w = WH_FILL,
+				bgImg = touchToolbarBackground,
+
+				div1 = _uses(_transportControlBorder),
+				div2 = _uses(_transportControlBorder),
+				div3 = _uses(_transportControlBorder),
+				div4 = _uses(_transportControlBorder),
+				div5 = _uses(_transportControlBorder),
+				div6 = _uses(_transportControlBorder),
+				div7 = _uses(_transportControlBorder),
+
+				rew   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_rew.png"),
+				}),
+				play  = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_play.png"),
+				}),
+				pause = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_pause.png"),
+				}),
+				fwd   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_ffwd.png"),
+				}),
+				shuffleMode   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_off.png"),
+				}),
+				shuffleOff   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_off.png"),
+				}),
+				shuffleSong  = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_on.png"),
+				}),
+				shuffleAlbum = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_album_on.png"),
+				}),
+				repeatMode   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_off.png"),
+				}),
+				repeatOff   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_off.png"),
+				}),
+				repeatPlaylist = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_on.png"),
+				}),
+				repeatSong = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_song_on.png"),
+				}),
+				volDown   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_vol_down.png"),
+				}),
+				volUp   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_vol_up.png"),
+				}),
+				thumbsUp   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_thumbup.png"),
+				}),
+				thumbsDown   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_thumbdown.png"),
+				}),
+				thumbsUpDisabled   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_thumbup_dis.png"),
+				}),
+				thumbsDownDisabled   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_thumbdown_dis.png"),
+				}),
+				love   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_love_on.png"),
+				}),
+				hate   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_love_off.png"),
+				}),
+				fwdDisabled   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_ffwd_dis.png"),
+				}),
+				rewDisabled   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_rew_dis.png"),
+				}),
+				shuffleDisabled   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_shuffle_dis.png"),
+				}),
+				repeatDisabled   = _uses(_transportControlButton, {
+					img = _loadImage(self, "Icons/icon_toolbar_repeat_dis.png"),
+				}),
+			},
 	
-		-- Progress bar
-		npprogress = {
-			position = LAYOUT_NONE,
-			x = _tracklayout.x + 2,
-			y = screenHeight - 160,
-			padding = { 0, 11, 0, 0 },
-			order = { "elapsed", "slider", "remain" },
-			elapsed = {
-				w = 60,
-				align = 'left',
-				padding = { 0, 0, 4, 20 },
-				font = _boldfont(18),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			remain = {
-				w = 60,
-				align = 'right',
-				padding = { 4, 0, 0, 20 },
-				font = _boldfont(18),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			elapsedSmall = {
-				w = 60,
-				align = 'left',
-				padding = { 0, 0, 4, 20 },
-				font = _boldfont(14),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			remainSmall = {
-				w = 60,
-				align = 'right',
-				padding = { 4, 0, 0, 20 },
-				font = _boldfont(14),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			npprogressB = {
-				w = screenWidth - _tracklayout.x - 2*80 - 25,
-				h = 50,
-				padding = { 0, 0, 0, 0 },
-			        position = LAYOUT_SOUTH,
-				horizontal = 1,
-				bgImg = _songProgressBackground,
-				img = _songProgressBar,
+			-- Progress bar
+			npprogress = {
+				position = LAYOUT_NONE,
+				x = _tracklayout.x + 2,
+				y = screenHeight - 160,
+				padding = { 0, 11, 0, 0 },
+				order = { "elapsed", "slider", "remain" },
+				elapsed = {
+					w = 60,
+					align = 'left',
+					padding = { 0, 0, 4, 20 },
+					font = _boldfont(18),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				remain = {
+					w = 60,
+					align = 'right',
+					padding = { 4, 0, 0, 20 },
+					font = _boldfont(18),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				elapsedSmall = {
+					w = 60,
+					align = 'left',
+					padding = { 0, 0, 4, 20 },
+					font = _boldfont(14),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				remainSmall = {
+					w = 60,
+					align = 'right',
+					padding = { 4, 0, 0, 20 },
+					font = _boldfont(14),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				npprogressB = {
+					w = screenWidth - _tracklayout.x - 2*80 - 25,
+					h = 50,
+					padding = { 0, 0, 0, 0 },
+				        position = LAYOUT_SOUTH,
+					horizontal = 1,
+					bgImg = _songProgressBackground,
+					img = _songProgressBar,
+				},
 			},
-		},
 	
-		-- special style for when there shouldn't be a progress bar (e.g., internet radio streams)
-		npprogressNB = {
-			order = { "elapsed" },
-			position = LAYOUT_NONE,
-			x = _tracklayout.x + 2,
-			y = TITLE_HEIGHT + 29 + 26 + 32 + 32 + 23 + 84 + 40,
-			elapsed = {
-				w = WH_FILL,
-				align = "left",
-				font = _boldfont(18),
-				fg = { 0xe7, 0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
+			-- special style for when there shouldn't be a progress bar (e.g., internet radio streams)
+			npprogressNB = {
+				order = { "elapsed" },
+				position = LAYOUT_NONE,
+				x = _tracklayout.x + 2,
+				y = TITLE_HEIGHT + 29 + 26 + 32 + 32 + 23 + 84 + 40,
+				elapsed = {
+					w = WH_FILL,
+					align = "left",
+					font = _boldfont(18),
+					fg = { 0xe7, 0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
 			},
-		},
 
-	})
-	s.nowplaying.npprogressNB.elapsedSmall = s.nowplaying.npprogressNB.elapsed
+		})
+		s.nowplaying.npprogressNB.elapsedSmall = s.nowplaying.npprogressNB.elapsed
 
-	-- sliders
-	s.nowplaying.npprogress.npprogressB_disabled = _uses(s.nowplaying.npprogress.npprogressB, {
-		img = _songProgressBarDisabled,
-	})
+		-- sliders
+		s.nowplaying.npprogress.npprogressB_disabled = _uses(s.nowplaying.npprogress.npprogressB, {
+			img = _songProgressBarDisabled,
+		})
 
-	s.npvolumeB = {
-		w = volumeBarWidth,
-		border = { 5, 20, 5, 0 },
-		padding = { 6, 0, 6, 0 },
-                position = LAYOUT_SOUTH,
-                horizontal = 1,
-                bgImg = _volumeSliderBackground,
-                img = _volumeSliderBar,
-                pillImg = _volumeSliderPill,
-	}
-	s.npvolumeB_disabled = _uses(s.npvolumeB, {
-		pillImg = false,
-	})
+		s.npvolumeB = {
+			w = volumeBarWidth,
+			border = { 5, 20, 5, 0 },
+			padding = { 6, 0, 6, 0 },
+	                position = LAYOUT_SOUTH,
+	                horizontal = 1,
+	                bgImg = _volumeSliderBackground,
+	                img = _volumeSliderBar,
+	                pillImg = _volumeSliderPill,
+		}
+		s.npvolumeB_disabled = _uses(s.npvolumeB, {
+			pillImg = false,
+		})
+
+		-- pressed styles
+		s.nowplaying.title.pressed = _uses(s.nowplaying.title, {
+			text = {
+				fg = { 0xB3, 0xB3, 0xB3 },
+				sh = { },
+				bgImg = pressedTitlebarButtonBox,
+			},
+			lbutton = {
+				bgImg = pressedTitlebarButtonBox,
+			},
+			rbutton = {
+				bgImg = pressedTitlebarButtonBox,
+			},
+		})
+
+		s.nowplaying.pressed = s.nowplaying
+		s.nowplaying.nptitle.pressed = _uses(s.nowplaying.nptitle)
+		s.nowplaying.npalbumgroup.pressed = _uses(s.nowplaying.npalbumgroup)
+		s.nowplaying.npartistgroup.pressed = _uses(s.nowplaying.npartistgroup)
+		s.nowplaying.npartwork.pressed = s.nowplaying.npartwork
+
+		s.nowplaying.npcontrols.pressed = {
+			rew     = _uses(s.nowplaying.npcontrols.rew, { bgImg = keyMiddlePressed }),
+			play    = _uses(s.nowplaying.npcontrols.play, { bgImg = keyMiddlePressed }),
+			pause   = _uses(s.nowplaying.npcontrols.pause, { bgImg = keyMiddlePressed }),
+			fwd     = _uses(s.nowplaying.npcontrols.fwd, { bgImg = keyMiddlePressed }),
+			repeatPlaylist  = _uses(s.nowplaying.npcontrols.repeatPlaylist, { bgImg = keyMiddlePressed }),
+			repeatSong      = _uses(s.nowplaying.npcontrols.repeatSong, { bgImg = keyMiddlePressed }),
+			repeatOff       = _uses(s.nowplaying.npcontrols.repeatOff, { bgImg = keyMiddlePressed }),
+			repeatMode      = _uses(s.nowplaying.npcontrols.repeatMode, { bgImg = keyMiddlePressed }),
+			shuffleAlbum    = _uses(s.nowplaying.npcontrols.shuffleAlbum, { bgImg = keyMiddlePressed }),
+			shuffleSong     = _uses(s.nowplaying.npcontrols.shuffleSong, { bgImg = keyMiddlePressed }),
+			shuffleMode      = _uses(s.nowplaying.npcontrols.shuffleMode, { bgImg = keyMiddlePressed }),
+			shuffleOff      = _uses(s.nowplaying.npcontrols.shuffleOff, { bgImg = keyMiddlePressed }),
+			volDown = _uses(s.nowplaying.npcontrols.volDown, { bgImg = keyMiddlePressed }),
+			volUp   = _uses(s.nowplaying.npcontrols.volUp, { bgImg = keyMiddlePressed }),
+
+			thumbsUp    = _uses(s.nowplaying.npcontrols.thumbsUp, { bgImg = keyMiddlePressed }),
+			thumbsDown  = _uses(s.nowplaying.npcontrols.thumbsDown, { bgImg = keyMiddlePressed }),
+			thumbsUpDisabled    = s.nowplaying.npcontrols.thumbsUpDisabled,
+			thumbsDownDisabled  = s.nowplaying.npcontrols.thumbsDownDisabled,
+			love        = _uses(s.nowplaying.npcontrols.love, { bgImg = keyMiddlePressed }),
+			hate        = _uses(s.nowplaying.npcontrols.hate, { bgImg = keyMiddlePressed }),
+			fwdDisabled = _uses(s.nowplaying.npcontrols.fwdDisabled),
+			rewDisabled = _uses(s.nowplaying.npcontrols.rewDisabled),
+			shuffleDisabled = _uses(s.nowplaying.npcontrols.shuffleDisabled),
+			repeatDisabled = _uses(s.nowplaying.npcontrols.repeatDisabled),
+		}
 
-	-- pressed styles
-	s.nowplaying.title.pressed = _uses(s.nowplaying.title, {
-		text = {
-			fg = { 0xB3, 0xB3, 0xB3 },
-			sh = { },
-			bgImg = pressedTitlebarButtonBox,
-		},
-		lbutton = {
-			bgImg = pressedTitlebarButtonBox,
-		},
-		rbutton = {
-			bgImg = pressedTitlebarButtonBox,
-		},
-	})
 
-	s.nowplaying.pressed = s.nowplaying
-	s.nowplaying.nptitle.pressed = _uses(s.nowplaying.nptitle)
-	s.nowplaying.npalbumgroup.pressed = _uses(s.nowplaying.npalbumgroup)
-	s.nowplaying.npartistgroup.pressed = _uses(s.nowplaying.npartistgroup)
-	s.nowplaying.npartwork.pressed = s.nowplaying.npartwork
-
-	s.nowplaying.npcontrols.pressed = {
-		rew     = _uses(s.nowplaying.npcontrols.rew, { bgImg = keyMiddlePressed }),
-		play    = _uses(s.nowplaying.npcontrols.play, { bgImg = keyMiddlePressed }),
-		pause   = _uses(s.nowplaying.npcontrols.pause, { bgImg = keyMiddlePressed }),
-		fwd     = _uses(s.nowplaying.npcontrols.fwd, { bgImg = keyMiddlePressed }),
-		repeatPlaylist  = _uses(s.nowplaying.npcontrols.repeatPlaylist, { bgImg = keyMiddlePressed }),
-		repeatSong      = _uses(s.nowplaying.npcontrols.repeatSong, { bgImg = keyMiddlePressed }),
-		repeatOff       = _uses(s.nowplaying.npcontrols.repeatOff, { bgImg = keyMiddlePressed }),
-		repeatMode      = _uses(s.nowplaying.npcontrols.repeatMode, { bgImg = keyMiddlePressed }),
-		shuffleAlbum    = _uses(s.nowplaying.npcontrols.shuffleAlbum, { bgImg = keyMiddlePressed }),
-		shuffleSong     = _uses(s.nowplaying.npcontrols.shuffleSong, { bgImg = keyMiddlePressed }),
-		shuffleMode      = _uses(s.nowplaying.npcontrols.shuffleMode, { bgImg = keyMiddlePressed }),
-		shuffleOff      = _uses(s.nowplaying.npcontrols.shuffleOff, { bgImg = keyMiddlePressed }),
-		volDown = _uses(s.nowplaying.npcontrols.volDown, { bgImg = keyMiddlePressed }),
-		volUp   = _uses(s.nowplaying.npcontrols.volUp, { bgImg = keyMiddlePressed }),
-
-		thumbsUp    = _uses(s.nowplaying.npcontrols.thumbsUp, { bgImg = keyMiddlePressed }),
-		thumbsDown  = _uses(s.nowplaying.npcontrols.thumbsDown, { bgImg = keyMiddlePressed }),
-		thumbsUpDisabled    = s.nowplaying.npcontrols.thumbsUpDisabled,
-		thumbsDownDisabled  = s.nowplaying.npcontrols.thumbsDownDisabled,
-		love        = _uses(s.nowplaying.npcontrols.love, { bgImg = keyMiddlePressed }),
-		hate        = _uses(s.nowplaying.npcontrols.hate, { bgImg = keyMiddlePressed }),
-		fwdDisabled = _uses(s.nowplaying.npcontrols.fwdDisabled),
-		rewDisabled = _uses(s.nowplaying.npcontrols.rewDisabled),
-		shuffleDisabled = _uses(s.nowplaying.npcontrols.shuffleDisabled),
-		repeatDisabled = _uses(s.nowplaying.npcontrols.repeatDisabled),
-	}
-
-
-	local settings = appletManager:callService("getNowPlayingScreenButtons")
-	local buttonOrder = {}
-	local smallTbButtons
-
-	local i = 1
-	for k,v in ipairs(tbButtons) do
-		if settings[v] then
-			table.insert(buttonOrder, v)
+		local settings = appletManager:callService("getNowPlayingScreenButtons")
+		local buttonOrder = {}
+		local smallTbButtons
+
+		local i = 1
+		for k,v in ipairs(tbButtons) do
+			if settings[v] then
+				table.insert(buttonOrder, v)
 			
-			i = i + 1
+				i = i + 1
 			
-			-- We can't comfortably accomodate more than five items
-			if (screenWidth <= 800 and i > 5) or (i > 2 and v == 'volSlider') then
-				smallTbButtons = true
-				if screenWidth <= 800 then break end
-			end
+				-- We can't comfortably accomodate more than five items
+				if (screenWidth <= 800 and i > 5) or (i > 2 and v == 'volSlider') then
+					smallTbButtons = true
+					if screenWidth <= 800 then break end
+				end
 			
-			table.insert(buttonOrder, 'div' .. tostring(i))
+				table.insert(buttonOrder, 'div' .. tostring(i))
+			end
 		end
-	end
 	
-	local npX = screenHeight + 15
+		local npX = screenHeight + 15
 
-	s.nowplaying_large_art = _uses(s.nowplaying, {
-		bgImg = blackBackground,
-		title = {
-			bgImg = false,
-			text = {
-				border = { screenHeight - 72, 0, 0, 0 },
-				padding = { 10, 12, 10, 15 },
-				font = _boldfont(24),
-			},
-			button_back = {
-				bgImg = false
-			}
-		},
-		nptitle = {
-			x = npX,
-			nptrack = {
-				w = screenWidth - npX - 10,
-				font = _boldfont(NP_ARTISTALBUM_FONT_SIZE * 0.9), 
+		s.nowplaying_large_art = _uses(s.nowplaying, {
+			bgImg = blackBackground,
+			title = {
+				bgImg = false,
+				text = {
+					border = { screenHeight - 72, 0, 0, 0 },
+					padding = { 10, 12, 10, 15 },
+					font = _boldfont(24),
+				},
+				button_back = {
+					bgImg = false
+				}
 			},
-		},
-		npartistgroup = {
-			x = npX,
-			npartist = {
-				font = _font(NP_ARTISTALBUM_FONT_SIZE * 0.9),
-				w = screenWidth - npX - 10,
-			} 
-		},
-		npalbumgroup = {
-			x = npX,
-			npalbum = {
-				font = _font(NP_ARTISTALBUM_FONT_SIZE * 0.9),
-				w = screenWidth - npX - 10,
-			} 
-		},
-		npcontrols = {
-			order = buttonOrder,
-			x = screenHeight,
-		},
-		npprogress = {
-			x = npX,
-			elapsed = {
-				w = 60,
+			nptitle = {
+				x = npX,
+				nptrack = {
+					w = screenWidth - npX - 10,
+					font = _boldfont(NP_ARTISTALBUM_FONT_SIZE * 0.9), 
+				},
 			},
-			remain = {
-				w = 60,
+			npartistgroup = {
+				x = npX,
+				npartist = {
+					font = _font(NP_ARTISTALBUM_FONT_SIZE * 0.9),
+					w = screenWidth - npX - 10,
+				} 
+			},
+			npalbumgroup = {
+				x = npX,
+				npalbum = {
+					font = _font(NP_ARTISTALBUM_FONT_SIZE * 0.9),
+					w = screenWidth - npX - 10,
+				} 
+			},
+			npcontrols = {
+				order = buttonOrder,
+				x = screenHeight,
+			},
+			npprogress = {
+				x = npX,
+				elapsed = {
+					w = 60,
+				},
+				remain = {
+					w = 60,
+				},
+				npprogressB = {
+					w = screenWidth - npX - 2*60 - 15,
+				},
 			},
-			npprogressB = {
-				w = screenWidth - npX - 2*60 - 15,
+			npprogressNB = {
+				x = npX,
 			},
-		},
-		npprogressNB = {
-			x = npX,
-		},
-		npartwork = {
-			w = screenHeight,
-			x = 0,
-			y = 0,
-			align = "center",
-			h = WH_FILL,
-			artwork = {
-				w = WH_FILL,
+			npartwork = {
+				w = screenHeight,
+				x = 0,
+				y = 0,
+				align = "center",
 				h = WH_FILL,
-				align = "left",
-				padding = 0,
-				img = false,
+				artwork = {
+					w = WH_FILL,
+					h = WH_FILL,
+					align = "left",
+					padding = 0,
+					img = false,
+				},
 			},
-		},
 
-		npvisu = { hidden = 1 },
-	})
+			npvisu = { hidden = 1 },
+		})
 
-	s.nowplaying_large_art.pressed = s.nowplaying_large_art
+		s.nowplaying_large_art.pressed = s.nowplaying_large_art
 
-	-- if we have more than four buttons, then make them smaller
-	if (smallTbButtons) then
-		local smallControlWidth = controlWidth - 14
-		s.nowplaying_large_art.npcontrols.rew = _uses(s.nowplaying.npcontrols.rew, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.play = _uses(s.nowplaying.npcontrols.play, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.pause = _uses(s.nowplaying.npcontrols.pause, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.fwd = _uses(s.nowplaying.npcontrols.fwd, { w = smallControlWidth })
+		-- if we have more than four buttons, then make them smaller
+		if (smallTbButtons) then
+			local smallControlWidth = controlWidth - 14
+			s.nowplaying_large_art.npcontrols.rew = _uses(s.nowplaying.npcontrols.rew, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.play = _uses(s.nowplaying.npcontrols.play, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.pause = _uses(s.nowplaying.npcontrols.pause, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.fwd = _uses(s.nowplaying.npcontrols.fwd, { w = smallControlWidth })
 		
-		s.nowplaying_large_art.npcontrols.repeatMode = _uses(s.nowplaying.npcontrols.repeatMode, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.repeatOff = _uses(s.nowplaying.npcontrols.repeatOff, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.repeatSong = _uses(s.nowplaying.npcontrols.repeatSong, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.repeatPlaylist = _uses(s.nowplaying.npcontrols.repeatPlaylist, { w = smallControlWidth })
-
-		s.nowplaying_large_art.npcontrols.shuffleMode = _uses(s.nowplaying.npcontrols.shuffleMode, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.shuffleOff = _uses(s.nowplaying.npcontrols.shuffleOff, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.shuffleSong = _uses(s.nowplaying.npcontrols.shuffleSong, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.shuffleAlbum = _uses(s.nowplaying.npcontrols.shuffleAlbum, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.repeatMode = _uses(s.nowplaying.npcontrols.repeatMode, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.repeatOff = _uses(s.nowplaying.npcontrols.repeatOff, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.repeatSong = _uses(s.nowplaying.npcontrols.repeatSong, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.repeatPlaylist = _uses(s.nowplaying.npcontrols.repeatPlaylist, { w = smallControlWidth })
+
+			s.nowplaying_large_art.npcontrols.shuffleMode = _uses(s.nowplaying.npcontrols.shuffleMode, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.shuffleOff = _uses(s.nowplaying.npcontrols.shuffleOff, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.shuffleSong = _uses(s.nowplaying.npcontrols.shuffleSong, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.shuffleAlbum = _uses(s.nowplaying.npcontrols.shuffleAlbum, { w = smallControlWidth })
 		
-		s.nowplaying_large_art.npcontrols.volDown = _uses(s.nowplaying.npcontrols.volDown, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.volUp = _uses(s.nowplaying.npcontrols.volUp, { w = smallControlWidth })
-
-		s.nowplaying_large_art.npcontrols.thumbsUp = _uses(s.nowplaying.npcontrols.thumbsUp, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.thumbsDown = _uses(s.nowplaying.npcontrols.thumbsDown, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.thumbsUpDisabled = _uses(s.nowplaying.npcontrols.thumbsUpDisabled, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.thumbsDownDisabled = _uses(s.nowplaying.npcontrols.thumbsDownDisabled, { w = smallControlWidth })
-
-		s.nowplaying_large_art.npcontrols.love = _uses(s.nowplaying.npcontrols.love, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.hate = _uses(s.nowplaying.npcontrols.hate, { w = smallControlWidth })
-
-		s.nowplaying_large_art.npcontrols.fwdDisabled = _uses(s.nowplaying.npcontrols.fwdDisabled, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.rewDisabled = _uses(s.nowplaying.npcontrols.rewDisabled, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.shuffleDisabled = _uses(s.nowplaying.npcontrols.shuffleDisabled, { w = smallControlWidth })
-		s.nowplaying_large_art.npcontrols.repeatDisabled = _uses(s.nowplaying.npcontrols.repeatDisabled, { w = smallControlWidth })
-	else
-		s.nowplaying_large_art.npcontrols.div1 = _uses(_transportControlBorder, {
-			w = 6,
-			padding = { 2, 0, 2, 0 }
-		})
+			s.nowplaying_large_art.npcontrols.volDown = _uses(s.nowplaying.npcontrols.volDown, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.volUp = _uses(s.nowplaying.npcontrols.volUp, { w = smallControlWidth })
 
-		s.nowplaying_large_art.npcontrols.div2 = _uses(s.nowplaying_large_art.npcontrols.div1)
-		s.nowplaying_large_art.npcontrols.div3 = _uses(s.nowplaying_large_art.npcontrols.div1)
-		s.nowplaying_large_art.npcontrols.div4 = _uses(s.nowplaying_large_art.npcontrols.div1)
-		s.nowplaying_large_art.npcontrols.div5 = _uses(s.nowplaying_large_art.npcontrols.div1)
-		s.nowplaying_large_art.npcontrols.div6 = _uses(s.nowplaying_large_art.npcontrols.div1)
-	end
+			s.nowplaying_large_art.npcontrols.thumbsUp = _uses(s.nowplaying.npcontrols.thumbsUp, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.thumbsDown = _uses(s.nowplaying.npcontrols.thumbsDown, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.thumbsUpDisabled = _uses(s.nowplaying.npcontrols.thumbsUpDisabled, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.thumbsDownDisabled = _uses(s.nowplaying.npcontrols.thumbsDownDisabled, { w = smallControlWidth })
 
-	s.nowplaying_large_art.npcontrols.pressed = {
-		rew     = _uses(s.nowplaying_large_art.npcontrols.rew, { bgImg = keyMiddlePressed }),
-		play    = _uses(s.nowplaying_large_art.npcontrols.play, { bgImg = keyMiddlePressed }),
-		pause   = _uses(s.nowplaying_large_art.npcontrols.pause, { bgImg = keyMiddlePressed }),
-		fwd     = _uses(s.nowplaying_large_art.npcontrols.fwd, { bgImg = keyMiddlePressed }),
-		repeatPlaylist  = _uses(s.nowplaying_large_art.npcontrols.repeatPlaylist, { bgImg = keyMiddlePressed }),
-		repeatSong      = _uses(s.nowplaying_large_art.npcontrols.repeatSong, { bgImg = keyMiddlePressed }),
-		repeatOff       = _uses(s.nowplaying_large_art.npcontrols.repeatOff, { bgImg = keyMiddlePressed }),
-		repeatMode      = _uses(s.nowplaying_large_art.npcontrols.repeatMode, { bgImg = keyMiddlePressed }),
-		shuffleAlbum    = _uses(s.nowplaying_large_art.npcontrols.shuffleAlbum, { bgImg = keyMiddlePressed }),
-		shuffleSong     = _uses(s.nowplaying_large_art.npcontrols.shuffleSong, { bgImg = keyMiddlePressed }),
-		shuffleMode      = _uses(s.nowplaying_large_art.npcontrols.shuffleMode, { bgImg = keyMiddlePressed }),
-		shuffleOff      = _uses(s.nowplaying_large_art.npcontrols.shuffleOff, { bgImg = keyMiddlePressed }),
-		volDown = _uses(s.nowplaying_large_art.npcontrols.volDown, { bgImg = keyMiddlePressed }),
-		volUp   = _uses(s.nowplaying_large_art.npcontrols.volUp, { bgImg = keyMiddlePressed }),
-
-		thumbsUp    = _uses(s.nowplaying_large_art.npcontrols.thumbsUp, { bgImg = keyMiddlePressed }),
-		thumbsDown  = _uses(s.nowplaying_large_art.npcontrols.thumbsDown, { bgImg = keyMiddlePressed }),
-		thumbsUpDisabled    = s.nowplaying_large_art.npcontrols.thumbsUpDisabled,
-		thumbsDownDisabled  = s.nowplaying_large_art.npcontrols.thumbsDownDisabled,
-		love        = _uses(s.nowplaying_large_art.npcontrols.love, { bgImg = keyMiddlePressed }),
-		hate        = _uses(s.nowplaying_large_art.npcontrols.hate, { bgImg = keyMiddlePressed }),
-		fwdDisabled = _uses(s.nowplaying_large_art.npcontrols.fwdDisabled),
-		rewDisabled = _uses(s.nowplaying_large_art.npcontrols.rewDisabled),
-		shuffleDisabled = _uses(s.nowplaying_large_art.npcontrols.shuffleDisabled),
-		repeatDisabled = _uses(s.nowplaying_large_art.npcontrols.repeatDisabled),
-	}
-
-	s.nowplaying_large_art.nptitle.pressed = _uses(s.nowplaying_large_art.nptitle)
-	s.nowplaying_large_art.npalbumgroup.pressed = _uses(s.nowplaying_large_art.npalbumgroup)
-	s.nowplaying_large_art.npartistgroup.pressed = _uses(s.nowplaying_large_art.npartistgroup)
-	s.nowplaying_large_art.title.pressed = _uses(s.nowplaying_large_art.title, {
-		text = {
-			fg = { 0xB3, 0xB3, 0xB3 },
-			sh = { },
-			bgImg = pressedTitlebarButtonBox,
+			s.nowplaying_large_art.npcontrols.love = _uses(s.nowplaying.npcontrols.love, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.hate = _uses(s.nowplaying.npcontrols.hate, { w = smallControlWidth })
+
+			s.nowplaying_large_art.npcontrols.fwdDisabled = _uses(s.nowplaying.npcontrols.fwdDisabled, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.rewDisabled = _uses(s.nowplaying.npcontrols.rewDisabled, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.shuffleDisabled = _uses(s.nowplaying.npcontrols.shuffleDisabled, { w = smallControlWidth })
+			s.nowplaying_large_art.npcontrols.repeatDisabled = _uses(s.nowplaying.npcontrols.repeatDisabled, { w = smallControlWidth })
+		else
+			s.nowplaying_large_art.npcontrols.div1 = _uses(_transportControlBorder, {
+				w = 6,
+				padding = { 2, 0, 2, 0 }
+			})
+
+			s.nowplaying_large_art.npcontrols.div2 = _uses(s.nowplaying_large_art.npcontrols.div1)
+			s.nowplaying_large_art.npcontrols.div3 = _uses(s.nowplaying_large_art.npcontrols.div1)
+			s.nowplaying_large_art.npcontrols.div4 = _uses(s.nowplaying_large_art.npcontrols.div1)
+			s.nowplaying_large_art.npcontrols.div5 = _uses(s.nowplaying_large_art.npcontrols.div1)
+			s.nowplaying_large_art.npcontrols.div6 = _uses(s.nowplaying_large_art.npcontrols.div1)
+		end
+
+		s.nowplaying_large_art.npcontrols.pressed = {
+			rew     = _uses(s.nowplaying_large_art.npcontrols.rew, { bgImg = keyMiddlePressed }),
+			play    = _uses(s.nowplaying_large_art.npcontrols.play, { bgImg = keyMiddlePressed }),
+			pause   = _uses(s.nowplaying_large_art.npcontrols.pause, { bgImg = keyMiddlePressed }),
+			fwd     = _uses(s.nowplaying_large_art.npcontrols.fwd, { bgImg = keyMiddlePressed }),
+			repeatPlaylist  = _uses(s.nowplaying_large_art.npcontrols.repeatPlaylist, { bgImg = keyMiddlePressed }),
+			repeatSong      = _uses(s.nowplaying_large_art.npcontrols.repeatSong, { bgImg = keyMiddlePressed }),
+			repeatOff       = _uses(s.nowplaying_large_art.npcontrols.repeatOff, { bgImg = keyMiddlePressed }),
+			repeatMode      = _uses(s.nowplaying_large_art.npcontrols.repeatMode, { bgImg = keyMiddlePressed }),
+			shuffleAlbum    = _uses(s.nowplaying_large_art.npcontrols.shuffleAlbum, { bgImg = keyMiddlePressed }),
+			shuffleSong     = _uses(s.nowplaying_large_art.npcontrols.shuffleSong, { bgImg = keyMiddlePressed }),
+			shuffleMode      = _uses(s.nowplaying_large_art.npcontrols.shuffleMode, { bgImg = keyMiddlePressed }),
+			shuffleOff      = _uses(s.nowplaying_large_art.npcontrols.shuffleOff, { bgImg = keyMiddlePressed }),
+			volDown = _uses(s.nowplaying_large_art.npcontrols.volDown, { bgImg = keyMiddlePressed }),
+			volUp   = _uses(s.nowplaying_large_art.npcontrols.volUp, { bgImg = keyMiddlePressed }),
+
+			thumbsUp    = _uses(s.nowplaying_large_art.npcontrols.thumbsUp, { bgImg = keyMiddlePressed }),
+			thumbsDown  = _uses(s.nowplaying_large_art.npcontrols.thumbsDown, { bgImg = keyMiddlePressed }),
+			thumbsUpDisabled    = s.nowplaying_large_art.npcontrols.thumbsUpDisabled,
+			thumbsDownDisabled  = s.nowplaying_large_art.npcontrols.thumbsDownDisabled,
+			love        = _uses(s.nowplaying_large_art.npcontrols.love, { bgImg = keyMiddlePressed }),
+			hate        = _uses(s.nowplaying_large_art.npcontrols.hate, { bgImg = keyMiddlePressed }),
+			fwdDisabled = _uses(s.nowplaying_large_art.npcontrols.fwdDisabled),
+			rewDisabled = _uses(s.nowplaying_large_art.npcontrols.rewDisabled),
+			shuffleDisabled = _uses(s.nowplaying_large_art.npcontrols.shuffleDisabled),
+			repeatDisabled = _uses(s.nowplaying_large_art.npcontrols.repeatDisabled),
 		}
-	})
-	s.nowplaying_large_art.npprogress.npprogressB_disabled = _uses(s.nowplaying_large_art.npprogress.npprogressB, {
-		img = _songProgressBarDisabled,
-	})
+
+		s.nowplaying_large_art.nptitle.pressed = _uses(s.nowplaying_large_art.nptitle)
+		s.nowplaying_large_art.npalbumgroup.pressed = _uses(s.nowplaying_large_art.npalbumgroup)
+		s.nowplaying_large_art.npartistgroup.pressed = _uses(s.nowplaying_large_art.npartistgroup)
+		s.nowplaying_large_art.title.pressed = _uses(s.nowplaying_large_art.title, {
+			text = {
+				fg = { 0xB3, 0xB3, 0xB3 },
+				sh = { },
+				bgImg = pressedTitlebarButtonBox,
+			}
+		})
+		s.nowplaying_large_art.npprogress.npprogressB_disabled = _uses(s.nowplaying_large_art.npprogress.npprogressB, {
+			img = _songProgressBarDisabled,
+		})
 	
-	s.nowplaying_art_only = _uses(s.nowplaying, {
-
-		bgImg            = blackBackground,
-		title            = { hidden = 1 },
-		nptitle          = { hidden = 1 },
-		npcontrols       = { hidden = 1 },
-		npprogress       = { hidden = 1 },
-		npprogressNB     = { hidden = 1 },
-		npartistgroup    = { hidden = 1 },
-		npalbumgroup     = { hidden = 1 },
-		npartwork = {
-			w = screenHeight,
-			position = LAYOUT_NONE,
-			x = (screenWidth - screenHeight) / 2,
-			y = 0,
-			align = "center",
-			h = screenHeight,
-			artwork = {
+		s.nowplaying_art_only = _uses(s.nowplaying, {
+
+			bgImg            = blackBackground,
+			title            = { hidden = 1 },
+			nptitle          = { hidden = 1 },
+			npcontrols       = { hidden = 1 },
+			npprogress       = { hidden = 1 },
+			npprogressNB     = { hidden = 1 },
+			npartistgroup    = { hidden = 1 },
+			npalbumgroup     = { hidden = 1 },
+			npartwork = {
 				w = screenHeight,
+				position = LAYOUT_NONE,
+				x = (screenWidth - screenHeight) / 2,
+				y = 0,
 				align = "center",
-				padding = 0,
-				img = false,
+				h = screenHeight,
+				artwork = {
+					w = screenHeight,
+					align = "center",
+					padding = 0,
+					img = false,
+				},
 			},
-		},
-
-		npvisu = { hidden = 1 },
-
-	})
-	s.nowplaying_art_only.pressed = s.nowplaying_art_only
 
-	s.nowplaying_text_only = _uses(s.nowplaying, {
-		nptitle          = { 
-                        x          = 40,
-                        y          = TITLE_HEIGHT + 50,
-                        nptrack =  {
-                                w          = screenWidth - 140,
-                        },
-		},
-		npartistgroup    = { 
-                        x          = 40,
-                        y          = TITLE_HEIGHT + 50 + 65,
-                        npartist =  {
-                                w          = screenWidth - 65,
-                        },
-		},
-		npalbumgroup     = { 
-                        x          = 40,
-                        y          = TITLE_HEIGHT + 50 + 60 + 55,
-                        npalbum =  {
-                                w          = screenWidth - 65,
-                        },
-		},
-		npartwork = { hidden = 1 },
+			npvisu = { hidden = 1 },
 
-		npvisu = { hidden = 1 },
+		})
+		s.nowplaying_art_only.pressed = s.nowplaying_art_only
+
+		s.nowplaying_text_only = _uses(s.nowplaying, {
+			nptitle          = { 
+	                        x          = 40,
+	                        y          = TITLE_HEIGHT + 50,
+	                        nptrack =  {
+	                                w          = screenWidth - 140,
+	                        },
+			},
+			npartistgroup    = { 
+	                        x          = 40,
+	                        y          = TITLE_HEIGHT + 50 + 65,
+	                        npartist =  {
+	                                w          = screenWidth - 65,
+	                        },
+			},
+			npalbumgroup     = { 
+	                        x          = 40,
+	                        y          = TITLE_HEIGHT + 50 + 60 + 55,
+	                        npalbum =  {
+	                                w          = screenWidth - 65,
+	                        },
+			},
+			npartwork = { hidden = 1 },
+
+			npvisu = { hidden = 1 },
 		
-		npprogress = {
-			position = LAYOUT_NONE,
-			x = 50,
-			y = screenHeight - 160,
-			padding = { 0, 10, 0, 0 },
-			elapsed = {
-				w = 60,
-				align = 'left',
-				padding = { 0, 0, 4, 20 },
-				font = _boldfont(18),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			remain = {
-				w = 60,
-				align = 'right',
-				padding = { 4, 0, 0, 20 },
-				font = _boldfont(18),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			elapsedSmall = {
-				w = 60,
-				align = 'left',
-				padding = { 0, 0, 4, 20 },
-				font = _boldfont(14),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			remainSmall = {
-				w = 60,
-				align = 'right',
-				padding = { 4, 0, 0, 20 },
-				font = _boldfont(14),
-				fg = { 0xe7,0xe7, 0xe7 },
-				sh = { 0x37, 0x37, 0x37 },
-			},
-			npprogressB = {
-				w = screenWidth - 2*50 - 2*80,
-				h = 50,
+			npprogress = {
+				position = LAYOUT_NONE,
+				x = 50,
+				y = screenHeight - 160,
+				padding = { 0, 10, 0, 0 },
+				elapsed = {
+					w = 60,
+					align = 'left',
+					padding = { 0, 0, 4, 20 },
+					font = _boldfont(18),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				remain = {
+					w = 60,
+					align = 'right',
+					padding = { 4, 0, 0, 20 },
+					font = _boldfont(18),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				elapsedSmall = {
+					w = 60,
+					align = 'left',
+					padding = { 0, 0, 4, 20 },
+					font = _boldfont(14),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				remainSmall = {
+					w = 60,
+					align = 'right',
+					padding = { 4, 0, 0, 20 },
+					font = _boldfont(14),
+					fg = { 0xe7,0xe7, 0xe7 },
+					sh = { 0x37, 0x37, 0x37 },
+				},
+				npprogressB = {
+					w = screenWidth - 2*50 - 2*80,
+					h = 50,
+					padding = { 0, 0, 0, 0 },
+			                position = LAYOUT_SOUTH,
+					horizontal = 1,
+					bgImg = _songProgressBackground,
+					img = _songProgressBar,
+				},
+			},
+			npprogressNB = {
+				x = 720,
+				y = TITLE_HEIGHT + 55,
 				padding = { 0, 0, 0, 0 },
-		                position = LAYOUT_SOUTH,
-				horizontal = 1,
-				bgImg = _songProgressBackground,
-				img = _songProgressBar,
+				position = LAYOUT_NONE,
 			},
-		},
-		npprogressNB = {
-			x = 720,
-			y = TITLE_HEIGHT + 55,
-			padding = { 0, 0, 0, 0 },
-			position = LAYOUT_NONE,
-		},
-	})
-	s.nowplaying_text_only.npprogress.npprogressB_disabled = _uses(s.nowplaying_text_only.npprogress.npprogressB, {
-		img = _songProgressBarDisabled,
-	})
-	s.nowplaying_text_only.pressed = s.nowplaying_text_only
-	s.nowplaying_text_only.nptitle.pressed = _uses(s.nowplaying_text_only.nptitle)
-	s.nowplaying_text_only.npalbumgroup.pressed = _uses(s.nowplaying_text_only.npalbumgroup)
-	s.nowplaying_text_only.npartistgroup.pressed = _uses(s.nowplaying_text_only.npartistgroup)
-
-	-- Visualizer: Container with titlebar, progressbar and controls.
-	--  The space between title and controls is used for the visualizer.
-	s.nowplaying_visualizer_common = _uses(s.nowplaying, {
-		bgImg = blackBackground,
-
-		npartistgroup = { hidden = 1 },
-		npalbumgroup = { hidden = 1 },
-		npartwork = { hidden = 1 },
+		})
+		s.nowplaying_text_only.npprogress.npprogressB_disabled = _uses(s.nowplaying_text_only.npprogress.npprogressB, {
+			img = _songProgressBarDisabled,
+		})
+		s.nowplaying_text_only.pressed = s.nowplaying_text_only
+		s.nowplaying_text_only.nptitle.pressed = _uses(s.nowplaying_text_only.nptitle)
+		s.nowplaying_text_only.npalbumgroup.pressed = _uses(s.nowplaying_text_only.npalbumgroup)
+		s.nowplaying_text_only.npartistgroup.pressed = _uses(s.nowplaying_text_only.npartistgroup)
+
+		-- Visualizer: Container with titlebar, progressbar and controls.
+		--  The space between title and controls is used for the visualizer.
+		s.nowplaying_visualizer_common = _uses(s.nowplaying, {
+			bgImg = blackBackground,
+
+			npartistgroup = { hidden = 1 },
+			npalbumgroup = { hidden = 1 },
+			npartwork = { hidden = 1 },
+
+			title = _uses(s.title, {
+				zOrder = 1,
+				h = TITLE_HEIGHT,
+				text = {
+					-- Hack: text needs to be there to fill the space, but is not visible
+					padding = { screenWidth, 0, 0, 0 }
+				},
+			}),
 
-		title = _uses(s.title, {
-			zOrder = 1,
-			h = TITLE_HEIGHT,
-			text = {
-				-- Hack: text needs to be there to fill the space, but is not visible
-				padding = { screenWidth, 0, 0, 0 }
+			-- Drawn over regular text between buttons
+			nptitle = { 
+				zOrder = 2,
+				position = LAYOUT_NONE,
+				x = 80,
+				y = 0,
+				h = TITLE_HEIGHT,
+				border = { 0, 0 ,0, 0 },
+				padding = { 20, 14, 5, 5 },
+				nptrack = {
+					align = "center",
+					w = screenWidth - 196,
+				},
 			},
-		}),
 
-		-- Drawn over regular text between buttons
-		nptitle = { 
-			zOrder = 2,
-			position = LAYOUT_NONE,
-			x = 80,
-			y = 0,
-			h = TITLE_HEIGHT,
-			border = { 0, 0 ,0, 0 },
-			padding = { 20, 14, 5, 5 },
-			nptrack = {
+			npartistalbum = {
+				hidden = 0,
+				zOrder = 2,
+				position = LAYOUT_NONE,
+				x = 0,
+				y = TITLE_HEIGHT,
+				w = screenWidth,
+				h = 60,
+				bgImg = titleBox,
 				align = "center",
-				w = screenWidth - 196,
+				fg = { 0xb3, 0xb3, 0xb3 },
+				padding = { 100, 0, 100, 5 },
+				font = _font(NP_ARTISTALBUM_FONT_SIZE),
 			},
-		},
-
-		npartistalbum = {
-			hidden = 0,
-			zOrder = 2,
-			position = LAYOUT_NONE,
-			x = 0,
-			y = TITLE_HEIGHT,
-			w = screenWidth,
-			h = 60,
-			bgImg = titleBox,
-			align = "center",
-			fg = { 0xb3, 0xb3, 0xb3 },
-			padding = { 100, 0, 100, 5 },
-			font = _font(NP_ARTISTALBUM_FONT_SIZE),
-		},
 
-		npprogress = {
-			zOrder = 3,
-			position = LAYOUT_NONE,
-			x = 10,
-			y = TITLE_HEIGHT + 20,
-			h = 60,
-			w = screenWidth - 30,
-			elapsed = {
-				w = 60,
-			},
-			remain = {
-				w = 60,
-			},
-			elapsedSmall = {
-				w = 60,
-			},
-			remainSmall = {
-				w = 60,
-			},
-			npprogressB = {
-				h = 29,
-				w = WH_FILL,
-				zOrder = 10,
-				padding = { 0, 19, 0, 15 },
-				horizontal = 1,
-				bgImg = false,
-				img = _vizProgressBar,
-                		pillImg = _vizProgressBarPill,
+			npprogress = {
+				zOrder = 3,
+				position = LAYOUT_NONE,
+				x = 10,
+				y = TITLE_HEIGHT + 20,
+				h = 60,
+				w = screenWidth - 30,
+				elapsed = {
+					w = 60,
+				},
+				remain = {
+					w = 60,
+				},
+				elapsedSmall = {
+					w = 60,
+				},
+				remainSmall = {
+					w = 60,
+				},
+				npprogressB = {
+					h = 29,
+					w = WH_FILL,
+					zOrder = 10,
+					padding = { 0, 19, 0, 15 },
+					horizontal = 1,
+					bgImg = false,
+					img = _vizProgressBar,
+	                		pillImg = _vizProgressBarPill,
+				},
 			},
-		},
 
-		npprogressNB = {
-			x = screenWidth - 80,
-			y = TITLE_HEIGHT + 22,
-			h = 38,
-		},
-	})
-	s.nowplaying_visualizer_common.npprogress.npprogressB_disabled = s.nowplaying_visualizer_common.npprogress.npprogressB
-
-	-- Visualizer: Spectrum Visualizer
-	s.nowplaying_spectrum_text = _uses(s.nowplaying_visualizer_common, {
-		npvisu = {
-			hidden = 0,
-			position = LAYOUT_NONE,
-			x = 0,
-			y = 2 * TITLE_HEIGHT + 4,
-			w = 800,
-			h = 446 - (2 * TITLE_HEIGHT + 4 + 45),
-			border = { 0, 0, 0, 0 },
-			padding = { 0, 0, 0, 0 },
+			npprogressNB = {
+				x = screenWidth - 80,
+				y = TITLE_HEIGHT + 22,
+				h = 38,
+			},
+		})
+		s.nowplaying_visualizer_common.npprogress.npprogressB_disabled = s.nowplaying_visualizer_common.npprogress.npprogressB
 
-			spectrum = {
+		-- Visualizer: Spectrum Visualizer
+		s.nowplaying_spectrum_text = _uses(s.nowplaying_visualizer_common, {
+			npvisu = {
+				hidden = 0,
 				position = LAYOUT_NONE,
 				x = 0,
 				y = 2 * TITLE_HEIGHT + 4,
@@ -3563,46 +3462,80 @@ function skin(self, s, reload, useDefaultSize, w, h)
 				border = { 0, 0, 0, 0 },
 				padding = { 0, 0, 0, 0 },
 
-				bg = { 0x00, 0x00, 0x00, 0x00 },
+				spectrum = {
+					position = LAYOUT_NONE,
+					x = 0,
+					y = 2 * TITLE_HEIGHT + 4,
+					w = 800,
+					h = 446 - (2 * TITLE_HEIGHT + 4 + 45),
+					border = { 0, 0, 0, 0 },
+					padding = { 0, 0, 0, 0 },
+
+					bg = { 0x00, 0x00, 0x00, 0x00 },
+
+					barColor = { 0x14, 0xbc, 0xbc, 0xff },
+					capColor = { 0x74, 0x56, 0xa1, 0xff },
+
+					isMono = 0,				-- 0 / 1
+
+					capHeight = { 4, 4 },			-- >= 0
+					capSpace = { 4, 4 },			-- >= 0
+					channelFlipped = { 0, 1 },		-- 0 / 1
+					barsInBin = { 2, 2 },			-- > 1
+					barWidth = { 1, 1 },			-- > 1
+					barSpace = { 3, 3 },			-- >= 0
+					binSpace = { 6, 6 },			-- >= 0
+					clipSubbands = { 1, 1 },		-- 0 / 1
+				}
+			},
+		})
+		s.nowplaying_spectrum_text.pressed = s.nowplaying_spectrum_text
 
-				barColor = { 0x14, 0xbc, 0xbc, 0xff },
-				capColor = { 0x74, 0x56, 0xa1, 0xff },
+		s.nowplaying_spectrum_text.title.pressed = _uses(s.nowplaying_spectrum_text.title, {
+			text = {
+				-- Hack: text needs to be there to fill the space, not visible
+				padding = { screenWidth, 0, 0, 0 }
+			},
+		})
 
-				isMono = 0,				-- 0 / 1
+		-- Visualizer: Waterfall
+		s.nowplaying_waterfall_text = _uses(s.nowplaying_visualizer_common, {
+			npvisu = {
+				hidden = 0,
+				position = LAYOUT_NONE,
+				x = 0,
+				y = 2 * TITLE_HEIGHT + 4,
+				w = 800,
+				h = 446 - (2 * TITLE_HEIGHT + 4 + 45),
+				border = { 0, 0, 0, 0 },
+				padding = { 0, 0, 0, 0 },
 
-				capHeight = { 4, 4 },			-- >= 0
-				capSpace = { 4, 4 },			-- >= 0
-				channelFlipped = { 0, 1 },		-- 0 / 1
-				barsInBin = { 2, 2 },			-- > 1
-				barWidth = { 1, 1 },			-- > 1
-				barSpace = { 3, 3 },			-- >= 0
-				binSpace = { 6, 6 },			-- >= 0
-				clipSubbands = { 1, 1 },		-- 0 / 1
-			}
-		},
-	})
-	s.nowplaying_spectrum_text.pressed = s.nowplaying_spectrum_text
+				waterfall = {
+					position = LAYOUT_NONE,
+					x = 0,
+					y = 2 * TITLE_HEIGHT + 4,
+					w = 800,
+					h = 446 - (2 * TITLE_HEIGHT + 4 + 45),
+					border = { 0, 0, 0, 0 },
+					padding = { 0, 0, 0, 0 },
 
-	s.nowplaying_spectrum_text.title.pressed = _uses(s.nowplaying_spectrum_text.title, {
-		text = {
-			-- Hack: text needs to be there to fill the space, not visible
-			padding = { screenWidth, 0, 0, 0 }
-		},
-	})
+					colormap = "heat",			-- heat / ice / gray
+				}
+			},
+		})
+		s.nowplaying_waterfall_text.pressed = s.nowplaying_waterfall_text
 
-	-- Visualizer: Analog VU Meter
-	s.nowplaying_vuanalog_text = _uses(s.nowplaying_visualizer_common, {
-		npvisu = {
-			hidden = 0,
-			position = LAYOUT_NONE,
-			x = 0,
-			y = TITLE_HEIGHT + 63,
-			w = 800,
-			h = 413 - (TITLE_HEIGHT + 38 + 38),
-			border = { 0, 0, 0, 0 },
-			padding = { 0, 0, 0, 0 },
+		s.nowplaying_waterfall_text.title.pressed = _uses(s.nowplaying_waterfall_text.title, {
+			text = {
+				-- Hack: text needs to be there to fill the space, not visible
+				padding = { screenWidth, 0, 0, 0 }
+			},
+		})
 
-			vumeter_analog = {
+		-- Visualizer: Analog VU Meter
+		s.nowplaying_vuanalog_text = _uses(s.nowplaying_visualizer_common, {
+			npvisu = {
+				hidden = 0,
 				position = LAYOUT_NONE,
 				x = 0,
 				y = TITLE_HEIGHT + 63,
@@ -3610,18 +3543,28 @@ function skin(self, s, reload, useDefaultSize, w, h)
 				h = 413 - (TITLE_HEIGHT + 38 + 38),
 				border = { 0, 0, 0, 0 },
 				padding = { 0, 0, 0, 0 },
-				bgImg = _loadImage(self, "UNOFFICIAL/VUMeter/vu_analog_25seq_w.png"),
-			}
-		},
-	})
-	s.nowplaying_vuanalog_text.pressed = s.nowplaying_vuanalog_text
 
-	s.nowplaying_vuanalog_text.title.pressed = _uses(s.nowplaying_vuanalog_text.title, {
-		text = {
-			-- Hack: text needs to be there to fill the space, not visible
-			padding = { screenWidth, 0, 0, 0 }
-		},
-	})
+				vumeter_analog = {
+					position = LAYOUT_NONE,
+					x = 0,
+					y = TITLE_HEIGHT + 63,
+					w = 800,
+					h = 413 - (TITLE_HEIGHT + 38 + 38),
+					border = { 0, 0, 0, 0 },
+					padding = { 0, 0, 0, 0 },
+					bgImg = _loadImage(self, "UNOFFICIAL/VUMeter/vu_analog_25seq_w.png"),
+				}
+			},
+		})
+		s.nowplaying_vuanalog_text.pressed = s.nowplaying_vuanalog_text
+
+		s.nowplaying_vuanalog_text.title.pressed = _uses(s.nowplaying_vuanalog_text.title, {
+			text = {
+				-- Hack: text needs to be there to fill the space, not visible
+				padding = { screenWidth, 0, 0, 0 }
+			},
+		})
+	end)
 
 	s.brightness_group = {
 		order = {  'down', 'div1', 'slider', 'div2', 'up' },
@@ -3796,8 +3739,10 @@ function skin1024x600(self, s, reload, useDefaultSize)
 	self:skin(s, reload, useDefaultSize, 1024, 600)
 
 	-- put a space between volume controls and other buttons	
-	s.nowplaying.npcontrols.div5.w = 230
-	s.nowplaying.npcontrols.div5.img = false
+	lazystyle.extend(s, "nowplaying", function(s)
+		s.nowplaying.npcontrols.div5.w = 230
+		s.nowplaying.npcontrols.div5.img = false
+	end)
 	
 	return s
 end
@@ -3807,17 +3752,19 @@ function skin1280x800(self, s, reload, useDefaultSize, w, h)
 	
 	local c = s.CONSTANTS
 
-	s.nowplaying.nptitle.nptrack.font = _boldfont(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
-	s.nowplaying.npartistgroup.npartist.font = _font(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
-	s.nowplaying.npalbumgroup.npalbum.font = _font(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
+	lazystyle.extend(s, "nowplaying", function(s)
+		s.nowplaying.nptitle.nptrack.font = _boldfont(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
+		s.nowplaying.npartistgroup.npartist.font = _font(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
+		s.nowplaying.npalbumgroup.npalbum.font = _font(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
 
-	s.nowplaying_large_art.nptitle.nptrack.font = _boldfont(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
-	s.nowplaying_large_art.npartistgroup.npartist.font = _font(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
-	s.nowplaying_large_art.npalbumgroup.npalbum.font = _font(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
+		s.nowplaying_large_art.nptitle.nptrack.font = _boldfont(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
+		s.nowplaying_large_art.npartistgroup.npartist.font = _font(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
+		s.nowplaying_large_art.npalbumgroup.npalbum.font = _font(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
 
-	-- put a space between volume controls and other buttons	
-	s.nowplaying.npcontrols.div5.w = 490
-	s.nowplaying.npcontrols.div5.img = false
+		-- put a space between volume controls and other buttons	
+		s.nowplaying.npcontrols.div5.w = 490
+		s.nowplaying.npcontrols.div5.img = false
+	end)
 
 	return s
 end
@@ -3826,8 +3773,10 @@ function skin1366x768(self, s, reload, useDefaultSize)
 	self:skin(s, reload, useDefaultSize, 1366, 768)
 
 	-- put a space between volume controls and other buttons	
-	s.nowplaying.npcontrols.div5.w = 568
-	s.nowplaying.npcontrols.div5.img = false
+	lazystyle.extend(s, "nowplaying", function(s)
+		s.nowplaying.npcontrols.div5.w = 568
+		s.nowplaying.npcontrols.div5.img = false
+	end)
 
 	return s
 end
@@ -3853,18 +3802,20 @@ function skinCustom(self, s, reload, useDefaultSize)
 		s.nowplaying_large_art.npalbumgroup.npalbum.font = _font(c.NP_ARTISTALBUM_FONT_SIZE * 1.2) 
 	end
 
-	if screen_width == 1024 and screen_height == 600 then
-		s.nowplaying.npcontrols.div5.w = 230
-		s.nowplaying.npcontrols.div5.img = false
-	elseif screen_width == 1280 and screen_height == 800 then
-		s.nowplaying.npcontrols.div5.w = 490
-		s.nowplaying.npcontrols.div5.img = false
-		_largerFont()
-	elseif screen_width == 1366 and screen_height == 768 then
-		s.nowplaying.npcontrols.div5.w = 568
-		s.nowplaying.npcontrols.div5.img = false
-		_largerFont()
-	end
+	lazystyle.extend(s, "nowplaying", function(s)
+		if screen_width == 1024 and screen_height == 600 then
+			s.nowplaying.npcontrols.div5.w = 230
+			s.nowplaying.npcontrols.div5.img = false
+		elseif screen_width == 1280 and screen_height == 800 then
+			s.nowplaying.npcontrols.div5.w = 490
+			s.nowplaying.npcontrols.div5.img = false
+			_largerFont()
+		elseif screen_width == 1366 and screen_height == 768 then
+			s.nowplaying.npcontrols.div5.w = 568
+			s.nowplaying.npcontrols.div5.img = false
+			_largerFont()
+		end
+	end)
 
 	return s
 end
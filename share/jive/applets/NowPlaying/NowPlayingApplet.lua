@@ -32,6 +32,7 @@ local Player           = require("jive.slim.Player")
 
 local VUMeter          = require("jive.vis.VUMeter")
 local SpectrumMeter    = require("jive.vis.SpectrumMeter")
+local Waterfall        = require("jive.vis.Waterfall")
 
 local debug            = require("jive.utils.debug")
 local datetime         = require("jive.utils.datetime")
@@ -440,6 +441,33 @@ function notify_playerRepeatModeChange(self, player, repeatMode)
 end
 
 
+function notify_playerVolumeChange(self, player, volume)
+	if player ~= self.player or self.volumeSliderDragInProgress then
+		return
+	end
+	log:debug("notify_playerVolumeChange(): ", volume)
+	self:_updateVolume()
+end
+
+
+function notify_playerTrackPosition(self, player, elapsed, duration)
+	if player ~= self.player or not self.window then
+		return
+	end
+	log:debug("notify_playerTrackPosition(): ", elapsed)
+	self:_updatePosition()
+end
+
+
+function notify_playerPlaylistIndexChange(self, player, index, size)
+	if player ~= self.player or not self.XofY then
+		return
+	end
+	log:debug("notify_playerPlaylistIndexChange(): ", index, "/", size)
+	self:_updatePlaylist()
+end
+
+
 function _setVolumeSliderStyle(self)
 	if self.volSlider then
 		if self.player:useVolumeControl() == 0 then
@@ -1569,6 +1597,19 @@ function _createUI(self)
 		)
 	end
 
+	-- Visualizer: Waterfall - only load if needed
+	if self.windowStyle == "nowplaying_waterfall_text" then
+		self.visuGroup = Button(
+			Group('npvisu', {
+				visu = Waterfall("waterfall"),
+			}),
+			function()
+				Framework:pushAction("go_now_playing")
+				return EVENT_CONSUME
+			end
+		)
+	end
+
 	-- Visualizer: Analog VU Meter - only load if needed
 	if self.windowStyle == "nowplaying_vuanalog_text" then
 		self.visuGroup = Button(
@@ -1738,7 +1779,7 @@ function _createUI(self)
 	window:addWidget(self.artistalbumTitle)
 	window:addWidget(self.artworkGroup)
 	-- Visualizer: Only load if needed
-	if (self.windowStyle == "nowplaying_spectrum_text") or (self.windowStyle == "nowplaying_vuanalog_text") then
+	if (self.windowStyle == "nowplaying_spectrum_text") or (self.windowStyle == "nowplaying_vuanalog_text") or (self.windowStyle == "nowplaying_waterfall_text") then
 		window:addWidget(self.visuGroup)
 	end
 
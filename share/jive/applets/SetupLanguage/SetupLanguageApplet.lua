@@ -81,6 +81,9 @@ function setupShowSetupLanguage(self, setupNext, helpText)
 	-- but it's needed for speed here
 	self.allStrings = locale:loadAllStrings(self._entry.dirpath .. "strings.txt")
 
+	-- _showLang changes all the applet's strings, not just those used so far
+	locale:loadStrings(self._stringsTable)
+
 	-- setup menu
 	local window = Window("text_list", self:string("CHOOSE_LANGUAGE"), "setuptitle")
 	window:setAllowScreensaver(false)
@@ -150,6 +153,9 @@ function settingsShow(self, menuItem)
 	-- but it's needed for speed here
 	self.allStrings = locale:loadAllStrings(self._entry.dirpath .. "strings.txt")
 
+	-- _showLang changes all the applet's strings, not just those used so far
+	locale:loadStrings(self._stringsTable)
+
 	-- setup menu
 	local window = Window("text_list", self:string("LANGUAGE"), 'settingstitle')
 	local menu = SimpleMenu("menu")
@@ -475,8 +475,9 @@ end
 
 
 -- _artworkItem
--- updates a group widget with the artwork for item
-local function _artworkItem(step, item, group, menuAccel)
+-- updates a group widget with the artwork for item, index is the
+-- position of the item in the menu
+local function _artworkItem(step, item, group, menuAccel, index)
 	local icon = group and group:getWidget("icon")
 	local iconSize
 
@@ -495,7 +496,7 @@ local function _artworkItem(step, item, group, menuAccel)
 			_server:cancelArtwork(icon)
 		else
 			-- Fetch an image from SlimServer
-			_server:fetchArtwork(iconId, icon, iconSize)
+			_server:fetchArtwork(iconId, icon, iconSize, nil, index)
 		end
 	elseif item["trackType"] == 'radio' and item["params"] and item["params"]["track_id"] then
 		if menuAccel and not _server:artworkThumbCached(item["params"]["track_id"], iconSize) then
@@ -503,7 +504,7 @@ local function _artworkItem(step, item, group, menuAccel)
 			_server:cancelArtwork(icon)
                	else
 			-- workaround: this needs to be png not jpg to allow for transparencies
-			_server:fetchArtwork(item["params"]["track_id"], icon, iconSize, 'png')
+			_server:fetchArtwork(item["params"]["track_id"], icon, iconSize, 'png', index)
 		end
 	else
 		_server:cancelArtwork(icon)
@@ -587,7 +588,7 @@ end
 
 -- _decoratedLabel
 -- updates or generates a label cum decoration in the given labelStyle
-local function _decoratedLabel(group, labelStyle, item, step, menuAccel)
+local function _decoratedLabel(group, labelStyle, item, step, menuAccel, index)
 	local db = step.db
 	local windowStyle = db:windowStyle() 
 
@@ -698,7 +699,7 @@ local function _decoratedLabel(group, labelStyle, item, step, menuAccel)
 				end
 				group._type = nil
 			end
-			_artworkItem(step, item, group, menuAccel)
+			_artworkItem(step, item, group, menuAccel, index)
 		end
 		group:setStyle(labelStyle)
 
@@ -2412,6 +2413,9 @@ local function _browseMenuRenderer(menu, step, widgets, toRenderIndexes, toRende
 		_server:cancelAllArtwork()
 	end
 
+	-- fetch the artwork nearest the visible items first
+	_server:setArtworkViewport(menu, menu:getVisibleIndicies())
+
 	for widgetIndex = 1, toRenderSize do
 		local dbIndex = toRenderIndexes[widgetIndex]
 		
@@ -2446,7 +2450,7 @@ local function _browseMenuRenderer(menu, step, widgets, toRenderIndexes, toRende
 			if item and (item['checkbox'] or item['radio'] or item['selectedIndex']) then
 				style = 'item_choice'
 			end
-			widgets[widgetIndex] = _decoratedLabel(widget, style, item, step, menuAccel)
+			widgets[widgetIndex] = _decoratedLabel(widget, style, item, step, menuAccel, dbIndex)
 		end
 	end
 
@@ -2466,7 +2470,7 @@ local function _browseMenuRenderer(menu, step, widgets, toRenderIndexes, toRende
 	for dbIndex = startIndex, startIndex + toRenderSize do
 		local item = db:item(dbIndex)
 		if item then
-			_artworkItem(step, item, nil, false)
+			_artworkItem(step, item, nil, false, dbIndex)
 		end
 	end
 end
@@ -19,6 +19,7 @@ See L<jive.AppletMeta> for a description of standard applet meta functions.
 local oo            = require("loop.simple")
 
 local AppletMeta    = require("jive.AppletMeta")
+local ArtworkCache  = require("jive.slim.ArtworkCache")
 local utilLog       = require("jive.utils.log")
 
 local appletManager = appletManager
@@ -34,7 +35,16 @@ function jiveVersion(self)
 end
 
 
+function defaultSettings(self)
+	return {
+		-- keep resized artwork as pixels in the disk cache
+		artworkStoreImages = false,
+	}
+end
+
+
 function registerApplet(self)
+	ArtworkCache:setStoreImages(self:getSettings()["artworkStoreImages"])
 	
 	-- SlimBrowser uses its an extra log category
 	utilLog.logger("applet.SlimBrowser.data")
@@ -18,9 +18,10 @@ TODO
 --]]
 
 -- stuff we use
-local package, pairs, error, load, loadfile, io, assert, os = package, pairs, error, load, loadfile, io, assert, os
+local package, pairs, ipairs, error, load, loadfile, io, assert, os = package, pairs, ipairs, error, load, loadfile, io, assert, os
 local setfenv, getfenv, require, pcall, unpack = setfenv, getfenv, require, pcall, unpack
-local tostring, tonumber, collectgarbage = tostring, tonumber, collectgarbage
+local tostring, tonumber, collectgarbage, loadstring = tostring, tonumber, collectgarbage, loadstring
+local _VERSION = _VERSION
 
 local string           = require("jive.utils.string")
                        
@@ -64,6 +65,18 @@ local _services = {}
 local _defaultSettingsByAppletName = {}
 --work in progress-- local _overrideSettingsByAppletName = {}
 
+-- the applet index caches the applets found, their load priority and
+-- compiled meta, so a warm start needs only a stat per applets directory
+-- and meta instead of scanning them and compiling every meta. each entry
+-- keeps the mtimes of its Meta.lua and loadPriority.lua and a checksum of
+-- its bytecode, any mismatch falls back to a full scan.
+local INDEX_HEADER = "jive applet index 2 " .. tostring(JIVE_VERSION) .. " " .. _VERSION
+
+-- the settings of all applets are kept in one settings store, opened on
+-- first use. false if it is not available, settings are then written to
+-- a lua file per applet
+local _settingsStore
+
 -- allowed applets, can be used for debugging to limit applets loaded
 --[[
 local allowedApplets = {
@@ -88,12 +101,16 @@ function _initUserpathdir()
 	_userpathdir = System.getUserDir()
 	_usersettingsdir = _userpathdir .. "/settings"
 	_userappletsdir = _userpathdir .. "/applets"
+	_usercachedir = _userpathdir .. "/cache"
+	_indexFilepath = _usercachedir .. "/applets.idx"
+	_settingsStoreFilepath = _usersettingsdir .. "/settings.db"
 	
 	log:info("User Path: ", _userpathdir)
 	
 	_mkdirRecursive(_userpathdir)
 	_mkdirRecursive(_usersettingsdir)
 	_mkdirRecursive(_userappletsdir)
+	_mkdirRecursive(_usercachedir)
 end
 
 function _mkdirRecursive(dir)
@@ -120,7 +137,7 @@ end
 
 -- _saveApplet
 -- creates entries for appletsDb, calculates paths and module names
-local function _saveApplet(name, dir)
+local function _saveApplet(name, dir, cached)
 	log:debug("Found applet ", name, " in ", dir)
 	
 	if allowedApplets and not allowedApplets[name] then
@@ -153,22 +170,208 @@ local function _saveApplet(name, dir)
 			metaConfigured = false,
 			appletLoaded = false,
 			appletEvaluated = false,
-			loadPriority = _getLoadPriority(dir.. "/" .. name)
+			loadPriority = cached.loadPriority or _getLoadPriority(dir.. "/" .. name),
+
+			-- for the applet index
+			dir = dir,
+			metaMtime = cached.metaMtime,
+			priorityMtime = cached.priorityMtime,
+			metaBytecode = cached.metaBytecode,
+			metaFunc = cached.metaFunc,
 		}
 		_appletsDb[name] = newEntry
 	end
 end
 
 
+-- _appletDirs
+-- returns the applets directories on the lua path, and their mtimes
+local function _appletDirs()
+	local dirs = {}
+
+	for dir in package.path:gmatch("([^;]*)%?[^;]*;") do
+		dir = dir .. "applets"
+		dirs[#dirs + 1] = {
+			path = dir,
+			mtime = lfs.attributes(dir, "modification") or 0,
+		}
+	end
+
+	return dirs
+end
+
+
+-- _checksum
+-- Adler-32 of s, so a damaged index entry is found before its bytecode
+-- is loaded
+local function _checksum(s)
+	local a, b = 1, 0
+
+	for i = 1, #s do
+		a = (a + string.byte(s, i)) % 65521
+		b = (b + a) % 65521
+	end
+
+	return b * 65536 + a
+end
+
+
+-- _metaMtimes
+-- returns the mtimes of the Meta.lua and loadPriority.lua of an applet,
+-- nil if it has no meta
+local function _metaMtimes(dir, name)
+	local meta = lfs.attributes(dir .. "/" .. name .. "/" .. name .. "Meta.lua")
+	if not meta or meta.mode ~= "file" then
+		return nil
+	end
+
+	return meta.modification, lfs.attributes(dir .. "/" .. name .. "/loadPriority.lua", "modification") or 0
+end
+
+
+-- _readIndex
+-- reads the applet index, returns its applets by name, and true if the
+-- applets and their metas are unchanged since it was written. the compiled
+-- metas returned are checked and loaded.
+local function _readIndex(dirs)
+	local fh = io.open(_indexFilepath, "rb")
+	if fh == nil then
+		return {}, false
+	end
+
+	local ok = fh:read("*l") == INDEX_HEADER
+	local current = true
+	local applets = {}
+	local i = 0
+
+	while ok do
+		local line = fh:read("*l")
+		if line == nil then
+			-- truncated
+			ok = false
+			break
+		end
+
+		local mtime, path = line:match("^dir (%d+) (.*)$")
+		if path then
+			-- keep reading if changed, the compiled metas can be reused
+			i = i + 1
+			if not dirs[i] or dirs[i].path ~= path or dirs[i].mtime ~= tonumber(mtime) then
+				current = false
+			end
+
+		elseif line == "end" then
+			break
+
+		else
+			local name, loadPriority, metaMtime, priorityMtime, sum, size, dir = line:match("^applet (%S+) (%-?%d+) (%d+) (%d+) (%d+) (%d+) (.*)$")
+			if not name then
+				ok = false
+				break
+			end
+
+			local bytecode = fh:read(tonumber(size)) or ""
+			fh:read(1)
+
+			local f
+			if bytecode ~= "" and _checksum(bytecode) == tonumber(sum) then
+				f = loadstring(bytecode)
+			end
+
+			if bytecode ~= "" and not f then
+				log:warn("Applet index entry for ", name, " is damaged")
+				bytecode = ""
+				current = false
+			end
+
+			applets[name] = {
+				dir = dir,
+				loadPriority = tonumber(loadPriority),
+				metaMtime = tonumber(metaMtime),
+				priorityMtime = tonumber(priorityMtime),
+				metaBytecode = bytecode ~= "" and bytecode or nil,
+				metaFunc = f,
+			}
+		end
+	end
+
+	fh:close()
+
+	if not (ok and current and i == #dirs) then
+		return applets, false
+	end
+
+	-- metas edited in place don't change the directory mtimes
+	for name, applet in pairs(applets) do
+		local metaMtime, priorityMtime = _metaMtimes(applet.dir, name)
+
+		if metaMtime ~= applet.metaMtime or priorityMtime ~= applet.priorityMtime then
+			log:info("Applet ", name, " changed since the applet index was written")
+			return applets, false
+		end
+	end
+
+	return applets, true
+end
+
+
+-- _writeIndex
+-- writes the applet index for the applets found
+local function _writeIndex(dirs)
+	log:debug("_writeIndex")
+
+	local data = { INDEX_HEADER }
+
+	for i, dir in ipairs(dirs) do
+		data[#data + 1] = "dir " .. dir.mtime .. " " .. dir.path
+	end
+
+	for i, entry in ipairs(getSortedAppletDb(_appletsDb)) do
+		local bytecode = entry.metaBytecode or ""
+
+		data[#data + 1] = "applet " .. entry.appletName .. " " .. (entry.loadPriority or 100) .. " " .. (entry.metaMtime or 0) .. " " .. (entry.priorityMtime or 0) .. " " .. _checksum(bytecode) .. " " .. #bytecode .. " " .. entry.dir
+		data[#data] = data[#data] .. "\n" .. bytecode
+	end
+
+	data[#data + 1] = "end\n"
+
+	local tmpname = _indexFilepath .. ".new"
+	local fh, err = io.open(tmpname, "wb")
+	if fh == nil then
+		log:warn("Can't write applet index: ", err)
+		return
+	end
+
+	fh:write(table.concat(data, "\n"))
+	fh:close()
+
+	-- windows can't rename over an existing file
+	os.remove(_indexFilepath)
+	os.rename(tmpname, _indexFilepath)
+end
+
+
 -- _findApplets
--- find the available applets and store the findings in the appletsDb
-local function _findApplets()
+-- find the available applets and store the findings in the appletsDb,
+-- returns true if they were found in an up to date applet index
+local function _findApplets(dirs)
 	log:debug("_findApplets")
 
+	local indexed, valid = _readIndex(dirs)
+
+	if valid then
+		log:info("Using applet index")
+
+		for name, applet in pairs(indexed) do
+			_saveApplet(name, applet.dir, applet)
+		end
+		return true
+	end
+
 	-- Find all applets/* directories on lua path
-	for dir in package.path:gmatch("([^;]*)%?[^;]*;") do repeat
+	for i, dir in ipairs(dirs) do repeat
 	
-		dir = dir .. "applets"
+		dir = dir.path
 		log:debug("..in ", dir)
 		
 		local mode = lfs.attributes(dir, "mode")
@@ -184,12 +387,42 @@ local function _findApplets()
 				break
 			end
 
-			local metamode = lfs.attributes(entrydir  .. "/" .. entry .. "Meta.lua", "mode")
-			if metamode == "file" then
-				_saveApplet(entry, dir)
+			local metaMtime, priorityMtime = _metaMtimes(dir, entry)
+			if metaMtime then
+				-- reuse the compiled meta if it is unchanged
+				local applet = indexed[entry]
+				if applet and (applet.dir ~= dir or applet.metaMtime ~= metaMtime) then
+					applet = nil
+				end
+
+				_saveApplet(entry, dir, {
+					metaMtime = metaMtime,
+					priorityMtime = priorityMtime,
+					metaBytecode = applet and applet.metaBytecode,
+					metaFunc = applet and applet.metaFunc,
+				})
 			end
 		until true end
 	until true end
+
+	return false
+end
+
+
+-- _loadfile
+-- loads file of applet entry, precompiled from the bundle if the applet is
+-- in the bundle's script path
+local function _loadfile(entry, module, file)
+	local bundle = package.loaded["jive.bundle"]
+
+	if bundle and entry.dirpath == bundle.dir .. "/applets/" .. entry.appletName .. "/" then
+		local f = bundle.load(module)
+		if f then
+			return f
+		end
+	end
+
+	return loadfile(entry.basename .. file)
 end
 
 
@@ -205,9 +438,16 @@ local function _loadMeta(entry)
 		end
 		return p
 	end
-	local f, err = loadfile(entry.basename .. "Meta.lua")
+	local f, err = entry.metaFunc
+	entry.metaFunc = nil
 	if not f then
-		error (string.format ("error loading meta `%s' (%s)", entry.appletName, err))
+		f, err = _loadfile(entry, entry.metaModule, "Meta.lua")
+		if not f then
+			error (string.format ("error loading meta `%s' (%s)", entry.appletName, err))
+		end
+
+		-- keep the compiled meta for the applet index
+		entry.metaBytecode = string.dump(f)
 	end
 
 	-- load applet resources
@@ -384,6 +624,8 @@ local function _evalMetas()
 
 	for name, entry in pairs(getSortedAppletDb(_appletsDb)) do
 		entry.metaObj = nil
+		entry.metaBytecode = nil
+		entry.metaFunc = nil
 
 		-- trash the meta in all cases, it's done it's job
 		package.loaded[entry.metaModule] = nil
@@ -399,8 +641,15 @@ end
 function discover(self)
 	log:debug("AppletManager:loadApplets")
 
-	_findApplets()
+	local dirs = _appletDirs()
+	local indexed = _findApplets(dirs)
+
 	_loadAndRegisterMetas()
+
+	if not indexed then
+		_writeIndex(dirs)
+	end
+
 	_evalMetas()
 end
 
@@ -436,7 +685,7 @@ local function _loadApplet(entry)
 		end
 		return p
 	end
-	local f, err = loadfile(entry.basename .. "Applet.lua")
+	local f, err = _loadfile(entry, entry.appletModule, "Applet.lua")
 	if not f then
 		--error (string.format ("error loading applet `%s' (%s)\n", entry.appletName, err))
 		error (string.format ("%s|%s", entry.appletName, err))
@@ -611,6 +860,27 @@ function _loadLocaleStrings(entry)
 end
 
 
+-- _getSettingsStore
+--
+function _getSettingsStore()
+	if _settingsStore == nil then
+		_settingsStore = false
+
+		local ok, settingsstore = pcall(require, "jive.settingsstore")
+		if ok then
+			local store, err = settingsstore:open(_settingsStoreFilepath)
+			if store then
+				_settingsStore = store
+			else
+				log:error("Can't open settings store: ", err)
+			end
+		end
+	end
+
+	return _settingsStore
+end
+
+
 -- _loadSettings
 --
 function _loadSettings(entry)
@@ -621,6 +891,15 @@ function _loadSettings(entry)
 
 	log:debug("_loadSettings: ", entry.appletName)
 
+	local store = _getSettingsStore()
+	if store then
+		entry.settings = store:get(entry.appletName)
+		if entry.settings then
+			return
+		end
+	end
+
+	-- settings not yet in the store, the lua file is left for older versions
 	local fh = io.open(entry.settingsFilepath)
 	if fh == nil then
 		-- no settings file, look for legacy settings - remove legacy usage after in two public releases
@@ -708,6 +987,12 @@ function _storeSettings(entry)
 
 	log:info("store settings: ", entry.appletName)
 
+	local store = _getSettingsStore()
+	if store then
+		store:store(entry.appletName, entry.settings)
+		return
+	end
+
 	System:atomicWrite(entry.settingsFilepath,
 		dumper.dump(entry.settings, "settings", true))
 end
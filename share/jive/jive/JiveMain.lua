@@ -38,6 +38,7 @@ local Task          = require("jive.ui.Task")
 local Timer         = require("jive.ui.Timer")
 local Event         = require("jive.ui.Event")
 local table         = require("jive.utils.table")
+local lazystyle     = require("jive.utils.lazystyle")
 
 local Canvas        = require("jive.ui.Canvas")
 
@@ -565,6 +566,18 @@ local function _loadSkin(self, skinId, reload, useDefaultSize)
 	local obj = appletManager:loadApplet(appletName)
 	assert(obj, "Cannot load skin " .. appletName)
 
+	-- report the lazy styles the old skin used
+	local stats = lazystyle.getStats(jive.ui.style)
+	if stats.declared > 0 then
+		log:info("skin built ", stats.built, " of ", stats.declared, " lazy styles in ", stats.time, " ms")
+		if log:isDebug() then
+			for _, used in ipairs(stats.used) do
+				log:debug("skin used ", used.style, " (", used.time, " ms)")
+			end
+			log:debug("skin unused: ", table.concat(stats.unused, " "))
+		end
+	end
+
 	-- reset the skin
 	jive.ui.style = {}
 
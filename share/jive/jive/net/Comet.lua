@@ -18,6 +18,9 @@ This class implements a HTTP socket running in a L<jive.net.NetworkThread>.
  -- playerid may be nil
  comet:subscribe('/slim/serverstatus', func, playerid, {'serverstatus', 0, 50, 'subscribe:60'})
 
+ -- subscribe to an event, only decoding the given fields of its data
+ comet:subscribe('/slim/playerstatus/' .. playerid, func, playerid, request, priority, { mode = true, time = true })
+
  -- unsubscribe from an event
  comet:unsubscribe('/slim/serverstatus', func)
 
@@ -47,6 +50,12 @@ This class implements a HTTP socket running in a L<jive.net.NetworkThread>.
   comet:request(...)
   comet:endBatch()
 
+Calls made outside a batch are not sent at once either, they are held
+until the current Task yields, or for the flush window if one is set with
+setFlushWindow, and then sent together in one HTTP request. Repeated
+absolute settings such as 'mixer volume' replace any still waiting to be
+sent for the same player, and are sent at most every MERGE_INTERVAL ms.
+
 =head1 FUNCTIONS
 
 =cut
@@ -57,20 +66,23 @@ This class implements a HTTP socket running in a L<jive.net.NetworkThread>.
 
 
 -- stuff we use
-local assert, ipairs, table, pairs, string, tonumber, tostring = assert, ipairs, table, pairs, string, tonumber, tostring
+local assert, ipairs, table, pairs, string, tonumber, tostring, type = assert, ipairs, table, pairs, string, tonumber, tostring, type
 
 local oo            = require("loop.simple")
 local math          = require("math")
+local json          = require("cjson")
 
 local System        = require("jive.System")
 local CometRequest  = require("jive.net.CometRequest")
 local HttpPool      = require("jive.net.HttpPool")
 local SocketHttp    = require("jive.net.SocketHttp")
+local Framework     = require("jive.ui.Framework")
 local Timer         = require("jive.ui.Timer")
 local Task          = require("jive.ui.Task")
 local DNS           = require("jive.net.DNS")
 
 local debug         = require("jive.utils.debug")
+local jsonfilters   = require("jive.utils.jsonfilters")
 local log           = require("jive.utils.log").logger("net.comet")
 
 local JIVE_VERSION  = jive.JIVE_VERSION
@@ -79,6 +91,24 @@ local JIVE_VERSION  = jive.JIVE_VERSION
 local RETRY_DEFAULT = 5000  -- default delay time to retry connection (5s)
 local MAX_BACKOFF   = 60000 -- don't wait longer than this before retrying (60s)
 
+-- decode spec to find the channels of the events in a chunk
+local CHANNEL_SPEC  = { channel = true }
+
+-- hold requests for this long to send them together, 0 sends them once
+-- the current Task yields
+local FLUSH_WINDOW   = 0
+
+-- idempotent commands, a newer one replaces one still waiting to be sent
+-- for the same player, and they are sent at most every MERGE_INTERVAL ms
+local MERGE_COMMANDS = {
+	["mixer volume"] = true,
+	["mixer bass"] = true,
+	["mixer treble"] = true,
+	["mixer pitch"] = true,
+	["time"] = true,
+}
+local MERGE_INTERVAL = 100
+
 -- jive.net.Comet is a base class
 module(..., oo.class)
 
@@ -86,6 +116,9 @@ module(..., oo.class)
 -- forward declarations
 local _addPendingRequests
 local _sendPendingRequests
+local _mergeKey
+local _scheduleFlush
+local _flush
 local _state
 local _handshake
 local _getHandshakeSink
@@ -93,6 +126,7 @@ local _connect
 local _reconnect
 local _connected
 local _getEventSink
+local _getEventDecoder
 local _getRequestSink
 local _response
 local _disconnect
@@ -150,6 +184,14 @@ function __init(self, jnt, name)
 	obj.pending_reqs   = {}       -- pending requests to send with connect
 	obj.sent_reqs      = {}       -- sent requests, awaiting a response
 	obj.notify         = {}       -- callbacks to notify
+	obj.specs          = {}       -- event decode specs by subscription
+
+	obj.flushWindow    = FLUSH_WINDOW
+	obj.merged         = {}       -- last send time of merged commands
+	obj:resetStats()
+
+	-- Timer to send coalesced requests
+	obj.flush_timer = Timer(0, function() _flush(obj) end, true)
 
 	-- Reconnection timer
 	obj.reconnect_timer = Timer(0, function() _handleTimer(obj) end, true)
@@ -309,7 +351,13 @@ _addPendingRequests = function(self, data)
 	end
 
 	-- Add pending requests
+	local now = Framework:getTicks()
 	for i, v in ipairs( self.pending_reqs ) do
+		-- note when merged commands are sent
+		if v.merge then
+			self.merged[v.merge] = now
+		end
+
 		local cmd = {
 			v.playerid or '',
 			v.request
@@ -357,6 +405,11 @@ _sendPendingRequests = function(self, data)
 	
 	-- Only continue if we have some data to send
 	if data[1] then
+		self.flush_timer:stop()
+
+		self.stats.messages = self.stats.messages + #data
+		self.stats.posts = self.stats.posts + 1
+
 		if log:isDebug() then
 			log:debug("Sending pending request(s):")
 			debug.dump(data, 5)
@@ -377,7 +430,7 @@ _sendPendingRequests = function(self, data)
 end
 
 
-function subscribe(self, subscription, func, playerid, request, priority)
+function subscribe(self, subscription, func, playerid, request, priority, fields)
 	local id = self.reqid
 
 	if log:isDebug() then
@@ -396,16 +449,17 @@ function subscribe(self, subscription, func, playerid, request, priority)
 		pending      = true, -- pending means we haven't sent this sub request yet
 	} )
 
+	-- only skip event data fields if no other callback wants all of them
+	if fields and self.specs[subscription] == nil then
+		self.specs[subscription] = { ["*"] = true, data = fields }
+	else
+		self.specs[subscription] = false
+	end
+
 	-- Bump reqid for the next request
 	self.reqid = id + 1
 
-	-- Send immediately unless we're batching queries
-	if self.state ~= CONNECTED or self.batch ~= 0 then
-		return
-	end
-
-	-- Send all pending requests and subscriptions
-	_sendPendingRequests(self)
+	_scheduleFlush(self)
 end
 
 
@@ -429,6 +483,8 @@ function unsubscribe(self, subscription, func)
 	end
 
 	log:debug("No more callbacks for ", subscription, " unsubscribing at server")
+
+	self.specs[subscription] = nil
 		
 	-- Remove from subs list
 	for i, v in ipairs( self.subs ) do
@@ -447,13 +503,7 @@ function unsubscribe(self, subscription, func)
 	-- Bump reqid for the next request
 	self.reqid = id + 1
 
-	-- Send immediately unless we're batching queries
-	if self.state ~= CONNECTED or self.batch ~= 0 then
-		return
-	end
-
-	-- Send all pending requests
-	_sendPendingRequests(self)
+	_scheduleFlush(self)
 end
 
 
@@ -469,6 +519,29 @@ function request(self, func, playerid, request, priority)
 		log:debug(self, ": request(", func, ", reqid:", id, ", ", playerid, ", ", table.concat(_request, ","), ", priority:", priority, ")")
 	end
 
+	-- Idempotent commands replace one still waiting to be sent
+	local merge = not func and _mergeKey(playerid, request)
+	local delay = 0
+
+	if merge then
+		for i, v in ipairs(self.pending_reqs) do
+			if v.merge == merge then
+				log:debug(self, ": merge reqid:", v.reqid, " with reqid:", id)
+
+				table.remove(self.pending_reqs, i)
+				self.stats.merged = self.stats.merged + 1
+				break
+			end
+		end
+
+		-- send at most every MERGE_INTERVAL, so later ones can merge
+		local now = Framework:getTicks()
+		local last = self.merged[merge]
+		if last and now - last < MERGE_INTERVAL then
+			delay = last + MERGE_INTERVAL - now
+		end
+	end
+
 	-- Add to pending requests
 	table.insert(self.pending_reqs, {
 		reqid = id,
@@ -476,6 +549,7 @@ function request(self, func, playerid, request, priority)
 		playerid = playerid,
 		request = request,
 		priority = priority,
+		merge = merge,
 	})
 
 	-- Bump reqid for the next request
@@ -488,18 +562,14 @@ function request(self, func, playerid, request, priority)
 		_reconnect(self)
 	end
 
-	-- Send immediately unless we're batching queries
-	if self.state ~= CONNECTED or self.batch ~= 0 then
-		if self.state ~= CONNECTED then
-			self.jnt:notify('cometDisconnected', self, self.idleTimeoutTriggered)
-			self.idleTimeoutTriggered = nil
-		end
+	if self.state ~= CONNECTED then
+		self.jnt:notify('cometDisconnected', self, self.idleTimeoutTriggered)
+		self.idleTimeoutTriggered = nil
 
 		return id
 	end
 
-	-- Send all pending requests
-	_sendPendingRequests(self)
+	_scheduleFlush(self, delay)
 
 	return id
 end
@@ -513,6 +583,7 @@ function addCallback(self, subscription, func)
 	end
 	
 	self.notify[subscription][func] = func
+	self.specs[subscription] = false
 end
 
 
@@ -531,6 +602,41 @@ function startBatch(self)
 end
 
 
+-- Send requests made within I<window> ms together, 0 sends them once
+-- the current Task yields
+function setFlushWindow(self, window)
+	self.flushWindow = window
+end
+
+
+--[[
+
+=head2 jive.net.Comet:getStats()
+
+Returns a table of statistics since the last reset: the number of bayeux
+I<messages> sent, the number of HTTP I<posts> they were sent in, and the
+number of requests I<merged> with a newer one.
+
+=cut
+--]]
+function getStats(self)
+	local stats = {}
+	for k, v in pairs(self.stats) do
+		stats[k] = v
+	end
+	return stats
+end
+
+
+function resetStats(self)
+	self.stats = {
+		messages = 0,
+		posts    = 0,
+		merged   = 0,
+	}
+end
+
+
 -- End batch mode, send all batched queries together
 function endBatch(self)
 	log:debug(self, ": endBatch ", self.batch)
@@ -549,6 +655,56 @@ function endBatch(self)
 end
 
 
+-- Returns the merge key for idempotent commands, relative changes such
+-- as 'mixer volume +5' are never merged
+_mergeKey = function(playerid, request)
+	local cmd = tostring(request[1])
+	local value = request[2]
+
+	if not MERGE_COMMANDS[cmd] then
+		cmd = cmd .. " " .. tostring(value)
+		value = request[3]
+
+		if not MERGE_COMMANDS[cmd] then
+			return nil
+		end
+	end
+
+	if value == nil or string.match(tostring(value), "^[%+%-]") then
+		return nil
+	end
+
+	return (playerid or '') .. "|" .. cmd
+end
+
+
+-- Send pending requests once the current Task yields, or after the flush
+-- window or I<delay> ms, whichever is later
+_scheduleFlush = function(self, delay)
+	if self.state ~= CONNECTED or self.batch ~= 0 then
+		return
+	end
+
+	local expires = Framework:getTicks() + math.max(self.flushWindow, delay or 0)
+
+	-- an earlier flush sends these requests too
+	if self.flush_timer:isRunning() and self.flush_timer.expires <= expires then
+		return
+	end
+
+	self.flush_timer:restart(expires - Framework:getTicks())
+end
+
+
+_flush = function(self)
+	if self.state ~= CONNECTED or self.batch ~= 0 then
+		return
+	end
+
+	_sendPendingRequests(self)
+end
+
+
 -- Notify changes in connection state
 _state = function(self, state)
         if self.state == state then
@@ -710,6 +866,7 @@ _connect = function(self)
 			self.uri,
 			data
 		)
+	req:setDecodeFilter(_getEventDecoder(self))
 	
 	self.chttp:fetch(req)
 end
@@ -752,6 +909,7 @@ _reconnect = function(self)
 			self.uri,
 			data
 		)
+	req:setDecodeFilter(_getEventDecoder(self))
 
 	self.chttp:fetch(req)
 end
@@ -821,6 +979,41 @@ _getEventSink = function(self)
 end
 
 
+-- decoder for chunked connection. if all events in a chunk are for
+-- subscriptions with a decode spec, only the wanted data is decoded
+_getEventDecoder = function(self)
+	return function(chunk)
+		if type(chunk) ~= "string" or chunk == "" or not json.decode_fields then
+			return jsonfilters.decode(chunk)
+		end
+
+		-- first find the channels, this is cheap as nothing else is decoded
+		local events = json.decode_fields(chunk, CHANNEL_SPEC)
+		if type(events) ~= "table" then
+			return events
+		end
+
+		local spec = false
+		for i, event in ipairs(events) do
+			local subscription = type(event.channel) == "string"
+				and string.gsub(event.channel, "^/[0-9A-Za-z]+", "")
+
+			local eventSpec = subscription and self.specs[subscription]
+			if not eventSpec or (spec and spec ~= eventSpec) then
+				return json.decode(chunk)
+			end
+			spec = eventSpec
+		end
+
+		if not spec then
+			return json.decode(chunk)
+		end
+
+		return json.decode_fields(chunk, spec)
+	end
+end
+
+
 -- sink for request connection, resend requests on error
 _getRequestSink = function(self)
 	return function(chunk, err, cometRequest)
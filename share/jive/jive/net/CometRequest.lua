@@ -104,12 +104,26 @@ function __init(self, sink, uri, data, options)
 	return obj
 end
 
+--[[
+
+=head2 jive.net.CometRequest:setDecodeFilter(filter)
+
+Sets the ltn12 filter used to decode the JSON response, by default
+jive.utils.jsonfilters.decode.
+
+=cut
+--]]
+function setDecodeFilter(self, filter)
+	self.decodeFilter = filter
+end
+
+
 -- Tells SocketHttp whether to return us chunks or the whole response
 function t_getResponseSinkMode(self)
 	if self:t_getResponseHeader("Transfer-Encoding") then
 		return 'jive-by-chunk'
 	else
-		return 'jive-concat'
+		return 'jive-json'
 	end
 end
 
@@ -129,7 +143,7 @@ function t_setResponseBody(self, data)
 		local code, err = self:t_getResponseStatus()
 		if code == 200 then
 			local mySink = ltn12.sink.chain(
-				jsonfilters.decode,
+				self.decodeFilter or jsonfilters.decode,
 				sink
 			)
 			mySink(data, nil, self)
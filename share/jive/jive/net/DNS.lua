@@ -8,10 +8,18 @@ jive.net.DNS - non-blocking dns queries.
 Implements non-block dns queries using the same api a luasocket. These
 functions must be called in a Task.
 
+Lookups are made by a pool of resolver threads, so a slow lookup does not
+hold up the others. Answers are cached, host names that do not exist for
+a shorter time, and concurrent lookups of the same address are merged.
+
+The hostent returned with an answer is { name = name, ip = { IPv4
+addresses }, ip6 = { IPv6 addresses } }. toip only returns IPv4 addresses
+as the sockets are IPv4 only.
+
 --]]
 
 
-local assert = assert
+local assert, ipairs, pairs = assert, ipairs, pairs
 
 local oo          = require("loop.base")
 local table       = require("table")
@@ -33,6 +41,19 @@ module(..., oo.class)
 -- singleton instance
 local _instance = false
 
+-- cache answers for 5 minutes, and unknown hosts for 30 seconds
+local CACHE_TTL = 300000
+local NEGATIVE_TTL = 30000
+
+-- errors that are cached
+local NEGATIVE_ERRORS = {
+	["Not found"] = true,
+	["No data"] = true,
+}
+
+-- expired answers are removed when the cache grows past this
+local CACHE_PRUNE = 64
+
 
 function __init(self, jnt)
 	if _instance then
@@ -41,7 +62,20 @@ function __init(self, jnt)
 
 	local obj = oo.rawnew(self, {})
 	obj.sock = jive_dns:open()
-	obj.dnsQueue = {}
+
+	-- lookups in progress, by request id and by address
+	obj.requests = {}
+	obj.pending = {}
+
+	-- answers by address
+	obj.cache = {}
+	obj.cacheSize = 0
+
+	obj.stats = {
+		hits = 0,
+		misses = 0,
+		merged = 0,
+	}
 
 	jnt:t_addRead(obj.sock,
 		Task("DNS",
@@ -51,12 +85,19 @@ function __init(self, jnt)
 				     Task:yield(false)
 
 				     -- read host entry
-				     local hostent, err = obj.sock:read()
+				     local hostent, err, id = obj.sock:read()
+
+				     local request = obj.requests[id]
+				     if request then
+					     obj.requests[id] = nil
+					     obj.pending[request.address] = nil
+
+					     obj:_cacheAnswer(request.address, hostent, err)
 
-				     -- wake up requesting task
-				     local task = table.remove(obj.dnsQueue, 1)
-				     if task then
-					     task:addTask(hostent, err)
+					     -- wake up requesting tasks
+					     for i, task in ipairs(request.tasks) do
+						     task:addTask(hostent, err)
+					     end
 				     end
 			     end
 		     end),
@@ -67,6 +108,102 @@ function __init(self, jnt)
 end
 
 
+function _cacheAnswer(self, address, hostent, err)
+	local ttl
+	if hostent then
+		ttl = CACHE_TTL
+	elseif NEGATIVE_ERRORS[err] then
+		ttl = NEGATIVE_TTL
+	else
+		-- network errors are not cached
+		return
+	end
+
+	local now = Framework:getTicks()
+
+	if self.cacheSize >= CACHE_PRUNE then
+		for cachedAddress, entry in pairs(self.cache) do
+			if entry.expires < now then
+				self.cache[cachedAddress] = nil
+				self.cacheSize = self.cacheSize - 1
+			end
+		end
+	end
+
+	if not self.cache[address] then
+		self.cacheSize = self.cacheSize + 1
+	end
+
+	self.cache[address] = {
+		hostent = hostent,
+		err = err,
+		expires = now + ttl,
+	}
+end
+
+
+-- returns the host entry for address, from the cache or the resolver
+local function _lookup(address)
+	local stats = _instance.stats
+
+	local entry = _instance.cache[address]
+	if entry then
+		if entry.expires >= Framework:getTicks() then
+			stats.hits = stats.hits + 1
+			return entry.hostent, entry.err
+		end
+
+		_instance.cache[address] = nil
+		_instance.cacheSize = _instance.cacheSize - 1
+	end
+
+	stats.misses = stats.misses + 1
+
+	local request = _instance.pending[address]
+	if request then
+		stats.merged = stats.merged + 1
+	else
+		-- queue request
+		request = {
+			address = address,
+			tasks = {},
+		}
+
+		local id = _instance.sock:write(address)
+		_instance.requests[id] = request
+		_instance.pending[address] = request
+	end
+
+	-- wait for reply
+	table.insert(request.tasks, Task:running())
+	local _, hostent, err = Task:yield(false)
+
+	return hostent, err
+end
+
+
+--[[
+
+=head2 jive.net.DNS:getStats()
+
+Returns the number of lookups answered from the cache, the number passed
+to the resolver, and the number of those merged with a lookup in progress.
+
+=cut
+--]]
+function getStats(self)
+	local stats = _instance.stats
+	return stats.hits, stats.misses, stats.merged
+end
+
+
+-- Empties the cache, for example when the network changes.
+function flushCache(self)
+	_instance.cache = {}
+	_instance.cacheSize = 0
+end
+
+
 function isip(self, address)
 	-- XXXX crude check
 	return string.match(address, "%d+%.%d+%.%d+%.%d+")
@@ -75,15 +212,9 @@ end
 
 -- Converts from IP address to host name. See socket.dns.tohostname.
 function tohostname(self, address)
-	local task = Task:running()
-	assert(task, "DNS:tohostname must be called in a Task")
+	assert(Task:running(), "DNS:tohostname must be called in a Task")
 
-	-- queue request
-	_instance.sock:write(address)
-
-	-- wait for reply
-	table.insert(_instance.dnsQueue, task)
-	local _, hostent, err = Task:yield(false)
+	local hostent, err = _lookup(address)
 
 	if err then
 		return nil, err
@@ -95,18 +226,14 @@ end
 
 -- Coverts from host name to IP address. See socket.dns.toip.
 function toip(self, address)
-	local task = Task:running()
-	assert(task, "DNS:toip must be called in a Task")
+	assert(Task:running(), "DNS:toip must be called in a Task")
 
-	-- queue request
-	_instance.sock:write(address)
-
-	-- wait for reply
-	table.insert(_instance.dnsQueue, task)
-	local _, hostent, err = Task:yield(false)
+	local hostent, err = _lookup(address)
 
 	if err then
 		return nil, err
+	elseif not hostent.ip[1] then
+		return nil, "No data"
 	else
 		return hostent.ip[1], hostent
 	end
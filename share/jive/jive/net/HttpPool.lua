@@ -11,15 +11,27 @@ of HTTP sockets (see L<jive.net.SocketHttp>). The sockets are opened
 dynamically as the queue size grows, and are closed once all requests
 have been serviced.
 
+Once a connection has been kept alive after a response, further
+requests may be pipelined on it, up to the pipeline depth. The number
+of requests in flight to the server can be limited, requests wait in
+the queue until they can be sent and may be cancelled until then.
+
 =head1 SYNOPSIS
 
  -- create a pool for http://192.168.1.1:9000
  -- with a max of 4 connections, threshold of 2 requests
  local pool = HttpPool(jnt, "192.168.1.1", 9000, 4, 2, 'slimserver'),
 
+ -- pipeline up to 4 requests per connection, at most 6 in flight
+ pool:setPipelineDepth(4)
+ pool:setMaxInFlight(6)
+
  -- queue a request
  pool:queue(aRequest)
 
+ -- it is no longer needed
+ pool:cancel(aRequest)
+
 
 =head1 FUNCTIONS
 
@@ -31,7 +43,7 @@ have been serviced.
 
 
 -- stuff we use
-local _assert, ipairs, tostring, type = _assert, ipairs, tostring, type
+local _assert, ipairs, pairs, tostring, type = _assert, ipairs, pairs, tostring, type
 
 local table           = require("table")
 local math            = require("math")
@@ -39,6 +51,7 @@ local math            = require("math")
 local oo              = require("loop.base")
 
 local SocketHttpQueue = require("jive.net.SocketHttpQueue")
+local Framework       = require("jive.ui.Framework")
 local Timer           = require("jive.ui.Timer")
 
 local log             = require("jive.utils.log").logger("net.http")
@@ -76,6 +89,9 @@ function __init(self, jnt, name, ip, port, quantity, threshold, priority)
 	local obj = oo.rawnew(self, {
 		jnt           = jnt,
 		poolName      = name or "",
+		ip            = ip,
+		port          = port,
+		priority      = priority,
 		pool          = {
 			active    = 1,
 			threshold = threshold or 10,
@@ -84,20 +100,86 @@ function __init(self, jnt, name, ip, port, quantity, threshold, priority)
 		reqQueue      = {},
 		reqQueueCount = 0,
 		timeout_timer = nil,
+
+		-- ticks when each request was queued and sent
+		queuedAt      = {},
+		sentAt        = {},
+		inFlight      = 0,
+
+		-- requests per connection, and in flight to the server
+		pipelineDepth = 1,
+		maxInFlight   = false,
+
+		stats         = {},
 	})
 	
 	
 	-- init the pool
-	local q = quantity or 1
-	for i = 1, q do
-		obj.pool.jshq[i] = SocketHttpQueue(jnt, ip, port, obj, obj.poolName .. i)
-		obj.pool.jshq[i]:setPriority(priority)
-	end
+	obj:setPoolSize(quantity or 1)
+	obj:resetStats()
 	
 	return obj
 end
 
 
+--[[
+
+=head2 jive.net.HttpPool:setPoolSize(quantity)
+
+Sets the maximum number of connections to I<quantity>. Connections
+above the new size are closed.
+
+=cut
+--]]
+function setPoolSize(self, quantity)
+	local jshq = self.pool.jshq
+
+	for i = #jshq + 1, quantity do
+		jshq[i] = SocketHttpQueue(self.jnt, self.ip, self.port, self, self.poolName .. i)
+		jshq[i]:setPriority(self.priority)
+	end
+
+	for i = #jshq, quantity + 1, -1 do
+		jshq[i]:close("pool resized")
+		jshq[i]:free()
+		jshq[i] = nil
+	end
+
+	self.pool.active = #jshq
+end
+
+
+--[[
+
+=head2 jive.net.HttpPool:setPipelineDepth(depth)
+
+Allows up to I<depth> requests to be sent on a connection before the
+first response has arrived. Requests are only pipelined on connections
+the server has kept alive after a response. The default is 1, no
+pipelining.
+
+=cut
+--]]
+function setPipelineDepth(self, depth)
+	self.pipelineDepth = depth or 1
+end
+
+
+--[[
+
+=head2 jive.net.HttpPool:setMaxInFlight(count)
+
+Limits the requests in flight to the server, over all connections, to
+I<count>. Use false for no limit, the default.
+
+=cut
+--]]
+function setMaxInFlight(self, count)
+	self.maxInFlight = count or false
+	self:_kick()
+end
+
+
 --[[
 
 =head2 jive.net.HttpPool:free()
@@ -111,6 +193,9 @@ function free(self)
 		self.pool.jshq[i]:free()
 		self.pool.jshq[i] = nil
 	end
+
+	self.sentAt = {}
+	self.inFlight = 0
 end
 
 
@@ -143,6 +228,7 @@ function queue(self, request)
 
 	table.insert(self.reqQueue, request)
 	self.reqQueueCount = self.reqQueueCount + 1
+	self.queuedAt[request] = Framework:getTicks()
 	
 	-- calculate threshold
 --[[
@@ -158,6 +244,84 @@ function queue(self, request)
 --	log:debug(self, ":", self.reqQueueCount, " requests, ", self.pool.active, " connections")
 
 	-- kick all active queues
+	self:_kick()
+end
+
+
+--[[
+
+=head2 jive.net.HttpPool:cancel(request)
+
+Removes I<request> from the queue if it has not been sent yet. Its sink
+is not called. Returns true if the request was cancelled.
+
+=cut
+--]]
+function cancel(self, request)
+	for i, queued in ipairs(self.reqQueue) do
+		if queued == request then
+			table.remove(self.reqQueue, i)
+			self.reqQueueCount = self.reqQueueCount - 1
+			self.queuedAt[request] = nil
+
+			self.stats.cancelled = self.stats.cancelled + 1
+			return true
+		end
+	end
+
+	return false
+end
+
+
+--[[
+
+=head2 jive.net.HttpPool:isIdle()
+
+Returns true if the pool has no requests queued or in flight.
+
+=cut
+--]]
+function isIdle(self)
+	return self.inFlight == 0 and #self.reqQueue == 0
+end
+
+
+--[[
+
+=head2 jive.net.HttpPool:getStats()
+
+Returns a table of statistics since the last reset: I<requests>
+completed, I<failed>, I<cancelled> and I<requeued> requests, and the
+total and maximum I<wait> in the queue and I<transfer> times in ms.
+
+=cut
+--]]
+function getStats(self)
+	local stats = {}
+	for k, v in pairs(self.stats) do
+		stats[k] = v
+	end
+	return stats
+end
+
+
+function resetStats(self)
+	self.stats = {
+		requests    = 0,
+		failed      = 0,
+		cancelled   = 0,
+		requeued    = 0,
+		wait        = 0,
+		maxWait     = 0,
+		transfer    = 0,
+		maxTransfer = 0,
+	}
+end
+
+
+-- _kick
+-- start idle connections on any queued requests
+function _kick(self)
 	for i = 1, self.pool.active do
 		self.pool.jshq[i]:t_sendDequeueIfIdle()
 	end
@@ -169,15 +333,38 @@ end
 -- called by SocketHttpQueue
 function t_dequeue(self, socket)
 --	log:debug(self, ":t_dequeue()")
+
+	if #self.reqQueue > 0 then
+		-- leave requests queued while the server is busy, they
+		-- are sent as earlier requests complete
+		if self.maxInFlight and self.inFlight >= self.maxInFlight then
+			return nil, false
+		end
+
+		local pending = socket:t_getPendingCount()
+		if pending > 0 and (pending >= self.pipelineDepth or not socket:t_isKeepAlive()) then
+			return nil, false
+		end
+	end
 		
 	local request = table.remove(self.reqQueue, 1)
 	if request then
+		local now = Framework:getTicks()
+		local wait = now - (self.queuedAt[request] or now)
+		self.queuedAt[request] = nil
+
 		if type(request) == "function" then
 			request = request()
 		end
 
 		self.reqQueueCount = self.reqQueueCount - 1
 --		log:warn(self, " dequeues ", request)
+
+		self.sentAt[request] = now
+		self.inFlight = self.inFlight + 1
+
+		self.stats.wait = self.stats.wait + wait
+		self.stats.maxWait = math.max(self.stats.maxWait, wait)
 			
 		if self.timeout_timer then
 			self.timeout_timer:stop()
@@ -196,7 +383,7 @@ function t_dequeue(self, socket)
 			function()
 				log:debug(self, ": closing idle connection")
 				for i = 1, self.pool.active do
-					self.pool.jshq[1]:close('keep-alive timeout')
+					self.pool.jshq[i]:close('keep-alive timeout')
 				end
 			end,
 			true -- run once
@@ -209,6 +396,64 @@ function t_dequeue(self, socket)
 end
 
 
+-- t_done
+-- a request has completed, or failed with err
+-- called by SocketHttpQueue
+function t_done(self, socket, request, err)
+	local sentAt = request and self.sentAt[request]
+	if not sentAt then
+		return
+	end
+
+	self.sentAt[request] = nil
+	self.inFlight = self.inFlight - 1
+
+	local stats = self.stats
+	if err then
+		stats.failed = stats.failed + 1
+	else
+		local transfer = Framework:getTicks() - sentAt
+
+		stats.requests = stats.requests + 1
+		stats.transfer = stats.transfer + transfer
+		stats.maxTransfer = math.max(stats.maxTransfer, transfer)
+	end
+
+	if log:isDebug() then
+		log:debug(self, " ", stats.requests, " requests, wait=", stats.wait, "ms transfer=", stats.transfer, "ms failed=", stats.failed, " cancelled=", stats.cancelled)
+	end
+
+	-- send requests held back by the in flight limit, a failed request
+	-- frees its slot too
+	if #self.reqQueue > 0 then
+		self:_kick()
+	end
+end
+
+
+-- t_requeue
+-- requests sent on a connection that closed before they were answered
+-- called by SocketHttpQueue
+function t_requeue(self, socket, requests)
+	local now = Framework:getTicks()
+
+	for i = #requests, 1, -1 do
+		local request = requests[i]
+
+		if self.sentAt[request] then
+			self.sentAt[request] = nil
+			self.inFlight = self.inFlight - 1
+		end
+
+		table.insert(self.reqQueue, 1, request)
+		self.reqQueueCount = self.reqQueueCount + 1
+		self.queuedAt[request] = now
+
+		self.stats.requeued = self.stats.requeued + 1
+	end
+end
+
+
 --[[
 
 =head2 tostring(aPool)
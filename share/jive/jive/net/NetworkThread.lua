@@ -51,6 +51,9 @@ local log               = require("jive.utils.log").logger("net.thread")
 
 local perfhook          = jive.perfhook
 
+-- native reactor, not available on all platforms
+local hasReactor, jive_reactor = pcall(require, "jive.reactor")
+
 local EVENT_SERVICE_JNT = jive.ui.EVENT_SERVICE_JNT
 local EVENT_CONSUME     = jive.ui.EVENT_CONSUME
 
@@ -66,14 +69,16 @@ local squeezenetworkHostname = "www.squeezenetwork.com"
 -- _add
 -- adds a socket to the read or write list
 -- timeout == 0 => no time out!
-local function _add(sock, task, sockList, timeout)
+local function _add(self, mode, sock, task, sockList, timeout)
 	if not sock then 
 		return
 	end
 
 	if not sockList[sock] then
 		-- add us if we're not already in there
-		table.insert(sockList, sock)
+		if not self.reactor then
+			table.insert(sockList, sock)
+		end
 
 		sockList[sock] = {
 			lastSeen = Framework:getTicks()
@@ -86,12 +91,16 @@ local function _add(sock, task, sockList, timeout)
 	-- remember the pump, the time and the desired timeout
 	sockList[sock].task = task
 	sockList[sock].timeout = (timeout or 60) * 1000
+
+	if self.reactor then
+		self.reactor:add(sock, mode, sockList[sock].timeout)
+	end
 end
 
 
 -- _remove
 -- removes a socket from the read or write list
-local function _remove(sock, sockList)
+local function _remove(self, mode, sock, sockList)
 	if not sock then 
 		return 
 	end
@@ -101,7 +110,12 @@ local function _remove(sock, sockList)
 		sockList[sock].task:removeTask()
 		
 		sockList[sock] = nil
-		table.delete(sockList, sock)
+
+		if self.reactor then
+			self.reactor:remove(sock, mode)
+		else
+			table.delete(sockList, sock)
+		end
 	end
 end
 
@@ -111,25 +125,25 @@ end
 function t_addRead(self, sock, task, timeout)
 --	log:warn("NetworkThread:t_addRead()", sock)
 
-	_add(sock, task, self.t_readSocks, timeout)
+	_add(self, "r", sock, task, self.t_readSocks, timeout)
 end
 
 function t_removeRead(self, sock)
 --	log:warn("NetworkThread:t_removeRead()", sock)
 	
-	_remove(sock, self.t_readSocks)
+	_remove(self, "r", sock, self.t_readSocks)
 end
 
 function t_addWrite(self, sock, task, timeout)
 --	log:warn("NetworkThread:t_addWrite()", sock)
 	
-	_add(sock, task, self.t_writeSocks, timeout)
+	_add(self, "w", sock, task, self.t_writeSocks, timeout)
 end
 
 function t_removeWrite(self, sock)
 --	log:warn("NetworkThread:t_removeWrite()", sock)
 	
-	_remove(sock, self.t_writeSocks)
+	_remove(self, "w", sock, self.t_writeSocks)
 end
 
 
@@ -170,7 +184,7 @@ local function _t_select(self, timeout)
 		for i,v in ipairs(w) do
 			self.t_writeSocks[v].lastSeen = now
 			if not self.t_writeSocks[v].task:addTask() then
-				_remove(v, self.t_writeSocks)
+				_remove(self, "w", v, self.t_writeSocks)
 			end
 		end
 		
@@ -178,7 +192,7 @@ local function _t_select(self, timeout)
 		for i,v in ipairs(r) do
 			self.t_readSocks[v].lastSeen = now
 			if not self.t_readSocks[v].task:addTask() then
-				_remove(v, self.t_readSocks)
+				_remove(self, "r", v, self.t_readSocks)
 			end
 		end
 	end
@@ -189,6 +203,52 @@ local function _t_select(self, timeout)
 end
 
 
+-- _t_wait
+-- waits for our sockets using the reactor, this keeps the sockets
+-- registered and tracks their timeouts in C
+local function _t_wait(self, timeout)
+	local r, w, rt, wt = self.reactor:wait(timeout)
+
+	if not r then
+		log:error(w)
+		return
+	end
+
+	-- call the write pumps
+	for i,v in ipairs(w) do
+		local t = self.t_writeSocks[v]
+		if t and not t.task:addTask() then
+			_remove(self, "w", v, self.t_writeSocks)
+		end
+	end
+
+	-- call the read pumps
+	for i,v in ipairs(r) do
+		local t = self.t_readSocks[v]
+		if t and not t.task:addTask() then
+			_remove(self, "r", v, self.t_readSocks)
+		end
+	end
+
+	-- manage timeouts
+	for i,v in ipairs(wt) do
+		local t = self.t_writeSocks[v]
+		if t then
+			log:warn("network thread timeout for ", t.task)
+			t.task:addTask("inactivity timeout")
+		end
+	end
+
+	for i,v in ipairs(rt) do
+		local t = self.t_readSocks[v]
+		if t then
+			log:warn("network thread timeout for ", t.task)
+			t.task:addTask("inactivity timeout")
+		end
+	end
+end
+
+
 -- _thread
 -- the thread function with the endless loop
 local function _run(self, timeout)
@@ -196,15 +256,17 @@ local function _run(self, timeout)
 
 	log:debug("NetworkThread starting...")
 
+	local wait = self.reactor and _t_wait or _t_select
+
 	while true do
 		local timeoutSecs = timeout / 1000
 		if timeoutSecs < 0 then
 			timeoutSecs = 0
 		end
 
-		ok, err = pcall(_t_select, self, timeoutSecs)
+		ok, err = pcall(wait, self, timeoutSecs)
 		if not ok then
-			log:error("error in _t_select: " .. err)
+			log:error("error in network wait: " .. err)
 		end
 
 		_, timeout = Task:yield(true)
@@ -464,6 +526,9 @@ function __init(self)
 		t_readSocks = {},
 		t_writeSocks = {},
 
+		-- persistent socket registrations, replaces select
+		reactor = hasReactor and jive_reactor:open(),
+
 		-- list of objects for notify
 		subscribers = {},
 
@@ -93,6 +93,8 @@ I<uri> : the URI to GET/POST to
 
 I<options> : table with optional parameters: I<t_bodySource> is a lnt12 source required for POST operation;
 I<headers> is a table with aditional headers to use for the request.
+I<buffer> receives the body into a L<jive.buffer> instead of a string, for large
+binary bodies such as artwork.
 
 =cut
 --]]
@@ -114,6 +116,7 @@ function __init(self, sink, method, uri, options)
 	local defHeaders = {}
 	local t_bodySource, headersSink
 	local stream = false
+	local buffer = false
 
 	-- handle the options table
 	if options then
@@ -143,6 +146,10 @@ function __init(self, sink, method, uri, options)
 		if options.stream then
 			stream = options.stream
 		end
+
+		if options.buffer then
+			buffer = true
+		end
 	end
 	
 	-- Default URI settings
@@ -181,6 +188,7 @@ function __init(self, sink, method, uri, options)
 			["done"]        = false,
 			["sink"]        = sink,
 			["stream"]      = stream,
+			["buffer"]      = buffer,
 		},
 		-- stash options in case of redirect
 		options = options,
@@ -319,6 +327,8 @@ function t_getResponseSinkMode(self)
 
 	if self.t_httpResponse.stream then
 		return "jive-by-chunk"
+	elseif self.t_httpResponse.buffer then
+		return "jive-buffer"
 	else
 		return "jive-concat"
 	end
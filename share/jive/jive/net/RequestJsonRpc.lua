@@ -129,6 +129,16 @@ function __init(self, sink, uri, method, params, options)
 end
 
 
+-- Tells SocketHttp to decode the JSON response as it arrives
+function t_getResponseSinkMode(self)
+	if self.t_httpResponse.stream then
+		return 'jive-by-chunk'
+	else
+		return 'jive-json'
+	end
+end
+
+
 -- t_setResponseBody
 -- HTTP socket data to process, along with a safe sink to send it to customer
 function t_setResponseBody(self, data)
@@ -30,7 +30,7 @@ This class implements a HTTP socket running in a L<jive.net.NetworkThread>.
 
 
 -- stuff we use
-local _assert, ipairs, pairs, setmetatable, tostring, tonumber, type = _assert, ipairs, pairs, setmetatable, tostring, tonumber, type
+local _assert, ipairs, pairs, pcall, setmetatable, tostring, tonumber, type = _assert, ipairs, pairs, pcall, setmetatable, tostring, tonumber, type
 
 local math        = require("math")
 local table       = require("table")
@@ -41,6 +41,7 @@ local oo          = require("loop.simple")
 local socket      = require("socket")
 local mime        = require("mime")
 local ltn12       = require("ltn12")
+local json        = require("cjson")
 
 local System      = require("jive.System")
 
@@ -56,6 +57,12 @@ local log         = require("jive.utils.log").logger("net.http")
 
 local JIVE_VERSION = jive.JIVE_VERSION
 
+-- native http parser
+local hasHttpParser, jive_http = pcall(require, "jive.http")
+
+-- native byte buffers
+local hasBuffer, jive_buffer = pcall(require, "jive.buffer")
+
 -- jive.net.SocketHttp is a subclass of jive.net.SocketTcp
 module(...)
 oo.class(_M, SocketTcp)
@@ -63,13 +70,22 @@ oo.class(_M, SocketTcp)
 
 local BLOCKSIZE = 4096
 
+-- largest body buffer allocated up front from the Content-Length
+local BUFFER_PREALLOC = 1024 * 1024
+
 -- timeout for socket operations
 local SOCKET_CONNECT_TIMEOUT = 10 -- connect in 10 seconds
 local SOCKET_BODY_TIMEOUT = 70 -- response in 70 seconds
 
+-- tables decoded by a jive-json sink before other tasks can run
+local DECODE_BUDGET = 50
+
 -- http authentication credentials
 local credentials = {}
 
+-- use the native http parser for responses
+local useHttpParser = hasHttpParser
+
 
 -- Class method to set HTTP authentication headers
 function setCredentials(class, cred)
@@ -84,6 +100,13 @@ function setCredentials(class, cred)
 end
 
 
+-- Class method to switch between the native and the lua response parser,
+-- this takes effect for new connections
+function setHttpParser(class, enabled)
+	useHttpParser = enabled and hasHttpParser
+end
+
+
 --[[
 
 =head2 jive.net.SocketHttp(jnt, host, port, name)
@@ -113,8 +136,19 @@ function __init(self, jnt, host, port, name)
 
 	obj.t_httpRecvRequests = {}
 	obj.t_httpRecvRequest = false
+
+	-- received request whose body is still being decoded, the next
+	-- response is not read until it has been delivered
+	obj.t_httpDecoding = false
 	
 	obj.t_httpProtocol = '1.1'
+
+	-- native response parser, set per connection
+	obj.t_httpParser = false
+
+	-- true once a response has completed on the connection without
+	-- the server closing it, requests may then be pipelined
+	obj.t_httpKeepAlive = false
 	
 	return obj
 end
@@ -202,6 +236,40 @@ function t_sendDequeueIfIdle(self)
 end
 
 
+-- t_getPendingCount
+-- returns the number of requests being sent or waiting for a response
+function t_getPendingCount(self)
+	local count = #self.t_httpRecvRequests
+
+	if self.t_httpSendRequest then
+		count = count + 1
+	end
+	if self.t_httpRecvRequest then
+		count = count + 1
+	end
+
+	return count
+end
+
+
+-- t_isKeepAlive
+-- returns true if the connection is open and has been kept alive
+-- after a response, so further requests can be pipelined
+function t_isKeepAlive(self)
+	return self.t_httpKeepAlive and self:connected()
+end
+
+
+-- _requeueRequests
+-- queues requests again that were sent on a connection that has since
+-- closed, can be overridden by sub-classes
+function _requeueRequests(self, requests)
+	for i = #requests, 1, -1 do
+		table.insert(self.t_httpSendRequests, 1, requests[i])
+	end
+end
+
+
 -- t_sendResolve
 -- resolve the hostname to an ip address
 function t_sendResolve(self)
@@ -259,6 +327,13 @@ function t_sendConnect(self)
 		self:close(err)
 		return
 	end
+
+	if useHttpParser then
+		self.t_httpParser = self.t_httpParser or jive_http:parser()
+		self.t_httpParser:clear()
+	else
+		self.t_httpParser = false
+	end
 		
 	self:t_nextSendState(true, 't_sendRequest')
 end
@@ -464,11 +539,54 @@ end
 
 
 
+-- _t_rcvHeadersParser
+-- reads the status line and headers with the native parser
+local function _t_rcvHeadersParser(self)
+	local parser = self.t_httpParser
+	parser:reset()
+
+	local pump = function (NetworkThreadErr)
+		log:debug(self, ":t_rcvHeaders.pump()")
+		if NetworkThreadErr then
+			log:error(self, ":t_rcvHeaders.pump:", NetworkThreadErr)
+			self:close(NetworkThreadErr)
+			return
+		end
+
+		local statusCode, statusLine, headers = parser:headers(self.t_sock)
+		if not statusCode then
+			-- statusLine is the error
+			if statusLine ~= 'timeout' then
+				log:error(self, ":t_rcvHeaders.pump:", statusLine)
+				self:close(statusLine)
+			end
+			return
+		end
+
+		self.t_httpRecvRequest:t_setResponseHeaders(statusCode, statusLine, headers)
+
+		-- move on to our future...
+		self:t_nextRecvState(true, 't_rcvResponse')
+	end
+
+	self:t_addRead(pump, SOCKET_BODY_TIMEOUT)
+
+	-- a pipelined response may already be buffered
+	if parser:pending() then
+		pump()
+	end
+end
+
+
 -- t_rcvHeaders
 --
 function t_rcvHeaders(self)
 	log:debug(self, ":t_rcvHeaders()")
 
+	if self.t_httpParser then
+		return _t_rcvHeadersParser(self)
+	end
+
 	local line, err, partial = true
 	local source = function()
 		line, err, partial = self.t_sock:receive('*l', partial)
@@ -526,7 +644,7 @@ function t_rcvHeaders(self)
 			if line ~= "" then
 				local name, value = socket.skip(2, string.find(line, "^(.-):%s*(.*)"))
 				if not (name and value) then
-					err = "malformed reponse headers"
+					err = "malformed response headers"
 					log:warn(err)
 					self:close(err)
 					return
@@ -697,7 +815,9 @@ local sinkt = {}
 -- jive-concat sink
 -- a sink that concats chunks and forwards to the request once done
 sinkt["jive-concat"] = function(request)
-	local data = {}
+	-- most bodies arrive in one chunk, only use a table for more
+	local first = false
+	local data = false
 	return function(chunk, src_err)
 		log:debug("SocketHttp.jive-concat.sink(", chunk and #chunk, ", ", src_err, ")")
 		
@@ -708,11 +828,17 @@ sinkt["jive-concat"] = function(request)
 		
 		-- concatenate any chunk
 		if chunk and chunk ~= "" then
-			table.insert(data, chunk)
+			if data then
+				data[#data + 1] = chunk
+			elseif first then
+				data = { first, chunk }
+			else
+				first = chunk
+			end
 		end
 
 		if not chunk or src_err == "done" then
-			local blob = table.concat(data)
+			local blob = data and table.concat(data) or first or ""
 			-- let request decide what to do with data
 			request:t_setResponseBody(blob)
 			log:debug("SocketHttp.jive-concat.sink: done ", #blob)
@@ -753,6 +879,140 @@ sinkt["jive-by-chunk"] = function(request)
 end
 
 
+-- jive-buffer sink
+-- a sink that collects the body in a jive.buffer and forwards it to the
+-- request once done. the http parser appends to the buffer directly and
+-- returns it as the chunk, so the body is never copied into lua strings.
+sinkt["jive-buffer"] = function(request)
+	-- only keep successful responses
+	if request:t_getResponseStatus() ~= 200 or not hasBuffer then
+		return sinkt["jive-concat"](request)
+	end
+
+	local len = tonumber(request:t_getResponseHeader("Content-Length")) or 0
+	local buffer = jive_buffer:new(math.min(len, BUFFER_PREALLOC))
+
+	return function(chunk, src_err)
+		log:debug("SocketHttp.jive-buffer.sink(", chunk and #chunk, ", ", src_err, ")")
+
+		if src_err and src_err ~= "done" then
+			-- let the pump handle errors
+			return nil, src_err
+		end
+
+		-- append string chunks, the parser has already added its data
+		if chunk and chunk ~= buffer and chunk ~= "" then
+			buffer:append(chunk)
+		end
+
+		if not chunk or src_err == "done" then
+			log:debug("SocketHttp.jive-buffer.sink: done ", #buffer)
+			-- as jive-concat, deliver empty bodies as is
+			request:t_setResponseBody(#buffer > 0 and buffer or "")
+			return nil
+		end
+
+		return true
+	end, buffer
+end
+
+
+-- jive-json sink
+-- a sink that decodes a JSON body as it arrives and forwards the value to
+-- the request once done. large bodies are decoded a few items at a time
+-- by a task, so the ui keeps running while big menus load. the third
+-- value returned calls back once the body has been delivered, so the
+-- socket can hold later responses until then.
+sinkt["jive-json"] = function(request)
+	-- only successful responses are JSON
+	if request:t_getResponseStatus() ~= 200 or not json.decoder then
+		return sinkt["jive-concat"](request)
+	end
+
+	local decoder = json.decoder()
+	local empty = true
+	local task = false
+	local whenDone = false
+
+	-- returns true while there is more to decode
+	local decode = function()
+		local ok, done, value = pcall(decoder.decode, decoder, DECODE_BUDGET)
+
+		if not ok then
+			log:warn("SocketHttp.jive-json.sink: ", done)
+			decoder = false
+
+			local sink = request:t_getResponseSink()
+			if sink then
+				sink(nil, done)
+			end
+			return false
+		end
+
+		if done then
+			log:debug("SocketHttp.jive-json.sink: done")
+			request:t_setResponseBody(value)
+			return false
+		end
+
+		return value == "budget"
+	end
+
+	return function(chunk, src_err)
+		log:debug("SocketHttp.jive-json.sink(", chunk and #chunk, ", ", src_err, ")")
+
+		if src_err and src_err ~= "done" then
+			-- let the pump handle errors
+			return nil, src_err
+		end
+
+		local last = not chunk or src_err == "done"
+
+		if decoder then
+			if chunk and chunk ~= "" then
+				decoder:feed(chunk)
+				empty = false
+			end
+
+			if last and empty then
+				-- as jive-concat, deliver empty bodies as is
+				request:t_setResponseBody("")
+
+			elseif last then
+				decoder:finish()
+			end
+
+			if not empty and not task and decode() then
+				task = Task("jive-json", request, function()
+					while decoder and decode() do
+						Task:yield(true)
+					end
+					task = false
+
+					if whenDone then
+						whenDone()
+						whenDone = false
+					end
+				end)
+				task:addTask()
+			end
+		end
+
+		if last then
+			return nil
+		end
+
+		return true
+	end, nil, function(callback)
+		if task then
+			whenDone = callback
+		else
+			callback()
+		end
+	end
+end
+
+
 -- _getSink
 -- returns a sink for the request
 local function _getSink(mode, request, customerSink)
@@ -768,10 +1028,31 @@ end
 -- t_rcvResponse
 -- acrobatics to read the response body
 function t_rcvResponse(self)
+	local parser = self.t_httpParser
 	local mode
 	local len
+	local source
+	local connectionClose
 
-	if self.t_httpRecvRequest:t_getResponseHeader('Transfer-Encoding') == 'chunked' then
+	-- the sink may provide a buffer for the parser to receive into
+	local sinkMode = self.t_httpRecvRequest:t_getResponseSinkMode()
+	local sink, buffer, whenDelivered = _getSink(sinkMode, self.t_httpRecvRequest)
+
+	if parser then
+
+		mode = 'jive-http-parser'
+
+		-- don't count the chunked connections as active, these are
+		-- long term connections used for server push
+		if parser:chunked() then
+			self:socketInactive()
+		end
+
+		source = function()
+			return parser:body(self.t_sock, buffer)
+		end
+
+	elseif self.t_httpRecvRequest:t_getResponseHeader('Transfer-Encoding') == 'chunked' then
 	
 		mode = 'jive-http-chunked'
 
@@ -791,12 +1072,10 @@ function t_rcvResponse(self)
 		end
 	end
 
-	local connectionClose = self.t_httpRecvRequest:t_getResponseHeader('Connection') == 'close'
-	
-	local source = socket.source(mode, self.t_sock, len or self)
-	
-	local sinkMode = self.t_httpRecvRequest:t_getResponseSinkMode()
-	local sink = _getSink(sinkMode, self.t_httpRecvRequest)
+	if not parser then
+		connectionClose = self.t_httpRecvRequest:t_getResponseHeader('Connection') == 'close'
+		source = socket.source(mode, self.t_sock, len or self)
+	end
 
 	local pump = function (NetworkThreadErr)
 		log:debug(self, ":t_rcvResponse.pump(", mode, ", ", tostring(nt_err) , ")")
@@ -809,6 +1088,12 @@ function t_rcvResponse(self)
 		
 		
 		local continue, err = ltn12.pump.step(source, sink)
+
+		-- the parser has read everything available from the socket,
+		-- so process all buffered data now
+		while continue and parser do
+			continue, err = ltn12.pump.step(source, sink)
+		end
 		
 		-- shortcut on timeout
 		if err == 'timeout' then
@@ -828,17 +1113,55 @@ function t_rcvResponse(self)
 				return
 			end
 
-			if connectionClose then
+			if connectionClose or (parser and not parser:keepalive()) then
 				-- just close the socket, don't reset our state
 				SocketTcp.close(self)
+				self.t_httpKeepAlive = false
+
+				-- requests pipelined behind this response will
+				-- not be answered, send them again once it is done
+				local requests = self.t_httpRecvRequests
+				if self.t_httpSendRequest then
+					table.insert(requests, self.t_httpSendRequest)
+					self.t_httpSendRequest = false
+					self:t_nextSendState(false, 't_sendDequeue')
+				end
+				if #requests > 0 then
+					log:info(self, " requeuing ", #requests, " pipelined requests")
+					self.t_httpRecvRequests = {}
+					self:_requeueRequests(requests)
+				end
+			else
+				self.t_httpKeepAlive = true
 			end
 
-			-- move on to our future
-			self:t_nextRecvState(true, 't_recvComplete')
+			-- move on to our future, once the body has been delivered
+			-- so a later response can not overtake a deferred decode
+			if whenDelivered then
+				local request = self.t_httpRecvRequest
+				self.t_httpDecoding = request
+
+				whenDelivered(function()
+					if self.t_httpDecoding == request then
+						self.t_httpDecoding = false
+						self:t_nextRecvState(true, 't_recvComplete')
+					else
+						-- the socket closed while it was delivered
+						self:t_recvDelivered(request)
+					end
+				end)
+			else
+				self:t_nextRecvState(true, 't_recvComplete')
+			end
 		end
 	end
 	
 	self:t_addRead(pump, SOCKET_BODY_TIMEOUT)
+
+	-- the body may already be buffered with the headers
+	if parser and parser:pending() then
+		pump()
+	end
 end
 
 
@@ -847,6 +1170,15 @@ function t_recvComplete(self)
 
 	self.t_httpRecvRequest = false
 	self:t_nextRecvState(true, 't_recvDequeue')
+
+	-- send any requests held back while this response was received
+	self:t_sendDequeueIfIdle()
+end
+
+
+-- t_recvDelivered
+-- a response received in full was delivered after the socket was closed
+function t_recvDelivered(self, request)
 end
 
 
@@ -862,6 +1194,7 @@ function free(self)
 
 	self.t_httpRecvRequests = {}
 	self.t_httpRecvRequest = false
+	self.t_httpDecoding = false
 	
 	SocketTcp.free(self)
 end
@@ -874,17 +1207,21 @@ function close(self, err)
 
 	-- close the socket
 	SocketTcp.close(self)
+	self.t_httpKeepAlive = false
 
 	-- cancel all requests 'on the wire'
 	local errorSendRequest = self.t_httpSendRequest
 	local errorRecvRequests = self.t_httpRecvRequests
-	if self.t_httpRecvRequest then
+	if self.t_httpRecvRequest and self.t_httpRecvRequest ~= self.t_httpDecoding then
 		table.insert(errorRecvRequests, 1, self.t_httpRecvRequest)
 	end
 
+	-- a response being decoded has been received in full, it is still
+	-- delivered but no longer holds up the socket
 	self.t_httpSendRequest = false
 	self.t_httpRecvRequest = false
 	self.t_httpRecvRequests = {}
+	self.t_httpDecoding = false
 
 	-- start again
 	self:t_nextSendState(true, 't_sendDequeue')
@@ -23,7 +23,7 @@ None provided.
 
 
 -- stuff we use
-local _assert, tostring = _assert, tostring
+local _assert, ipairs, tostring = _assert, ipairs, tostring
 
 local oo         = require("loop.simple")
 
@@ -44,7 +44,9 @@ oo.class(_M, SocketHttp)
 Same as L<jive.net.SocketHttp>, save for the I<queueObj> parameter
 which must refer to an object implementing a B<t_dequeue> function
 that returns a request from its queue and a boolean indicating if
-the connection must close.
+the connection must close. The object is told when each request is
+done with B<t_done>, and given back requests that must be sent again
+with B<t_requeue>.
 
 =cut
 --]]
@@ -81,6 +83,50 @@ function _dequeueRequest(self)
 end
 
 
+-- _requeueRequests
+-- returns requests to the queue object, to be sent on any connection
+function _requeueRequests(self, requests)
+	self.httpqueue:t_requeue(self, requests)
+end
+
+
+function t_recvComplete(self)
+	local request = self.t_httpRecvRequest
+
+	SocketHttp.t_recvComplete(self)
+
+	self.httpqueue:t_done(self, request)
+end
+
+
+-- a response being decoded when the socket closed is done once delivered
+function t_recvDelivered(self, request)
+	self.httpqueue:t_done(self, request)
+end
+
+
+function close(self, err)
+	-- requests on the wire fail with the connection, except a response
+	-- received in full that is still being delivered
+	local requests = {}
+	if self.t_httpSendRequest then
+		requests[#requests + 1] = self.t_httpSendRequest
+	end
+	if self.t_httpRecvRequest and self.t_httpRecvRequest ~= self.t_httpDecoding then
+		requests[#requests + 1] = self.t_httpRecvRequest
+	end
+	for i, request in ipairs(self.t_httpRecvRequests) do
+		requests[#requests + 1] = request
+	end
+
+	SocketHttp.close(self, err)
+
+	for i, request in ipairs(requests) do
+		self.httpqueue:t_done(self, request, err or "closed")
+	end
+end
+
+
 --[[
 
 =head2 tostring(aSocket)
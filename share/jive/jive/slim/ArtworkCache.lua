@@ -4,16 +4,29 @@
 
 jive.slim.ArtworkCache - Size bounded LRU cache for artwork
 
+Values are the compressed artwork, as strings or jive.buffer objects.
+
+Artwork is also kept in a disk cache under the user directory, shared by
+all servers, so it survives a restart. The disk cache writes from a
+background thread. Resized images may be stored there too, to be used
+without fetching or decoding the artwork again, see
+L<jive.slim.ArtworkCache:setStoreImages>.
+
 --]]
 
-local pairs, setmetatable = pairs, setmetatable
+local pairs, pcall, require, setmetatable = pairs, pcall, require, setmetatable
 
 local os          = require("os")
 local oo          = require("loop.base")
+local lfs         = require("lfs")
+
+local System      = require("jive.System")
 
 local debug       = require("jive.utils.debug")
 local log         = require("jive.utils.log").logger("squeezebox.server.cache")
 
+local hasDiskCache, DiskCache = pcall(require, "jive.diskcache")
+
 
 -- ArtworkCache is a base class
 module(..., oo.class)
@@ -22,9 +35,44 @@ module(..., oo.class)
 -- Limit artwork cache to 8 Mbytes
 local ARTWORK_LIMIT = 24 * 1024 * 1024
 
+-- Limit disk cache to 64 Mbytes
+local DISK_LIMIT = 64 * 1024 * 1024
+
+-- disk cache, opened on first use
+local diskCache = nil
+
+-- store resized images as pixels in the disk cache
+local storeImages = false
+
+
+local function _openDiskCache()
+	if diskCache == nil then
+		diskCache = false
+
+		if hasDiskCache then
+			local dir = System.getUserDir() .. "/cache"
+			lfs.mkdir(dir)
+
+			local cache, err = DiskCache:open(dir .. "/artwork", DISK_LIMIT)
+			if cache then
+				diskCache = cache
+			else
+				log:warn("disk cache: ", err)
+			end
+		end
+	end
+
+	return diskCache
+end
+
 
-function __init(self)
-	local obj = oo.rawnew(self, {})
+-- namespace is prefixed to the disk cache keys, as artwork ids are
+-- only unique for one server
+function __init(self, namespace)
+	local obj = oo.rawnew(self, {
+		namespace = (namespace or "") .. ":",
+		disk = _openDiskCache(),
+	})
 
 	-- initialise state
 	obj:free()
@@ -79,7 +127,16 @@ function set(self, key, value)
 		return
 	end
 
-	-- loaded artwork
+	if self.disk then
+		self.disk:set(self.namespace .. key, value)
+	end
+
+	self:_add(key, value)
+end
+
+
+-- add loaded artwork to the memory cache
+function _add(self, key, value)
 	local bytes = #value
 
 	self.total = self.total + bytes
@@ -130,7 +187,11 @@ function get(self, key)
 	local entry = self.cache[key]
 
 	if not entry then
-		return nil
+		local value = self.disk and self.disk:get(self.namespace .. key)
+		if value then
+			self:_add(key, value)
+		end
+		return value
 	end
 
 	-- loading or already most recently used entry?
@@ -167,6 +228,41 @@ function get(self, key)
 end
 
 
+--[[
+
+=head2 jive.slim.ArtworkCache:setStoreImages(enable)
+
+Class method, enables storing resized images as their pixels in the disk
+cache. This trades disk space, several times the compressed size, for
+not decoding the artwork again after a restart.
+
+=cut
+--]]
+function setStoreImages(class, enable)
+	storeImages = enable and true or false
+end
+
+
+-- returns true if a resized image is in the disk cache, without reading it
+function hasImage(self, key)
+	return storeImages and self.disk and self.disk:hasSurface(self.namespace .. key) or false
+end
+
+
+-- returns a resized image from the disk cache
+function getImage(self, key)
+	return storeImages and self.disk and self.disk:getSurface(self.namespace .. key) or nil
+end
+
+
+-- stores a resized image in the disk cache
+function setImage(self, key, image)
+	if storeImages and self.disk then
+		self.disk:setSurface(self.namespace .. key, image)
+	end
+end
+
+
 --[[
 
 =head1 LICENSE
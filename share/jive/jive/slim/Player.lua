@@ -36,7 +36,7 @@ Notifications:
 
 
 -- stuff we need
-local _assert, assert, require, setmetatable, tonumber, tostring, ipairs, pairs, type, bit = _assert, assert, require, setmetatable, tonumber, tostring, ipairs, pairs, type, bit
+local _assert, assert, require, select, setmetatable, tonumber, tostring, ipairs, pairs, type, bit = _assert, assert, require, select, setmetatable, tonumber, tostring, ipairs, pairs, type, bit
 
 local os             = require("os")
 local math           = require("math")
@@ -131,6 +131,69 @@ local playerList = {}
 -- current player
 local currentPlayer = nil
 
+-- playerstatus fields used by jive, other fields are skipped when the
+-- status is decoded. applets using other fields must add them with
+-- Player:addStatusFields()
+local statusFields = {
+	["error"] = true,
+	["player_name"] = true,
+	["player_connected"] = true,
+	["player_needs_upgrade"] = true,
+	["player_is_upgrading"] = true,
+	["power"] = true,
+	["mode"] = true,
+	["remote"] = true,
+	["remoteMeta"] = true,
+	["current_title"] = true,
+	["time"] = true,
+	["rate"] = true,
+	["duration"] = true,
+	["can_seek"] = true,
+	["sleep"] = true,
+	["seq_no"] = true,
+	["mixer volume"] = true,
+	["digital_volume_control"] = true,
+	["use_volume_control"] = true,
+	["playlist repeat"] = true,
+	["playlist shuffle"] = true,
+	["playlist_cur_index"] = true,
+	["playlist_timestamp"] = true,
+	["playlist_tracks"] = true,
+	["waitingToPlay"] = true,
+	["preset_loop"] = true,
+	["alarm_state"] = true,
+	["alarm_next"] = true,
+	["alarm_next2"] = true,
+	["alarm_version"] = true,
+	["alarm_repeat"] = true,
+	["alarm_days"] = true,
+	["alarm_snooze_seconds"] = true,
+	["alarm_timeout_seconds"] = true,
+	["artwork"] = true,
+	-- menu fields used by the playlist
+	["base"] = true,
+	["window"] = true,
+	["count"] = true,
+	["offset"] = true,
+	["item_loop"] = true,
+}
+
+
+--[[
+
+=head2 jive.slim.Player:addStatusFields(...)
+
+Adds fields to decode from playerstatus updates, only the fields used by
+jive are decoded by default.
+
+=cut
+--]]
+function addStatusFields(class, ...)
+	for i = 1, select('#', ...) do
+		statusFields[select(i, ...)] = true
+	end
+end
+
 
 -- class method to iterate over all players
 function iterate(class)
@@ -262,6 +325,32 @@ local function _formatShowBrieflyText(msg)
 end
 
 
+-- the interpolated elapsed time is only corrected from the playerstatus
+-- when it has drifted by more than this many seconds
+local ELAPSED_DRIFT = 1.5
+
+
+-- _diffStatus(old, new)
+-- returns the set of playerstatus fields that have changed, tables such
+-- as item_loop are not compared
+local function _diffStatus(old, new)
+	local changed = {}
+
+	for k, v in pairs(new) do
+		if type(v) ~= "table" and old[k] ~= v then
+			changed[k] = true
+		end
+	end
+	for k, v in pairs(old) do
+		if new[k] == nil and type(v) ~= "table" then
+			changed[k] = true
+		end
+	end
+
+	return changed
+end
+
+
 -- _whatsPlaying(obj)
 -- returns the track_id from a playerstatus structure
 local function _whatsPlaying(obj)
@@ -973,7 +1062,9 @@ function onStage(self)
 		'/slim/playerstatus/' .. self.id,
 		_getSink(self, cmd),
 		self.id,
-		cmd
+		cmd,
+		nil,
+		statusFields
 	)
 
 	-- subscribe to displaystatus
@@ -1163,13 +1254,38 @@ function _process_status(self, event)
 	local oldState = self.state
 	self.state = event.data
 
+	--Ignore fractional component of volume
+	self.state["mixer volume"] = self.state["mixer volume"] and math.floor(tonumber(self.state["mixer volume"])) or nil
+
+	-- only the fields that have changed are acted on below
+	local changed = _diffStatus(oldState, self.state)
+
+	local nowPlaying, artwork = _whatsPlaying(event.data)
+	local trackChanged = self.nowPlaying ~= nowPlaying or self.nowPlayingArtwork ~= artwork
+
+	-- used for calculating getTrackElapsed(), getTrackRemaining(). the
+	-- elapsed time is interpolated locally, it is only reset if the track
+	-- or play rate changed or the server time has drifted, for example
+	-- after a seek
+	local trackTime = tonumber(event.data.time)
+	local elapsed = self.rate and self:getTrackElapsed()
 
-	-- used for calculating getTrackElapsed(), getTrackRemaining()
 	self.rate = tonumber(event.data.rate)
-	self.trackSeen = Framework:getTicks() / 1000
-	self.trackCorrection = 0
-	self.trackTime = tonumber(event.data.time)
 	self.trackDuration = tonumber(event.data.duration)
+
+	if trackChanged or changed.rate or changed.mode or changed.duration
+		or not elapsed or not trackTime
+		or math.abs(elapsed - trackTime) > ELAPSED_DRIFT then
+
+		self.trackSeen = Framework:getTicks() / 1000
+		self.trackCorrection = 0
+		self.trackTime = trackTime
+
+		if not trackChanged then
+			self.jnt:notify('playerTrackPosition', self, trackTime, self.trackDuration)
+		end
+	end
+
 	self.playlistSize = tonumber(event.data.playlist_tracks)
 	-- add 1 to playlist_cur_index to get 1-based place in playlist
 	self.playlistCurrentIndex = event.data.playlist_cur_index and tonumber(event.data.playlist_cur_index) + 1
@@ -1208,10 +1324,7 @@ function _process_status(self, event)
 	end
 	self:updatePlayerInfo(self.slimServer, playerInfo, useSequenceNumber, isSequenceNumberInSync)
 
-	-- update track list
-	local nowPlaying, artwork = _whatsPlaying(event.data)
-
-	if self.state.mode ~= oldState.mode then
+	if changed.mode then
 		-- self.mode is set immedidately by togglePause and stop methods to give immediate user feedback in e.g. iconbar
 		-- getPlayerMode method uses self.mode not self.state.mode, so we need to set self.mode again here to be certain it's correct                                          
 		log:debug('notify_playerModeChange')
@@ -1227,12 +1340,12 @@ function _process_status(self, event)
 	log:debug("self.state['alarm_repeat']: ", self.state['alarm_repeat'], ",  oldState['alarm_repeat']: ", oldState['alarm_repeat'])
 	log:debug("self.state['alarm_days']: ", self.state['alarm_days'], ",  oldState['alarm_days']: ", oldState['alarm_days'])
 
-	if self.state['alarm_state'] ~= oldState['alarm_state'] or
-	   self.state['alarm_next'] ~= oldState['alarm_next'] or
-	   self.state['alarm_version'] ~= oldState['alarm_version'] or
-	   self.state['alarm_next2'] ~= oldState['alarm_next2'] or
-	   self.state['alarm_repeat'] ~= oldState['alarm_repeat'] or
-	   self.state['alarm_days'] ~= oldState['alarm_days'] then
+	if changed['alarm_state'] or
+	   changed['alarm_next'] or
+	   changed['alarm_version'] or
+	   changed['alarm_next2'] or
+	   changed['alarm_repeat'] or
+	   changed['alarm_days'] then
 		log:debug('notify_playerAlarmState')
 		-- none from server for alarm_state changes this to nil
 		if self.state['alarm_state'] == 'none' then
@@ -1253,35 +1366,37 @@ function _process_status(self, event)
 
 	end
 
-	if self.state['playlist shuffle'] ~= oldState['playlist shuffle'] then
+	if changed['playlist shuffle'] then
 		log:debug('notify_playerShuffleModeChange')
 		self.jnt:notify('playerShuffleModeChange', self, self.state['playlist shuffle'])
 	end
 
-	if self.state['sleep'] ~= oldState['sleep'] then
+	if changed['sleep'] then
 		log:debug('notify_playerSleepChange')
 		self.jnt:notify('playerSleepChange', self, self.state['sleep'])
 	end
 
-	if self.state['playlist repeat'] ~= oldState['playlist repeat'] then
+	if changed['playlist repeat'] then
 		log:debug('notify_playerRepeatModeChange')
 		self.jnt:notify('playerRepeatModeChange', self, self.state['playlist repeat'])
 	end
 
-	if self.nowPlaying ~= nowPlaying or self.nowPlayingArtwork ~= artwork then
+	if trackChanged then
 		log:debug('notify_playerTrackChange')
 		self.nowPlaying = nowPlaying
 		self.nowPlayingArtwork = artwork
 		self.jnt:notify('playerTrackChange', self, nowPlaying, artwork)
 	end
 
-	if self.state.playlist_timestamp ~= oldState.playlist_timestamp then
+	if changed.playlist_timestamp then
 		log:debug('notify_playerPlaylistChange')
 		self.jnt:notify('playerPlaylistChange', self)
-	end
 
-	--Ignore fractional component of volume
-	self.state["mixer volume"] = self.state["mixer volume"] and math.floor(tonumber(self.state["mixer volume"])) or nil
+	elseif changed.playlist_cur_index or changed.playlist_tracks then
+		-- the playlist change also covers the index
+		log:debug('notify_playerPlaylistIndexChange')
+		self.jnt:notify('playerPlaylistIndexChange', self, self.playlistCurrentIndex, self.playlistSize)
+	end
 
 	--might use server volume
 	if useSequenceNumber then
@@ -1310,8 +1425,17 @@ function _process_status(self, event)
 			self:refreshLocallyMaintainedParameters()
 		end
 	end
-	-- update iconbar
-	self:updateIconbar()
+	if self.state["mixer volume"] ~= oldState["mixer volume"] then
+		log:debug('notify_playerVolumeChange')
+		self.jnt:notify('playerVolumeChange', self, self.state["mixer volume"])
+	end
+
+	-- update iconbar, if anything it shows has changed
+	if changed.mode or changed['playlist shuffle'] or changed['sleep']
+		or changed['playlist repeat'] or changed.waitingToPlay then
+
+		self:updateIconbar()
+	end
 end
 
 function _alertWindow(self, title, textValue)
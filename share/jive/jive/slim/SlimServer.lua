@@ -53,6 +53,7 @@ local Task        = require("jive.ui.Task")
 local Framework   = require("jive.ui.Framework")
 
 local ArtworkCache = require("jive.slim.ArtworkCache")
+local ThumbnailCache = require("jive.slim.ThumbnailCache")
 
 local debug       = require("jive.utils.debug")
 local log         = require("jive.utils.log").logger("squeezebox.server")
@@ -63,6 +64,23 @@ local jnt          = jnt
 
 local SERVER_DISCONNECT_LAG_TIME = 10000
 
+-- artwork fetched from the server, connections, requests pipelined per
+-- connection and requests in flight
+local ARTWORK_POOL_SIZE = 2
+local ARTWORK_PIPELINE_DEPTH = 4
+local ARTWORK_IN_FLIGHT = 8
+
+-- artwork fetched directly from other hosts, in flight per host, and the
+-- number of idle host pools kept open
+local REMOTE_ARTWORK_IN_FLIGHT = 2
+local REMOTE_ARTWORK_POOLS = 4
+
+-- artwork requests handed to the pools at once
+local ARTWORK_FETCH_LIMIT = 12
+
+-- fetch priority of artwork for a menu that is no longer in view
+local ARTWORK_OFFSCREEN = 1000000
+
 -- jive.slim.SlimServer is a base class
 module(..., oo.class)
 
@@ -470,15 +488,42 @@ function __init(self, jnt, id, name, version)
 		-- artwork http pool, initially not connected
 		artworkPool = false,
 
+		-- artwork http pools for other hosts, by host and port, and
+		-- when each was last used
+		remoteArtworkPools = {},
+		remoteArtworkPoolsUsed = {},
+
 		-- artwork cache: Weak table storing a surface by iconId
-		artworkCache = ArtworkCache(),
+		artworkCache = ArtworkCache(id),
+
+		-- resized artwork, by id and size
+		thumbnailCache = ThumbnailCache(),
 
 		-- Icons waiting for the given iconId
 		artworkThumbIcons = {},
 
-		-- queue of artwork to fetch
+		-- queue of artwork to fetch, a heap ordered by the distance
+		-- from the menu viewport, and its entries by cache key
 		artworkFetchQueue = {},
+		artworkFetchEntries = {},
 		artworkFetchCount = 0,
+		artworkFetchSeq = 0,
+
+		-- visible items of the menu showing artwork, the queue is
+		-- reordered when they change
+		artworkViewport = false,
+		artworkFetchReorder = false,
+
+		-- fetched artwork that was displayed or no longer wanted,
+		-- and requests dropped before they were fetched
+		artworkStats = {
+			used = 0,
+			wasted = 0,
+			dropped = 0,
+		},
+
+		-- artwork requests handed to a pool, by cache key
+		artworkRequests = {},
 
 		-- loaded images
 		imageCache = {},
@@ -517,6 +562,9 @@ function __init(self, jnt, id, name, version)
 
 	setmetatable(obj.imageCache, { __mode = "kv" })
 
+	-- don't keep icons alive waiting for artwork
+	setmetatable(obj.artworkThumbIcons, { __mode = "k" })
+
 	serverIds[obj.id] = obj
 
 	-- subscribe to comet events
@@ -591,7 +639,9 @@ function updateAddress(self, ip, port, name)
 
 		if not self:isSqueezeNetwork() then
 			-- artwork http pool
-			self.artworkPool = HttpPool(self.jnt, self.name, ip, port, 2, 1, Task.PRIORITY_LOW)
+			self.artworkPool = HttpPool(self.jnt, self.name, ip, port, ARTWORK_POOL_SIZE, 1, Task.PRIORITY_LOW)
+			self.artworkPool:setPipelineDepth(ARTWORK_PIPELINE_DEPTH)
+			self.artworkPool:setMaxInFlight(ARTWORK_IN_FLIGHT)
 		end
 
 		-- comet
@@ -627,7 +677,8 @@ function free(self)
 
 	-- clear cache
 	self.artworkCache:free()
-	self.artworkThumbIcons = {}
+	self.thumbnailCache:free()
+	self.artworkThumbIcons = setmetatable({}, { __mode = "k" })
 
 	-- server is gone
 	self.lastSeen = 0
@@ -703,6 +754,28 @@ function connect(self)
 end
 
 
+-- closes and frees the artwork pool for another host. requests still
+-- queued on it are dropped so the artwork can be fetched again later.
+local function _freeRemoteArtworkPool(self, key)
+	local pool = self.remoteArtworkPools[key]
+
+	for cacheKey, fetch in pairs(self.artworkRequests) do
+		if fetch.pool == pool and pool:cancel(fetch.req) then
+			self.artworkRequests[cacheKey] = nil
+			self.artworkFetchCount = self.artworkFetchCount - 1
+			self.artworkCache:set(cacheKey, nil)
+		end
+	end
+
+	-- requests on the wire fail, and their sinks release them
+	pool:close()
+	pool:free()
+
+	self.remoteArtworkPools[key] = nil
+	self.remoteArtworkPoolsUsed[key] = nil
+end
+
+
 function _disconnectServerInternals(self)
 
 	self.netstate = 'disconnected'
@@ -710,6 +783,10 @@ function _disconnectServerInternals(self)
 	if not self:isSqueezeNetwork() then
 		self.artworkPool:close()
 	end
+
+	for key, pool in pairs(self.remoteArtworkPools) do
+		_freeRemoteArtworkPool(self, key)
+	end
 	
 	self.comet:disconnect()
 
@@ -879,28 +956,35 @@ function linked(self, pin)
 end
 
 
+-- parse size specification for width and height if in format <W>x<H>
+local function _parseSize(size)
+	local sizeW = tonumber(string.match(size, "(%d+)x%d+") or size)
+	local sizeH = tonumber(string.match(size, "%d+x(%d+)") or size)
+
+	return sizeW, sizeH
+end
+
+
 -- convert artwork to a resized image
-local function _loadArtworkImage(self, cacheKey, chunk, size)
-	-- create a surface
-	local image = Surface:loadImageData(chunk, #chunk)
+local function _loadArtworkImage(self, cacheKey, thumbId, chunk, size)
+	local sizeW, sizeH = _parseSize(size)
 
-	local w, h = image:getSize()
+	-- create a surface, large artwork is decoded at about the size it
+	-- is shown, w and h are the size of the artwork
+	local image, w, h = Surface:loadImageScaled(chunk, sizeW, sizeH)
 
 	-- don't display empty artwork
-	if w == 0 or h == 0 then
+	if not image or w == 0 or h == 0 then
 		self.imageCache[cacheKey] = true
 		return nil
 	end
 
-	-- parse size specification for width and height if in format <W>x<H>
-	local sizeW = tonumber(string.match(size, "(%d+)x%d+") or size)
-	local sizeH = tonumber(string.match(size, "%d+x(%d+)") or size)
-
-	-- Resize image
+	-- Resize image, if the decoded image does not already fit the box
 	-- Note this allows for artwork to be resized to a larger
 	-- size than the original.  This is intentional so smaller cover
 	-- art will still fill the space properly on the Now Playing screen
-	if w ~= sizeW and h ~= sizeH then
+	local iw, ih = image:getSize()
+	if iw ~= sizeW and ih ~= sizeH then
 		local tmp = image:resize(sizeW, sizeH, true)
 		image:release()
 		image = tmp
@@ -912,6 +996,41 @@ local function _loadArtworkImage(self, cacheKey, chunk, size)
 
 	-- cache image
 	self.imageCache[cacheKey] = image
+	self.thumbnailCache:set(thumbId, sizeW, sizeH, image)
+	self.artworkCache:setImage(cacheKey, image)
+
+	return image
+end
+
+
+-- returns a resized image from the thumbnail cache, resizing a larger
+-- size of the same artwork if needed
+local function _getThumbnail(self, thumbId, size)
+	local sizeW, sizeH = _parseSize(size)
+
+	local image = self.thumbnailCache:get(thumbId, sizeW, sizeH)
+	if image then
+		return image
+	end
+
+	local larger = self.thumbnailCache:getLarger(thumbId, sizeW, sizeH)
+	if not larger then
+		return nil
+	end
+
+	local w, h = larger:getSize()
+	if w ~= sizeW and h ~= sizeH then
+		image = larger:resize(sizeW, sizeH, true)
+	else
+		image = larger
+	end
+
+	if logcache:isDebug() then
+		local wnew, hnew = image:getSize()
+		logcache:debug("Resized thumbnail from ", w, "x", h, " to ", wnew, "x", hnew)
+	end
+
+	self.thumbnailCache:set(thumbId, sizeW, sizeH, image)
 
 	return image
 end
@@ -919,7 +1038,7 @@ end
 
 -- _getArworkThumbSink
 -- returns a sink for artwork so we can cache it as Surface before sending it forward
-local function _getArtworkThumbSink(self, cacheKey, size, url)
+local function _getArtworkThumbSink(self, cacheKey, thumbId, size, url, wanted)
 
 	assert(size)
 	
@@ -929,6 +1048,7 @@ local function _getArtworkThumbSink(self, cacheKey, size, url)
 			-- allow more artwork to be fetched
 			self.artworkFetchCount = self.artworkFetchCount - 1
 			self.artworkFetchTask:addTask()
+			self.artworkRequests[cacheKey] = nil
 		end
 
 		-- on error, print something...
@@ -942,50 +1062,229 @@ local function _getArtworkThumbSink(self, cacheKey, size, url)
 			-- store the compressed artwork in the cache
 			self.artworkCache:set(cacheKey, chunk)
 
-			local image = _loadArtworkImage(self, cacheKey, chunk, size)
+			local image = _loadArtworkImage(self, cacheKey, thumbId, chunk, size)
 
 			-- set it to all icons waiting for it
+			local used = false
 			local icons = self.artworkThumbIcons
 			for icon, key in pairs(icons) do
 				if key == cacheKey then
 					icon:setValue(image)
 					icons[icon] = nil
+					used = true
 				end
 			end
+
+			-- count fetches for icons that had moved on
+			local stats = self.artworkStats
+			if used then
+				stats.used = stats.used + 1
+			elseif wanted then
+				stats.wasted = stats.wasted + 1
+			end
+			logcache:debug("artwork used=", stats.used, " wasted=", stats.wasted, " dropped=", stats.dropped)
+		end
+	end
+end
+
+
+-- returns the pool for artwork from another host. the least recently
+-- used idle pool is freed when there are too many.
+local function _getRemoteArtworkPool(self, uri)
+	local key = uri.host .. ":" .. uri.port
+
+	local pool = self.remoteArtworkPools[key]
+	if not pool then
+		local count, oldest = 0, false
+
+		for k, p in pairs(self.remoteArtworkPools) do
+			count = count + 1
+
+			if p:isIdle() and (not oldest or self.remoteArtworkPoolsUsed[k] < self.remoteArtworkPoolsUsed[oldest]) then
+				oldest = k
+			end
+		end
+
+		if count >= REMOTE_ARTWORK_POOLS and oldest then
+			_freeRemoteArtworkPool(self, oldest)
+		end
+
+		pool = HttpPool(self.jnt, uri.host, uri.host, uri.port, REMOTE_ARTWORK_IN_FLIGHT, 1, Task.PRIORITY_LOW)
+		pool:setMaxInFlight(REMOTE_ARTWORK_IN_FLIGHT)
+
+		self.remoteArtworkPools[key] = pool
+	end
+
+	self.remoteArtworkPoolsUsed[key] = Framework:getTicks()
+
+	return pool
+end
+
+
+-- returns the distance of the artwork from the menu viewport, in items
+local function _artworkDistance(self, entry)
+	local view = self.artworkViewport
+
+	if not entry.index then
+		-- not in a menu, such as now playing artwork
+		return 0
+	elseif entry.view ~= view then
+		return ARTWORK_OFFSCREEN
+	elseif entry.index < view.first then
+		return view.first - entry.index
+	elseif entry.index > view.last then
+		return entry.index - view.last
+	else
+		return 0
+	end
+end
+
+
+-- nearest artwork first, then the most recently requested
+local function _artworkBefore(a, b)
+	if a.distance ~= b.distance then
+		return a.distance < b.distance
+	end
+	return a.seq > b.seq
+end
+
+
+local function _artworkSiftUp(queue, i)
+	local entry = queue[i]
+
+	while i > 1 do
+		local parent = math.floor(i / 2)
+		if not _artworkBefore(entry, queue[parent]) then
+			break
 		end
+		queue[i] = queue[parent]
+		i = parent
+	end
+	queue[i] = entry
+end
+
+
+local function _artworkSiftDown(queue, i)
+	local n = #queue
+	local entry = queue[i]
+
+	while true do
+		local child = i * 2
+		if child > n then
+			break
+		end
+		if child < n and _artworkBefore(queue[child + 1], queue[child]) then
+			child = child + 1
+		end
+		if not _artworkBefore(queue[child], entry) then
+			break
+		end
+		queue[i] = queue[child]
+		i = child
+	end
+	queue[i] = entry
+end
+
+
+-- recompute priorities after the viewport has moved, or entries have
+-- been removed from the middle of the heap
+local function _artworkReorder(self)
+	local queue = self.artworkFetchQueue
+
+	for i, entry in ipairs(queue) do
+		entry.distance = _artworkDistance(self, entry)
+	end
+	for i = math.floor(#queue / 2), 1, -1 do
+		_artworkSiftDown(queue, i)
+	end
+
+	self.artworkFetchReorder = false
+end
+
+
+local function _artworkPush(self, entry)
+	local queue = self.artworkFetchQueue
+
+	entry.distance = _artworkDistance(self, entry)
+	queue[#queue + 1] = entry
+	_artworkSiftUp(queue, #queue)
+
+	self.artworkFetchEntries[entry.key] = entry
+end
+
+
+local function _artworkPop(self)
+	local queue = self.artworkFetchQueue
+
+	if self.artworkFetchReorder then
+		_artworkReorder(self)
+	end
+
+	local entry = queue[1]
+	local last = table.remove(queue)
+	if #queue > 0 then
+		queue[1] = last
+		_artworkSiftDown(queue, 1)
+	end
+
+	self.artworkFetchEntries[entry.key] = nil
+	return entry
+end
+
+
+-- returns true if an icon is still waiting for the artwork
+local function _artworkWaiting(self, cacheKey)
+	for icon, key in pairs(self.artworkThumbIcons) do
+		if key == cacheKey then
+			return true
+		end
+	end
+	return false
+end
+
+
+-- hands the artwork request to the pool for its host
+local function _fetchArtworkEntry(self, entry)
+	--log:debug("ARTWORK ID=", entry.key)
+	local req = RequestHttp(
+		_getArtworkThumbSink(self, entry.key, entry.thumbId, entry.size, entry.url, entry.wanted),
+		'GET',
+		entry.url,
+		{ buffer = true }
+	)
+
+	self.artworkFetchCount = self.artworkFetchCount + 1
+
+	if string.find(entry.url, "^http") then
+		-- image from remote server
+		local pool = _getRemoteArtworkPool(self, req:getURI())
+
+		pool:queue(req)
+		self.artworkRequests[entry.key] = { req = req, pool = pool }
+	elseif self.artworkPool then
+		-- slimserver icon id
+		self.artworkPool:queue(req)
+		self.artworkRequests[entry.key] = { req = req, pool = self.artworkPool }
+	else
+		log:error("Server ", self.name, " cannot handle artwork for ", entry.url)
+		self.artworkFetchCount = self.artworkFetchCount - 1
 	end
 end
 
 
 function processArtworkQueue(self)
 	while true do
-		while self.artworkFetchCount < 4 and #self.artworkFetchQueue > 0 do
-			-- remove tail entry
-			local entry = table.remove(self.artworkFetchQueue)
-
-			--log:debug("ARTWORK ID=", entry.key)
-			local req = RequestHttp(
-				_getArtworkThumbSink(self, entry.key, entry.size, entry.url),
-				'GET',
-				entry.url
-			)
-
-			self.artworkFetchCount = self.artworkFetchCount + 1
-
-			if string.find(entry.url, "^http") then
-				-- image from remote server
-
-				-- XXXX manage pool of connections to remote server
-				local uri  = req:getURI()
-				local http = SocketHttp(self.jnt, uri.host, uri.port, uri.host)
- 
-				http:fetch(req)
-			elseif self.artworkPool then
-				-- slimserver icon id
-				self.artworkPool:queue(req)
+		while self.artworkFetchCount < ARTWORK_FETCH_LIMIT and #self.artworkFetchQueue > 0 do
+			-- remove nearest entry
+			local entry = _artworkPop(self)
+
+			if entry.wanted and not _artworkWaiting(self, entry.key) then
+				-- the icons have moved on to other artwork, or were collected
+				logcache:debug("dropping artwork ", entry.key)
+				self.artworkStats.dropped = self.artworkStats.dropped + 1
+				self.artworkCache:set(entry.key, nil)
 			else
-				log:error("Server ", self.name, " cannot handle artwork for ", entry.url)
-				self.artworkFetchCount = self.artworkFetchCount - 1
+				_fetchArtworkEntry(self, entry)
 			end
 
 			-- try again
@@ -1019,6 +1318,43 @@ function artworkThumbCached(self, iconId, size, imgFormat)
 end
 
 
+-- _cancelArtworkFetch
+-- removes artwork from the fetch queues if it has not been requested yet
+local function _cancelArtworkFetch(self, cacheKey)
+	local cancelled = false
+
+	local entry = self.artworkFetchEntries[cacheKey]
+	if entry then
+		for i, queued in ipairs(self.artworkFetchQueue) do
+			if queued == entry then
+				table.remove(self.artworkFetchQueue, i)
+				break
+			end
+		end
+
+		self.artworkFetchEntries[cacheKey] = nil
+		self.artworkFetchReorder = true
+		cancelled = true
+	end
+
+	local fetch = self.artworkRequests[cacheKey]
+	if fetch and fetch.pool:cancel(fetch.req) then
+		self.artworkRequests[cacheKey] = nil
+
+		self.artworkFetchCount = self.artworkFetchCount - 1
+		self.artworkFetchTask:addTask()
+		cancelled = true
+	end
+
+	if cancelled then
+		-- release cache marker
+		self.artworkCache:set(cacheKey, nil)
+	end
+
+	return cancelled
+end
+
+
 --[[
 
 =head2 jive.slim.SlimServer:cancelArtworkThumb(icon)
@@ -1034,7 +1370,20 @@ function cancelArtwork(self, icon)
 			--only set nil if not already nil
 			icon:setValue(nil)
 		end
+
+		local cacheKey = self.artworkThumbIcons[icon]
 		self.artworkThumbIcons[icon] = nil
+
+		-- stop the fetch if no other icon is waiting for it
+		if cacheKey then
+			for icon, key in pairs(self.artworkThumbIcons) do
+				if key == cacheKey then
+					return
+				end
+			end
+
+			_cancelArtworkFetch(self, cacheKey)
+		end
 	end
 end
 
@@ -1066,26 +1415,41 @@ function cancelAllArtwork(self, icon)
 
 	-- clear the queue
 	self.artworkFetchQueue = {}
+	self.artworkFetchEntries = {}
+
+	-- and requests not yet sent to the server
+	for cacheKey, fetch in pairs(self.artworkRequests) do
+		if _cancelArtworkFetch(self, cacheKey) then
+			local icons = self.artworkThumbIcons
+			for icon, key in pairs(icons) do
+				if key == cacheKey then
+					icons[icon] = nil
+				end
+			end
+		end
+	end
 end
 
 
 --[[
 
-=head2 jive.slim.SlimServer:fetchArtwork(iconId, icon, size, imgFormat)
+=head2 jive.slim.SlimServer:fetchArtwork(iconId, icon, size, imgFormat, index)
 
 The SlimServer object maintains an artwork cache. This function either loads from the cache or
 gets from the network the thumb for I<iconId>. A L<jive.ui.Surface> is used to perform
 I<icon>:setValue(). This function computes the URI to request the artwork from the server from I<iconId>. I<imgFormat> is an optional
-argument to control the image format.
+argument to control the image format. I<index> is the optional position of the item in the
+menu given to L<setArtworkViewport>, artwork nearest the visible items is fetched first.
 
 =cut
 --]]
-function fetchArtwork(self, iconId, icon, size, imgFormat)
-	logcache:debug(self, ":fetchArtwork(", iconId, ", ", size, ", ", imgFormat, ")")
+function fetchArtwork(self, iconId, icon, size, imgFormat, index)
+	logcache:debug(self, ":fetchArtwork(", iconId, ", ", size, ", ", imgFormat, ", ", index, ")")
 
 	assert(size)
 
 	local cacheKey = iconId .. "@" .. size .. "/" .. (imgFormat or '')
+	local thumbId = iconId .. "/" .. (imgFormat or '')
 
 	-- do we have an image already cached?
 	local image = self.imageCache[cacheKey]
@@ -1107,6 +1471,36 @@ function fetchArtwork(self, iconId, icon, size, imgFormat)
 			return
 		end
 	end
+
+	-- or is the image in the thumbnail cache, or can it be resized
+	-- from a larger size that is?
+	image = _getThumbnail(self, thumbId, size)
+	if image then
+		logcache:debug("..image in thumbnail cache")
+
+		self.imageCache[cacheKey] = image
+		if icon then
+			icon:setValue(image)
+			self.artworkThumbIcons[icon] = nil
+		end
+		return
+	end
+
+	-- or is the resized image in the disk cache? the index is checked
+	-- first so a miss does not touch the disk
+	image = self.artworkCache:hasImage(cacheKey) and self.artworkCache:getImage(cacheKey)
+	if image then
+		logcache:debug("..image in disk cache")
+
+		local sizeW, sizeH = _parseSize(size)
+		self.thumbnailCache:set(thumbId, sizeW, sizeH, image)
+		self.imageCache[cacheKey] = image
+		if icon then
+			icon:setValue(image)
+			self.artworkThumbIcons[icon] = nil
+		end
+		return
+	end
 	
 	-- or is the compressed artwork cached?
 	local artwork = self.artworkCache:get(cacheKey)
@@ -1117,11 +1511,24 @@ function fetchArtwork(self, iconId, icon, size, imgFormat)
 				icon:setValue(nil)
 				self.artworkThumbIcons[icon] = cacheKey
 			end
+
+			-- move a queued request to its new position
+			local entry = self.artworkFetchEntries[cacheKey]
+			if entry then
+				entry.wanted = entry.wanted or icon ~= nil
+				if index then
+					entry.index = index
+					entry.view = self.artworkViewport
+				end
+				self.artworkFetchSeq = self.artworkFetchSeq + 1
+				entry.seq = self.artworkFetchSeq
+				self.artworkFetchReorder = true
+			end
 			return
 		else
 			logcache:debug("..artwork in cache")
 			if icon then
-				image = _loadArtworkImage(self, cacheKey, artwork, size)
+				image = _loadArtworkImage(self, cacheKey, thumbId, artwork, size)
 				icon:setValue(image)
 				self.artworkThumbIcons[icon] = nil
 			end
@@ -1186,16 +1593,64 @@ function fetchArtwork(self, iconId, icon, size, imgFormat)
 	end
 	logcache:debug("..fetching artwork")
 
-	-- queue up the request on a lifo
-	table.insert(self.artworkFetchQueue, {
+	-- queue up the request, nearest to the viewport and most recent first
+	self.artworkFetchSeq = self.artworkFetchSeq + 1
+	_artworkPush(self, {
 			     key = cacheKey,
 			     id = iconId,
+			     thumbId = thumbId,
 			     url = url,
 			     size = size,
+			     wanted = icon ~= nil,
+			     index = index,
+			     view = index and self.artworkViewport,
+			     seq = self.artworkFetchSeq,
 		     })
 	self.artworkFetchTask:addTask()
 end
 
+
+--[[
+
+=head2 jive.slim.SlimServer:setArtworkViewport(menu, first, last)
+
+Tells the artwork fetcher items I<first> to I<last> of I<menu> are visible.
+Queued artwork for the menu is fetched nearest to these items first, and
+artwork for other menus after that.
+
+=cut
+--]]
+function setArtworkViewport(self, menu, first, last)
+	local view = self.artworkViewport
+
+	if not view or view.menu ~= menu then
+		view = setmetatable({ menu = menu }, { __mode = "v" })
+		self.artworkViewport = view
+	elseif view.first == first and view.last == last then
+		return
+	end
+
+	view.first = first
+	view.last = last
+	self.artworkFetchReorder = true
+end
+
+
+--[[
+
+=head2 jive.slim.SlimServer:getArtworkStats()
+
+Returns counts of fetched artwork that was I<used> by an icon, I<wasted> as
+the icons had moved on when it arrived, and requests I<dropped> before they
+were sent.
+
+=cut
+--]]
+function getArtworkStats(self)
+	local stats = self.artworkStats
+	return { used = stats.used, wasted = stats.wasted, dropped = stats.dropped }
+end
+
 function getAppParameters(self, appType)
 	if not self.appParameters then
 		return nil
@@ -0,0 +1,180 @@
+
+--[[
+=head1 NAME
+
+jive.slim.ThumbnailCache - Size bounded LRU cache for resized artwork
+
+Values are decoded surfaces, keyed by the artwork id and the size they
+were resized to. The same artwork is often shown at several sizes, a
+missing size can be resized from a larger one already in the cache
+instead of fetching and decoding the artwork again.
+
+--]]
+
+local next, pairs = next, pairs
+
+local oo          = require("loop.base")
+
+local debug       = require("jive.utils.debug")
+local log         = require("jive.utils.log").logger("squeezebox.server.cache")
+
+
+-- ThumbnailCache is a base class
+module(..., oo.class)
+
+
+-- Limit thumbnail cache to 12 Mbytes
+local THUMBNAIL_LIMIT = 12 * 1024 * 1024
+
+
+function __init(self)
+	local obj = oo.rawnew(self, {})
+
+	-- initialise state
+	obj:free()
+
+	return obj
+end
+
+
+function free(self)
+	-- entries by id, then by size
+	self.cache = {}
+
+	-- most and least recently used links
+	self.mru = nil
+	self.lru = nil
+
+	-- total size in bytes
+	self.total = 0
+end
+
+
+local function _unlink(self, entry)
+	if entry.prev then
+		entry.prev.next = entry.next
+	else
+		self.mru = entry.next
+	end
+
+	if entry.next then
+		entry.next.prev = entry.prev
+	else
+		self.lru = entry.prev
+	end
+
+	entry.prev = nil
+	entry.next = nil
+end
+
+
+local function _link(self, entry)
+	entry.prev = nil
+	entry.next = self.mru
+
+	if self.mru then
+		self.mru.prev = entry
+	end
+	self.mru = entry
+
+	if not self.lru then
+		self.lru = entry
+	end
+end
+
+
+local function _remove(self, entry)
+	_unlink(self, entry)
+
+	local sizes = self.cache[entry.id]
+	sizes[entry.size] = nil
+	if next(sizes) == nil then
+		self.cache[entry.id] = nil
+	end
+
+	self.total = self.total - entry.bytes
+end
+
+
+function set(self, id, w, h, image)
+	local size = w .. "x" .. h
+
+	local sizes = self.cache[id]
+	if sizes and sizes[size] then
+		_remove(self, sizes[size])
+	end
+
+	sizes = self.cache[id]
+	if not sizes then
+		sizes = {}
+		self.cache[id] = sizes
+	end
+
+	local entry = {
+		id = id,
+		size = size,
+		w = w,
+		h = h,
+		image = image,
+		bytes = image:getBytes(),
+	}
+
+	sizes[size] = entry
+	self.total = self.total + entry.bytes
+	_link(self, entry)
+
+	-- keep cache under the limit
+	while self.total > THUMBNAIL_LIMIT and self.lru ~= entry do
+		log:debug("Free thumbnail id=", self.lru.id, " size=", self.lru.size, " total=", self.total)
+		_remove(self, self.lru)
+	end
+end
+
+
+-- returns the image for id resized to w x h
+function get(self, id, w, h)
+	local sizes = self.cache[id]
+	local entry = sizes and sizes[w .. "x" .. h]
+
+	if not entry then
+		return nil
+	end
+
+	if self.mru ~= entry then
+		_unlink(self, entry)
+		_link(self, entry)
+	end
+
+	return entry.image
+end
+
+
+-- returns the smallest image for id resized to at least w x h, this is
+-- the cheapest to resize to w x h and loses nothing compared to decoding
+function getLarger(self, id, w, h)
+	local sizes = self.cache[id]
+	if not sizes then
+		return nil
+	end
+
+	local best = nil
+	for size, entry in pairs(sizes) do
+		if entry.w >= w and entry.h >= h and (not best or entry.bytes < best.bytes) then
+			best = entry
+		end
+	end
+
+	return best and best.image
+end
+
+
+--[[
+
+=head1 LICENSE
+
+Copyright 2010 Logitech. All Rights Reserved.
+
+This file is licensed under BSD. Please see the LICENSE file for details.
+
+=cut
+--]]
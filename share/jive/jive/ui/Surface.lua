@@ -35,7 +35,11 @@ Load an image from I<path>. If I<path> is relative the lua path is searched for
 
 =head2 loadImageData(data, len)
 
-Load an image from I<data> using I<len> bytes. Returns the loaded image.
+Load an image from I<data> using I<len> bytes. I<data> may be a string or a L<jive.buffer>, which is decoded without copying. I<len> defaults to the length of I<data>. Returns the loaded image.
+
+=head2 loadImageScaled(data, w, h, cover)
+
+Load an image from I<data> scaled to fit in I<w> x I<h>, or if I<cover> is true to cover it, keeping its aspect ratio. Images are not enlarged. Large JPEGs are decoded at a reduced scale, which is much faster than loading and then resizing them. Returns the loaded image, and the width and height of the image before scaling.
 
 =head2 drawText(font, color, str)
 
@@ -28,6 +28,8 @@ A set of ltn12 filters that encode/decode JSON.
 =cut
 --]]
 
+local type = type
+
 local json = require("cjson")
 
 module(...)
@@ -37,7 +39,8 @@ module(...)
 
 =head2 decode(chunk)
 
-Decodes a JSON chunk (string) into a Lua array
+Decodes a JSON chunk (string) into a Lua array. Values already decoded,
+for example by a jive-json sink, are passed through.
 
 =cut
 --]]
@@ -47,6 +50,8 @@ function decode(chunk)
 		return nil
 	elseif chunk == "" then
 		return ""
+	elseif type(chunk) ~= "string" then
+		return chunk
 	elseif chunk then
 		return json.decode(chunk)
 	end
@@ -0,0 +1,282 @@
+-----------------------------------------------------------------------------
+-- lazystyle.lua
+-----------------------------------------------------------------------------
+
+--[[
+=head1 NAME
+
+jive.utils.lazystyle - skin styles built on first use
+
+=head1 DESCRIPTION
+
+Lets a skin declare styles as constructors instead of tables. A
+constructor is called the first time any of its styles is looked up,
+normally when a widget first resolves a style path through it, and the
+styles it sets are then plain entries in the skin. Images and fonts used
+only by windows that are never opened are not loaded.
+
+Assigning a style that is still lazy replaces it, so a child skin can
+override styles of its parent without them being built.
+
+=head1 SYNOPSIS
+
+ -- one style, the constructor returns it
+ lazystyle.define(s, "hm_radio", function()
+ 	return _uses(_buttonicon, { img = _loadImage(self, "icon_tunein.png") })
+ end)
+
+ -- several styles built together, the constructor sets them
+ lazystyle.define(s, { "nowplaying", "nowplaying_art_only" }, function(s)
+ 	s.nowplaying = _uses(s.window, { ... })
+ 	s.nowplaying_art_only = _uses(s.nowplaying, { ... })
+ end)
+
+ -- changes to a style once it is built
+ lazystyle.extend(s, "nowplaying", function(s)
+ 	s.nowplaying.npcontrols.div5.w = 230
+ end)
+
+ -- which styles have been used
+ local stats = lazystyle.getStats(s)
+
+=head1 FUNCTIONS
+
+=cut
+--]]
+
+-- import some global stuff
+local getmetatable, setmetatable, rawget, rawset = getmetatable, setmetatable, rawget, rawset
+local ipairs, pcall, type = ipairs, pcall, type
+
+local os               = require("os")
+local table            = require("table")
+
+local log              = require("jive.utils.log").logger("jivelite.ui")
+
+
+module(...)
+
+
+-- lazy state by skin table
+local _skins = setmetatable({}, { __mode = "k" })
+
+
+local function _build(tab, state, group, key)
+	if group.built then
+		return
+	end
+
+	-- styles assigned or redefined since the group was defined take
+	-- precedence over the ones it sets
+	local keep = {}
+	for _, k in ipairs(group.keys) do
+		if group.overridden[k] or state.pending[k] ~= group then
+			keep[#keep + 1] = { k, rawget(tab, k) }
+		end
+	end
+
+	group.built = true
+	group.trigger = key
+
+	local start = os.clock()
+
+	local building = state.building
+	state.building = group
+
+	local ok, value = pcall(group.constructor, tab)
+
+	state.building = building
+	if not ok then
+		log:error("error building style ", key, ": ", value)
+	elseif value ~= nil and #group.keys == 1 then
+		rawset(tab, group.keys[1], value)
+	end
+
+	for _, k in ipairs(group.keys) do
+		if state.pending[k] == group then
+			state.pending[k] = nil
+		end
+	end
+	for _, kv in ipairs(keep) do
+		rawset(tab, kv[1], kv[2])
+	end
+
+	if ok then
+		for _, fn in ipairs(group.extenders) do
+			fn(tab)
+		end
+	end
+	group.extenders = nil
+
+	group.time = (os.clock() - start) * 1000
+	state.time = state.time + group.time
+
+	log:debug("built style ", key, " (", #group.keys, " styles) in ", group.time, " ms")
+end
+
+
+local function _state(tab)
+	local state = _skins[tab]
+	if state then
+		return state
+	end
+
+	state = {
+		-- groups by style name, until built
+		pending = {},
+
+		-- all groups, in the order defined
+		groups = {},
+
+		-- group being built
+		building = false,
+
+		-- time spent in constructors, ms
+		time = 0,
+	}
+	_skins[tab] = state
+
+	local mt = getmetatable(tab) or {}
+	local index = mt.__index
+
+	mt.__index = function(t, k)
+		local group = state.pending[k]
+		if group and not group.built then
+			_build(t, state, group, k)
+			return rawget(t, k)
+		end
+
+		if type(index) == "function" then
+			return index(t, k)
+		elseif index then
+			return index[k]
+		end
+	end
+
+	mt.__newindex = function(t, k, v)
+		local group = state.pending[k]
+		if group and not group.built and not state.building then
+			group.overridden[k] = true
+		end
+
+		rawset(t, k, v)
+	end
+
+	setmetatable(tab, mt)
+	return state
+end
+
+
+--[[
+
+=head2 lazystyle.define(tab, keys, constructor)
+
+Declares the style I<keys> of skin I<tab>, a name or a list of names.
+The first lookup of any of them calls I<constructor(tab)>, which sets the
+styles in I<tab>, or for a single name may return it instead.
+
+=cut
+--]]
+function define(tab, keys, constructor)
+	local state = _state(tab)
+
+	if type(keys) ~= "table" then
+		keys = { keys }
+	end
+
+	local group = {
+		keys = keys,
+		constructor = constructor,
+		extenders = {},
+		overridden = {},
+		built = false,
+	}
+	state.groups[#state.groups + 1] = group
+
+	for _, k in ipairs(keys) do
+		state.pending[k] = group
+		rawset(tab, k, nil)
+	end
+end
+
+
+--[[
+
+=head2 lazystyle.extend(tab, key, fn)
+
+Calls I<fn(tab)> once the style I<key> of skin I<tab> is built, or now if
+the style is not lazy or is already built. For skins that adjust the
+styles of another skin.
+
+=cut
+--]]
+function extend(tab, key, fn)
+	local state = _skins[tab]
+	local group = state and state.pending[key]
+
+	if group and not group.built then
+		group.extenders[#group.extenders + 1] = fn
+	else
+		fn(tab)
+	end
+end
+
+
+--[[
+
+=head2 lazystyle.getStats(tab)
+
+Returns the use of the lazy styles of skin I<tab>: I<declared> and
+I<built> count the constructors, I<time> is the time spent in them in
+ms, I<used> lists the style that caused each constructor to be built
+with its time and I<unused> lists the styles never looked up.
+
+=cut
+--]]
+function getStats(tab)
+	local stats = {
+		declared = 0,
+		built = 0,
+		time = 0,
+		used = {},
+		unused = {},
+	}
+
+	local state = _skins[tab]
+	if not state then
+		return stats
+	end
+
+	stats.time = state.time
+
+	for _, group in ipairs(state.groups) do
+		stats.declared = stats.declared + 1
+
+		if group.built then
+			stats.built = stats.built + 1
+			stats.used[#stats.used + 1] = { style = group.trigger, time = group.time }
+		else
+			for _, k in ipairs(group.keys) do
+				if not group.overridden[k] and state.pending[k] == group then
+					stats.unused[#stats.unused + 1] = k
+				end
+			end
+		end
+	end
+
+	table.sort(stats.unused)
+
+	return stats
+end
+
+
+--[[
+
+=head1 LICENSE
+
+Copyright 2010 Logitech. All Rights Reserved.
+
+This file is licensed under BSD. Please see the LICENSE file for details.
+
+=cut
+--]]
@@ -8,17 +8,27 @@ jive.utils.locale - Deliver strings based on locale (defaults to EN) and path
 
 Parses strings.txt from appropriate directory and sends it back as a table
 
+The strings of the current locale are compiled into a string table in the
+user cache directory, see jive.stringtable. Strings files that have not
+changed since are not parsed again, their strings are looked up in the
+table when first used.
+
 =head1 FUNCTIONS
 
 setLocale(locale)
 
 readStringsFile(thisPath)
 
+loadStrings(stringsTable)
+
 =cut
 --]]
 
 -- stuff we use
-local ipairs, pairs, io, select, setmetatable, string, tostring = ipairs, pairs, io, select, setmetatable, string, tostring
+local ipairs, pairs, io, pcall, rawget, rawset, require, select, setmetatable, string, tostring, type = ipairs, pairs, io, pcall, rawget, rawset, require, select, setmetatable, string, tostring, type
+
+local lfs              = require("lfs")
+local table            = require("table")
 
 local log              = require("jive.utils.log").logger("jivelite")
 
@@ -44,6 +54,185 @@ local globalStrings = {}
 -- contains type of machine
 local globalMachine = false
 
+-- meta table for strings
+local strmt = {
+	__tostring = function(e)
+			     return e.str
+		     end,
+}
+
+-- jive.stringtable, or false if it is not available
+local stringtableLib = nil
+
+-- compiled strings of the current locale, or false
+local stringTable = false
+local stringTableLocale = nil
+
+-- sections parsed since the string table was opened, by strings file path
+local newSections = {}
+
+-- string table and section of the strings tables looked up as used
+local attachedSections = {}
+setmetatable(attachedSections, { __mode = "k" })
+
+-- task writing the string table, if one is pending
+local writeTask = nil
+
+
+local function _tablePath(myLocale)
+	return System.getUserDir() .. "/cache/strings-" .. myLocale .. ".tbl"
+end
+
+
+-- returns the string table of the current locale, opening it if needed
+local function _getTable()
+	if stringtableLib == nil then
+		local ok, mod = pcall(require, "jive.stringtable")
+		stringtableLib = ok and mod
+	end
+
+	if stringtableLib and stringTableLocale ~= globalLocale then
+		stringTableLocale = globalLocale
+		stringTable = stringtableLib:open(_tablePath(globalLocale)) or false
+		newSections = {}
+	end
+
+	return stringTable
+end
+
+
+-- writes the string table with the sections parsed since it was opened
+local function _writeTable()
+	writeTask = nil
+
+	local sections = {}
+
+	-- sections for strings files not loaded since, if they still exist
+	if stringTable then
+		for i = 1, stringTable:count() do
+			local name, mtime, size, locales = stringTable:info(i)
+
+			if not newSections[name] and lfs.attributes(name, "mode") then
+				sections[#sections + 1] = {
+					name = name,
+					mtime = mtime,
+					size = size,
+					locales = locales,
+					strings = stringTable:strings(i),
+				}
+			end
+		end
+	end
+
+	for _, section in pairs(newSections) do
+		sections[#sections + 1] = section
+	end
+
+	log:info("writing string table for ", stringTableLocale, ", ", #sections, " files")
+	stringtableLib:write(_tablePath(stringTableLocale), sections)
+end
+
+
+-- adds the strings parsed from a strings file to the string table
+local function _addSection(myFilePath, attr, locales, stringsTable)
+	local strings = {}
+	for token, v in pairs(stringsTable) do
+		if type(v) == "table" and v.str then
+			strings[token] = v.str
+		end
+	end
+
+	local names = {}
+	for locale in pairs(locales) do
+		names[#names + 1] = locale
+	end
+	table.sort(names)
+
+	newSections[myFilePath] = {
+		name = myFilePath,
+		mtime = attr.modification,
+		size = attr.size,
+		locales = table.concat(names, ","),
+		strings = strings,
+	}
+
+	-- once loading is done
+	if not writeTask then
+		writeTask = Task("stringTable", nil, _writeTable)
+		writeTask:addTask()
+	end
+end
+
+
+-- looks up the strings of stringsTable in section of the string table as
+-- they are used, and other keys in parent
+local function _attachSection(stringsTable, section, parent)
+	local tbl = stringTable
+
+	setmetatable(stringsTable, {
+		__index = function(t, token)
+			local str = tbl:get(section, token)
+			if str then
+				local e = setmetatable({ str = str }, strmt)
+				rawset(t, token, e)
+				return e
+			end
+
+			return parent[token]
+		end
+	})
+	attachedSections[stringsTable] = { tbl = tbl, section = section }
+
+	-- strings already used, from an earlier locale. a string no longer
+	-- in the file keeps its old value
+	for token, e in pairs(stringsTable) do
+		local str = tbl:get(section, token)
+		if str then
+			e.str = str
+		end
+	end
+end
+
+
+-- loads the strings in myFilePath for the current locale into
+-- stringsTable, from the string table if the file is in it
+local function _loadStringsFile(self, myFilePath, stringsTable, parent)
+	globalMachine = "_" .. string.upper(System:getMachine())
+
+	attachedSections[stringsTable] = nil
+
+	local attr = lfs.attributes(myFilePath)
+	if not attr then
+		setmetatable(stringsTable, { __index = parent })
+		return stringsTable
+	end
+
+	local tbl = _getTable()
+	if tbl then
+		local section, locales = tbl:section(myFilePath, attr.modification, attr.size)
+		if section then
+			for locale in string.gmatch(locales, "[^,]+") do
+				allLocales[locale] = true
+			end
+
+			_attachSection(stringsTable, section, parent)
+			return stringsTable
+		end
+	end
+
+	setmetatable(stringsTable, { __index = parent })
+
+	local locales
+	stringsTable, locales = _parseStringsFile(self, globalLocale, myFilePath, stringsTable)
+
+	if stringtableLib then
+		_addSection(myFilePath, attr, locales, stringsTable)
+	end
+
+	return stringsTable
+end
+
+
 --[[
 =head 2 setLocale(newLocale)
 
@@ -65,7 +254,7 @@ function setLocale(self, newLocale, doYield)
 		if doYield then
 			Task:yield(true)
 		end
-		_parseStringsFile(self, newLocale, k, v)
+		_loadStringsFile(self, k, v, globalStrings)
 	end
 end
 
@@ -112,8 +301,7 @@ function readGlobalStringsFile(self)
 	if globalStringsPath == nil then
 		return globalStrings
 	end
-	globalStrings = _parseStringsFile(self, globalLocale, globalStringsPath, globalStrings)
-	setmetatable(globalStrings, { __index = self , mode = "_v" })
+	globalStrings = _loadStringsFile(self, globalStringsPath, globalStrings, self)
 	return globalStrings
 end
 
@@ -123,29 +311,49 @@ function readStringsFile(self, fullPath, stringsTable)
 
 	stringsTable = stringsTable or {}
 	loadedFiles[fullPath] = stringsTable
-	setmetatable(stringsTable, { __index = globalStrings })
-	stringsTable = _parseStringsFile(self, globalLocale, fullPath, stringsTable)
 
-	return stringsTable
+	return _loadStringsFile(self, fullPath, stringsTable, globalStrings)
+end
+
+--[[
+
+=head2 loadStrings(self, stringsTable)
+
+Loads all the strings of stringsTable, as returned by readStringsFile, for
+the current locale. Strings from the string table are otherwise loaded as
+they are used, so use this before iterating over stringsTable with pairs.
+
+=cut
+--]]
+function loadStrings(self, stringsTable)
+	local attached = attachedSections[stringsTable]
+	if not attached then
+		-- parsed from the strings file, all strings are loaded
+		return
+	end
+
+	for token, str in pairs(attached.tbl:strings(attached.section)) do
+		local e = rawget(stringsTable, token)
+		if e then
+			e.str = str
+		else
+			rawset(stringsTable, token, setmetatable({ str = str }, strmt))
+		end
+	end
 end
 
+
 function _parseStringsFile(self, myLocale, myFilePath, stringsTable)
 	log:debug("parsing ", myFilePath)
 
-	globalMachine = "_" .. string.upper(System:getMachine())
-
 	local stringsFile = io.open(myFilePath)
 	if stringsFile == nil then
-		return stringsTable
+		return stringsTable, {}
 	end
 	stringsTable = stringsTable or {}
 
-	-- meta table for strings
-	local strmt = {
-		__tostring = function(e)
-				     return e.str -- .. "{" .. myLocale .. "}"
-			     end,
-	}
+	-- locales with translations in this file
+	local locales = {}
 
 	local token, fallback
 	while true do
@@ -191,6 +399,7 @@ function _parseStringsFile(self, myLocale, myFilePath, stringsTable)
 		if locale and translation and token then
 			-- remember all locales seen
 			allLocales[locale] = true
+			locales[locale] = true
 
 			if locale == myLocale then
 				log:debug("translation=", translation)
@@ -216,7 +425,7 @@ function _parseStringsFile(self, myLocale, myFilePath, stringsTable)
 
 	stringsFile:close()
 
-	return stringsTable
+	return stringsTable, locales
 end
 
 
@@ -40,6 +40,49 @@ function _skin(self)
 	self.barColor = self:styleColor("barColor", { 0xff, 0xff, 0xff, 0xff })
 
 	self.capColor = self:styleColor("capColor", { 0xff, 0xff, 0xff, 0xff })
+
+	-- optional gradient, from barColor at the bottom to barColorTop
+	self.barColorBottom = self:styleValue("barColor", { 0xff, 0xff, 0xff, 0xff })
+	self.barColorTop = self:styleValue("barColorTop", self.barColorBottom)
+end
+
+
+-- Pre-render a full height bar, bars are drawn by blitting the bottom part
+local function _barStrip(self, w, h)
+	if h <= 0 then
+		return nil
+	end
+
+	local strip = Surface:newRGB(w, h)
+	local c1 = self.barColorBottom
+	local c2 = self.barColorTop
+
+	for row = 0, h - 1 do
+		local t = (h > 1) and (row / (h - 1)) or 0
+		local col = 0
+
+		for i = 1, 4 do
+			local v1 = c1[i] or 0xff
+			local v2 = c2[i] or 0xff
+			col = col * 0x100 + math.floor(v2 + (v1 - v2) * t)
+		end
+
+		strip:filledRectangle(0, row, w - 1, row, col)
+	end
+
+	return strip
+end
+
+
+local function _capStrip(self, w, h)
+	if h <= 0 then
+		return nil
+	end
+
+	local strip = Surface:newRGB(w, h)
+	strip:filledRectangle(0, 0, w - 1, h - 1, self.capColor)
+
+	return strip
 end
 
 
@@ -117,28 +160,25 @@ function _layout(self)
 
 	local barHeight = {}
 
-	barHeight[1] = h - t - b - self.capHeight[1] - self.capSpace[1]
-	barHeight[2] = h - t - b - self.capHeight[2] - self.capSpace[2]
-
-	-- max bin value from C code is 31
-	self.barHeightMulti = {}
-	self.barHeightMulti[1] = barHeight[1] / 31
-	self.barHeightMulti[2] = barHeight[2] / 31
+	barHeight[1] = math.max(h - t - b - self.capHeight[1] - self.capSpace[1], 0)
+	barHeight[2] = math.max(h - t - b - self.capHeight[2] - self.capSpace[2], 0)
 
 	self.x1 = x + l + self.channelWidth[1] - numBars[1] * barSize[1]
 	self.x2 = x + l + self.channelWidth[2] + self.binSpace[2]
 
 	self.y = y + h - b
 
-	self.cap = { {}, {} }
-	for i = 1, numBars[1] do
-		self.cap[1][i] = 0
-	end
+	for ch = 1, 2 do
+		local x = (ch == 1) and self.x1 or self.x2
 
-	for i = 1, numBars[2] do
-		self.cap[2][i] = 0
+		vis:spectrum_sprites(ch,
+			_barStrip(self, self.barWidth[ch], barHeight[ch]),
+			_capStrip(self, self.barWidth[ch], self.capHeight[ch]),
+			x, self.y,
+			self.barsInBin[ch], self.barWidth[ch], self.barSpace[ch], self.binSpace[ch],
+			barHeight[ch], self.capHeight[ch], self.capSpace[ch]
+		)
 	end
-
 end
 
 
@@ -153,70 +193,11 @@ function draw(self, surface)
 		self.backgroundDrawn = true
 	end
 
-	local bins = { {}, {} }
-
-	bins[1], bins[2] = vis:spectrum()
-
-	_drawBins(
-		self, surface, bins, 1, self.x1, self.y, self.barsInBin[1],
-		self.barWidth[1], self.barSpace[1], self.binSpace[1],
-		self.barHeightMulti[1], self.capHeight[1], self.capSpace[1]
-	)
-	_drawBins(
-		self, surface, bins, 2, self.x2, self.y, self.barsInBin[2],
-		self.barWidth[2], self.barSpace[2], self.binSpace[2],
-		self.barHeightMulti[2], self.capHeight[2], self.capSpace[2]
-	)
-
+	vis:spectrum_draw(1, surface)
+	vis:spectrum_draw(2, surface)
 end
 
 
-function _drawBins(self, surface, bins, ch, x, y, barsInBin, barWidth, barSpace, binSpace, barHeightMulti, capHeight, capSpace)
-	local bch = bins[ch]
-	local cch = self.cap[ch]
-	local barSize = barWidth + barSpace
-
-	for i = 1, #bch do
-		bch[i] = bch[i] * barHeightMulti
-
-		-- bar
-		if bch[i] > 0 then
-			for k = 0, barsInBin - 1 do
-				surface:filledRectangle(
-					x + (k * barSize),
-					y,
-					x + (barWidth - 1) + (k * barSize),
-					y - bch[i] + 1,
-					self.barColor
-				)
-			end
-		end
-		
-		if bch[i] >= cch[i] then
-			cch[i] = bch[i]
-		elseif cch[i] > 0 then
-			cch[i] = cch[i] - barHeightMulti
-			if cch[i] < 0 then
-				cch[i] = 0
-			end
-		end
-
-		-- cap
-		if capHeight > 0 then
-			for k = 0, barsInBin - 1 do
-				surface:filledRectangle(
-					x + (k * barSize),
-					y - cch[i] - capSpace,
-					x + (barWidth - 1) + (k * barSize),
-					y - cch[i] - capHeight - capSpace,
-					self.capColor
-				)
-			end
-		end
-
-		x = x + barWidth * barsInBin + barSpace * (barsInBin - 1) + binSpace
-	end
-end
 --[[
 
 =head1 LICENSE
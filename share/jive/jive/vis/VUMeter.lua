@@ -14,6 +14,9 @@ local log           = require("jive.utils.log").logger("jivelite.vis")
 
 local FRAME_RATE    = jive.ui.FRAME_RATE
 
+-- number of frames in the analog meter image sequence
+local ANALOG_FRAMES = 25
+
 local appletManager = appletManager
 
 module(...)
@@ -25,8 +28,6 @@ function __init(self, style)
 
 	obj.style = style
 
-	obj.cap = { 0, 0 }
-
 	obj:addAnimation(function() obj:reDraw() end, FRAME_RATE)
 
 	return obj
@@ -68,15 +69,20 @@ function _layout(self)
 		self.x1 = x + l + ((self.w - tw * 2) / 3)
 		self.x2 = x + l + ((self.w - tw * 2) / 3) * 2 + tw
 
-		self.bars = self.h / th
+		self.bars = math.floor(self.h / th)
 		self.y = y + t + (self.bars * th)
 
+		self.meter = vis:vumeter_init(self.bars, -40, -6, 20, 300, 1000)
+
 	elseif self.style == "vumeter_analog" then
 		self.x1 = x
 		self.x2 = x + (w / 2)
 		self.y = y
 		self.w = w / 2
 		self.h = h
+
+		-- the needle has slower ballistics and no peak hold
+		self.meter = vis:vumeter_init(ANALOG_FRAMES - 1, -40, -6, 150, 300, 0)
 	end
 end
 
@@ -86,54 +92,25 @@ function draw(self, surface)
 		self.bgImg:blit(surface, self:getBounds())
 	end
 
-	local sampleAcc = vis:vumeter()
-
-	-- local volume = self.player:getVolume()
-
-	_drawMeter(self, surface, sampleAcc, 1, self.x1, self.y, self.w, self.h)
-	_drawMeter(self, surface, sampleAcc, 2, self.x2, self.y, self.w, self.h)
-end
-
--- FIXME dynamic based on number of bars
-local RMS_MAP = {
-	0, 2, 5, 7, 10, 21, 33, 45, 57, 82, 108, 133, 159, 200, 
-	242, 284, 326, 387, 448, 509, 570, 652, 735, 817, 900, 
-	1005, 1111, 1217, 1323, 1454, 1585, 1716, 1847, 2005, 
-	2163, 2321, 2480, 2666, 2853, 3040, 3227, 3414, 3601,
-	3788, 3975, 4162, 4349, 4536,
-}
-
-function _drawMeter(self, surface, sampleAcc, ch, x, y, w, h)
-	local val = 1
-	for i = #RMS_MAP, 1, -1 do
-		if sampleAcc[ch] > RMS_MAP[i] then
-			val = i
-			break
-		end
+	if not self.meter then
+		return
 	end
 
-	-- FIXME when rms map scaled
-	val = math.floor(val / 2)
+	local val1, cap1, val2, cap2 = vis:vumeter_bars(self.meter)
 
---	val = math.floor(math.log(sampleAcc[ch]) * 1.5)
---	if val > 24 then
---		val = 24
---	end
-
-	if val >= self.cap[ch] then
-		self.cap[ch] = val
-	elseif self.cap[ch] > 0 then
-		self.cap[ch] = self.cap[ch] - 1
-	end
+	_drawMeter(self, surface, val1, cap1, self.x1, self.y, self.w, self.h)
+	_drawMeter(self, surface, val2, cap2, self.x2, self.y, self.w, self.h)
+end
 
+function _drawMeter(self, surface, val, cap, x, y, w, h)
 	if self.style == "vumeter" then
 
 		local tw,th = self.tickOn:getMinSize()
 
 		for i = 1, self.bars do
-			if i == math.floor(self.cap[ch] / 2) then
+			if i == cap then
 				self.tickCap:blit(surface, x, y, tw, th)
-			elseif i < val then
+			elseif i <= val then
 				self.tickOn:blit(surface, x, y, tw, th)
 			else
 				self.tickOff:blit(surface, x, y, tw, th)
@@ -143,14 +120,7 @@ function _drawMeter(self, surface, sampleAcc, ch, x, y, w, h)
 		end
 
 	elseif self.style == "vumeter_analog" then
-
---		local x,y,w,h = self:getBounds()
-
-		if ch == 1 then
-			self.bgImg:blitClip(self.cap[ch] * w, y, w, h, surface, x, y)
-		else
-			self.bgImg:blitClip(self.cap[ch] * w, y, w, h, surface, x, y)
-		end
+		self.bgImg:blitClip(val * w, y, w, h, surface, x, y)
 	end
 end
 
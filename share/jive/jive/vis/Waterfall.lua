@@ -0,0 +1,97 @@
+local oo            = require("loop.simple")
+local math          = require("math")
+
+local Framework     = require("jive.ui.Framework")
+local Icon          = require("jive.ui.Icon")
+local Surface       = require("jive.ui.Surface")
+local Timer         = require("jive.ui.Timer")
+local Widget        = require("jive.ui.Widget")
+
+local vis           = require("jive.vis")
+
+local debug         = require("jive.utils.debug")
+local log           = require("jive.utils.log").logger("jivelite.vis")
+
+local FRAME_RATE    = jive.ui.FRAME_RATE
+
+-- keep the fft within the shared sample buffer
+local MAX_BINS      = 128
+
+
+module(...)
+oo.class(_M, Icon)
+
+
+function __init(self, style)
+	local obj = oo.rawnew(self, Icon(style))
+
+	obj:addAnimation(function() obj:reDraw() end, FRAME_RATE)
+
+	return obj
+end
+
+
+function _skin(self)
+	Icon._skin(self)
+
+	self.colormap = self:styleValue("colormap", "heat")
+end
+
+
+function _layout(self)
+	local x,y,w,h = self:getBounds()
+	local l,t,r,b = self:getPadding()
+
+	-- When used in NP screen _layout gets called with strange values
+	if w <= 0 or h <= 0 then
+		return
+	end
+
+	self.x = x + l
+	self.y = y + t
+	self.w = w - l - r
+	self.h = h - t - b
+
+	if self.w <= 0 or self.h <= 0 then
+		self.history = nil
+		return
+	end
+
+	-- one mono spectrum column per frame, with a bin covering one or more rows
+	local barSize = math.ceil(self.h / MAX_BINS)
+
+	vis:spectrum_init(1, self.h, 0, barSize, 0)
+
+	-- the history is a ring, one column is appended each frame
+	self.history = Surface:newRGB(self.w, self.h)
+
+	vis:waterfall_init(self.history, self.colormap)
+end
+
+
+function draw(self, surface)
+	if not self.history then
+		return
+	end
+
+	local col = vis:waterfall()
+
+	-- oldest columns on the left, newest on the right
+	self.history:blitClip(col, 0, self.w - col, self.h, surface, self.x, self.y)
+	if col > 0 then
+		self.history:blitClip(0, 0, col, self.h, surface, self.x + self.w - col, self.y)
+	end
+end
+
+
+--[[
+
+=head1 LICENSE
+
+Copyright 2010 Logitech. All Rights Reserved.
+
+This file is licensed under BSD. Please see the LICENSE file for details.
+
+=cut
+--]]
+
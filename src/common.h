@@ -79,6 +79,9 @@ const char * system_get_machine(void);
 const char * system_get_arch(void);
 const char * system_get_version(void);
 const char * system_get_uuid_char(void);
+void system_write_file(const char *fname, const char *fdata, size_t len);
+void system_append_file(const char *fname, const char *fdata, size_t len);
+void system_flush_files(void);
 
 /* time */
 #if HAVE_CLOCK_GETTIME
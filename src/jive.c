@@ -9,6 +9,11 @@
 #include "common.h"
 #include "version.h"
 
+#include <sys/stat.h>
+#if !defined(WIN32)
+#include <sys/mman.h>
+#endif
+
 /* Lua API */
 #include <lua.h>
 #include <lauxlib.h>
@@ -23,8 +28,14 @@ extern int luaopen_log(lua_State *L);
 extern int luaopen_jive(lua_State *L);
 extern int luaopen_jive_ui_framework(lua_State *L);
 extern int luaopen_jive_net_dns(lua_State *L);
+extern int luaopen_jive_net_http(lua_State *L);
+extern int luaopen_jive_buffer(lua_State *L);
 extern int luaopen_jive_debug(lua_State *L);
 #if !defined(WIN32)
+extern int luaopen_jive_net_reactor(lua_State *L);
+extern int luaopen_jive_diskcache(lua_State *L);
+extern int luaopen_jive_settingsstore(lua_State *L);
+extern int luaopen_jive_stringtable(lua_State *L);
 extern int luaopen_visualizer(lua_State *L);
 #endif
 
@@ -46,6 +57,11 @@ extern int luaopen_visualizer(lua_State *L);
 #define LUA_DEFAULT_FIX_PATH "/usr/share/jive"
 #endif
 
+/* LUA_BUNDLE_FILE
+** Precompiled modules in the script path, made with 'make bundle'
+*/
+#define LUA_BUNDLE_FILE "jive.bundle"
+
 
 /* GLOBALS
 */
@@ -53,6 +69,12 @@ extern int luaopen_visualizer(lua_State *L);
 // our lua state
 static lua_State *globalL = NULL;
 
+// bundle of precompiled modules, mapped for the life of the process
+static const unsigned char *bundle = NULL;
+static size_t bundle_size = 0;
+static Uint32 bundle_count = 0;
+static char *bundle_dir = NULL;
+
 
 /* lmessage
 ** prints a message to std err. pname is optional 
@@ -90,6 +112,12 @@ static void jive_openlibs(lua_State *L) {
 	lua_pushcfunction(L, luaopen_jive_net_dns);
 	lua_call(L, 0, 0);
 
+	lua_pushcfunction(L, luaopen_jive_net_http);
+	lua_call(L, 0, 0);
+
+	lua_pushcfunction(L, luaopen_jive_buffer);
+	lua_call(L, 0, 0);
+
 	lua_pushcfunction(L, luaopen_jive_debug);
 	lua_call(L, 0, 0);
 
@@ -100,6 +128,18 @@ static void jive_openlibs(lua_State *L) {
 	lua_call(L, 0, 0);
 
 #if !defined(WIN32)
+	lua_pushcfunction(L, luaopen_jive_net_reactor);
+	lua_call(L, 0, 0);
+
+	lua_pushcfunction(L, luaopen_jive_diskcache);
+	lua_call(L, 0, 0);
+
+	lua_pushcfunction(L, luaopen_jive_settingsstore);
+	lua_call(L, 0, 0);
+
+	lua_pushcfunction(L, luaopen_jive_stringtable);
+	lua_call(L, 0, 0);
+
 	lua_pushcfunction(L, luaopen_visualizer);
 	lua_call(L, 0, 0); 
 #endif
@@ -123,6 +163,278 @@ char *dirname(char *path) {
 #endif
 
 
+/* bundle
+** The bundle is "JIVEBC02", the module count, then an index sorted by
+** module name of name offset, name length, bytecode offset, bytecode
+** length, source path offset, source path length, source mtime and source
+** size, followed by the names, bytecode and source paths. All numbers are
+** 32 bit little endian, offsets are from the start of the file. Source
+** paths are relative to the bundle's directory.
+*/
+#define BUNDLE_MAGIC "JIVEBC02"
+#define BUNDLE_HEADER (8 + 4)
+#define BUNDLE_ENTRY (8 * 4)
+
+static Uint32 bundle_u32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32) p[3] << 24);
+}
+
+
+static bool bundle_open(const char *filename) {
+	const unsigned char *data;
+	size_t size;
+	Uint32 i, count;
+
+#if !defined(WIN32)
+	struct stat st;
+	int fd;
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_size < BUNDLE_HEADER) {
+		close(fd);
+		return false;
+	}
+	size = st.st_size;
+
+	data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED) {
+		return false;
+	}
+#else
+	FILE *fp;
+	unsigned char *buf;
+
+	fp = fopen(filename, "rb");
+	if (!fp) {
+		return false;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	buf = malloc(size ? size : 1);
+	if (!buf || size < BUNDLE_HEADER || fread(buf, 1, size, fp) != size) {
+		free(buf);
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+	data = buf;
+#endif
+
+	/* check the index is within the file */
+	count = bundle_u32(data + 8);
+	if (memcmp(data, BUNDLE_MAGIC, 8) != 0 || count > (size - BUNDLE_HEADER) / BUNDLE_ENTRY) {
+		goto bad_bundle;
+	}
+
+	for (i = 0; i < count; i++) {
+		const unsigned char *e = data + BUNDLE_HEADER + i * BUNDLE_ENTRY;
+
+		if (bundle_u32(e) > size || bundle_u32(e + 4) > size - bundle_u32(e)
+		    || bundle_u32(e + 8) > size || bundle_u32(e + 12) > size - bundle_u32(e + 8)
+		    || bundle_u32(e + 16) > size || bundle_u32(e + 20) > size - bundle_u32(e + 16)) {
+			goto bad_bundle;
+		}
+	}
+
+	bundle = data;
+	bundle_size = size;
+	bundle_count = count;
+	return true;
+
+ bad_bundle:
+	l_message("Error", "invalid bundle, loading modules from source");
+#if !defined(WIN32)
+	munmap((void *) data, size);
+#else
+	free((void *) data);
+#endif
+	return false;
+}
+
+
+/* bundle_current
+** True unless the source of entry e has changed since the bundle was made.
+** A missing source is not a change, the bundle may be installed without
+** the sources.
+*/
+static bool bundle_current(const unsigned char *e) {
+	struct stat st;
+	size_t dir_len = strlen(bundle_dir);
+	Uint32 path_len = bundle_u32(e + 20);
+	char *path;
+	bool current = true;
+
+	path = malloc(dir_len + 1 + path_len + 1);
+	if (!path) {
+		return true;
+	}
+
+	memcpy(path, bundle_dir, dir_len);
+	path[dir_len] = '/';
+	memcpy(path + dir_len + 1, bundle + bundle_u32(e + 16), path_len);
+	path[dir_len + 1 + path_len] = '\0';
+
+	if (stat(path, &st) == 0) {
+		current = ((Uint32) st.st_mtime == bundle_u32(e + 24) && (Uint32) st.st_size == bundle_u32(e + 28));
+	}
+
+	free(path);
+	return current;
+}
+
+
+/* find the bytecode for module name, false if it is not in the bundle or
+** its source has changed */
+static bool bundle_find(const char *name, size_t len, const char **code, size_t *code_len) {
+	Uint32 lo = 0, hi = bundle_count;
+
+	while (lo < hi) {
+		Uint32 mid = lo + (hi - lo) / 2;
+		const unsigned char *e = bundle + BUNDLE_HEADER + mid * BUNDLE_ENTRY;
+		Uint32 elen = bundle_u32(e + 4);
+		int r;
+
+		r = memcmp(name, bundle + bundle_u32(e), (len < elen) ? len : elen);
+		if (r == 0) {
+			r = (len < elen) ? -1 : (len > elen);
+		}
+
+		if (r == 0) {
+			if (!bundle_current(e)) {
+				return false;
+			}
+
+			*code = (const char *) bundle + bundle_u32(e + 8);
+			*code_len = bundle_u32(e + 12);
+			return true;
+		}
+		else if (r < 0) {
+			hi = mid;
+		}
+		else {
+			lo = mid + 1;
+		}
+	}
+
+	return false;
+}
+
+
+/* bundle_searcher
+** package.loaders entry, loads the module from the bundle if it is there
+** and its source is unchanged, otherwise the source searchers find it
+*/
+static int bundle_searcher(lua_State *L) {
+	const char *name, *code;
+	size_t len, code_len;
+
+	name = luaL_checklstring(L, 1, &len);
+
+	if (!bundle_find(name, len, &code, &code_len)) {
+		lua_pushfstring(L, "\n\tno module '%s' in " LUA_BUNDLE_FILE, name);
+		return 1;
+	}
+
+	if (luaL_loadbuffer(L, code, code_len, name) != 0) {
+		return luaL_error(L, "error loading module '%s' from " LUA_BUNDLE_FILE ":\n\t%s", name, lua_tostring(L, -1));
+	}
+
+	return 1;
+}
+
+
+/* bundle_load
+** func = jive.bundle.load(name), or nil if name is not in the bundle or its
+** source has changed. For
+** modules loaded with loadfile, such as applets. jive.bundle.dir is the
+** script path the bundle was built from.
+*/
+static int bundle_load(lua_State *L) {
+	const char *name, *code;
+	size_t len, code_len;
+
+	name = luaL_checklstring(L, 1, &len);
+
+	if (!bundle_find(name, len, &code, &code_len)) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	if (luaL_loadbuffer(L, code, code_len, name) != 0) {
+		lua_pushnil(L);
+		lua_insert(L, -2);
+		return 2;
+	}
+
+	return 1;
+}
+
+
+/* bundle_setup
+** Add the bundle searcher to package.loaders, after the preload searcher
+** so it is used before the lua source files. package is on the stack.
+*/
+static void bundle_setup(lua_State *L, const char *dir) {
+	char *filename;
+	int i;
+
+	if (getenv("JIVE_NO_BUNDLE")) {
+		// use the source files, for development
+		return;
+	}
+
+	// sources are checked against the bundle relative to its directory
+	free(bundle_dir);
+	bundle_dir = strdup(dir);
+	if (!bundle_dir) {
+		return;
+	}
+
+	filename = malloc(strlen(dir) + sizeof(DIR_SEPARATOR_STR LUA_BUNDLE_FILE));
+	if (!filename) {
+		return;
+	}
+	strcpy(filename, dir);
+	strcat(filename, DIR_SEPARATOR_STR LUA_BUNDLE_FILE);
+
+	if (!bundle_open(filename)) {
+		free(filename);
+		return;
+	}
+	free(filename);
+
+	lua_getfield(L, -1, "loaders");
+	if (lua_istable(L, -1)) {
+		for (i = lua_objlen(L, -1); i >= 2; i--) {
+			lua_rawgeti(L, -1, i);
+			lua_rawseti(L, -2, i + 1);
+		}
+		lua_pushcfunction(L, bundle_searcher);
+		lua_rawseti(L, -2, 2);
+	}
+	lua_pop(L, 1);
+
+	// jive.bundle module
+	lua_getfield(L, -1, "loaded");
+	lua_newtable(L);
+	lua_pushcfunction(L, bundle_load);
+	lua_setfield(L, -2, "load");
+	lua_pushstring(L, dir);
+	lua_setfield(L, -2, "dir");
+	lua_setfield(L, -2, "jive.bundle");
+	lua_pop(L, 1);
+}
+
+
 /* paths_setup
 ** Modify the lua path and cpath, prepending standard directories
 ** relative to this executable.
@@ -166,6 +478,17 @@ static void paths_setup(lua_State *L, char *app) {
 	lua_getglobal(L, "package");
 	if (lua_istable(L, -1)) {
 		luaL_Buffer b;
+
+		// precompiled modules, from the script path
+		strcpy(temp, binpath);
+		strcat(temp, "/" LUA_DEFAULT_REL_PATH);
+		realpath(temp, path);
+
+		bundle_setup(L, path);
+		if (!bundle) {
+			bundle_setup(L, LUA_DEFAULT_FIX_PATH);
+		}
+
 		luaL_buffinit(L, &b);
 
 		// default lua path
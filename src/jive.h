@@ -200,6 +200,8 @@ typedef struct jive_event JiveEvent;
 
 typedef struct jive_font JiveFont;
 
+typedef struct jive_buffer JiveBuffer;
+
 
 struct jive_peer_meta {
 	size_t size;
@@ -332,6 +334,9 @@ void jive_send_gesture_event(JiveGesture code);
 void jive_send_char_press_event(Uint16 unicode);
 void jive_send_quit(void);
 
+/* network reactor */
+void jive_reactor_wakeup(void);
+
 
 /* platform functions */
 void platform_init(lua_State *L);
@@ -344,6 +349,9 @@ char *platform_get_arch();
 /* global counter used to invalidate widget */
 extern Uint32 jive_origin;
 
+/* global counter of animation frames */
+extern Uint32 jive_frame;
+
 /* Util functions */
 void jive_print_stack(lua_State *L, char *str);
 void jive_debug_traceback(lua_State *L, int n);
@@ -356,6 +364,17 @@ void jive_rect_intersection(SDL_Rect *a, SDL_Rect *b, SDL_Rect *c);
 void jive_queue_event(JiveEvent *evt);
 int jive_traceback (lua_State *L);
 
+/* Buffer functions */
+JiveBuffer *jive_buffer_new(lua_State *L, size_t capacity);
+JiveBuffer *jive_buffer_to(lua_State *L, int idx);
+const char *jive_buffer_tolstring(lua_State *L, int idx, size_t *len);
+const char *jive_buffer_checklstring(lua_State *L, int idx, size_t *len);
+const char *jive_buffer_bytes(JiveBuffer *b);
+size_t jive_buffer_len(JiveBuffer *b);
+char *jive_buffer_reserve(JiveBuffer *b, size_t n);
+void jive_buffer_commit(JiveBuffer *b, size_t n);
+bool jive_buffer_append(JiveBuffer *b, const char *bytes, size_t len);
+
 /* Surface functions */
 JiveSurface *jive_surface_set_video_mode(Uint16 w, Uint16 h, Uint16 bpp, bool fullscreen);
 JiveSurface *jive_surface_newRGB(Uint16 w, Uint16 h);
@@ -364,6 +383,7 @@ JiveSurface *jive_surface_new_SDLSurface(SDL_Surface *sdl_surface);
 JiveSurface *jive_surface_ref(JiveSurface *srf);
 JiveSurface *jive_surface_load_image(const char *path);
 JiveSurface *jive_surface_load_image_data(const char *data, size_t len);
+JiveSurface *jive_surface_load_image_scaled(const char *data, size_t len, int w, int h, bool cover, int *iw, int *ih);
 int jive_surface_set_wm_icon(JiveSurface *srf);
 int jive_surface_save_bmp(JiveSurface *srf, const char *file);
 int jive_surface_cmp(JiveSurface *a, JiveSurface *b, Uint32 key);
@@ -380,6 +400,7 @@ void jive_surface_blit_clip(JiveSurface *src, Uint16 sx, Uint16 sy, Uint16 sw, U
 			    JiveSurface* dst, Uint16 dx, Uint16 dy);
 void jive_surface_blit_alpha(JiveSurface *src, JiveSurface *dst, Uint16 dx, Uint16 dy, Uint8 alpha);
 void jive_surface_get_size(JiveSurface *srf, Uint16 *w, Uint16 *h);
+SDL_Surface *jive_surface_get_sdl(JiveSurface *srf);
 int jive_surface_get_bytes(JiveSurface *srf);
 void jive_surface_free(JiveSurface *srf);
 void jive_surface_release(JiveSurface *srf);
@@ -575,6 +596,7 @@ int jiveL_surface_newRGB(lua_State *L);
 int jiveL_surface_newRGBA(lua_State *L);
 int jiveL_surface_load_image(lua_State *L);
 int jiveL_surface_load_image_data(lua_State *L);
+int jiveL_surface_load_image_scaled(lua_State *L);
 int jiveL_surface_draw_text(lua_State *L);
 int jiveL_surface_free(lua_State *L);
 int jiveL_surface_release(lua_State *L);
@@ -0,0 +1,386 @@
+/*
+** Copyright 2010 Logitech. All Rights Reserved.
+**
+** This file is licensed under BSD. Please see the LICENSE file for details.
+*/
+
+#include "common.h"
+#include "jive.h"
+
+/*
+Refcounted byte buffers for network bodies and image data.
+
+A jive.buffer is a view (offset and length) onto a shared block of bytes.
+Slices share the block instead of copying it, and the bytes are never
+interned as lua strings, so large bodies such as artwork can be received,
+cached and decoded in place. Appending to a view that ends at the end of
+the block writes into the spare capacity, other views are unaffected as
+their length is fixed. Appending anywhere else copies the view first.
+*/
+
+
+#define BUFFER_MIN_SIZE 1024
+
+
+struct jive_buffer_data {
+	int refcount;
+	size_t used, capacity;
+	char *bytes;
+};
+
+struct jive_buffer {
+	struct jive_buffer_data *data;
+	size_t offset, len;
+};
+
+
+static struct jive_buffer_data *_data_new(size_t capacity) {
+	struct jive_buffer_data *data;
+
+	data = malloc(sizeof(struct jive_buffer_data));
+	if (!data) {
+		return NULL;
+	}
+
+	data->refcount = 1;
+	data->used = 0;
+	data->capacity = capacity;
+	data->bytes = capacity ? malloc(capacity) : NULL;
+
+	if (capacity && !data->bytes) {
+		free(data);
+		return NULL;
+	}
+
+	return data;
+}
+
+
+static void _data_unref(struct jive_buffer_data *data) {
+	if (data && --data->refcount == 0) {
+		free(data->bytes);
+		free(data);
+	}
+}
+
+
+JiveBuffer *jive_buffer_new(lua_State *L, size_t capacity) {
+	JiveBuffer *b;
+
+	b = lua_newuserdata(L, sizeof(JiveBuffer));
+	b->data = NULL;
+	b->offset = 0;
+	b->len = 0;
+
+	luaL_getmetatable(L, "jive.buffer");
+	lua_setmetatable(L, -2);
+
+	if (capacity) {
+		b->data = _data_new(capacity);
+		if (!b->data) {
+			luaL_error(L, "out of memory");
+		}
+	}
+
+	return b;
+}
+
+
+JiveBuffer *jive_buffer_to(lua_State *L, int idx) {
+	JiveBuffer *b = lua_touserdata(L, idx);
+
+	if (b && lua_getmetatable(L, idx)) {
+		luaL_getmetatable(L, "jive.buffer");
+		if (!lua_rawequal(L, -1, -2)) {
+			b = NULL;
+		}
+		lua_pop(L, 2);
+		return b;
+	}
+
+	return NULL;
+}
+
+
+const char *jive_buffer_tolstring(lua_State *L, int idx, size_t *len) {
+	JiveBuffer *b = jive_buffer_to(L, idx);
+
+	if (b) {
+		if (len) {
+			*len = b->len;
+		}
+		return jive_buffer_bytes(b);
+	}
+
+	if (lua_type(L, idx) == LUA_TSTRING) {
+		return lua_tolstring(L, idx, len);
+	}
+
+	return NULL;
+}
+
+
+const char *jive_buffer_checklstring(lua_State *L, int idx, size_t *len) {
+	const char *s = jive_buffer_tolstring(L, idx, len);
+
+	if (!s) {
+		luaL_typerror(L, idx, "string or buffer");
+	}
+
+	return s;
+}
+
+
+const char *jive_buffer_bytes(JiveBuffer *b) {
+	return (b->data && b->data->bytes) ? b->data->bytes + b->offset : "";
+}
+
+
+size_t jive_buffer_len(JiveBuffer *b) {
+	return b->len;
+}
+
+
+/*
+ * Returns space for at least n bytes at the end of the buffer, to be
+ * filled directly, for example by recv, and then committed. Returns NULL
+ * if out of memory.
+ */
+char *jive_buffer_reserve(JiveBuffer *b, size_t n) {
+	struct jive_buffer_data *data = b->data;
+	size_t end = b->offset + b->len;
+
+	if (data && data->refcount > 1 && end != data->used) {
+		/* another view owns the bytes after this one, copy on write */
+		struct jive_buffer_data *copy = _data_new(MAX(b->len + n, BUFFER_MIN_SIZE));
+
+		if (!copy) {
+			return NULL;
+		}
+
+		memcpy(copy->bytes, data->bytes + b->offset, b->len);
+		copy->used = b->len;
+		_data_unref(data);
+
+		b->data = data = copy;
+		b->offset = 0;
+		end = b->len;
+	}
+
+	if (!data) {
+		b->data = data = _data_new(MAX(n, BUFFER_MIN_SIZE));
+		if (!data) {
+			return NULL;
+		}
+	}
+
+	if (end + n > data->capacity) {
+		size_t capacity = MAX(data->capacity, BUFFER_MIN_SIZE);
+		char *bytes;
+
+		while (capacity < end + n) {
+			capacity *= 2;
+		}
+
+		/* views keep offsets, not pointers, so the block can move */
+		bytes = realloc(data->bytes, capacity);
+		if (!bytes) {
+			return NULL;
+		}
+
+		data->bytes = bytes;
+		data->capacity = capacity;
+	}
+
+	return data->bytes + end;
+}
+
+
+/*
+ * Adds n bytes written to the space returned by jive_buffer_reserve.
+ */
+void jive_buffer_commit(JiveBuffer *b, size_t n) {
+	b->len += n;
+	b->data->used = b->offset + b->len;
+}
+
+
+bool jive_buffer_append(JiveBuffer *b, const char *bytes, size_t len) {
+	char *dst;
+
+	if (len == 0) {
+		return true;
+	}
+
+	dst = jive_buffer_reserve(b, len);
+	if (!dst) {
+		return false;
+	}
+
+	memcpy(dst, bytes, len);
+	jive_buffer_commit(b, len);
+	return true;
+}
+
+
+static JiveBuffer *_check_buffer(lua_State *L, int idx) {
+	return luaL_checkudata(L, idx, "jive.buffer");
+}
+
+
+/* convert lua string style 1 based inclusive indexes to an offset and length */
+static void _range(lua_State *L, JiveBuffer *b, int idx, size_t *offset, size_t *len) {
+	ptrdiff_t i = luaL_optinteger(L, idx, 1);
+	ptrdiff_t j = luaL_optinteger(L, idx + 1, -1);
+	ptrdiff_t n = (ptrdiff_t) b->len;
+
+	if (i < 0) {
+		i += n + 1;
+	}
+	if (j < 0) {
+		j += n + 1;
+	}
+	if (i < 1) {
+		i = 1;
+	}
+	if (j > n) {
+		j = n;
+	}
+
+	if (i > j) {
+		*offset = 0;
+		*len = 0;
+	}
+	else {
+		*offset = i - 1;
+		*len = j - i + 1;
+	}
+}
+
+
+/*
+ * buffer = jive_buffer:new([size])
+ *
+ * Returns an empty buffer, with space reserved for size bytes.
+ */
+static int jiveL_buffer_new(lua_State *L) {
+	jive_buffer_new(L, luaL_optinteger(L, 2, 0));
+	return 1;
+}
+
+
+static int jiveL_buffer_gc(lua_State *L) {
+	JiveBuffer *b = lua_touserdata(L, 1);
+
+	_data_unref(b->data);
+	b->data = NULL;
+	b->len = 0;
+
+	return 0;
+}
+
+
+/*
+ * buffer = buffer:append(data)
+ *
+ * Appends a string or another buffer.
+ */
+static int jiveL_buffer_append(lua_State *L) {
+	JiveBuffer *b = _check_buffer(L, 1);
+	const char *bytes;
+	size_t len;
+
+	bytes = jive_buffer_checklstring(L, 2, &len);
+	if (jive_buffer_to(L, 2) == b) {
+		/* appending to itself, the bytes may move on reserve */
+		lua_pushlstring(L, bytes, len);
+		bytes = lua_tolstring(L, -1, &len);
+	}
+
+	if (!jive_buffer_append(b, bytes, len)) {
+		return luaL_error(L, "out of memory");
+	}
+
+	lua_settop(L, 1);
+	return 1;
+}
+
+
+/*
+ * slice = buffer:slice([i [, j]])
+ *
+ * Returns a new buffer sharing the bytes i to j, indexes are as for
+ * string.sub.
+ */
+static int jiveL_buffer_slice(lua_State *L) {
+	JiveBuffer *b = _check_buffer(L, 1);
+	JiveBuffer *s;
+	size_t offset, len;
+
+	_range(L, b, 2, &offset, &len);
+
+	s = jive_buffer_new(L, 0);
+	if (len) {
+		s->data = b->data;
+		s->data->refcount++;
+		s->offset = b->offset + offset;
+		s->len = len;
+	}
+
+	return 1;
+}
+
+
+/*
+ * str = buffer:tostring([i [, j]])
+ *
+ * Copies the bytes i to j into a lua string.
+ */
+static int jiveL_buffer_tostring(lua_State *L) {
+	JiveBuffer *b = _check_buffer(L, 1);
+	size_t offset, len;
+
+	_range(L, b, 2, &offset, &len);
+	lua_pushlstring(L, jive_buffer_bytes(b) + offset, len);
+
+	return 1;
+}
+
+
+static int jiveL_buffer_len(lua_State *L) {
+	JiveBuffer *b = _check_buffer(L, 1);
+
+	lua_pushinteger(L, b->len);
+	return 1;
+}
+
+
+static const struct luaL_Reg buffer_m[] = {
+	{ "__gc", jiveL_buffer_gc },
+	{ "__len", jiveL_buffer_len },
+	{ "append", jiveL_buffer_append },
+	{ "slice", jiveL_buffer_slice },
+	{ "tostring", jiveL_buffer_tostring },
+	{ "len", jiveL_buffer_len },
+	{ NULL, NULL }
+};
+
+
+static const struct luaL_Reg buffer_lib[] = {
+	{ "new", jiveL_buffer_new },
+	{ NULL, NULL }
+};
+
+
+int luaopen_jive_buffer(lua_State *L) {
+	luaL_newmetatable(L, "jive.buffer");
+
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+
+	luaL_register(L, NULL, buffer_m);
+
+	luaL_register(L, "jive.buffer", buffer_lib);
+
+	return 0;
+}
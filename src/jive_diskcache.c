@@ -0,0 +1,767 @@
+/*
+** Copyright 2010 Logitech. All Rights Reserved.
+**
+** This file is licensed under BSD. Please see the LICENSE file for details.
+*/
+
+#include "common.h"
+#include "jive.h"
+
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+Persistent content addressed blob store, used for the artwork cache.
+
+Blobs are files in the cache directory named by the hash of their
+contents, so the same artwork stored under several keys is only written
+once. The index is a fixed size open addressing hash table in a memory
+mapped file, mapping the hash of each key to its blob, size and last use.
+The least recently used entries are evicted once the blobs exceed the
+byte limit, or the index is three quarters full.
+
+Blobs are queued for the writer thread, see system_write_file, which
+writes them to a temporary file and renames them into place. The index
+may refer to a blob before it is written: a read of a missing blob waits
+for the queued writes first. Blobs are checked against their hash when
+read, so after a crash an entry is at worst dropped when it is next used.
+This avoids an fsync for each blob. Blobs no longer in the index are
+removed when the cache is opened.
+
+Surfaces are stored as their pixels in the surface format, artwork that
+has already been resized to display format is loaded without decoding.
+*/
+
+
+#define DISKCACHE_MAGIC "JIVEDC01"
+#define DISKCACHE_INDEX "index"
+#define DISKCACHE_SLOTS 4096
+
+#define PIXELS_MAGIC "JPX1"
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+
+struct diskcache_header {
+	char magic[8];
+	Uint32 slots;
+	Uint32 clock;
+};
+
+struct diskcache_slot {
+	Uint64 key;	/* hash of the key, 0 if the slot is empty */
+	Uint64 blob;	/* hash of the contents, names the blob file */
+	Uint32 size;
+	Uint32 used;	/* clock at last use */
+};
+
+/* stored before the rows of a surface */
+struct diskcache_pixels {
+	char magic[4];
+	Uint16 w, h;
+	Uint16 pitch;
+	Uint8 bpp;
+	Uint8 pad;
+	Uint32 rmask, gmask, bmask, amask;
+};
+
+struct diskcache {
+	char *path;
+	size_t max_bytes;
+	size_t bytes;
+	Uint32 count;
+
+	int fd;
+	size_t map_len;
+	struct diskcache_header *header;
+	struct diskcache_slot *slots;
+};
+
+enum diskcache_kind {
+	KIND_DATA = 0,
+	KIND_PIXELS,
+};
+
+
+static LOG_CATEGORY *log_cache;
+
+
+static Uint64 _hash(const void *bytes, size_t len, Uint64 h) {
+	const Uint8 *p = bytes;
+
+	while (len--) {
+		h ^= *p++;
+		h *= FNV_PRIME;
+	}
+
+	return h;
+}
+
+
+static Uint64 _key_hash(const char *key, size_t len, enum diskcache_kind kind) {
+	Uint8 k = kind;
+	Uint64 h;
+
+	h = _hash(&k, 1, FNV_OFFSET);
+	h = _hash(key, len, h);
+
+	/* zero marks an empty slot */
+	return h ? h : 1;
+}
+
+
+static void _blob_path(struct diskcache *dc, Uint64 blob, char *buf, size_t len) {
+	snprintf(buf, len, "%s/%016llx", dc->path, (unsigned long long) blob);
+}
+
+
+static Uint32 _home(struct diskcache *dc, Uint64 key) {
+	return (Uint32) (key % dc->header->slots);
+}
+
+
+static int _find(struct diskcache *dc, Uint64 key) {
+	Uint32 i = _home(dc, key);
+
+	while (dc->slots[i].key) {
+		if (dc->slots[i].key == key) {
+			return i;
+		}
+		i = (i + 1) % dc->header->slots;
+	}
+
+	return -1;
+}
+
+
+static bool _blob_referenced(struct diskcache *dc, Uint64 blob) {
+	Uint32 i;
+
+	for (i = 0; i < dc->header->slots; i++) {
+		if (dc->slots[i].key && dc->slots[i].blob == blob) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+static void _remove(struct diskcache *dc, Uint32 i) {
+	Uint32 slots = dc->header->slots;
+	Uint64 blob = dc->slots[i].blob;
+	Uint32 j;
+
+	dc->bytes -= dc->slots[i].size;
+	dc->count--;
+
+	/* backward shift deletion, keeps probe sequences unbroken */
+	j = i;
+	for (;;) {
+		Uint32 home;
+
+		j = (j + 1) % slots;
+		if (!dc->slots[j].key) {
+			break;
+		}
+
+		/* can the entry at j move to the hole at i? */
+		home = _home(dc, dc->slots[j].key);
+		if ((j > i && (home <= i || home > j)) || (j < i && (home <= i && home > j))) {
+			dc->slots[i] = dc->slots[j];
+			i = j;
+		}
+	}
+
+	memset(&dc->slots[i], 0, sizeof(struct diskcache_slot));
+
+	if (!_blob_referenced(dc, blob)) {
+		char path[PATH_MAX];
+
+		_blob_path(dc, blob, path, sizeof(path));
+		unlink(path);
+	}
+}
+
+
+static void _evict(struct diskcache *dc, size_t need) {
+	Uint32 limit = dc->header->slots * 3 / 4;
+
+	while (dc->count && (dc->bytes + need > dc->max_bytes || dc->count >= limit)) {
+		Uint32 i, lru = 0, age = 0;
+
+		for (i = 0; i < dc->header->slots; i++) {
+			if (dc->slots[i].key && dc->header->clock - dc->slots[i].used >= age) {
+				age = dc->header->clock - dc->slots[i].used;
+				lru = i;
+			}
+		}
+
+		LOG_DEBUG(log_cache, "evict %016llx", (unsigned long long) dc->slots[lru].blob);
+		_remove(dc, lru);
+	}
+}
+
+
+static bool _write_blob(struct diskcache *dc, Uint64 blob, const void *a, size_t alen, const void *b, size_t blen) {
+	char path[PATH_MAX];
+	struct stat st;
+
+	_blob_path(dc, blob, path, sizeof(path));
+
+	/* content addressed, the same bytes are already stored */
+	if (stat(path, &st) == 0 && (size_t) st.st_size == alen + blen) {
+		return true;
+	}
+
+	/* written off the ui thread, a replace followed by an append to the
+	 * same file is queued as one job */
+	system_write_file(path, a, alen);
+	if (blen) {
+		system_append_file(path, b, blen);
+	}
+
+	return true;
+}
+
+
+static bool _store(struct diskcache *dc, Uint64 key, const void *a, size_t alen, const void *b, size_t blen) {
+	Uint64 blob;
+	int i;
+
+	if (alen + blen > dc->max_bytes) {
+		return false;
+	}
+
+	blob = _hash(b, blen, _hash(a, alen, FNV_OFFSET));
+
+	i = _find(dc, key);
+	if (i >= 0) {
+		if (dc->slots[i].blob == blob) {
+			dc->slots[i].used = ++dc->header->clock;
+			return true;
+		}
+		_remove(dc, i);
+	}
+
+	_evict(dc, alen + blen);
+
+	if (!_write_blob(dc, blob, a, alen, b, blen)) {
+		return false;
+	}
+
+	i = _home(dc, key);
+	while (dc->slots[i].key) {
+		i = (i + 1) % dc->header->slots;
+	}
+
+	dc->slots[i].blob = blob;
+	dc->slots[i].size = alen + blen;
+	dc->slots[i].used = ++dc->header->clock;
+	dc->slots[i].key = key;
+
+	dc->bytes += alen + blen;
+	dc->count++;
+
+	return true;
+}
+
+
+/*
+ * Reads the blob for key into a new buffer pushed on the stack. Returns
+ * NULL, pushing nothing, if the key is not cached or the blob is missing
+ * or corrupt.
+ */
+static JiveBuffer *_load(lua_State *L, struct diskcache *dc, Uint64 key) {
+	char path[PATH_MAX];
+	struct diskcache_slot *slot;
+	struct stat st;
+	JiveBuffer *b;
+	char *dst;
+	size_t n = 0;
+	int i, fd;
+
+	i = _find(dc, key);
+	if (i < 0) {
+		return NULL;
+	}
+
+	slot = &dc->slots[i];
+	_blob_path(dc, slot->blob, path, sizeof(path));
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0 && errno == ENOENT) {
+		/* the blob may still be queued for the writer thread */
+		system_flush_files();
+		fd = open(path, O_RDONLY);
+	}
+	if (fd < 0 || fstat(fd, &st) < 0 || (size_t) st.st_size != slot->size) {
+		goto err;
+	}
+
+	b = jive_buffer_new(L, 0);
+	dst = jive_buffer_reserve(b, slot->size);
+	if (!dst) {
+		lua_pop(L, 1);
+		goto err;
+	}
+
+	while (n < slot->size) {
+		ssize_t r = read(fd, dst + n, slot->size - n);
+
+		if (r <= 0) {
+			if (r < 0 && errno == EINTR) {
+				continue;
+			}
+			lua_pop(L, 1);
+			goto err;
+		}
+		n += r;
+	}
+
+	close(fd);
+
+	if (_hash(dst, n, FNV_OFFSET) != slot->blob) {
+		LOG_WARN(log_cache, "Corrupt blob %s", path);
+		lua_pop(L, 1);
+		unlink(path);
+		_remove(dc, i);
+		return NULL;
+	}
+
+	jive_buffer_commit(b, n);
+	slot->used = ++dc->header->clock;
+
+	return b;
+
+ err:
+	if (fd >= 0) {
+		close(fd);
+	}
+	_remove(dc, i);
+	return NULL;
+}
+
+
+static int _blob_cmp(const void *a, const void *b) {
+	Uint64 x = *(const Uint64 *) a;
+	Uint64 y = *(const Uint64 *) b;
+
+	return (x > y) - (x < y);
+}
+
+
+/* remove temporary files and blobs that are not in the index */
+static void _cleanup(struct diskcache *dc) {
+	char path[PATH_MAX];
+	struct dirent *ent;
+	Uint64 *blobs;
+	Uint32 i, n = 0;
+	DIR *dir;
+
+	dir = opendir(dc->path);
+	if (!dir) {
+		return;
+	}
+
+	blobs = malloc(sizeof(Uint64) * (dc->count + 1));
+	if (!blobs) {
+		closedir(dir);
+		return;
+	}
+
+	for (i = 0; i < dc->header->slots; i++) {
+		if (dc->slots[i].key) {
+			blobs[n++] = dc->slots[i].blob;
+		}
+	}
+	qsort(blobs, n, sizeof(Uint64), _blob_cmp);
+
+	while ((ent = readdir(dir)) != NULL) {
+		size_t len = strlen(ent->d_name);
+		Uint64 blob;
+		char *end;
+
+		/* temporary files left by an interrupted write are removed */
+		if (strncmp(ent->d_name, "tmp.", 4) != 0
+		    && !(len > 4 && strcmp(ent->d_name + len - 4, ".new") == 0)) {
+			if (len != 16) {
+				continue;
+			}
+
+			blob = strtoull(ent->d_name, &end, 16);
+			if (*end || bsearch(&blob, blobs, n, sizeof(Uint64), _blob_cmp)) {
+				continue;
+			}
+		}
+
+		snprintf(path, sizeof(path), "%s/%s", dc->path, ent->d_name);
+		unlink(path);
+	}
+
+	closedir(dir);
+	free(blobs);
+}
+
+
+static bool _open_index(struct diskcache *dc, Uint32 slots) {
+	char path[PATH_MAX];
+	struct stat st;
+	Uint32 i;
+	bool init;
+
+	snprintf(path, sizeof(path), "%s/" DISKCACHE_INDEX, dc->path);
+
+	dc->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (dc->fd < 0 || fstat(dc->fd, &st) < 0) {
+		return false;
+	}
+
+	dc->map_len = sizeof(struct diskcache_header) + slots * sizeof(struct diskcache_slot);
+
+	/* a index of the wrong size is discarded, this also resizes it */
+	init = ((size_t) st.st_size != dc->map_len);
+	if (init && (ftruncate(dc->fd, 0) < 0 || ftruncate(dc->fd, dc->map_len) < 0)) {
+		return false;
+	}
+
+	dc->header = mmap(NULL, dc->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, dc->fd, 0);
+	if (dc->header == MAP_FAILED) {
+		dc->header = NULL;
+		return false;
+	}
+	dc->slots = (struct diskcache_slot *) (dc->header + 1);
+
+	if (init || memcmp(dc->header->magic, DISKCACHE_MAGIC, 8) != 0 || dc->header->slots != slots) {
+		memset(dc->header, 0, dc->map_len);
+		memcpy(dc->header->magic, DISKCACHE_MAGIC, 8);
+		dc->header->slots = slots;
+	}
+
+	dc->bytes = 0;
+	dc->count = 0;
+	for (i = 0; i < slots; i++) {
+		if (dc->slots[i].key) {
+			dc->bytes += dc->slots[i].size;
+			dc->count++;
+		}
+	}
+
+	return true;
+}
+
+
+static void _close(struct diskcache *dc) {
+	if (dc->header) {
+		munmap(dc->header, dc->map_len);
+		dc->header = NULL;
+		dc->slots = NULL;
+	}
+	if (dc->fd >= 0) {
+		close(dc->fd);
+		dc->fd = -1;
+	}
+	if (dc->path) {
+		free(dc->path);
+		dc->path = NULL;
+	}
+}
+
+
+static struct diskcache *_check_cache(lua_State *L, int idx) {
+	struct diskcache *dc = luaL_checkudata(L, idx, "jive.diskcache");
+
+	if (!dc->header) {
+		luaL_error(L, "disk cache is closed");
+	}
+
+	return dc;
+}
+
+
+/*
+ * cache, err = jive_diskcache:open(path, maxBytes [, slots])
+ *
+ * Opens the cache in the directory path, creating it if needed. The
+ * index holds at most three quarters of slots entries.
+ */
+static int jiveL_diskcache_open(lua_State *L) {
+	const char *path = luaL_checkstring(L, 2);
+	size_t max_bytes = luaL_checkinteger(L, 3);
+	Uint32 slots = luaL_optinteger(L, 4, DISKCACHE_SLOTS);
+	struct diskcache *dc;
+
+	if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: %s", path, strerror(errno));
+		return 2;
+	}
+
+	dc = lua_newuserdata(L, sizeof(struct diskcache));
+	memset(dc, 0, sizeof(struct diskcache));
+	dc->fd = -1;
+
+	luaL_getmetatable(L, "jive.diskcache");
+	lua_setmetatable(L, -2);
+
+	dc->path = strdup(path);
+	dc->max_bytes = max_bytes;
+
+	if (!dc->path || !_open_index(dc, MAX(slots, 16))) {
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: %s", path, strerror(errno));
+		_close(dc);
+		return 2;
+	}
+
+	_evict(dc, 0);
+	_cleanup(dc);
+
+	LOG_INFO(log_cache, "%s: %d entries %d bytes", path, dc->count, (int) dc->bytes);
+
+	return 1;
+}
+
+
+static int jiveL_diskcache_gc(lua_State *L) {
+	struct diskcache *dc = lua_touserdata(L, 1);
+
+	_close(dc);
+	return 0;
+}
+
+
+/*
+ * buffer = cache:get(key)
+ *
+ * Returns the data stored for key as a jive.buffer, or nil.
+ */
+static int jiveL_diskcache_get(lua_State *L) {
+	struct diskcache *dc = _check_cache(L, 1);
+	const char *key;
+	size_t len;
+
+	key = luaL_checklstring(L, 2, &len);
+
+	if (!_load(L, dc, _key_hash(key, len, KIND_DATA))) {
+		lua_pushnil(L);
+	}
+
+	return 1;
+}
+
+
+/*
+ * ok = cache:set(key, data)
+ *
+ * Stores a string or jive.buffer for key.
+ */
+static int jiveL_diskcache_set(lua_State *L) {
+	struct diskcache *dc = _check_cache(L, 1);
+	const char *key, *data;
+	size_t len, data_len;
+
+	key = luaL_checklstring(L, 2, &len);
+	data = jive_buffer_checklstring(L, 3, &data_len);
+
+	lua_pushboolean(L, _store(dc, _key_hash(key, len, KIND_DATA), data, data_len, NULL, 0));
+	return 1;
+}
+
+
+/*
+ * surface = cache:getSurface(key)
+ *
+ * Returns the surface stored for key, or nil.
+ */
+static int jiveL_diskcache_get_surface(lua_State *L) {
+	struct diskcache *dc = _check_cache(L, 1);
+	struct diskcache_pixels hdr;
+	const char *key, *src;
+	SDL_Surface *sdl;
+	JiveSurface *srf, **p;
+	JiveBuffer *b;
+	size_t len;
+	int y, row;
+
+	key = luaL_checklstring(L, 2, &len);
+
+	b = _load(L, dc, _key_hash(key, len, KIND_PIXELS));
+	if (!b) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	src = jive_buffer_bytes(b);
+	len = jive_buffer_len(b);
+
+	if (len < sizeof(hdr)) {
+		lua_pushnil(L);
+		return 1;
+	}
+	memcpy(&hdr, src, sizeof(hdr));
+
+	row = hdr.w * ((hdr.bpp + 7) / 8);
+	if (memcmp(hdr.magic, PIXELS_MAGIC, 4) != 0 || hdr.pitch < row
+	    || len != sizeof(hdr) + (size_t) hdr.pitch * hdr.h) {
+		lua_pushnil(L);
+		return 1;
+	}
+	src += sizeof(hdr);
+
+	sdl = SDL_CreateRGBSurface(SDL_SWSURFACE, hdr.w, hdr.h, hdr.bpp, hdr.rmask, hdr.gmask, hdr.bmask, hdr.amask);
+	if (!sdl) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	SDL_LockSurface(sdl);
+	for (y = 0; y < hdr.h; y++) {
+		memcpy((Uint8 *) sdl->pixels + y * sdl->pitch, src + y * hdr.pitch, row);
+	}
+	SDL_UnlockSurface(sdl);
+
+	srf = jive_surface_new_SDLSurface(sdl);
+
+	p = (JiveSurface **) lua_newuserdata(L, sizeof(JiveSurface *));
+	*p = srf;
+	luaL_getmetatable(L, "JiveSurface");
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
+
+/*
+ * ok = cache:setSurface(key, surface)
+ *
+ * Stores the pixels of surface for key, in the surface format.
+ */
+static int jiveL_diskcache_set_surface(lua_State *L) {
+	struct diskcache *dc = _check_cache(L, 1);
+	struct diskcache_pixels hdr;
+	const char *key;
+	JiveSurface *srf;
+	SDL_Surface *sdl;
+	size_t len;
+	bool ok;
+
+	key = luaL_checklstring(L, 2, &len);
+	srf = *(JiveSurface **) luaL_checkudata(L, 3, "JiveSurface");
+
+	sdl = srf ? jive_surface_get_sdl(srf) : NULL;
+	if (!sdl || sdl->w > 0xffff || sdl->h > 0xffff
+	    || sdl->format->BitsPerPixel < 8 || sdl->format->palette) {
+		lua_pushboolean(L, 0);
+		return 1;
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, PIXELS_MAGIC, 4);
+	hdr.w = sdl->w;
+	hdr.h = sdl->h;
+	hdr.pitch = sdl->pitch;
+	hdr.bpp = sdl->format->BitsPerPixel;
+	hdr.rmask = sdl->format->Rmask;
+	hdr.gmask = sdl->format->Gmask;
+	hdr.bmask = sdl->format->Bmask;
+	hdr.amask = sdl->format->Amask;
+
+	SDL_LockSurface(sdl);
+	ok = _store(dc, _key_hash(key, len, KIND_PIXELS), &hdr, sizeof(hdr), sdl->pixels, (size_t) sdl->pitch * sdl->h);
+	SDL_UnlockSurface(sdl);
+
+	lua_pushboolean(L, ok);
+	return 1;
+}
+
+
+/*
+ * bool = cache:hasSurface(key)
+ *
+ * Returns true if a surface is stored for key, from the index only.
+ */
+static int jiveL_diskcache_has_surface(lua_State *L) {
+	struct diskcache *dc = _check_cache(L, 1);
+	const char *key;
+	size_t len;
+
+	key = luaL_checklstring(L, 2, &len);
+
+	lua_pushboolean(L, _find(dc, _key_hash(key, len, KIND_PIXELS)) >= 0);
+	return 1;
+}
+
+
+/*
+ * cache:remove(key)
+ *
+ * Removes the data and surface stored for key.
+ */
+static int jiveL_diskcache_remove(lua_State *L) {
+	struct diskcache *dc = _check_cache(L, 1);
+	const char *key;
+	size_t len;
+	int kind, i;
+
+	key = luaL_checklstring(L, 2, &len);
+
+	for (kind = KIND_DATA; kind <= KIND_PIXELS; kind++) {
+		i = _find(dc, _key_hash(key, len, kind));
+		if (i >= 0) {
+			_remove(dc, i);
+		}
+	}
+
+	return 0;
+}
+
+
+/*
+ * count, bytes = cache:stats()
+ */
+static int jiveL_diskcache_stats(lua_State *L) {
+	struct diskcache *dc = _check_cache(L, 1);
+
+	lua_pushinteger(L, dc->count);
+	lua_pushinteger(L, dc->bytes);
+	return 2;
+}
+
+
+static const struct luaL_Reg diskcache_m[] = {
+	{ "__gc", jiveL_diskcache_gc },
+	{ "close", jiveL_diskcache_gc },
+	{ "get", jiveL_diskcache_get },
+	{ "set", jiveL_diskcache_set },
+	{ "getSurface", jiveL_diskcache_get_surface },
+	{ "setSurface", jiveL_diskcache_set_surface },
+	{ "hasSurface", jiveL_diskcache_has_surface },
+	{ "remove", jiveL_diskcache_remove },
+	{ "stats", jiveL_diskcache_stats },
+	{ NULL, NULL }
+};
+
+
+static const struct luaL_Reg diskcache_lib[] = {
+	{ "open", jiveL_diskcache_open },
+	{ NULL, NULL }
+};
+
+
+int luaopen_jive_diskcache(lua_State *L) {
+	log_cache = LOG_CATEGORY_GET("squeezebox.server.cache");
+
+	luaL_newmetatable(L, "jive.diskcache");
+
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+
+	luaL_register(L, NULL, diskcache_m);
+
+	luaL_register(L, "jive.diskcache", diskcache_lib);
+
+	return 0;
+}
@@ -24,14 +24,16 @@ typedef int socket_t;
 #endif
 
 /* fm - 01/12/2010
-Userland DNS resolve requests are queued into a pipe in jiveL_dns_write(), then
-dns_resolver_thread() reads the pipe and calls gethostbyaddr() or gethostbyname().
-Both of these functions are blocking and can take a couple of seconds to return,
-especially if the network is down.
-To allow the pipe to empty if a lot of DNS requests are issued while the network
+Userland DNS resolve requests are queued in jiveL_dns_write(), then one of the
+dns_resolver_thread()s takes the request and calls getnameinfo() or
+getaddrinfo(). Both of these functions are blocking and can take a couple of
+seconds to return, especially if the network is down. Several threads are used
+so that one slow lookup does not hold up the others. Each request has an id
+that is sent back with its reply, so replies may arrive in any order.
+To allow the queue to empty if a lot of DNS requests are issued while the network
 is down a 'shortcut' is taken as long as the following timeout is active. The
-shortcut path doesn't call the blocking functions but just reads from the pipe
-and returns the last error code again.
+shortcut path doesn't call the blocking functions but just takes requests from
+the queue and returns the last error code again.
 The timeout was set to 2 minutes which I found in my tests on Jive, Baby and
 Touch not to be necessary to make sure the pipe gets emptied. 10 seconds seem
 to be enough.
@@ -40,6 +42,13 @@ re-established.
 */
 #define RESOLV_TIMEOUT (10 * 1000) /* 10 seconds (was 2 minutes) */
 
+#define RESOLV_THREADS 4
+
+/* replies may be written after the lua side has been closed */
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 
 /*
  * Some systems do not provide this so that we provide our own. It's not
@@ -139,177 +148,380 @@ int socketpair(int domain, int type, int protocol, SOCKET socks[2])
 #endif
 
 
-/* write a string to the pipe fd */
-static void write_str(socket_t fd, char *str) {
-	size_t len;
+struct dns_request {
+	Uint32 id;
+	struct dns_request *next;
+	char address[1];
+};
+
+
+/* state shared by the resolver threads, freed by the last user */
+struct dns_pool {
+	socket_t fd[2];
+	int refs;
+	bool quit;
+
+	SDL_mutex *lock;
+	SDL_cond *cond;
+	struct dns_request *head, *tail;
+	Uint32 next_id;
+
+	/* network down shortcut, see above */
+	const char *failed_error;
+	Uint32 failed_timeout;
+
+	/* resolver state is per thread, so each thread calls res_init once
+	 * resolv.conf changes, when its generation is behind the pool's */
+	time_t resolv_mtime;
+	Uint32 resolv_generation;
+
+	/* replies are written whole, so threads don't interleave */
+	SDL_mutex *write_lock;
+};
+
+
+/* returns true and starts a new generation if resolv.conf has changed,
+ * called with the pool locked */
+static bool stat_resolv_conf(struct dns_pool *pool) {
+#ifndef _WIN32
+	struct stat stat_buf;
+
+	if (stat("/etc/resolv.conf", &stat_buf) == 0) {
+		if (pool->resolv_mtime != stat_buf.st_mtime) {
+			pool->resolv_mtime = stat_buf.st_mtime;
+			pool->resolv_generation++;
+			return true;
+		}
+	}
+#endif
 
-	len = strlen(str);
-	send(fd, &len, sizeof(len), 0);
-	send(fd, str, len, 0);
+	return false;
 }
 
 
-/* read a string to the lua stack from the pipe fd */
-static void read_pushstring(lua_State *L, socket_t fd) {
-	size_t len;
-	char *buf;
+static void dns_pool_unref(struct dns_pool *pool) {
+	struct dns_request *req;
+	int refs;
 
-	recv(fd, &len, sizeof(len), 0);
+	SDL_LockMutex(pool->lock);
+	refs = --pool->refs;
+	SDL_UnlockMutex(pool->lock);
 
-	if (len == 0) {
-		lua_pushnil(L);
+	if (refs > 0) {
+		return;
 	}
-	else {
-		buf = malloc(len);
-		if ( buf == NULL )
-			lua_pushnil(L);
-		else {
-			recv(fd, buf, len, 0);
-			lua_pushlstring(L, buf, len);
-
-			free(buf);
+
+	while ((req = pool->head)) {
+		pool->head = req->next;
+		free(req);
+	}
+
+	CLOSESOCKET(pool->fd[1]);
+	SDL_DestroyCond(pool->cond);
+	SDL_DestroyMutex(pool->lock);
+	SDL_DestroyMutex(pool->write_lock);
+	free(pool);
+}
+
+
+static const char *dns_gai_error(int err) {
+	switch (err) {
+	case EAI_NONAME:
+		return "Not found";
+#if defined(EAI_NODATA) && EAI_NODATA != EAI_NONAME
+	case EAI_NODATA:
+		return "No data";
+#endif
+	case EAI_FAIL:
+		return "No recovery";
+	case EAI_AGAIN:
+		return "Try again";
+	default:
+		return gai_strerror(err);
+	}
+}
+
+
+/*
+Replies are sent to the lua side as one binary record each, a struct
+dns_reply header followed by the addresses and then the name. Each address
+is a family byte (4 or 6) and 4 or 16 address bytes. If error is set the
+record has no addresses and the name is the error message. Records are
+built on the stack and written with a single send, and read back into a
+stack buffer, so no memory is allocated per reply.
+*/
+#define DNS_MAX_ADDRS 16
+#define DNS_ADDR_MAX (1 + 16)
+#define DNS_RECORD_MAX (sizeof(struct dns_reply) + DNS_MAX_ADDRS * DNS_ADDR_MAX + NI_MAXHOST)
+
+struct dns_reply {
+	Uint32 id;
+	Uint16 size;	/* bytes after the header */
+	Uint8 error;
+	Uint8 naddrs;
+};
+
+
+/* append an address to the record, unless it is already there */
+static char *dns_put_addr(char *rec, char *p, int family, const void *addr) {
+	struct dns_reply *reply = (struct dns_reply *) rec;
+	Uint8 tag = (family == AF_INET6) ? 6 : 4;
+	size_t len = (family == AF_INET6) ? 16 : 4;
+	char *q = rec + sizeof(struct dns_reply);
+
+	if (reply->naddrs == DNS_MAX_ADDRS) {
+		return p;
+	}
+
+	/* one entry per address, not per socket type */
+	while (q < p) {
+		size_t qlen = (*q == 6) ? 16 : 4;
+
+		if (*q == tag && memcmp(q + 1, addr, len) == 0) {
+			return p;
 		}
+		q += 1 + qlen;
 	}
+
+	*p++ = tag;
+	memcpy(p, addr, len);
+	reply->naddrs++;
+
+	return p + len;
 }
 
 
-static int stat_resolv_conf(void) {
-#ifndef _WIN32
-	struct stat stat_buf;
-	static time_t last_mtime = 0;
+/* send the record, p is the end of the addresses */
+static void dns_send_record(struct dns_pool *pool, char *rec, char *p, const char *name) {
+	struct dns_reply *reply = (struct dns_reply *) rec;
+	size_t len = strlen(name);
 
-	/* check if resolv.conf has changed */
-	if (stat("/etc/resolv.conf", &stat_buf) == 0) {
-		if (last_mtime != stat_buf.st_mtime) {
-			last_mtime = stat_buf.st_mtime;
-			return 1;
+	if (len > NI_MAXHOST) {
+		len = NI_MAXHOST;
+	}
+	memcpy(p, name, len);
+	p += len;
+
+	reply->size = (Uint16) (p - rec - sizeof(struct dns_reply));
+
+	SDL_LockMutex(pool->write_lock);
+	send(pool->fd[1], rec, p - rec, MSG_NOSIGNAL);
+	SDL_UnlockMutex(pool->write_lock);
+}
+
+
+static void dns_send_error(struct dns_pool *pool, Uint32 id, const char *error) {
+	char rec[DNS_RECORD_MAX];
+	struct dns_reply *reply = (struct dns_reply *) rec;
+
+	reply->id = id;
+	reply->error = 1;
+	reply->naddrs = 0;
+
+	dns_send_record(pool, rec, rec + sizeof(struct dns_reply), error);
+}
+
+
+/* read len bytes, a record may arrive in more than one piece */
+static bool dns_recv(socket_t fd, char *buf, size_t len) {
+	while (len > 0) {
+		int n = recv(fd, buf, len, 0);
+
+		if (n <= 0) {
+			return false;
 		}
+		buf += n;
+		len -= n;
+	}
+
+	return true;
+}
+
+
+/* resolve and write the reply for one request */
+static void dns_resolve(struct dns_pool *pool, struct dns_request *req) {
+	char rec[DNS_RECORD_MAX];
+	struct dns_reply *reply = (struct dns_reply *) rec;
+	char *p = rec + sizeof(struct dns_reply);
+	struct addrinfo hints, *res = NULL, *ai;
+	struct sockaddr_storage ss;
+	socklen_t sslen = 0;
+	char host[NI_MAXHOST];
+	const char *name = NULL;
+	int err;
+
+	memset(&ss, 0, sizeof(ss));
+	if (inet_aton(req->address, &((struct sockaddr_in *) &ss)->sin_addr)) {
+		ss.ss_family = AF_INET;
+		sslen = sizeof(struct sockaddr_in);
+	}
+	else if (inet_pton(AF_INET6, req->address, &((struct sockaddr_in6 *) &ss)->sin6_addr) == 1) {
+		ss.ss_family = AF_INET6;
+		sslen = sizeof(struct sockaddr_in6);
+	}
+
+	if (sslen) {
+		err = getnameinfo((struct sockaddr *) &ss, sslen, host, sizeof(host), NULL, 0, NI_NAMEREQD);
+		name = host;
 	}
+	else {
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_CANONNAME;
+#ifdef AI_ADDRCONFIG
+		/* don't ask for IPv6 addresses unless we have IPv6 */
+		hints.ai_flags |= AI_ADDRCONFIG;
 #endif
 
-	return 0;
+		err = getaddrinfo(req->address, NULL, &hints, &res);
+		if (err == 0) {
+			name = (res->ai_canonname) ? res->ai_canonname : req->address;
+		}
+	}
+
+	if (err) {
+		const char *error = dns_gai_error(err);
+
+		if (err == EAI_FAIL || err == EAI_AGAIN) {
+			SDL_LockMutex(pool->lock);
+			pool->failed_error = error;
+			pool->failed_timeout = jive_jiffies();
+			SDL_UnlockMutex(pool->lock);
+		}
+
+		dns_send_error(pool, req->id, error);
+		return;
+	}
+
+	reply->id = req->id;
+	reply->error = 0;
+	reply->naddrs = 0;
+
+	if (res) {
+		for (ai = res; ai; ai = ai->ai_next) {
+			if (ai->ai_family == AF_INET) {
+				p = dns_put_addr(rec, p, AF_INET, &((struct sockaddr_in *) ai->ai_addr)->sin_addr);
+			}
+			else if (ai->ai_family == AF_INET6) {
+				p = dns_put_addr(rec, p, AF_INET6, &((struct sockaddr_in6 *) ai->ai_addr)->sin6_addr);
+			}
+		}
+	}
+	else if (ss.ss_family == AF_INET) {
+		p = dns_put_addr(rec, p, AF_INET, &((struct sockaddr_in *) &ss)->sin_addr);
+	}
+	else {
+		p = dns_put_addr(rec, p, AF_INET6, &((struct sockaddr_in6 *) &ss)->sin6_addr);
+	}
+
+	dns_send_record(pool, rec, p, name);
+
+	if (res) {
+		freeaddrinfo(res);
+	}
 }
 
 
 /* dns resolver thread */
 static int dns_resolver_thread(void *p) {
-	socket_t fd = (long) p;
-	struct hostent *hostent;
-	struct in_addr **addr, byaddr;
-	char **alias;
-	size_t len;
-	char *buf;
-	char *failed_error = NULL;
-	Uint32 failed_timeout = 0;
+	struct dns_pool *pool = p;
+	struct dns_request *req;
+	Uint32 generation = 0, resolv_generation;
 
 	while (1) {
-		if (recv(fd, &len, sizeof(len), 0) < 0) {
-			/* broken pipe */
-			return 0;
-		}
+		SDL_LockMutex(pool->lock);
 
-		buf = malloc(len + 1);
-		if ( buf == NULL )
-			return 0;
+		while (!pool->head && !pool->quit) {
+			SDL_CondWait(pool->cond, pool->lock);
+		}
 
-		if (recv(fd, buf, len, 0) < 0) {
-			/* broken pipe */
-			free(buf);
+		if (pool->quit) {
+			SDL_UnlockMutex(pool->lock);
+			dns_pool_unref(pool);
 			return 0;
 		}
-		buf[len] = '\0';
-		if (failed_error && stat_resolv_conf()) {
-			#ifndef _WIN32
-			//reload resolv.conf
-			res_init();
-			#endif
-		}
-		else if (failed_error && !stat_resolv_conf()) {
+
+		req = pool->head;
+		pool->head = req->next;
+
+		if (pool->failed_error && !stat_resolv_conf(pool)) {
 			Uint32 now = jive_jiffies();
-			
-			if (now - failed_timeout < RESOLV_TIMEOUT) {
-				write_str(fd, failed_error);
-				free(buf);
+
+			if (now - pool->failed_timeout < RESOLV_TIMEOUT) {
+				const char *failed_error = pool->failed_error;
+
+				SDL_UnlockMutex(pool->lock);
+
+				dns_send_error(pool, req->id, failed_error);
+
+				free(req);
 				continue;
 			}
 		}
-		failed_error = NULL;
+		pool->failed_error = NULL;
+		resolv_generation = pool->resolv_generation;
 
-		if (inet_aton(buf, &byaddr)) {
-			hostent = gethostbyaddr((char *) &byaddr, sizeof(addr), AF_INET);
-		}
-		else {
-			hostent = gethostbyname(buf);
-		}
-		free(buf);
-
-		if (hostent == NULL) {
-			/* error */
-			switch (h_errno) {
-			case HOST_NOT_FOUND:
-				write_str(fd, "Not found");
-				break;
-			case NO_DATA:
-				write_str(fd, "No data");
-				break;
-			case NO_RECOVERY:
-				failed_error = "No recovery";
-				failed_timeout = jive_jiffies();
-				write_str(fd, failed_error);
-				break;
-			case TRY_AGAIN:
-				failed_error = "Try again"; 
-				failed_timeout = jive_jiffies();
-				write_str(fd, failed_error);
-				break;
-			}
-		}
-		else {
-			write_str(fd, ""); // no error
-			write_str(fd, hostent->h_name);
-
-			alias = hostent->h_aliases;
-			while (*alias) {
-				write_str(fd, *alias);
-				alias++;
-			}
-			write_str(fd, ""); // end of aliases
+		SDL_UnlockMutex(pool->lock);
 
-			addr = (struct in_addr **) hostent->h_addr_list;
-			while (*addr) {
-				write_str(fd, inet_ntoa(**addr));
-				addr++;
-			}
-			write_str(fd, ""); // end if addrs
+		if (generation != resolv_generation) {
+			#ifndef _WIN32
+			//reload resolv.conf
+			res_init();
+			#endif
+			generation = resolv_generation;
 		}
+
+		dns_resolve(pool, req);
+		free(req);
 	}
 }
 
 
 struct dns_userdata {
-	socket_t fd[2];
-	SDL_Thread *t;
+	struct dns_pool *pool;
 };
 
 
 static int jiveL_dns_open(lua_State *L) {
 	struct dns_userdata *u;
-	int r;
+	struct dns_pool *pool;
+	int i, r;
 
 	u = lua_newuserdata(L, sizeof(struct dns_userdata));
+	u->pool = NULL;
 
-	r = socketpair(AF_UNIX, SOCK_STREAM, 0, u->fd);
+	luaL_getmetatable(L, "jive.dns");
+	lua_setmetatable(L, -2);
+
+	pool = calloc(1, sizeof(struct dns_pool));
+	if (pool == NULL) {
+		return luaL_error(L, "out of memory");
+	}
+
+	r = socketpair(AF_UNIX, SOCK_STREAM, 0, pool->fd);
 	if (r < 0) {
+		free(pool);
 		return luaL_error(L, "socketpair failed: %s", strerror(r));
 	}
 
-	u->t = SDL_CreateThread(dns_resolver_thread, (void *)(long)(u->fd[1]));
-	if (u->t == NULL) {
-		return luaL_error(L, "create dns_resolver_thread failed");
-	}
+	pool->lock = SDL_CreateMutex();
+	pool->write_lock = SDL_CreateMutex();
+	pool->cond = SDL_CreateCond();
+	pool->refs = 1;
+	u->pool = pool;
 
-	luaL_getmetatable(L, "jive.dns");
-	lua_setmetatable(L, -2);
+	for (i = 0; i < RESOLV_THREADS; i++) {
+		pool->refs++;
+
+		if (SDL_CreateThread(dns_resolver_thread, pool) == NULL) {
+			pool->refs--;
+			if (i == 0) {
+				return luaL_error(L, "create dns_resolver_thread failed");
+			}
+			break;
+		}
+	}
 
 	return 1;
 }
@@ -317,10 +529,23 @@ static int jiveL_dns_open(lua_State *L) {
 
 static int jiveL_dns_gc(lua_State *L) {
 	struct dns_userdata *u;
+	struct dns_pool *pool;
 
 	u = lua_touserdata(L, 1);
-	CLOSESOCKET(u->fd[0]);
-	CLOSESOCKET(u->fd[1]);
+	pool = u->pool;
+	if (!pool) {
+		return 0;
+	}
+	u->pool = NULL;
+
+	/* threads exit after any lookup in progress */
+	SDL_LockMutex(pool->lock);
+	pool->quit = true;
+	SDL_CondBroadcast(pool->cond);
+	SDL_UnlockMutex(pool->lock);
+
+	CLOSESOCKET(pool->fd[0]);
+	dns_pool_unref(pool);
 
 	return 0;
 }
@@ -330,70 +555,119 @@ static int jiveL_dns_getfd(lua_State *L) {
 	struct dns_userdata *u;
 
 	u = lua_touserdata(L, 1);
-	lua_pushinteger(L, u->fd[0]);
+	lua_pushinteger(L, u->pool->fd[0]);
 
 	return 1;
 }
 
 
+/*
+ * hostent, err, id = dns:read()
+ *
+ * Reads the next reply, id is the request id returned by dns:write().
+ * hostent is { name = name, ip = { IPv4 addresses }, ip6 = { IPv6 addresses } }.
+ */
 static int jiveL_dns_read(lua_State *L) {
 	struct dns_userdata *u;
-	int i, resolved;
+	struct dns_reply reply;
+	char body[DNS_RECORD_MAX];
+	char ip[INET6_ADDRSTRLEN];
+	char *p, *end;
+	int i, nip = 0, nip6 = 0;
 
 	u = lua_touserdata(L, 1);
 
-	/* error? */
-	read_pushstring(L, u->fd[0]);
-	if (!lua_isnil(L, -1)) {
+	if (!dns_recv(u->pool->fd[0], (char *) &reply, sizeof(reply))
+	    || reply.size > sizeof(body)
+	    || !dns_recv(u->pool->fd[0], body, reply.size)) {
+		return luaL_error(L, "dns read failed");
+	}
+
+	p = body;
+	end = body + reply.size;
+
+	if (reply.error) {
 		lua_pushnil(L);
-		lua_insert(L, -2);
-		return 2;
+		lua_pushlstring(L, p, end - p);
+		lua_pushinteger(L, reply.id);
+		return 3;
 	}
 
 	/* read hostent table */
+	lua_createtable(L, 0, 3);
+	lua_newtable(L);
 	lua_newtable(L);
-	resolved = lua_gettop(L);
 
-	lua_pushstring(L, "name");
-	read_pushstring(L, u->fd[0]);
-	lua_settable(L, resolved);
+	for (i = 0; i < reply.naddrs && p < end; i++) {
+		int family = (*p == 6) ? AF_INET6 : AF_INET;
 
-	i = 1;
-	lua_newtable(L);
-	read_pushstring(L, u->fd[0]);
-	while (!lua_isnil(L, -1)) {
-		lua_rawseti(L, -2, i++);
-		read_pushstring(L, u->fd[0]);
+		if (inet_ntop(family, p + 1, ip, sizeof(ip))) {
+			lua_pushstring(L, ip);
+			if (family == AF_INET6) {
+				lua_rawseti(L, -2, ++nip6);
+			}
+			else {
+				lua_rawseti(L, -3, ++nip);
+			}
+		}
+		p += (family == AF_INET6) ? 17 : 5;
 	}
-	lua_pop(L, 1);
-	lua_setfield(L, resolved, "alias");
 
-	i = 1;
-	lua_newtable(L);
-	read_pushstring(L, u->fd[0]);
-	while (!lua_isnil(L, -1)) {
-		lua_rawseti(L, -2, i++);
-		read_pushstring(L, u->fd[0]);
+	lua_setfield(L, -3, "ip6");
+	lua_setfield(L, -2, "ip");
+
+	if (p < end) {
+		lua_pushlstring(L, p, end - p);
+		lua_setfield(L, -2, "name");
 	}
-	lua_pop(L, 1);
-	lua_setfield(L, resolved, "ip");
 
-	return 1;
+	lua_pushnil(L);
+	lua_pushinteger(L, reply.id);
+	return 3;
 }
 
 
+/*
+ * id = dns:write(address)
+ *
+ * Queues a lookup of a host name, or of the name of an IP address.
+ */
 static int jiveL_dns_write(lua_State *L) {
 	struct dns_userdata *u;
+	struct dns_pool *pool;
+	struct dns_request *req;
 	const char *buf;
 	size_t len;
+	Uint32 id;
 
 	u = lua_touserdata(L, 1);
-	buf = lua_tolstring(L, 2, &len);
+	pool = u->pool;
+	buf = luaL_checklstring(L, 2, &len);
 
-	send(u->fd[0], &len, sizeof(len), 0);
-	send(u->fd[0], buf, len, 0);
+	req = malloc(sizeof(struct dns_request) + len);
+	if (req == NULL) {
+		return luaL_error(L, "out of memory");
+	}
+	memcpy(req->address, buf, len + 1);
+	req->next = NULL;
 
-	return 0;
+	SDL_LockMutex(pool->lock);
+
+	req->id = id = ++pool->next_id;
+	if (pool->head) {
+		pool->tail->next = req;
+	}
+	else {
+		pool->head = req;
+	}
+	pool->tail = req;
+
+	SDL_CondSignal(pool->cond);
+	SDL_UnlockMutex(pool->lock);
+
+	/* req may already be resolved and freed */
+	lua_pushinteger(L, id);
+	return 1;
 }
 
 
@@ -25,6 +25,9 @@ SDL_Rect jive_dirty_region, last_dirty_region;
 Uint32 jive_origin = 0;
 static Uint32 next_jive_origin = 0;
 
+/* global counter of animation frames, used to share per frame state */
+Uint32 jive_frame = 0;
+
 
 /* performance warning thresholds, 0 = disabled */
 struct jive_perfwarn perfwarn = { 0, 0, 0, 0, 0, 0 };
@@ -209,6 +212,9 @@ int jive_traceback (lua_State *L) {
 }
 
 void jive_quit(void) {
+	/* settings written by the writer thread */
+	system_flush_files();
+
 	SDL_Quit();
 }
 
@@ -341,6 +347,11 @@ static int jiveL_initSDL(lua_State *L) {
 
 static int filter_events(const SDL_Event *event)
 {
+#if !defined(WIN32)
+	/* interrupt the network wait, the event needs processing */
+	jive_reactor_wakeup();
+#endif
+
 	if (jive_sdlfilter_pump) {
 		return jive_sdlfilter_pump(event);
 	}
@@ -382,6 +393,10 @@ void jive_send_quit(void) {
 	SDL_Event event;
 	event.type = SDL_QUIT;
 	SDL_PushEvent(&event);
+
+#if !defined(WIN32)
+	jive_reactor_wakeup();
+#endif
 }
 
 int jiveL_quit(lua_State *L) {
@@ -526,6 +541,8 @@ static int _draw_screen(lua_State *L) {
  
 	/* Widget animations - don't update in a standalone draw as its not the main screen update */
 	if (!standalone_draw) {
+		jive_frame++;
+
 		lua_getfield(L, 1, "animations");
 		lua_pushnil(L);
 		while (lua_next(L, -2) != 0) {
@@ -1599,6 +1616,7 @@ static const struct luaL_Reg surface_methods[] = {
 	{ "newRGBA", jiveL_surface_newRGBA },
 	{ "loadImage", jiveL_surface_load_image },
 	{ "loadImageData", jiveL_surface_load_image_data },
+	{ "loadImageScaled", jiveL_surface_load_image_scaled },
 	{ "drawText", jiveL_surface_draw_text },
 	{ "free", jiveL_surface_free },
 	{ "release", jiveL_surface_release },
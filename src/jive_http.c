@@ -0,0 +1,793 @@
+/*
+** Copyright 2010 Logitech. All Rights Reserved.
+**
+** This file is licensed under BSD. Please see the LICENSE file for details.
+*/
+
+#include "common.h"
+#include "jive.h"
+
+#include <ctype.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+
+#define strncasecmp _strnicmp
+
+typedef SOCKET socket_t;
+#define SOCKET_ERRNO     WSAGetLastError()
+#define SOCKET_EAGAIN(e) ((e) == WSAEWOULDBLOCK)
+#define SOCKET_EINTR(e)  ((e) == WSAEINTR)
+
+#else
+#include <strings.h>
+
+typedef int socket_t;
+#define SOCKET_ERRNO     errno
+#define SOCKET_EAGAIN(e) ((e) == EAGAIN || (e) == EWOULDBLOCK)
+#define SOCKET_EINTR(e)  ((e) == EINTR)
+
+#endif
+
+/*
+Incremental HTTP/1.1 response parser used by jive.net.SocketHttp.
+
+The parser reads directly from the socket fd into a fixed receive buffer,
+the status line and headers are only parsed once the complete header block
+has arrived, so no lua strings are created per line. Body data is returned
+as slices of the buffer, by content length, chunked or until the server
+closes the connection. Each call to body() returns a complete chunk for
+chunked responses, as the Comet protocol relies on the chunk boundaries.
+
+Data following a response stays in the buffer for the next response on a
+keep-alive connection, pending() is true while there is unparsed data.
+
+If a jive.buffer is given to body() the data is appended to it and the
+buffer is returned instead of a string. Once the receive buffer is drained
+the rest of a content length or connection close body is received directly
+into the jive.buffer.
+*/
+
+
+#define HTTP_BUFFER_SIZE 16384
+
+/* largest single receive directly into a jive.buffer */
+#define HTTP_DIRECT_SIZE (HTTP_BUFFER_SIZE * 16)
+
+
+enum http_state {
+	HTTP_HEADERS,
+	HTTP_BODY_LENGTH,
+	HTTP_BODY_CLOSE,
+	HTTP_CHUNK_SIZE,
+	HTTP_CHUNK_DATA,
+	HTTP_CHUNK_CRLF,
+	HTTP_TRAILERS,
+	HTTP_DONE,
+};
+
+enum http_fill {
+	FILL_DATA,
+	FILL_AGAIN,
+	FILL_CLOSED,
+	FILL_FULL,
+	FILL_ERROR,
+};
+
+struct http_parser {
+	enum http_state state;
+
+	/* unparsed data is buf[start..end], headers are scanned from scan */
+	size_t start, end, scan;
+
+	/* bytes left in the body or current chunk */
+	size_t remaining;
+
+	int status;
+	bool keepalive;
+	bool chunked;
+	bool closed;
+
+	/* chunk spanning more than one read */
+	char *chunk;
+	size_t chunk_len, chunk_size;
+
+	char buf[HTTP_BUFFER_SIZE];
+};
+
+
+static int _getfd(lua_State *L, int idx) {
+	int fd = -1;
+
+	lua_getfield(L, idx, "getfd");
+	if (lua_isfunction(L, -1)) {
+		lua_pushvalue(L, idx);
+		lua_call(L, 1, 1);
+		if (lua_isnumber(L, -1)) {
+			fd = lua_tointeger(L, -1);
+		}
+	}
+	lua_pop(L, 1);
+
+	return fd;
+}
+
+
+static enum http_fill _fill(struct http_parser *p, socket_t fd, int *err) {
+	int n;
+
+	if (p->start > 0) {
+		memmove(p->buf, p->buf + p->start, p->end - p->start);
+		p->end -= p->start;
+		p->scan -= p->start;
+		p->start = 0;
+	}
+
+	if (p->end == HTTP_BUFFER_SIZE) {
+		return FILL_FULL;
+	}
+
+	do {
+		n = recv(fd, p->buf + p->end, HTTP_BUFFER_SIZE - p->end, 0);
+		*err = (n < 0) ? SOCKET_ERRNO : 0;
+	} while (n < 0 && SOCKET_EINTR(*err));
+
+	if (n > 0) {
+		p->end += n;
+		return FILL_DATA;
+	}
+	if (n == 0) {
+		p->closed = true;
+		return FILL_CLOSED;
+	}
+	if (SOCKET_EAGAIN(*err)) {
+		return FILL_AGAIN;
+	}
+	return FILL_ERROR;
+}
+
+
+/* push nil and the error for a failed fill, returns false if there was no error */
+static bool _fill_error(lua_State *L, enum http_fill r, int err) {
+	switch (r) {
+	case FILL_CLOSED:
+		lua_pushnil(L);
+		lua_pushliteral(L, "closed");
+		return true;
+
+	case FILL_FULL:
+		lua_pushnil(L);
+		lua_pushliteral(L, "response too large");
+		return true;
+
+	case FILL_ERROR:
+		lua_pushnil(L);
+		lua_pushstring(L, strerror(err));
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+/* find the next line from pos, returns its length without CRLF or -1 */
+static ssize_t _line(struct http_parser *p, size_t pos, size_t *next) {
+	char *nl = memchr(p->buf + pos, '\n', p->end - pos);
+	size_t len;
+
+	if (!nl) {
+		return -1;
+	}
+
+	len = nl - (p->buf + pos);
+	*next = pos + len + 1;
+
+	if (len > 0 && p->buf[pos + len - 1] == '\r') {
+		len--;
+	}
+	return len;
+}
+
+
+static inline bool _name_is(const char *name, size_t len, const char *str) {
+	return strlen(str) == len && strncasecmp(name, str, len) == 0;
+}
+
+
+static bool _value_has(const char *value, size_t len, const char *str) {
+	size_t n = strlen(str);
+	size_t i;
+
+	for (i = 0; i + n <= len; i++) {
+		if (strncasecmp(value + i, str, n) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/*
+ * Parses a complete header block. Pushes the status code, status line and
+ * headers table and returns 3, pushes nil and an error and returns 2, or
+ * returns 0 if the header block is incomplete.
+ */
+static int _parse_headers(lua_State *L, struct http_parser *p) {
+	size_t pos, next, end_pos = 0;
+	ssize_t len;
+	int major, minor, tab;
+	bool has_length = false;
+	char *line;
+
+	/* skip empty lines before the status line */
+	while (p->scan == p->start && (len = _line(p, p->start, &next)) == 0) {
+		p->start = p->scan = next;
+	}
+
+	/* look for the empty line ending the header block */
+	while ((len = _line(p, p->scan, &next)) >= 0) {
+		p->scan = next;
+		if (len == 0) {
+			end_pos = next;
+			break;
+		}
+	}
+
+	if (!end_pos) {
+		return 0;
+	}
+
+	/* status line */
+	pos = p->start;
+	len = _line(p, pos, &next);
+	line = p->buf + pos;
+
+	if (len < 12 || strncmp(line, "HTTP/", 5) != 0
+	    || sscanf(line + 5, "%d.%d", &major, &minor) != 2) {
+		lua_pushnil(L);
+		lua_pushliteral(L, "malformed status line");
+		return 2;
+	}
+
+	line = memchr(line, ' ', len);
+	if (!line || !isdigit(line[1]) || !isdigit(line[2]) || !isdigit(line[3])) {
+		lua_pushnil(L);
+		lua_pushliteral(L, "malformed status line");
+		return 2;
+	}
+
+	p->status = (line[1] - '0') * 100 + (line[2] - '0') * 10 + (line[3] - '0');
+	p->keepalive = (major > 1 || (major == 1 && minor >= 1));
+	p->chunked = false;
+	p->remaining = 0;
+
+	lua_pushinteger(L, p->status);
+	lua_pushlstring(L, p->buf + pos, len);
+	lua_newtable(L);
+	tab = lua_gettop(L);
+
+	/* headers */
+	for (pos = next; (len = _line(p, pos, &next)) > 0; pos = next) {
+		char *name = p->buf + pos;
+		char *colon = memchr(name, ':', len);
+		char *value, *end = name + len;
+		size_t name_len;
+
+		if (!colon) {
+			lua_settop(L, tab - 3);
+			lua_pushnil(L);
+			lua_pushliteral(L, "malformed response headers");
+			return 2;
+		}
+
+		name_len = colon - name;
+		value = colon + 1;
+		while (value < end && (*value == ' ' || *value == '\t')) {
+			value++;
+		}
+
+		lua_pushlstring(L, name, name_len);
+		lua_pushlstring(L, value, end - value);
+		lua_rawset(L, tab);
+
+		if (_name_is(name, name_len, "Transfer-Encoding")) {
+			p->chunked = _value_has(value, end - value, "chunked");
+		}
+		else if (_name_is(name, name_len, "Content-Length")) {
+			p->remaining = strtoul(value, NULL, 10);
+			has_length = true;
+		}
+		else if (_name_is(name, name_len, "Connection")) {
+			if (_value_has(value, end - value, "close")) {
+				p->keepalive = false;
+			}
+			else if (_value_has(value, end - value, "keep-alive")) {
+				p->keepalive = true;
+			}
+		}
+	}
+
+	p->start = p->scan = end_pos;
+
+	/* body framing */
+	if (p->chunked) {
+		p->state = HTTP_CHUNK_SIZE;
+	}
+	else if (has_length) {
+		p->state = p->remaining ? HTTP_BODY_LENGTH : HTTP_DONE;
+	}
+	else if (p->status / 100 == 1 || p->status == 204 || p->status == 304) {
+		p->state = HTTP_DONE;
+	}
+	else {
+		p->state = HTTP_BODY_CLOSE;
+		p->keepalive = false;
+	}
+
+	return 3;
+}
+
+
+static bool _chunk_append(struct http_parser *p, const char *data, size_t len) {
+	if (p->chunk_len + len > p->chunk_size) {
+		size_t size = p->chunk_size ? p->chunk_size : HTTP_BUFFER_SIZE;
+		char *chunk;
+
+		while (size < p->chunk_len + len) {
+			size *= 2;
+		}
+
+		chunk = realloc(p->chunk, size);
+		if (!chunk) {
+			return false;
+		}
+		p->chunk = chunk;
+		p->chunk_size = size;
+	}
+
+	memcpy(p->chunk + p->chunk_len, data, len);
+	p->chunk_len += len;
+	return true;
+}
+
+
+/* push body data as a string, or appended to the jive.buffer at bidx */
+static bool _push_data(lua_State *L, JiveBuffer *b, int bidx, const char *data, size_t len) {
+	if (!b) {
+		lua_pushlstring(L, data, len);
+		return true;
+	}
+
+	if (!jive_buffer_append(b, data, len)) {
+		lua_pushnil(L);
+		lua_pushliteral(L, "out of memory");
+		return false;
+	}
+
+	lua_pushvalue(L, bidx);
+	return true;
+}
+
+
+/*
+ * Parses body data from the buffer. Returns the number of values pushed,
+ * or 0 if more data is needed.
+ */
+static int _parse_body(lua_State *L, struct http_parser *p, JiveBuffer *b, int bidx) {
+	size_t avail, n, next;
+	ssize_t len;
+
+	for (;;) {
+		avail = p->end - p->start;
+
+		switch (p->state) {
+		case HTTP_HEADERS:
+			lua_pushnil(L);
+			lua_pushliteral(L, "headers not read");
+			return 2;
+
+		case HTTP_DONE:
+			lua_pushnil(L);
+			lua_pushliteral(L, "done");
+			return 2;
+
+		case HTTP_BODY_LENGTH:
+			if (!avail) {
+				return 0;
+			}
+
+			n = MIN(avail, p->remaining);
+			if (!_push_data(L, b, bidx, p->buf + p->start, n)) {
+				return 2;
+			}
+			p->start += n;
+			p->remaining -= n;
+
+			if (p->remaining == 0) {
+				p->state = HTTP_DONE;
+				lua_pushliteral(L, "done");
+				return 2;
+			}
+			return 1;
+
+		case HTTP_BODY_CLOSE:
+			if (!avail) {
+				return 0;
+			}
+
+			if (!_push_data(L, b, bidx, p->buf + p->start, avail)) {
+				return 2;
+			}
+			p->start += avail;
+			return 1;
+
+		case HTTP_CHUNK_SIZE:
+			len = _line(p, p->start, &next);
+			if (len < 0) {
+				return 0;
+			}
+
+			if (len == 0 || !isxdigit(p->buf[p->start])) {
+				lua_pushnil(L);
+				lua_pushliteral(L, "invalid chunk size");
+				return 2;
+			}
+
+			p->remaining = strtoul(p->buf + p->start, NULL, 16);
+			p->start = next;
+			p->chunk_len = 0;
+			p->state = p->remaining ? HTTP_CHUNK_DATA : HTTP_TRAILERS;
+			break;
+
+		case HTTP_CHUNK_DATA:
+			if (p->chunk_len == 0 && avail >= p->remaining) {
+				/* complete chunk in the buffer */
+				if (!_push_data(L, b, bidx, p->buf + p->start, p->remaining)) {
+					return 2;
+				}
+				p->start += p->remaining;
+				p->state = HTTP_CHUNK_CRLF;
+				return 1;
+			}
+
+			if (!avail) {
+				return 0;
+			}
+
+			n = MIN(avail, p->remaining);
+			if (!_chunk_append(p, p->buf + p->start, n)) {
+				lua_pushnil(L);
+				lua_pushliteral(L, "out of memory");
+				return 2;
+			}
+			p->start += n;
+			p->remaining -= n;
+
+			if (p->remaining) {
+				return 0;
+			}
+
+			if (!_push_data(L, b, bidx, p->chunk, p->chunk_len)) {
+				return 2;
+			}
+			p->chunk_len = 0;
+			p->state = HTTP_CHUNK_CRLF;
+			return 1;
+
+		case HTTP_CHUNK_CRLF:
+			len = _line(p, p->start, &next);
+			if (len < 0) {
+				return 0;
+			}
+
+			p->start = next;
+			p->state = HTTP_CHUNK_SIZE;
+			break;
+
+		case HTTP_TRAILERS:
+			len = _line(p, p->start, &next);
+			if (len < 0) {
+				return 0;
+			}
+
+			p->start = next;
+			if (len == 0) {
+				p->state = HTTP_DONE;
+			}
+			break;
+		}
+	}
+}
+
+
+/*
+ * Receives body data directly into the jive.buffer, used when the receive
+ * buffer is empty. Returns the number of values pushed, or 0 if no data
+ * is available.
+ */
+static int _recv_body(lua_State *L, struct http_parser *p, socket_t fd, JiveBuffer *b, int bidx) {
+	size_t want;
+	char *dst;
+	int n, err;
+
+	want = (p->state == HTTP_BODY_LENGTH) ? MIN(p->remaining, HTTP_DIRECT_SIZE) : HTTP_BUFFER_SIZE;
+
+	dst = jive_buffer_reserve(b, want);
+	if (!dst) {
+		lua_pushnil(L);
+		lua_pushliteral(L, "out of memory");
+		return 2;
+	}
+
+	do {
+		n = recv(fd, dst, want, 0);
+		err = (n < 0) ? SOCKET_ERRNO : 0;
+	} while (n < 0 && SOCKET_EINTR(err));
+
+	if (n > 0) {
+		jive_buffer_commit(b, n);
+		lua_pushvalue(L, bidx);
+
+		if (p->state == HTTP_BODY_LENGTH) {
+			p->remaining -= n;
+			if (p->remaining == 0) {
+				p->state = HTTP_DONE;
+				lua_pushliteral(L, "done");
+				return 2;
+			}
+		}
+		return 1;
+	}
+
+	if (n == 0) {
+		p->closed = true;
+		if (p->state == HTTP_BODY_CLOSE) {
+			p->state = HTTP_DONE;
+			lua_pushnil(L);
+			lua_pushliteral(L, "done");
+			return 2;
+		}
+		return _fill_error(L, FILL_CLOSED, 0) ? 2 : 0;
+	}
+
+	if (SOCKET_EAGAIN(err)) {
+		return 0;
+	}
+
+	_fill_error(L, FILL_ERROR, err);
+	return 2;
+}
+
+
+static struct http_parser *_check_parser(lua_State *L) {
+	return luaL_checkudata(L, 1, "jive.http.parser");
+}
+
+
+static void _reset(struct http_parser *p) {
+	p->state = HTTP_HEADERS;
+	p->scan = p->start;
+	p->remaining = 0;
+	p->status = 0;
+	p->keepalive = true;
+	p->chunked = false;
+	p->chunk_len = 0;
+}
+
+
+static int jiveL_http_parser(lua_State *L) {
+	struct http_parser *p;
+
+	p = lua_newuserdata(L, sizeof(struct http_parser));
+	memset(p, 0, offsetof(struct http_parser, buf));
+	_reset(p);
+
+	luaL_getmetatable(L, "jive.http.parser");
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
+
+static int jiveL_http_parser_gc(lua_State *L) {
+	struct http_parser *p = lua_touserdata(L, 1);
+
+	free(p->chunk);
+	p->chunk = NULL;
+
+	return 0;
+}
+
+
+/*
+ * parser:reset()
+ *
+ * Starts the next response on the connection, keeping buffered data.
+ */
+static int jiveL_http_parser_reset(lua_State *L) {
+	_reset(_check_parser(L));
+	return 0;
+}
+
+
+/*
+ * parser:clear()
+ *
+ * Starts a new connection, discarding buffered data.
+ */
+static int jiveL_http_parser_clear(lua_State *L) {
+	struct http_parser *p = _check_parser(L);
+
+	p->start = p->end = 0;
+	p->closed = false;
+	_reset(p);
+
+	return 0;
+}
+
+
+/*
+ * status, statusLine, headers = parser:headers(sock)
+ *
+ * Returns nil, "timeout" until the complete header block has been read.
+ */
+static int jiveL_http_parser_headers(lua_State *L) {
+	struct http_parser *p = _check_parser(L);
+	enum http_fill r;
+	int fd, err, n;
+
+	if (p->state != HTTP_HEADERS) {
+		lua_pushnil(L);
+		lua_pushliteral(L, "headers already read");
+		return 2;
+	}
+
+	n = _parse_headers(L, p);
+	if (n) {
+		return n;
+	}
+
+	fd = _getfd(L, 2);
+	if (fd < 0) {
+		lua_pushnil(L);
+		lua_pushliteral(L, "closed");
+		return 2;
+	}
+
+	r = _fill(p, fd, &err);
+	if (_fill_error(L, r, err)) {
+		return 2;
+	}
+
+	if (r == FILL_DATA) {
+		n = _parse_headers(L, p);
+		if (n) {
+			return n;
+		}
+	}
+
+	lua_pushnil(L);
+	lua_pushliteral(L, "timeout");
+	return 2;
+}
+
+
+/*
+ * chunk, err = parser:body(sock [, buffer])
+ *
+ * Source for the response body. Returns nil, "timeout" when more data is
+ * needed, and "done" as the error with or after the last data. With a
+ * jive.buffer the data is appended to it and the buffer is returned as
+ * the chunk.
+ */
+static int jiveL_http_parser_body(lua_State *L) {
+	struct http_parser *p = _check_parser(L);
+	JiveBuffer *b = NULL;
+	enum http_fill r;
+	int fd, err = 0, n;
+
+	if (!lua_isnoneornil(L, 3)) {
+		b = luaL_checkudata(L, 3, "jive.buffer");
+	}
+
+	n = _parse_body(L, p, b, 3);
+	if (n) {
+		return n;
+	}
+
+	fd = _getfd(L, 2);
+
+	if (b && fd >= 0 && p->start == p->end
+	    && (p->state == HTTP_BODY_LENGTH || p->state == HTTP_BODY_CLOSE)) {
+		n = _recv_body(L, p, fd, b, 3);
+		if (n) {
+			return n;
+		}
+
+		lua_pushnil(L);
+		lua_pushliteral(L, "timeout");
+		return 2;
+	}
+
+	r = (fd < 0) ? FILL_CLOSED : _fill(p, fd, &err);
+
+	if (r == FILL_CLOSED && p->state == HTTP_BODY_CLOSE) {
+		p->state = HTTP_DONE;
+		lua_pushnil(L);
+		lua_pushliteral(L, "done");
+		return 2;
+	}
+
+	if (_fill_error(L, r, err)) {
+		return 2;
+	}
+
+	if (r == FILL_DATA) {
+		n = _parse_body(L, p, b, 3);
+		if (n) {
+			return n;
+		}
+	}
+
+	lua_pushnil(L);
+	lua_pushliteral(L, "timeout");
+	return 2;
+}
+
+
+static int jiveL_http_parser_pending(lua_State *L) {
+	struct http_parser *p = _check_parser(L);
+
+	lua_pushboolean(L, p->end > p->start);
+	return 1;
+}
+
+
+static int jiveL_http_parser_keepalive(lua_State *L) {
+	struct http_parser *p = _check_parser(L);
+
+	lua_pushboolean(L, p->keepalive && !p->closed);
+	return 1;
+}
+
+
+static int jiveL_http_parser_chunked(lua_State *L) {
+	struct http_parser *p = _check_parser(L);
+
+	lua_pushboolean(L, p->chunked);
+	return 1;
+}
+
+
+static const struct luaL_Reg http_parser_m[] = {
+	{ "__gc", jiveL_http_parser_gc },
+	{ "reset", jiveL_http_parser_reset },
+	{ "clear", jiveL_http_parser_clear },
+	{ "headers", jiveL_http_parser_headers },
+	{ "body", jiveL_http_parser_body },
+	{ "pending", jiveL_http_parser_pending },
+	{ "keepalive", jiveL_http_parser_keepalive },
+	{ "chunked", jiveL_http_parser_chunked },
+	{ NULL, NULL }
+};
+
+
+static const struct luaL_Reg http_lib[] = {
+	{ "parser", jiveL_http_parser },
+	{ NULL, NULL }
+};
+
+
+int luaopen_jive_net_http(lua_State *L) {
+	luaL_newmetatable(L, "jive.http.parser");
+
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+
+	luaL_register(L, NULL, http_parser_m);
+
+	luaL_register(L, "jive.http", http_lib);
+
+	return 0;
+}
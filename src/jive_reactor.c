@@ -0,0 +1,876 @@
+/*
+** Copyright 2010 Logitech. All Rights Reserved.
+**
+** This file is licensed under BSD. Please see the LICENSE file for details.
+*/
+
+#include "common.h"
+#include "jive.h"
+
+#if defined(linux)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#define HAVE_EPOLL 1
+#else
+#include <poll.h>
+#endif
+
+/*
+Network reactor used by jive.net.NetworkThread in place of socket.select().
+
+Sockets stay registered between waits, so a wait only costs the number of
+ready sockets rather than the number of registered sockets, and there is no
+FD_SETSIZE limit. On linux this uses epoll, elsewhere poll() with a pollfd
+array rebuilt on each wait.
+
+Each socket can be registered for read and write, each with an inactivity
+timeout in ms. The timeouts are kept in a binary heap ordered by deadline,
+so expiry is checked without scanning the sockets. A socket that times out
+is reported once and rearmed for another timeout period.
+
+The reactor also owns a wakeup fd, jive_reactor_wakeup() can be called from
+any thread to interrupt a wait, for example when input events arrive.
+
+Sockets are any lua object with a getfd() method, like luasocket's select.
+As in luasocket's select, a socket with a dirty() method returning true has
+buffered data and is reported readable without waiting. Only sockets that
+were added or became readable since the last wait are checked for this.
+*/
+
+
+#define REACTOR_READ  0
+#define REACTOR_WRITE 1
+
+#define MAX_EVENTS 64
+
+/* heap entries are encoded as (fd << 1) | mode */
+#define ENTRY(fd, mode) (((fd) << 1) | (mode))
+#define ENTRY_FD(e)     ((e) >> 1)
+#define ENTRY_MODE(e)   ((e) & 1)
+
+
+struct reactor_watch {
+	bool active;
+	Uint32 timeout;
+	Uint32 last_seen;
+	int heap_index;
+};
+
+struct reactor_fd {
+	struct reactor_watch watch[2];
+	Uint32 reported;
+};
+
+struct reactor_userdata {
+	int pollfd;
+	int wakeup_fd[2];
+
+	/* registrations, indexed by fd */
+	struct reactor_fd *fds;
+	int fds_size;
+
+	/* timeout heap */
+	int *heap;
+	int heap_len, heap_size;
+
+	/* read registrations to check for buffered data */
+	int *dirty;
+	int dirty_len, dirty_size;
+
+	/* wait counter, avoids reporting a socket twice in one wait */
+	Uint32 serial;
+
+#ifndef HAVE_EPOLL
+	struct pollfd *pfds;
+	int pfds_size;
+#endif
+};
+
+
+static int reactor_wakeup_fd = -1;
+static volatile bool reactor_waiting = false;
+
+static LOG_CATEGORY *log_net;
+
+
+static inline struct reactor_watch *_watch(struct reactor_userdata *u, int e) {
+	return &u->fds[ENTRY_FD(e)].watch[ENTRY_MODE(e)];
+}
+
+
+static inline Uint32 _deadline(struct reactor_userdata *u, int e) {
+	struct reactor_watch *w = _watch(u, e);
+	return w->last_seen + w->timeout;
+}
+
+
+static inline bool _before(struct reactor_userdata *u, int a, int b) {
+	return (Sint32)(_deadline(u, a) - _deadline(u, b)) < 0;
+}
+
+
+static inline void _heap_set(struct reactor_userdata *u, int i, int e) {
+	u->heap[i] = e;
+	_watch(u, e)->heap_index = i;
+}
+
+
+static void _heap_up(struct reactor_userdata *u, int i) {
+	int e = u->heap[i];
+
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+
+		if (!_before(u, e, u->heap[parent])) {
+			break;
+		}
+		_heap_set(u, i, u->heap[parent]);
+		i = parent;
+	}
+	_heap_set(u, i, e);
+}
+
+
+static void _heap_down(struct reactor_userdata *u, int i) {
+	int e = u->heap[i];
+
+	for (;;) {
+		int child = 2 * i + 1;
+
+		if (child >= u->heap_len) {
+			break;
+		}
+		if (child + 1 < u->heap_len && _before(u, u->heap[child + 1], u->heap[child])) {
+			child++;
+		}
+		if (!_before(u, u->heap[child], e)) {
+			break;
+		}
+		_heap_set(u, i, u->heap[child]);
+		i = child;
+	}
+	_heap_set(u, i, e);
+}
+
+
+static bool _heap_insert(struct reactor_userdata *u, int e) {
+	if (u->heap_len == u->heap_size) {
+		int size = u->heap_size ? u->heap_size * 2 : 32;
+		int *heap = realloc(u->heap, size * sizeof(int));
+
+		if (!heap) {
+			return false;
+		}
+		u->heap = heap;
+		u->heap_size = size;
+	}
+
+	_heap_set(u, u->heap_len++, e);
+	_heap_up(u, u->heap_len - 1);
+	return true;
+}
+
+
+static void _heap_remove(struct reactor_userdata *u, int e) {
+	struct reactor_watch *w = _watch(u, e);
+	int i = w->heap_index;
+
+	if (i < 0) {
+		return;
+	}
+	w->heap_index = -1;
+
+	if (--u->heap_len > i) {
+		_heap_set(u, i, u->heap[u->heap_len]);
+		_heap_up(u, i);
+		_heap_down(u, _watch(u, u->heap[i])->heap_index);
+	}
+}
+
+
+static void _heap_fix(struct reactor_userdata *u, int e) {
+	int i = _watch(u, e)->heap_index;
+
+	if (i >= 0) {
+		_heap_up(u, i);
+		_heap_down(u, _watch(u, e)->heap_index);
+	}
+}
+
+
+static void _dirty_add(struct reactor_userdata *u, int fd) {
+	if (u->dirty_len == u->dirty_size) {
+		int size = u->dirty_size ? u->dirty_size * 2 : 32;
+		int *dirty = realloc(u->dirty, size * sizeof(int));
+
+		if (!dirty) {
+			return;
+		}
+		u->dirty = dirty;
+		u->dirty_size = size;
+	}
+
+	u->dirty[u->dirty_len++] = fd;
+}
+
+
+static struct reactor_fd *_fd_entry(struct reactor_userdata *u, int fd) {
+	if (fd >= u->fds_size) {
+		int i, size = u->fds_size ? u->fds_size : 64;
+		struct reactor_fd *fds;
+
+		while (size <= fd) {
+			size *= 2;
+		}
+
+		fds = realloc(u->fds, size * sizeof(struct reactor_fd));
+		if (!fds) {
+			return NULL;
+		}
+
+		memset(fds + u->fds_size, 0, (size - u->fds_size) * sizeof(struct reactor_fd));
+		for (i = u->fds_size; i < size; i++) {
+			fds[i].watch[REACTOR_READ].heap_index = -1;
+			fds[i].watch[REACTOR_WRITE].heap_index = -1;
+		}
+
+		u->fds = fds;
+		u->fds_size = size;
+	}
+
+	return &u->fds[fd];
+}
+
+
+static void _update_poll(struct reactor_userdata *u, int fd, bool registered) {
+#ifdef HAVE_EPOLL
+	struct reactor_fd *f = &u->fds[fd];
+	struct epoll_event ev;
+	int r;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.data.fd = fd;
+	if (f->watch[REACTOR_READ].active) {
+		ev.events |= EPOLLIN;
+	}
+	if (f->watch[REACTOR_WRITE].active) {
+		ev.events |= EPOLLOUT;
+	}
+
+	if (!ev.events) {
+		/* the fd may already have been closed, removing it from the set */
+		epoll_ctl(u->pollfd, EPOLL_CTL_DEL, fd, &ev);
+		return;
+	}
+
+	if (registered) {
+		r = epoll_ctl(u->pollfd, EPOLL_CTL_MOD, fd, &ev);
+		if (r < 0 && errno == ENOENT) {
+			r = epoll_ctl(u->pollfd, EPOLL_CTL_ADD, fd, &ev);
+		}
+	}
+	else {
+		r = epoll_ctl(u->pollfd, EPOLL_CTL_ADD, fd, &ev);
+		if (r < 0 && errno == EEXIST) {
+			r = epoll_ctl(u->pollfd, EPOLL_CTL_MOD, fd, &ev);
+		}
+	}
+
+	if (r < 0) {
+		LOG_ERROR(log_net, "epoll_ctl fd=%d: %s", fd, strerror(errno));
+	}
+#endif
+}
+
+
+/* deactivate a watch, returns true if the fd has no more watches */
+static bool _unwatch(struct reactor_userdata *u, int fd, int mode) {
+	struct reactor_fd *f = &u->fds[fd];
+	struct reactor_watch *w = &f->watch[mode];
+
+	if (w->active) {
+		_heap_remove(u, ENTRY(fd, mode));
+		w->active = false;
+		_update_poll(u, fd, true);
+	}
+
+	return !f->watch[REACTOR_READ].active && !f->watch[REACTOR_WRITE].active;
+}
+
+
+/* forget the socket registered on fd in the environment table at env */
+static void _forget(lua_State *L, int env, int fd) {
+	lua_rawgeti(L, env, fd);
+	if (!lua_isnil(L, -1)) {
+		lua_pushnil(L);
+		lua_rawset(L, env);
+	}
+	else {
+		lua_pop(L, 1);
+	}
+
+	lua_pushnil(L);
+	lua_rawseti(L, env, fd);
+}
+
+
+static int _getfd(lua_State *L, int idx) {
+	int fd = -1;
+
+	lua_getfield(L, idx, "getfd");
+	if (lua_isfunction(L, -1)) {
+		lua_pushvalue(L, idx);
+		lua_call(L, 1, 1);
+		if (lua_isnumber(L, -1)) {
+			fd = lua_tointeger(L, -1);
+		}
+	}
+	lua_pop(L, 1);
+
+	return fd;
+}
+
+
+static bool _isdirty(lua_State *L, int idx) {
+	bool dirty = false;
+
+	lua_getfield(L, idx, "dirty");
+	if (lua_isfunction(L, -1)) {
+		lua_pushvalue(L, idx);
+		lua_call(L, 1, 1);
+		dirty = lua_toboolean(L, -1);
+	}
+	lua_pop(L, 1);
+
+	return dirty;
+}
+
+
+static int _wait(struct reactor_userdata *u, int timeout, int *ready, int *events) {
+	int i, n;
+
+	reactor_waiting = true;
+
+#ifdef HAVE_EPOLL
+	{
+		struct epoll_event ev[MAX_EVENTS];
+
+		n = epoll_wait(u->pollfd, ev, MAX_EVENTS, timeout);
+		for (i = 0; i < n; i++) {
+			ready[i] = ev[i].data.fd;
+			events[i] = 0;
+			if (ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+				events[i] |= 1 << REACTOR_READ;
+			}
+			if (ev[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+				events[i] |= 1 << REACTOR_WRITE;
+			}
+		}
+	}
+#else
+	{
+		int fd, nfds = 0;
+
+		if (u->pfds_size < u->fds_size + 1) {
+			struct pollfd *pfds = realloc(u->pfds, (u->fds_size + 1) * sizeof(struct pollfd));
+			if (!pfds) {
+				reactor_waiting = false;
+				errno = ENOMEM;
+				return -1;
+			}
+			u->pfds = pfds;
+			u->pfds_size = u->fds_size + 1;
+		}
+
+		u->pfds[nfds].fd = u->wakeup_fd[0];
+		u->pfds[nfds++].events = POLLIN;
+
+		for (fd = 0; fd < u->fds_size; fd++) {
+			struct reactor_fd *f = &u->fds[fd];
+			short mask = 0;
+
+			if (f->watch[REACTOR_READ].active) {
+				mask |= POLLIN;
+			}
+			if (f->watch[REACTOR_WRITE].active) {
+				mask |= POLLOUT;
+			}
+			if (mask) {
+				u->pfds[nfds].fd = fd;
+				u->pfds[nfds++].events = mask;
+			}
+		}
+
+		n = poll(u->pfds, nfds, timeout);
+		if (n > 0) {
+			int j = 0;
+
+			for (i = 0; i < nfds && j < MAX_EVENTS; i++) {
+				short r = u->pfds[i].revents;
+
+				if (!r) {
+					continue;
+				}
+				ready[j] = u->pfds[i].fd;
+				events[j] = 0;
+				if (r & (POLLIN | POLLHUP | POLLERR)) {
+					events[j] |= 1 << REACTOR_READ;
+				}
+				if (r & (POLLOUT | POLLHUP | POLLERR)) {
+					events[j] |= 1 << REACTOR_WRITE;
+				}
+				j++;
+			}
+			n = j;
+		}
+	}
+#endif
+
+	reactor_waiting = false;
+
+	return n;
+}
+
+
+/* append the socket registered on fd to the result table at tab */
+static void _report(lua_State *L, int env, int tab, int *len, int fd) {
+	lua_rawgeti(L, env, fd);
+	lua_rawseti(L, tab, ++(*len));
+}
+
+
+static void _clear(lua_State *L, int tab) {
+	int i, len = lua_objlen(L, tab);
+
+	for (i = 1; i <= len; i++) {
+		lua_pushnil(L);
+		lua_rawseti(L, tab, i);
+	}
+}
+
+
+void jive_reactor_wakeup(void) {
+	if (reactor_waiting && reactor_wakeup_fd >= 0) {
+#ifdef HAVE_EPOLL
+		uint64_t one = 1;
+		if (write(reactor_wakeup_fd, &one, sizeof(one)) < 0) {
+			/* already signalled */
+		}
+#else
+		char c = 0;
+		if (write(reactor_wakeup_fd, &c, sizeof(c)) < 0) {
+			/* pipe full, already signalled */
+		}
+#endif
+	}
+}
+
+
+static int jiveL_reactor_open(lua_State *L) {
+	struct reactor_userdata *u;
+
+	u = lua_newuserdata(L, sizeof(struct reactor_userdata));
+	memset(u, 0, sizeof(struct reactor_userdata));
+	u->pollfd = -1;
+	u->wakeup_fd[0] = u->wakeup_fd[1] = -1;
+
+	luaL_getmetatable(L, "jive.reactor");
+	lua_setmetatable(L, -2);
+
+#ifdef HAVE_EPOLL
+	{
+		struct epoll_event ev;
+
+		u->pollfd = epoll_create(MAX_EVENTS);
+		if (u->pollfd < 0) {
+			return luaL_error(L, "epoll_create failed: %s", strerror(errno));
+		}
+
+		u->wakeup_fd[0] = u->wakeup_fd[1] = eventfd(0, 0);
+		if (u->wakeup_fd[0] < 0) {
+			return luaL_error(L, "eventfd failed: %s", strerror(errno));
+		}
+
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = u->wakeup_fd[0];
+		epoll_ctl(u->pollfd, EPOLL_CTL_ADD, u->wakeup_fd[0], &ev);
+	}
+#else
+	if (pipe(u->wakeup_fd) < 0) {
+		return luaL_error(L, "pipe failed: %s", strerror(errno));
+	}
+	fcntl(u->wakeup_fd[1], F_SETFL, fcntl(u->wakeup_fd[1], F_GETFL) | O_NONBLOCK);
+#endif
+	fcntl(u->wakeup_fd[0], F_SETFL, fcntl(u->wakeup_fd[0], F_GETFL) | O_NONBLOCK);
+
+	reactor_wakeup_fd = u->wakeup_fd[1];
+
+	/* environment: fd -> socket, socket -> fd and the result tables */
+	lua_newtable(L);
+	lua_newtable(L);
+	lua_setfield(L, -2, "r");
+	lua_newtable(L);
+	lua_setfield(L, -2, "w");
+	lua_newtable(L);
+	lua_setfield(L, -2, "rt");
+	lua_newtable(L);
+	lua_setfield(L, -2, "wt");
+	lua_setfenv(L, -2);
+
+	return 1;
+}
+
+
+static int jiveL_reactor_gc(lua_State *L) {
+	struct reactor_userdata *u;
+
+	u = lua_touserdata(L, 1);
+
+	if (reactor_wakeup_fd == u->wakeup_fd[1]) {
+		reactor_wakeup_fd = -1;
+	}
+
+	if (u->wakeup_fd[1] >= 0 && u->wakeup_fd[1] != u->wakeup_fd[0]) {
+		close(u->wakeup_fd[1]);
+	}
+	if (u->wakeup_fd[0] >= 0) {
+		close(u->wakeup_fd[0]);
+	}
+	if (u->pollfd >= 0) {
+		close(u->pollfd);
+	}
+
+	free(u->fds);
+	free(u->heap);
+	free(u->dirty);
+#ifndef HAVE_EPOLL
+	free(u->pfds);
+#endif
+
+	return 0;
+}
+
+
+/*
+ * reactor:add(sock, mode, timeout)
+ *
+ * Registers sock for "r" or "w". The timeout is in ms, 0 for no timeout.
+ * Adding an existing registration updates its timeout.
+ */
+static int jiveL_reactor_add(lua_State *L) {
+	struct reactor_userdata *u;
+	struct reactor_fd *f;
+	struct reactor_watch *w;
+	const char *mode_str;
+	int env, fd, mode;
+	bool registered;
+
+	u = lua_touserdata(L, 1);
+	mode_str = luaL_checkstring(L, 3);
+	mode = (mode_str[0] == 'w') ? REACTOR_WRITE : REACTOR_READ;
+
+	fd = _getfd(L, 2);
+	if (fd < 0) {
+		return 0;
+	}
+
+	f = _fd_entry(u, fd);
+	if (!f) {
+		return luaL_error(L, "out of memory");
+	}
+
+	lua_getfenv(L, 1);
+	env = lua_gettop(L);
+
+	/* the fd may have been reused after closing a registered socket */
+	lua_rawgeti(L, env, fd);
+	if (!lua_isnil(L, -1) && !lua_rawequal(L, -1, 2)) {
+		lua_pop(L, 1);
+
+		_unwatch(u, fd, REACTOR_READ);
+		_unwatch(u, fd, REACTOR_WRITE);
+		_forget(L, env, fd);
+	}
+	else {
+		lua_pop(L, 1);
+	}
+
+	lua_pushvalue(L, 2);
+	lua_rawseti(L, env, fd);
+	lua_pushvalue(L, 2);
+	lua_pushinteger(L, fd);
+	lua_rawset(L, env);
+
+	registered = f->watch[REACTOR_READ].active || f->watch[REACTOR_WRITE].active;
+
+	w = &f->watch[mode];
+	if (!w->active) {
+		w->active = true;
+		w->last_seen = jive_jiffies();
+
+		if (mode == REACTOR_READ) {
+			_dirty_add(u, fd);
+		}
+	}
+
+	w->timeout = luaL_optinteger(L, 4, 0);
+	if (w->timeout > 0) {
+		if (w->heap_index < 0) {
+			_heap_insert(u, ENTRY(fd, mode));
+		}
+		else {
+			_heap_fix(u, ENTRY(fd, mode));
+		}
+	}
+	else {
+		_heap_remove(u, ENTRY(fd, mode));
+	}
+
+	_update_poll(u, fd, registered);
+
+	return 0;
+}
+
+
+/*
+ * reactor:remove(sock, mode)
+ */
+static int jiveL_reactor_remove(lua_State *L) {
+	struct reactor_userdata *u;
+	const char *mode_str;
+	int env, fd, mode;
+
+	u = lua_touserdata(L, 1);
+	mode_str = luaL_checkstring(L, 3);
+	mode = (mode_str[0] == 'w') ? REACTOR_WRITE : REACTOR_READ;
+
+	/* use the registered fd, the socket may already be closed */
+	lua_getfenv(L, 1);
+	env = lua_gettop(L);
+
+	lua_pushvalue(L, 2);
+	lua_rawget(L, env);
+	if (lua_isnil(L, -1)) {
+		return 0;
+	}
+	fd = lua_tointeger(L, -1);
+	lua_pop(L, 1);
+
+	if (_unwatch(u, fd, mode)) {
+		_forget(L, env, fd);
+	}
+
+	return 0;
+}
+
+
+/*
+ * r, w, rt, wt = reactor:wait(timeout)
+ *
+ * Waits up to timeout seconds, or forever if negative, for registered
+ * sockets to become ready. Returns arrays of the readable and writable
+ * sockets and of sockets whose read or write registration timed out. The
+ * arrays are reused by the next wait. On error returns nil and a message.
+ */
+static int jiveL_reactor_wait(lua_State *L) {
+	struct reactor_userdata *u;
+	int ready[MAX_EVENTS], events[MAX_EVENTS];
+	int env, r, w, rt, wt;
+	int nr = 0, nw = 0, nrt = 0, nwt = 0;
+	int i, n, dirty_len, timeout;
+	double secs;
+	Uint32 now;
+
+	u = lua_touserdata(L, 1);
+	secs = luaL_optnumber(L, 2, -1);
+
+	lua_getfenv(L, 1);
+	env = lua_gettop(L);
+	lua_getfield(L, env, "r");
+	r = lua_gettop(L);
+	lua_getfield(L, env, "w");
+	w = lua_gettop(L);
+	lua_getfield(L, env, "rt");
+	rt = lua_gettop(L);
+	lua_getfield(L, env, "wt");
+	wt = lua_gettop(L);
+
+	_clear(L, r);
+	_clear(L, w);
+	_clear(L, rt);
+	_clear(L, wt);
+
+	u->serial++;
+	now = jive_jiffies();
+
+	/* sockets with buffered data are ready now */
+	dirty_len = u->dirty_len;
+	u->dirty_len = 0;
+
+	for (i = 0; i < dirty_len; i++) {
+		int fd = u->dirty[i];
+		struct reactor_fd *f = &u->fds[fd];
+
+		if (!f->watch[REACTOR_READ].active || f->reported == u->serial) {
+			continue;
+		}
+
+		lua_rawgeti(L, env, fd);
+		if (_isdirty(L, lua_gettop(L))) {
+			lua_rawseti(L, r, ++nr);
+
+			f->reported = u->serial;
+			f->watch[REACTOR_READ].last_seen = now;
+			_heap_fix(u, ENTRY(fd, REACTOR_READ));
+			_dirty_add(u, fd);
+		}
+		else {
+			lua_pop(L, 1);
+		}
+	}
+
+	if (nr) {
+		timeout = 0;
+	}
+	else if (secs < 0) {
+		timeout = -1;
+	}
+	else {
+		timeout = (int)(secs * 1000);
+	}
+
+	if (u->heap_len) {
+		Sint32 d = (Sint32)(_deadline(u, u->heap[0]) - now);
+
+		if (d < 0) {
+			d = 0;
+		}
+		if (timeout < 0 || d < timeout) {
+			timeout = d;
+		}
+	}
+
+	n = _wait(u, timeout, ready, events);
+	if (n < 0 && errno != EINTR) {
+		lua_pushnil(L);
+		lua_pushstring(L, strerror(errno));
+		return 2;
+	}
+
+	now = jive_jiffies();
+
+	for (i = 0; i < n; i++) {
+		int fd = ready[i];
+		struct reactor_fd *f;
+
+		if (fd == u->wakeup_fd[0]) {
+			char buf[16];
+			while (read(fd, buf, sizeof(buf)) > 0) {
+				/* drain */
+			}
+			continue;
+		}
+
+		if (fd >= u->fds_size) {
+			continue;
+		}
+		f = &u->fds[fd];
+
+		if ((events[i] & (1 << REACTOR_READ)) && f->watch[REACTOR_READ].active && f->reported != u->serial) {
+			_report(L, env, r, &nr, fd);
+
+			f->watch[REACTOR_READ].last_seen = now;
+			_heap_fix(u, ENTRY(fd, REACTOR_READ));
+			_dirty_add(u, fd);
+		}
+
+		if ((events[i] & (1 << REACTOR_WRITE)) && f->watch[REACTOR_WRITE].active) {
+			_report(L, env, w, &nw, fd);
+
+			f->watch[REACTOR_WRITE].last_seen = now;
+			_heap_fix(u, ENTRY(fd, REACTOR_WRITE));
+		}
+	}
+
+	/* expired timeouts, rearmed for another period */
+	while (u->heap_len && (Sint32)(_deadline(u, u->heap[0]) - now) <= 0) {
+		int e = u->heap[0];
+
+		if (ENTRY_MODE(e) == REACTOR_READ) {
+			_report(L, env, rt, &nrt, ENTRY_FD(e));
+		}
+		else {
+			_report(L, env, wt, &nwt, ENTRY_FD(e));
+		}
+
+		_watch(u, e)->last_seen = now;
+		_heap_down(u, 0);
+	}
+
+	lua_pushvalue(L, r);
+	lua_pushvalue(L, w);
+	lua_pushvalue(L, rt);
+	lua_pushvalue(L, wt);
+	return 4;
+}
+
+
+static int jiveL_reactor_wakeup(lua_State *L) {
+	struct reactor_userdata *u;
+
+	u = lua_touserdata(L, 1);
+
+#ifdef HAVE_EPOLL
+	{
+		uint64_t one = 1;
+		if (write(u->wakeup_fd[1], &one, sizeof(one)) < 0) {
+			/* already signalled */
+		}
+	}
+#else
+	{
+		char c = 0;
+		if (write(u->wakeup_fd[1], &c, sizeof(c)) < 0) {
+			/* pipe full, already signalled */
+		}
+	}
+#endif
+
+	return 0;
+}
+
+
+static const struct luaL_Reg reactor_lib[] = {
+	{ "open", jiveL_reactor_open },
+	{ NULL, NULL }
+};
+
+
+int luaopen_jive_net_reactor(lua_State *L) {
+	log_net = LOG_CATEGORY_GET("net.thread");
+
+	luaL_newmetatable(L, "jive.reactor");
+
+	lua_pushcfunction(L, jiveL_reactor_gc);
+	lua_setfield(L, -2, "__gc");
+
+	lua_pushcfunction(L, jiveL_reactor_add);
+	lua_setfield(L, -2, "add");
+
+	lua_pushcfunction(L, jiveL_reactor_remove);
+	lua_setfield(L, -2, "remove");
+
+	lua_pushcfunction(L, jiveL_reactor_wait);
+	lua_setfield(L, -2, "wait");
+
+	lua_pushcfunction(L, jiveL_reactor_wakeup);
+	lua_setfield(L, -2, "wakeup");
+
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+
+	luaL_register(L, "jive.reactor", reactor_lib);
+
+	return 0;
+}
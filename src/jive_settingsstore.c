@@ -0,0 +1,968 @@
+/*
+** Copyright 2010 Logitech. All Rights Reserved.
+**
+** This file is licensed under BSD. Please see the LICENSE file for details.
+*/
+
+#include "common.h"
+#include "jive.h"
+
+#include <sys/stat.h>
+
+/*
+Log structured store for applet settings.
+
+All applets share one file. Storing an applet's settings appends a record
+for each top level setting that changed since it was last stored, so a
+new volume or browse position writes a few bytes instead of rewriting the
+applet's settings file. Values are kept in a compact binary encoding.
+
+Storing an applet also writes an applet record, once, so an applet whose
+settings are an empty table is still found after a restart. The pairs of
+table values are encoded sorted by key, so equal settings always encode
+the same and are not written again.
+
+Each record carries its length and a crc of its contents. When the store
+is opened the records are replayed in order, and a torn record at the end
+of the file, left by a crash while appending, is dropped. Once most of
+the file is superseded records it is compacted by replacing it with the
+current records.
+
+The appends and compactions are queued for the writer thread, see
+system_write_file, which coalesces them and does the fsync.
+
+The file is STORE_MAGIC followed by records of:
+	u32 length, u32 crc of the next length bytes,
+	u8 op, u8 applet name length, applet name,
+	encoded key, encoded value (for OP_SET only)
+OP_APPLET records, and OP_DELETE records removing them, have no key.
+Values are encoded as a type byte, then for T_NUMBER an 8 byte double,
+for T_STRING a u32 length and the bytes, and for T_TABLE encoded key and
+value pairs, sorted by encoded key, up to T_END. All numbers are little
+endian.
+
+The current records are kept as strings in the userdata environment,
+by applet name and then encoded key, the applet record under "".
+*/
+
+
+#define STORE_MAGIC "JIVEST01"
+#define STORE_MAGIC_LEN 8
+#define STORE_RECORD_HEADER 8
+
+/* compact once superseded records are most of a file at least this big */
+#define STORE_COMPACT_MIN (32 * 1024)
+
+#define STORE_MAX_DEPTH 32
+
+enum {
+	OP_SET = 1,
+	OP_DELETE = 2,
+	OP_APPLET = 3,
+};
+
+enum {
+	T_FALSE = 0,
+	T_TRUE,
+	T_NUMBER,
+	T_STRING,
+	T_TABLE,
+	T_END,
+};
+
+
+struct settingsstore {
+	char *path;
+	size_t size;	/* bytes in the file, once queued writes are done */
+	size_t live;	/* bytes of current records */
+};
+
+struct bytes {
+	char *data;
+	size_t len, cap;
+};
+
+struct pair {
+	const char *data;
+	size_t len;
+};
+
+
+static LOG_CATEGORY *log_settings;
+
+static Uint32 crc_table[256];
+
+
+static void _crc_init(void) {
+	Uint32 i, j, c;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++) {
+			c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		}
+		crc_table[i] = c;
+	}
+}
+
+
+static Uint32 _crc(const unsigned char *p, size_t len) {
+	Uint32 c = 0xFFFFFFFF;
+
+	while (len--) {
+		c = crc_table[(c ^ *p++) & 0xFF] ^ (c >> 8);
+	}
+
+	return c ^ 0xFFFFFFFF;
+}
+
+
+static Uint32 _get_u32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32) p[3] << 24);
+}
+
+
+static void _set_u32(char *p, Uint32 v) {
+	p[0] = v & 0xFF;
+	p[1] = (v >> 8) & 0xFF;
+	p[2] = (v >> 16) & 0xFF;
+	p[3] = (v >> 24) & 0xFF;
+}
+
+
+static void _put(lua_State *L, struct bytes *b, const void *data, size_t len) {
+	if (b->len + len > b->cap) {
+		size_t cap = MAX(b->cap * 2, 256);
+		char *tmp;
+
+		while (cap < b->len + len) {
+			cap *= 2;
+		}
+
+		tmp = realloc(b->data, cap);
+		if (!tmp) {
+			free(b->data);
+			b->data = NULL;
+			luaL_error(L, "out of memory");
+		}
+
+		b->data = tmp;
+		b->cap = cap;
+	}
+
+	memcpy(b->data + b->len, data, len);
+	b->len += len;
+}
+
+
+static void _put_byte(lua_State *L, struct bytes *b, Uint8 v) {
+	_put(L, b, &v, 1);
+}
+
+
+static void _put_u32(lua_State *L, struct bytes *b, Uint32 v) {
+	char tmp[4];
+
+	_set_u32(tmp, v);
+	_put(L, b, tmp, 4);
+}
+
+
+/*
+ * Orders encoded key and value pairs by key. Encoded keys are never a
+ * prefix of another, so comparing the whole pairs does this.
+ */
+static int _pair_cmp(const void *a, const void *b) {
+	const struct pair *pa = a, *pb = b;
+	int r;
+
+	r = memcmp(pa->data, pb->data, MIN(pa->len, pb->len));
+	if (r == 0) {
+		r = (pa->len > pb->len) - (pa->len < pb->len);
+	}
+
+	return r;
+}
+
+
+/*
+ * Encodes the value at idx, an absolute index. Returns false for values
+ * that can't be stored, functions, userdata and tables nested too deeply,
+ * which are left out.
+ */
+static bool _encode(lua_State *L, struct bytes *b, int idx, int depth) {
+	switch (lua_type(L, idx)) {
+	case LUA_TBOOLEAN:
+		_put_byte(L, b, lua_toboolean(L, idx) ? T_TRUE : T_FALSE);
+		return true;
+
+	case LUA_TNUMBER: {
+		union { double d; Uint64 u; } v;
+		char tmp[8];
+		int i;
+
+		v.d = lua_tonumber(L, idx);
+		for (i = 0; i < 8; i++) {
+			tmp[i] = (v.u >> (i * 8)) & 0xFF;
+		}
+
+		_put_byte(L, b, T_NUMBER);
+		_put(L, b, tmp, 8);
+		return true;
+	}
+
+	case LUA_TSTRING: {
+		const char *str;
+		size_t len;
+
+		str = lua_tolstring(L, idx, &len);
+
+		_put_byte(L, b, T_STRING);
+		_put_u32(L, b, len);
+		_put(L, b, str, len);
+		return true;
+	}
+
+	case LUA_TTABLE: {
+		struct bytes tmp = { NULL, 0, 0 };
+		struct pair *pairs;
+		int i, n = 0, list;
+
+		if (depth >= STORE_MAX_DEPTH) {
+			LOG_WARN(log_settings, "settings nested too deeply");
+			return false;
+		}
+		luaL_checkstack(L, 4, "settings nested too deeply");
+
+		_put_byte(L, b, T_TABLE);
+
+		/* lua_next order depends on the table's history, encode the
+		 * pairs and write them sorted */
+		lua_newtable(L);
+		list = lua_gettop(L);
+
+		lua_pushnil(L);
+		while (lua_next(L, idx) != 0) {
+			int top = lua_gettop(L);
+
+			tmp.len = 0;
+			if (_encode(L, &tmp, top - 1, depth + 1) && _encode(L, &tmp, top, depth + 1)) {
+				lua_pushlstring(L, tmp.data, tmp.len);
+				lua_rawseti(L, list, ++n);
+			}
+			lua_pop(L, 1);
+		}
+		free(tmp.data);
+
+		pairs = lua_newuserdata(L, n * sizeof(struct pair));
+		for (i = 0; i < n; i++) {
+			lua_rawgeti(L, list, i + 1);
+			pairs[i].data = lua_tolstring(L, -1, &pairs[i].len);
+			lua_pop(L, 1);
+		}
+
+		qsort(pairs, n, sizeof(struct pair), _pair_cmp);
+
+		for (i = 0; i < n; i++) {
+			_put(L, b, pairs[i].data, pairs[i].len);
+		}
+		lua_pop(L, 2);
+
+		_put_byte(L, b, T_END);
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+
+/*
+ * Checks the encoded value at *p, and moves *p past it.
+ */
+static bool _skip(const unsigned char **p, const unsigned char *end, int depth) {
+	Uint32 len;
+
+	if (*p >= end) {
+		return false;
+	}
+
+	switch (*(*p)++) {
+	case T_FALSE:
+	case T_TRUE:
+		return true;
+
+	case T_NUMBER:
+		if (end - *p < 8) {
+			return false;
+		}
+		*p += 8;
+		return true;
+
+	case T_STRING:
+		if (end - *p < 4) {
+			return false;
+		}
+		len = _get_u32(*p);
+		*p += 4;
+		if ((size_t) (end - *p) < len) {
+			return false;
+		}
+		*p += len;
+		return true;
+
+	case T_TABLE:
+		if (depth >= STORE_MAX_DEPTH) {
+			return false;
+		}
+		while (*p < end && **p != T_END) {
+			if (!_skip(p, end, depth + 1) || !_skip(p, end, depth + 1)) {
+				return false;
+			}
+		}
+		if (*p >= end) {
+			return false;
+		}
+		(*p)++;
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+/*
+ * Pushes the value at *p, which has been checked with _skip.
+ */
+static void _decode(lua_State *L, const unsigned char **p) {
+	Uint32 len;
+
+	switch (*(*p)++) {
+	case T_FALSE:
+		lua_pushboolean(L, 0);
+		break;
+
+	case T_TRUE:
+		lua_pushboolean(L, 1);
+		break;
+
+	case T_NUMBER: {
+		union { double d; Uint64 u; } v;
+		int i;
+
+		v.u = 0;
+		for (i = 0; i < 8; i++) {
+			v.u |= (Uint64) (*p)[i] << (i * 8);
+		}
+		*p += 8;
+
+		lua_pushnumber(L, v.d);
+		break;
+	}
+
+	case T_STRING:
+		len = _get_u32(*p);
+		*p += 4;
+		lua_pushlstring(L, (const char *) *p, len);
+		*p += len;
+		break;
+
+	case T_TABLE:
+		luaL_checkstack(L, 3, "settings nested too deeply");
+
+		lua_newtable(L);
+		while (**p != T_END) {
+			_decode(L, p);
+			_decode(L, p);
+
+			/* a nan key can't be stored */
+			if (lua_isnumber(L, -2) && lua_tonumber(L, -2) != lua_tonumber(L, -2)) {
+				lua_pop(L, 2);
+				continue;
+			}
+			lua_rawset(L, -3);
+		}
+		(*p)++;
+		break;
+	}
+}
+
+
+/*
+ * Appends a record to b. The key and value are already encoded.
+ */
+static void _put_record(lua_State *L, struct bytes *b, Uint8 op, const char *applet, size_t applet_len, const char *key, size_t key_len, const char *value, size_t value_len) {
+	size_t start = b->len;
+	Uint32 len = 2 + applet_len + key_len + value_len;
+
+	_put_u32(L, b, len);
+	_put_u32(L, b, 0);
+	_put_byte(L, b, op);
+	_put_byte(L, b, applet_len);
+	_put(L, b, applet, applet_len);
+	_put(L, b, key, key_len);
+	_put(L, b, value, value_len);
+
+	_set_u32(b->data + start + 4, _crc((unsigned char *) b->data + start + STORE_RECORD_HEADER, len));
+}
+
+
+/*
+ * Checks the record at p, returning its length or 0 if it is torn or
+ * corrupt. Sets the op, applet and encoded key.
+ */
+static size_t _parse_record(const unsigned char *p, const unsigned char *end, Uint8 *op, const char **applet, size_t *applet_len, const char **key, size_t *key_len) {
+	const unsigned char *q, *rend;
+	Uint32 len;
+
+	if (end - p < STORE_RECORD_HEADER) {
+		return 0;
+	}
+
+	len = _get_u32(p);
+	if ((size_t) (end - p - STORE_RECORD_HEADER) < len || len < 2) {
+		return 0;
+	}
+	if (_crc(p + STORE_RECORD_HEADER, len) != _get_u32(p + 4)) {
+		return 0;
+	}
+
+	q = p + STORE_RECORD_HEADER;
+	rend = q + len;
+
+	*op = *q++;
+	*applet_len = *q++;
+	*applet = (const char *) q;
+	if ((size_t) (rend - q) < *applet_len) {
+		return 0;
+	}
+	q += *applet_len;
+
+	*key = (const char *) q;
+	if (q == rend && *op != OP_SET) {
+		/* applet record */
+		*key_len = 0;
+		return STORE_RECORD_HEADER + len;
+	}
+
+	if (!_skip(&q, rend, 0)) {
+		return 0;
+	}
+	*key_len = (const char *) q - *key;
+
+	if (*op == OP_SET) {
+		if (!_skip(&q, rend, 0)) {
+			return 0;
+		}
+	}
+	else if (*op != OP_DELETE) {
+		return 0;
+	}
+
+	if (q != rend) {
+		return 0;
+	}
+
+	return STORE_RECORD_HEADER + len;
+}
+
+
+/*
+ * Pushes the current records table of applet, creating it if create is
+ * true, or pushes nil. The userdata environment is on the top of the stack.
+ */
+static void _applet_records(lua_State *L, const char *applet, size_t applet_len, bool create) {
+	lua_pushlstring(L, applet, applet_len);
+	lua_rawget(L, -2);
+
+	if (lua_isnil(L, -1) && create) {
+		lua_pop(L, 1);
+
+		lua_newtable(L);
+		lua_pushlstring(L, applet, applet_len);
+		lua_pushvalue(L, -2);
+		lua_rawset(L, -4);
+	}
+}
+
+
+/*
+ * Replaces the store with only the current records. The userdata
+ * environment is on the top of the stack.
+ */
+static void _compact(lua_State *L, struct settingsstore *st) {
+	struct bytes b = { NULL, 0, 0 };
+
+	_put(L, &b, STORE_MAGIC, STORE_MAGIC_LEN);
+
+	lua_pushnil(L);
+	while (lua_next(L, -2) != 0) {
+		lua_pushnil(L);
+		while (lua_next(L, -2) != 0) {
+			const char *rec;
+			size_t len;
+
+			rec = lua_tolstring(L, -1, &len);
+			_put(L, &b, rec, len);
+			lua_pop(L, 1);
+		}
+		lua_pop(L, 1);
+	}
+
+	LOG_INFO(log_settings, "%s: compacting %d to %d bytes", st->path, (int) st->size, (int) b.len);
+
+	system_write_file(st->path, b.data, b.len);
+	st->size = b.len;
+
+	free(b.data);
+}
+
+
+static void _maybe_compact(lua_State *L, struct settingsstore *st) {
+	if (st->size > STORE_COMPACT_MIN && st->size > 2 * (st->live + STORE_MAGIC_LEN)) {
+		_compact(L, st);
+	}
+}
+
+
+/*
+ * Replays the records in the file. The userdata environment is on the
+ * top of the stack.
+ */
+static bool _load(lua_State *L, struct settingsstore *st) {
+	struct stat sb;
+	unsigned char *data, *p, *end;
+	ssize_t n;
+	size_t got, good;
+	int fd;
+
+	/* writes still queued from an earlier open */
+	system_flush_files();
+
+	fd = open(st->path, O_RDWR);
+	if (fd < 0 && errno == ENOENT) {
+		system_write_file(st->path, STORE_MAGIC, STORE_MAGIC_LEN);
+		st->size = STORE_MAGIC_LEN;
+		return true;
+	}
+
+	if (fd < 0 || fstat(fd, &sb) != 0) {
+		goto err;
+	}
+
+	if (sb.st_size == 0) {
+		close(fd);
+		system_write_file(st->path, STORE_MAGIC, STORE_MAGIC_LEN);
+		st->size = STORE_MAGIC_LEN;
+		return true;
+	}
+
+	data = malloc(sb.st_size);
+	if (!data) {
+		goto err;
+	}
+
+	got = 0;
+	while (got < (size_t) sb.st_size) {
+		n = read(fd, data + got, sb.st_size - got);
+		if (n <= 0) {
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			free(data);
+			goto err;
+		}
+		got += n;
+	}
+
+	if (got < STORE_MAGIC_LEN || memcmp(data, STORE_MAGIC, STORE_MAGIC_LEN) != 0) {
+		LOG_WARN(log_settings, "%s: not a settings store", st->path);
+		free(data);
+		close(fd);
+		errno = EINVAL;
+		return false;
+	}
+
+	p = data + STORE_MAGIC_LEN;
+	end = data + got;
+
+	while (p < end) {
+		const char *applet, *key;
+		size_t len, applet_len, key_len;
+		Uint8 op;
+
+		len = _parse_record(p, end, &op, &applet, &applet_len, &key, &key_len);
+		if (!len) {
+			break;
+		}
+
+		_applet_records(L, applet, applet_len, true);
+
+		/* the record this one supersedes */
+		lua_pushlstring(L, key, key_len);
+		lua_rawget(L, -2);
+		st->live -= lua_objlen(L, -1);
+		lua_pop(L, 1);
+
+		lua_pushlstring(L, key, key_len);
+		if (op != OP_DELETE) {
+			lua_pushlstring(L, (const char *) p, len);
+			st->live += len;
+		}
+		else {
+			lua_pushnil(L);
+		}
+		lua_rawset(L, -3);
+		lua_pop(L, 1);
+
+		p += len;
+	}
+
+	good = p - data;
+	free(data);
+
+	st->size = good;
+
+	if (good < got) {
+		LOG_WARN(log_settings, "%s: dropped %d bytes of torn or corrupt records", st->path, (int) (got - good));
+
+		if (ftruncate(fd, good) != 0) {
+			goto err;
+		}
+	}
+
+	close(fd);
+	return true;
+
+ err:
+	if (fd >= 0) {
+		int err = errno;
+
+		close(fd);
+		errno = err;
+	}
+	return false;
+}
+
+
+static void _close(struct settingsstore *st) {
+	if (st->path) {
+		free(st->path);
+		st->path = NULL;
+	}
+}
+
+
+static struct settingsstore *_check_store(lua_State *L, int idx) {
+	struct settingsstore *st = luaL_checkudata(L, idx, "jive.settingsstore");
+
+	if (!st->path) {
+		luaL_error(L, "settings store is closed");
+	}
+
+	return st;
+}
+
+
+/*
+ * store, err = jive_settingsstore:open(path)
+ *
+ * Opens the store in file path, creating it if needed.
+ */
+static int jiveL_settingsstore_open(lua_State *L) {
+	const char *path = luaL_checkstring(L, 2);
+	struct settingsstore *st;
+
+	st = lua_newuserdata(L, sizeof(struct settingsstore));
+	memset(st, 0, sizeof(struct settingsstore));
+
+	luaL_getmetatable(L, "jive.settingsstore");
+	lua_setmetatable(L, -2);
+
+	lua_newtable(L);
+	lua_setfenv(L, -2);
+
+	st->path = strdup(path);
+	if (!st->path) {
+		goto err;
+	}
+
+	lua_getfenv(L, -1);
+	if (!_load(L, st)) {
+		lua_pop(L, 1);
+		goto err;
+	}
+
+	_maybe_compact(L, st);
+	lua_pop(L, 1);
+
+	LOG_INFO(log_settings, "%s: %d bytes, %d current", path, (int) st->size, (int) st->live);
+
+	return 1;
+
+ err:
+	lua_pushnil(L);
+	lua_pushfstring(L, "%s: %s", path, strerror(errno));
+	_close(st);
+	return 2;
+}
+
+
+static int jiveL_settingsstore_gc(lua_State *L) {
+	struct settingsstore *st = lua_touserdata(L, 1);
+
+	_close(st);
+	return 0;
+}
+
+
+/*
+ * settings = store:get(applet)
+ *
+ * Returns the settings stored for applet, or nil if it has none, not even
+ * an empty table.
+ */
+static int jiveL_settingsstore_get(lua_State *L) {
+	const char *applet;
+	size_t applet_len;
+
+	_check_store(L, 1);
+	applet = luaL_checklstring(L, 2, &applet_len);
+
+	lua_getfenv(L, 1);
+	_applet_records(L, applet, applet_len, false);
+	if (lua_isnil(L, -1)) {
+		return 1;
+	}
+
+	/* all its records were deleted */
+	lua_pushnil(L);
+	if (lua_next(L, -2) == 0) {
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_pop(L, 2);
+
+	lua_newtable(L);
+
+	lua_pushnil(L);
+	while (lua_next(L, -3) != 0) {
+		const unsigned char *p;
+
+		if (lua_objlen(L, -2) == 0) {
+			/* applet record */
+			lua_pop(L, 1);
+			continue;
+		}
+
+		/* skip the record header, op and applet name to the key */
+		p = (const unsigned char *) lua_tostring(L, -1) + STORE_RECORD_HEADER + 2 + applet_len;
+
+		_decode(L, &p);
+		_decode(L, &p);
+		lua_rawset(L, -5);
+
+		lua_pop(L, 1);
+	}
+
+	return 1;
+}
+
+
+/*
+ * count = store:store(applet, settings)
+ *
+ * Stores the settings of applet, appending a record for each top level
+ * setting added, changed or removed since they were last stored, and the
+ * applet record if it is new. Storing nil settings removes the applet.
+ * Returns the number of records queued to be written.
+ */
+static int jiveL_settingsstore_store(lua_State *L) {
+	struct settingsstore *st = _check_store(L, 1);
+	struct bytes key = { NULL, 0, 0 };
+	struct bytes val = { NULL, 0, 0 };
+	struct bytes out = { NULL, 0, 0 };
+	const char *applet;
+	size_t applet_len;
+	size_t live;
+	int count = 0;
+
+	applet = luaL_checklstring(L, 2, &applet_len);
+	if (applet_len > 255) {
+		return luaL_argerror(L, 2, "applet name too long");
+	}
+	if (!lua_isnil(L, 3)) {
+		luaL_checktype(L, 3, LUA_TTABLE);
+	}
+	lua_settop(L, 3);
+
+	lua_getfenv(L, 1);				// 4: environment
+	_applet_records(L, applet, applet_len, true);	// 5: current records
+	lua_newtable(L);				// 6: new records by key, false to delete
+
+	live = st->live;
+
+	if (lua_istable(L, 3)) {
+		lua_pushnil(L);
+		while (lua_next(L, 3) != 0) {
+			const char *rec;
+			size_t len;
+
+			key.len = 0;
+			val.len = 0;
+			if (!_encode(L, &key, lua_gettop(L) - 1, 0) || !_encode(L, &val, lua_gettop(L), 0)) {
+				lua_pop(L, 1);
+				continue;
+			}
+			lua_pop(L, 1);
+
+			len = out.len;
+			_put_record(L, &out, OP_SET, applet, applet_len, key.data, key.len, val.data, val.len);
+
+			lua_pushlstring(L, key.data, key.len);
+			lua_rawget(L, 5);
+			rec = lua_tolstring(L, -1, NULL);
+
+			if (rec && lua_objlen(L, -1) == out.len - len && memcmp(rec, out.data + len, out.len - len) == 0) {
+				/* unchanged */
+				out.len = len;
+
+				lua_pushlstring(L, key.data, key.len);
+				lua_pushvalue(L, -2);
+				lua_rawset(L, 6);
+			}
+			else {
+				live -= lua_objlen(L, -1);
+				live += out.len - len;
+				count++;
+
+				lua_pushlstring(L, key.data, key.len);
+				lua_pushlstring(L, out.data + len, out.len - len);
+				lua_rawset(L, 6);
+			}
+			lua_pop(L, 1);
+		}
+	}
+
+	/* the applet record is kept unless the settings are nil */
+	if (lua_istable(L, 3)) {
+		lua_pushliteral(L, "");
+		lua_pushliteral(L, "");
+		lua_rawget(L, 5);
+
+		if (lua_isnil(L, -1)) {
+			size_t len = out.len;
+
+			lua_pop(L, 1);
+			_put_record(L, &out, OP_APPLET, applet, applet_len, NULL, 0, NULL, 0);
+			lua_pushlstring(L, out.data + len, out.len - len);
+
+			live += out.len - len;
+			count++;
+		}
+		lua_rawset(L, 6);
+	}
+
+	/* settings removed */
+	lua_pushnil(L);
+	while (lua_next(L, 5) != 0) {
+		const char *k;
+		size_t k_len;
+
+		lua_pushvalue(L, -2);
+		lua_rawget(L, 6);
+		if (lua_isnil(L, -1)) {
+			k = lua_tolstring(L, -3, &k_len);
+
+			_put_record(L, &out, OP_DELETE, applet, applet_len, k, k_len, NULL, 0);
+			live -= lua_objlen(L, -2);
+			count++;
+		}
+		lua_pop(L, 2);
+	}
+
+	free(key.data);
+	free(val.data);
+
+	if (out.len) {
+		system_append_file(st->path, out.data, out.len);
+		st->size += out.len;
+	}
+	free(out.data);
+
+	/* the new records are now current */
+	lua_pushlstring(L, applet, applet_len);
+	lua_pushvalue(L, 6);
+	lua_rawset(L, 4);
+	st->live = live;
+
+	lua_pushvalue(L, 4);
+	_maybe_compact(L, st);
+
+	lua_pushinteger(L, count);
+	return 1;
+}
+
+
+/*
+ * store:compact()
+ */
+static int jiveL_settingsstore_compact(lua_State *L) {
+	struct settingsstore *st = _check_store(L, 1);
+
+	lua_getfenv(L, 1);
+	_compact(L, st);
+
+	return 0;
+}
+
+
+/*
+ * size, live = store:stats()
+ *
+ * Returns the bytes in the file and the bytes of current records.
+ */
+static int jiveL_settingsstore_stats(lua_State *L) {
+	struct settingsstore *st = _check_store(L, 1);
+
+	lua_pushinteger(L, st->size);
+	lua_pushinteger(L, st->live);
+	return 2;
+}
+
+
+static const struct luaL_Reg settingsstore_m[] = {
+	{ "__gc", jiveL_settingsstore_gc },
+	{ "close", jiveL_settingsstore_gc },
+	{ "get", jiveL_settingsstore_get },
+	{ "store", jiveL_settingsstore_store },
+	{ "compact", jiveL_settingsstore_compact },
+	{ "stats", jiveL_settingsstore_stats },
+	{ NULL, NULL }
+};
+
+
+static const struct luaL_Reg settingsstore_lib[] = {
+	{ "open", jiveL_settingsstore_open },
+	{ NULL, NULL }
+};
+
+
+int luaopen_jive_settingsstore(lua_State *L) {
+	log_settings = LOG_CATEGORY_GET("jivelite.applets");
+
+	_crc_init();
+
+	luaL_newmetatable(L, "jive.settingsstore");
+
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+
+	luaL_register(L, NULL, settingsstore_m);
+
+	luaL_register(L, "jive.settingsstore", settingsstore_lib);
+
+	return 0;
+}
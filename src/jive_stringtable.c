@@ -0,0 +1,588 @@
+/*
+** Copyright 2010 Logitech. All Rights Reserved.
+**
+** This file is licensed under BSD. Please see the LICENSE file for details.
+*/
+
+#include "common.h"
+#include "jive.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+Compiled locale strings, see jive.utils.locale.
+
+A string table holds the strings of one locale, with the english fallback
+already applied, for each strings.txt file it was made from. The file is
+mapped and strings are looked up in place, so only the strings actually
+used are copied into lua.
+
+Each strings.txt file is a section, with the modification time and size
+of the file when it was compiled and the locales it had translations for.
+
+The table is STRINGS_MAGIC, the section count and entry count, then the
+sections sorted by name, each:
+	u32 name offset, u32 name length, u32 mtime, u32 size,
+	u32 locales offset, u32 locales length,
+	u32 first entry, u32 entry count
+followed by the entries, sorted by token within each section:
+	u32 token offset, u32 token length, u32 string offset, u32 string length
+followed by the names, locales, tokens and strings. All numbers are little
+endian, offsets are from the start of the file.
+*/
+
+
+#define STRINGS_MAGIC "JIVESTR1"
+#define STRINGS_HEADER 16
+#define STRINGS_SECTION 32
+#define STRINGS_ENTRY 16
+
+
+struct stringtable {
+	const unsigned char *data;
+	size_t size;
+	Uint32 nsections;
+	Uint32 nentries;
+};
+
+struct bytes {
+	char *data;
+	size_t len, cap;
+};
+
+struct string {
+	const char *str;
+	size_t len;
+};
+
+struct entry {
+	struct string token, value;
+};
+
+struct section {
+	struct string name, locales;
+	Uint32 mtime, size;
+	struct entry *entries;
+	size_t count;
+};
+
+
+static LOG_CATEGORY *log_locale;
+
+
+static Uint32 _u32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32) p[3] << 24);
+}
+
+
+static int _cmp(const char *a, size_t alen, const char *b, size_t blen) {
+	int r = memcmp(a, b, MIN(alen, blen));
+
+	if (r != 0) {
+		return r;
+	}
+	return (alen > blen) - (alen < blen);
+}
+
+
+static const unsigned char *_section(struct stringtable *st, Uint32 i) {
+	return st->data + STRINGS_HEADER + i * STRINGS_SECTION;
+}
+
+
+static const unsigned char *_entry(struct stringtable *st, Uint32 i) {
+	return st->data + STRINGS_HEADER + st->nsections * STRINGS_SECTION + i * STRINGS_ENTRY;
+}
+
+
+/* checks the string at p, an offset and length, is within the table */
+static bool _valid(struct stringtable *st, const unsigned char *p) {
+	return _u32(p) <= st->size && _u32(p + 4) <= st->size - _u32(p);
+}
+
+
+static struct stringtable *_check_table(lua_State *L, int idx) {
+	struct stringtable *st = luaL_checkudata(L, idx, "jive.stringtable");
+
+	if (!st->data) {
+		luaL_error(L, "string table is closed");
+	}
+
+	return st;
+}
+
+
+static Uint32 _check_section(lua_State *L, struct stringtable *st, int idx) {
+	lua_Integer i = luaL_checkinteger(L, idx);
+
+	luaL_argcheck(L, i >= 1 && i <= (lua_Integer) st->nsections, idx, "invalid section");
+	return i - 1;
+}
+
+
+/*
+ * table, err = jive_stringtable:open(path)
+ */
+static int jiveL_stringtable_open(lua_State *L) {
+	const char *path = luaL_checkstring(L, 2);
+	struct stringtable *st;
+	const unsigned char *data;
+	struct stat sb;
+	Uint32 i;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: %s", path, strerror(errno));
+		return 2;
+	}
+
+	if (fstat(fd, &sb) != 0 || sb.st_size < STRINGS_HEADER) {
+		close(fd);
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: invalid string table", path);
+		return 2;
+	}
+
+	data = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED) {
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: %s", path, strerror(errno));
+		return 2;
+	}
+
+	st = lua_newuserdata(L, sizeof(struct stringtable));
+	st->data = data;
+	st->size = sb.st_size;
+	st->nsections = _u32(data + 8);
+	st->nentries = _u32(data + 12);
+
+	luaL_getmetatable(L, "jive.stringtable");
+	lua_setmetatable(L, -2);
+
+	/* check the sections and entries are within the file */
+	if (memcmp(data, STRINGS_MAGIC, 8) != 0
+	    || st->nsections > (st->size - STRINGS_HEADER) / STRINGS_SECTION
+	    || st->nentries > (st->size - STRINGS_HEADER - st->nsections * STRINGS_SECTION) / STRINGS_ENTRY) {
+		goto bad_table;
+	}
+
+	for (i = 0; i < st->nsections; i++) {
+		const unsigned char *s = _section(st, i);
+
+		if (!_valid(st, s) || !_valid(st, s + 16)
+		    || _u32(s + 24) > st->nentries || _u32(s + 28) > st->nentries - _u32(s + 24)) {
+			goto bad_table;
+		}
+	}
+
+	for (i = 0; i < st->nentries; i++) {
+		const unsigned char *e = _entry(st, i);
+
+		if (!_valid(st, e) || !_valid(st, e + 8)) {
+			goto bad_table;
+		}
+	}
+
+	LOG_DEBUG(log_locale, "%s: %d sections, %d strings", path, (int) st->nsections, (int) st->nentries);
+
+	return 1;
+
+ bad_table:
+	munmap((void *) st->data, st->size);
+	st->data = NULL;
+
+	lua_pushnil(L);
+	lua_pushfstring(L, "%s: invalid string table", path);
+	return 2;
+}
+
+
+static int jiveL_stringtable_gc(lua_State *L) {
+	struct stringtable *st = lua_touserdata(L, 1);
+
+	if (st->data) {
+		munmap((void *) st->data, st->size);
+		st->data = NULL;
+	}
+	return 0;
+}
+
+
+/*
+ * count = table:count()
+ *
+ * Returns the number of sections.
+ */
+static int jiveL_stringtable_count(lua_State *L) {
+	struct stringtable *st = _check_table(L, 1);
+
+	lua_pushinteger(L, st->nsections);
+	return 1;
+}
+
+
+/*
+ * name, mtime, size, locales = table:info(section)
+ */
+static int jiveL_stringtable_info(lua_State *L) {
+	struct stringtable *st = _check_table(L, 1);
+	const unsigned char *s = _section(st, _check_section(L, st, 2));
+
+	lua_pushlstring(L, (const char *) st->data + _u32(s), _u32(s + 4));
+	lua_pushinteger(L, _u32(s + 8));
+	lua_pushinteger(L, _u32(s + 12));
+	lua_pushlstring(L, (const char *) st->data + _u32(s + 16), _u32(s + 20));
+	return 4;
+}
+
+
+/*
+ * section, locales = table:section(name, mtime, size)
+ *
+ * Returns the section for strings file name, if it was compiled from the
+ * file as it is now, and the locales the file has, separated by commas.
+ */
+static int jiveL_stringtable_section(lua_State *L) {
+	struct stringtable *st = _check_table(L, 1);
+	const char *name;
+	size_t len;
+	Uint32 lo, hi;
+
+	name = luaL_checklstring(L, 2, &len);
+
+	lo = 0;
+	hi = st->nsections;
+	while (lo < hi) {
+		Uint32 mid = (lo + hi) / 2;
+		const unsigned char *s = _section(st, mid);
+		int r;
+
+		r = _cmp(name, len, (const char *) st->data + _u32(s), _u32(s + 4));
+		if (r < 0) {
+			hi = mid;
+		}
+		else if (r > 0) {
+			lo = mid + 1;
+		}
+		else {
+			if (_u32(s + 8) != (Uint32) luaL_checkinteger(L, 3) || _u32(s + 12) != (Uint32) luaL_checkinteger(L, 4)) {
+				/* the file has changed */
+				break;
+			}
+
+			lua_pushinteger(L, mid + 1);
+			lua_pushlstring(L, (const char *) st->data + _u32(s + 16), _u32(s + 20));
+			return 2;
+		}
+	}
+
+	lua_pushnil(L);
+	return 1;
+}
+
+
+/*
+ * str = table:get(section, token)
+ *
+ * Returns the string for token in section, or nil.
+ */
+static int jiveL_stringtable_get(lua_State *L) {
+	struct stringtable *st = _check_table(L, 1);
+	const unsigned char *s = _section(st, _check_section(L, st, 2));
+	const char *token;
+	size_t len;
+	Uint32 lo, hi;
+
+	if (lua_type(L, 3) != LUA_TSTRING) {
+		lua_pushnil(L);
+		return 1;
+	}
+	token = lua_tolstring(L, 3, &len);
+
+	lo = _u32(s + 24);
+	hi = lo + _u32(s + 28);
+	while (lo < hi) {
+		Uint32 mid = (lo + hi) / 2;
+		const unsigned char *e = _entry(st, mid);
+		int r;
+
+		r = _cmp(token, len, (const char *) st->data + _u32(e), _u32(e + 4));
+		if (r < 0) {
+			hi = mid;
+		}
+		else if (r > 0) {
+			lo = mid + 1;
+		}
+		else {
+			lua_pushlstring(L, (const char *) st->data + _u32(e + 8), _u32(e + 12));
+			return 1;
+		}
+	}
+
+	lua_pushnil(L);
+	return 1;
+}
+
+
+/*
+ * strings = table:strings(section)
+ *
+ * Returns all strings in section, by token.
+ */
+static int jiveL_stringtable_strings(lua_State *L) {
+	struct stringtable *st = _check_table(L, 1);
+	const unsigned char *s = _section(st, _check_section(L, st, 2));
+	Uint32 i, first, count;
+
+	first = _u32(s + 24);
+	count = _u32(s + 28);
+
+	lua_createtable(L, 0, count);
+	for (i = first; i < first + count; i++) {
+		const unsigned char *e = _entry(st, i);
+
+		lua_pushlstring(L, (const char *) st->data + _u32(e), _u32(e + 4));
+		lua_pushlstring(L, (const char *) st->data + _u32(e + 8), _u32(e + 12));
+		lua_rawset(L, -3);
+	}
+
+	return 1;
+}
+
+
+static void _put(lua_State *L, struct bytes *b, const void *data, size_t len) {
+	if (b->len + len > b->cap) {
+		size_t cap = MAX(b->cap * 2, 4096);
+		char *tmp;
+
+		while (cap < b->len + len) {
+			cap *= 2;
+		}
+
+		tmp = realloc(b->data, cap);
+		if (!tmp) {
+			free(b->data);
+			b->data = NULL;
+			luaL_error(L, "out of memory");
+		}
+
+		b->data = tmp;
+		b->cap = cap;
+	}
+
+	memcpy(b->data + b->len, data, len);
+	b->len += len;
+}
+
+
+static void _put_u32(lua_State *L, struct bytes *b, Uint32 v) {
+	unsigned char tmp[4];
+
+	tmp[0] = v & 0xFF;
+	tmp[1] = (v >> 8) & 0xFF;
+	tmp[2] = (v >> 16) & 0xFF;
+	tmp[3] = (v >> 24) & 0xFF;
+	_put(L, b, tmp, 4);
+}
+
+
+/* appends an offset and length for str, placing str in data */
+static void _put_string(lua_State *L, struct bytes *index, struct bytes *data, size_t base, struct string *str) {
+	_put_u32(L, index, base + data->len);
+	_put_u32(L, index, str->len);
+	_put(L, data, str->str, str->len);
+}
+
+
+static int _section_cmp(const void *a, const void *b) {
+	const struct section *sa = a, *sb = b;
+
+	return _cmp(sa->name.str, sa->name.len, sb->name.str, sb->name.len);
+}
+
+
+static int _entry_cmp(const void *a, const void *b) {
+	const struct entry *ea = a, *eb = b;
+
+	return _cmp(ea->token.str, ea->token.len, eb->token.str, eb->token.len);
+}
+
+
+static void _field_string(lua_State *L, int idx, const char *k, struct string *str) {
+	lua_getfield(L, idx, k);
+	if (lua_type(L, -1) == LUA_TSTRING) {
+		/* the string is still referenced by the section table */
+		str->str = lua_tolstring(L, -1, &str->len);
+	}
+	else {
+		str->str = "";
+		str->len = 0;
+	}
+	lua_pop(L, 1);
+}
+
+
+static Uint32 _field_u32(lua_State *L, int idx, const char *k) {
+	Uint32 v;
+
+	lua_getfield(L, idx, k);
+	v = luaL_optinteger(L, -1, 0);
+	lua_pop(L, 1);
+
+	return v;
+}
+
+
+/*
+ * jive_stringtable:write(path, sections)
+ *
+ * Writes a string table to path, using the writer thread. Each section
+ * is a table of name, mtime, size, locales and strings, a table of
+ * strings by token.
+ */
+static int jiveL_stringtable_write(lua_State *L) {
+	const char *path = luaL_checkstring(L, 2);
+	struct bytes index = { NULL, 0, 0 };
+	struct bytes data = { NULL, 0, 0 };
+	struct section *sections;
+	size_t nsections, nentries, i, j, base;
+
+	luaL_checktype(L, 3, LUA_TTABLE);
+	lua_settop(L, 3);
+
+	/* 4: the section and entry arrays, until they are written */
+	lua_newtable(L);
+
+	nsections = lua_objlen(L, 3);
+	sections = lua_newuserdata(L, nsections * sizeof(struct section) + 1);
+	lua_rawseti(L, 4, 0);
+
+	/* collect the sections, the strings stay referenced from argument 3 */
+	nentries = 0;
+	for (i = 0; i < nsections; i++) {
+		struct section *s = &sections[i];
+
+		lua_rawgeti(L, 3, i + 1);
+		luaL_checktype(L, -1, LUA_TTABLE);
+
+		_field_string(L, -1, "name", &s->name);
+		_field_string(L, -1, "locales", &s->locales);
+		s->mtime = _field_u32(L, -1, "mtime");
+		s->size = _field_u32(L, -1, "size");
+
+		s->count = 0;
+		lua_getfield(L, -1, "strings");
+		if (lua_istable(L, -1)) {
+			lua_pushnil(L);
+			while (lua_next(L, -2) != 0) {
+				if (lua_type(L, -2) == LUA_TSTRING && lua_type(L, -1) == LUA_TSTRING) {
+					s->count++;
+				}
+				lua_pop(L, 1);
+			}
+		}
+
+		s->entries = lua_newuserdata(L, s->count * sizeof(struct entry) + 1);
+		lua_rawseti(L, 4, i + 1);
+
+		j = 0;
+		if (lua_istable(L, -1)) {
+			lua_pushnil(L);
+			while (lua_next(L, -2) != 0) {
+				if (lua_type(L, -2) == LUA_TSTRING && lua_type(L, -1) == LUA_TSTRING) {
+					struct entry *e = &s->entries[j++];
+
+					e->token.str = lua_tolstring(L, -2, &e->token.len);
+					e->value.str = lua_tolstring(L, -1, &e->value.len);
+				}
+				lua_pop(L, 1);
+			}
+		}
+		lua_pop(L, 2);
+
+		qsort(s->entries, s->count, sizeof(struct entry), _entry_cmp);
+		nentries += s->count;
+	}
+
+	qsort(sections, nsections, sizeof(struct section), _section_cmp);
+
+	/* index, then data */
+	base = STRINGS_HEADER + nsections * STRINGS_SECTION + nentries * STRINGS_ENTRY;
+
+	_put(L, &index, STRINGS_MAGIC, 8);
+	_put_u32(L, &index, nsections);
+	_put_u32(L, &index, nentries);
+
+	nentries = 0;
+	for (i = 0; i < nsections; i++) {
+		struct section *s = &sections[i];
+
+		_put_string(L, &index, &data, base, &s->name);
+		_put_u32(L, &index, s->mtime);
+		_put_u32(L, &index, s->size);
+		_put_string(L, &index, &data, base, &s->locales);
+		_put_u32(L, &index, nentries);
+		_put_u32(L, &index, s->count);
+
+		nentries += s->count;
+	}
+
+	for (i = 0; i < nsections; i++) {
+		struct section *s = &sections[i];
+
+		for (j = 0; j < s->count; j++) {
+			_put_string(L, &index, &data, base, &s->entries[j].token);
+			_put_string(L, &index, &data, base, &s->entries[j].value);
+		}
+	}
+
+	_put(L, &index, data.data, data.len);
+	free(data.data);
+
+	system_write_file(path, index.data, index.len);
+	free(index.data);
+
+	LOG_DEBUG(log_locale, "%s: writing %d sections, %d strings", path, (int) nsections, (int) nentries);
+
+	return 0;
+}
+
+
+static const struct luaL_Reg stringtable_m[] = {
+	{ "__gc", jiveL_stringtable_gc },
+	{ "close", jiveL_stringtable_gc },
+	{ "count", jiveL_stringtable_count },
+	{ "info", jiveL_stringtable_info },
+	{ "section", jiveL_stringtable_section },
+	{ "get", jiveL_stringtable_get },
+	{ "strings", jiveL_stringtable_strings },
+	{ NULL, NULL }
+};
+
+
+static const struct luaL_Reg stringtable_lib[] = {
+	{ "open", jiveL_stringtable_open },
+	{ "write", jiveL_stringtable_write },
+	{ NULL, NULL }
+};
+
+
+int luaopen_jive_stringtable(lua_State *L) {
+	log_locale = LOG_CATEGORY_GET("jivelite");
+
+	luaL_newmetatable(L, "jive.stringtable");
+
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+
+	luaL_register(L, NULL, stringtable_m);
+
+	luaL_register(L, "jive.stringtable", stringtable_lib);
+
+	return 0;
+}
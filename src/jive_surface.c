@@ -7,6 +7,15 @@
 #include "common.h"
 #include "jive.h"
 
+#ifdef HAVE_LIBJPEG
+#include <setjmp.h>
+#include <jpeglib.h>
+#if JPEG_LIB_VERSION < 80 && !defined(MEM_SRCDST_SUPPORTED)
+/* jpeg_mem_src is needed to decode from memory */
+#undef HAVE_LIBJPEG
+#endif
+#endif
+
 /*
  * This file combines both JiveSurface and JiveTile into a single implementation.
  * The separate typdefs, JiveSurface and JiveTile, are still kept so that the
@@ -978,6 +987,178 @@ JiveSurface *jive_surface_load_image_data(const char *data, size_t len) {
 }
 
 
+/* scale to fit in, or to cover, w x h */
+static double _scale_to(int iw, int ih, int w, int h, bool cover) {
+	double sx, sy;
+
+	if (iw <= 0 || ih <= 0) {
+		return 1.0;
+	}
+
+	sx = (double) w / iw;
+	sy = (double) h / ih;
+
+	return cover ? MAX(sx, sy) : MIN(sx, sy);
+}
+
+
+#ifdef HAVE_LIBJPEG
+struct jpeg_error {
+	struct jpeg_error_mgr mgr;
+	jmp_buf jmp;
+};
+
+
+static void _jpeg_error_exit(j_common_ptr cinfo) {
+	struct jpeg_error *err = (struct jpeg_error *) cinfo->err;
+
+	longjmp(err->jmp, 1);
+}
+
+
+static void _jpeg_output_message(j_common_ptr cinfo) {
+	/* errors fall back to SDL_image, which reports them */
+}
+
+
+/*
+ * Decodes a JPEG at the smallest DCT scale, 1/1 to 1/8, that is no smaller
+ * than the image scaled by scale_to. Returns NULL for JPEGs that can't be
+ * decoded as RGB, such as CMYK.
+ */
+static SDL_Surface *_load_jpeg_scaled(const char *data, size_t len, int w, int h, bool cover, int *iw, int *ih) {
+	struct jpeg_decompress_struct cinfo;
+	struct jpeg_error err;
+	SDL_Surface *volatile sdl = NULL;
+	JSAMPLE *volatile row = NULL;
+	double scale;
+
+	cinfo.err = jpeg_std_error(&err.mgr);
+	err.mgr.error_exit = _jpeg_error_exit;
+	err.mgr.output_message = _jpeg_output_message;
+
+	if (setjmp(err.jmp)) {
+		jpeg_destroy_decompress(&cinfo);
+		if (sdl) {
+			SDL_FreeSurface(sdl);
+		}
+		free(row);
+		return NULL;
+	}
+
+	jpeg_create_decompress(&cinfo);
+	jpeg_mem_src(&cinfo, (unsigned char *) data, len);
+	jpeg_read_header(&cinfo, TRUE);
+
+	*iw = cinfo.image_width;
+	*ih = cinfo.image_height;
+
+	scale = _scale_to(*iw, *ih, w, h, cover);
+
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = 1;
+	while (cinfo.scale_denom < 8 && scale * cinfo.scale_denom * 2 <= 1.0) {
+		cinfo.scale_denom *= 2;
+	}
+
+	/* the resampler smooths the result */
+	cinfo.out_color_space = JCS_RGB;
+	cinfo.dct_method = JDCT_IFAST;
+	cinfo.do_fancy_upsampling = FALSE;
+
+	jpeg_start_decompress(&cinfo);
+
+	sdl = SDL_CreateRGBSurface(SDL_SWSURFACE, cinfo.output_width, cinfo.output_height, 32,
+				   0x00FF0000, 0x0000FF00, 0x000000FF, 0);
+	row = malloc(cinfo.output_width * cinfo.output_components);
+	if (!sdl || !row) {
+		longjmp(err.jmp, 1);
+	}
+
+	while (cinfo.output_scanline < cinfo.output_height) {
+		Uint32 *dst = (Uint32 *) ((Uint8 *) sdl->pixels + cinfo.output_scanline * sdl->pitch);
+		JSAMPROW rows[1];
+		JSAMPLE *src = row;
+		JDIMENSION x;
+
+		rows[0] = row;
+		jpeg_read_scanlines(&cinfo, rows, 1);
+
+		for (x = 0; x < cinfo.output_width; x++, src += 3) {
+			*dst++ = (src[0] << 16) | (src[1] << 8) | src[2];
+		}
+	}
+
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	free(row);
+
+	LOG_DEBUG(log_ui, "Decoded %dx%d jpeg at 1/%d", *iw, *ih, cinfo.scale_denom);
+
+	return sdl;
+}
+#endif
+
+
+/*
+ * Decodes image data scaled to fit in w x h, or with cover to cover it,
+ * keeping the aspect ratio. Images are not enlarged. JPEGs are decoded
+ * at a reduced DCT scale near the result, and 32 bit images such as
+ * RGBA PNGs are resampled as decoded, so large images are neither
+ * decoded nor converted at full size. The size of the image before
+ * scaling is returned in iw and ih.
+ */
+JiveSurface *jive_surface_load_image_scaled(const char *data, size_t len, int w, int h, bool cover, int *iw, int *ih) {
+	SDL_Surface *sdl = NULL;
+	JiveSurface *srf, *dst;
+	double scale;
+	int dw, dh;
+
+#ifdef HAVE_LIBJPEG
+	if (len > 3 && memcmp(data, "\xFF\xD8\xFF", 3) == 0) {
+		sdl = _load_jpeg_scaled(data, len, w, h, cover, iw, ih);
+	}
+#endif
+
+	if (!sdl) {
+		SDL_RWops *src = SDL_RWFromConstMem(data, (int) len);
+
+		sdl = IMG_Load_RW(src, 1);
+		if (!sdl) {
+			return NULL;
+		}
+
+		*iw = sdl->w;
+		*ih = sdl->h;
+	}
+
+	srf = jive_surface_new_SDLSurface(sdl);
+
+	scale = _scale_to(*iw, *ih, w, h, cover);
+	if (scale >= 1.0) {
+		return jive_surface_display_format(srf);
+	}
+
+	dw = MAX((int) (*iw * scale + 0.5), 1);
+	dh = MAX((int) (*ih * scale + 0.5), 1);
+
+	/* the resampler reads 16 and 32 bit surfaces */
+	if (sdl->format->BytesPerPixel != 4 && sdl->format->BytesPerPixel != 2) {
+		jive_surface_display_format(srf);
+		if (!srf->sdl) {
+			jive_surface_free(srf);
+			return NULL;
+		}
+	}
+
+	dst = jive_surface_newRGBA(dw, dh);
+	copyResampled(dst->sdl, srf->sdl, 0, 0, 0, 0, dw, dh, srf->sdl->w, srf->sdl->h);
+	jive_surface_free(srf);
+
+	return jive_surface_display_format(dst);
+}
+
+
 int jive_surface_set_wm_icon(JiveSurface *srf) {
 	SDL_WM_SetIcon(_resolve_SDL_surface(srf), NULL);
 	return 1;
@@ -1248,6 +1429,11 @@ void jive_surface_get_size(JiveSurface *srf, Uint16 *w, Uint16 *h) {
 }
 
 
+SDL_Surface *jive_surface_get_sdl(JiveSurface *srf) {
+	return _resolve_SDL_surface(srf);
+}
+
+
 int jive_surface_get_bytes(JiveSurface *srf) {
 	SDL_PixelFormat *format;
 
@@ -1682,11 +1868,12 @@ int jiveL_surface_load_image(lua_State *L) {
 int jiveL_surface_load_image_data(lua_State *L) {
 	/*
 	  class
-	  image
-	  len
+	  image, a string or jive.buffer decoded in place
+	  len (optional)
 	*/
-	const char *image = luaL_checklstring(L, 2, NULL);
-	int len = luaL_checkint(L, 3);
+	size_t len;
+	const char *image = jive_buffer_checklstring(L, 2, &len);
+	len = MIN(len, (size_t) luaL_optinteger(L, 3, len));
 	if (image && len) {
 		JiveSurface *srf = jive_surface_load_image_data(image, len);
 		if (srf) {
@@ -1701,6 +1888,43 @@ int jiveL_surface_load_image_data(lua_State *L) {
 	return 0;
 }
 
+/*
+ * image, w, h = Surface:loadImageScaled(data, w, h [, cover])
+ *
+ * Returns the image scaled to fit in w x h, and the size of the image
+ * before scaling.
+ */
+int jiveL_surface_load_image_scaled(lua_State *L) {
+	/*
+	  class
+	  image, a string or jive.buffer decoded in place
+	  w
+	  h
+	  cover (optional)
+	*/
+	size_t len;
+	const char *image = jive_buffer_checklstring(L, 2, &len);
+	int w = luaL_checkinteger(L, 3);
+	int h = luaL_checkinteger(L, 4);
+	bool cover = lua_toboolean(L, 5);
+	int iw, ih;
+
+	if (image && len) {
+		JiveSurface *srf = jive_surface_load_image_scaled(image, len, w, h, cover, &iw, &ih);
+		if (srf) {
+			JiveSurface **p = (JiveSurface **)lua_newuserdata(L, sizeof(JiveSurface *));
+			*p = srf;
+			luaL_getmetatable(L, "JiveSurface");
+			lua_setmetatable(L, -2);
+			lua_pushinteger(L, iw);
+			lua_pushinteger(L, ih);
+			return 3;
+		}
+	}
+
+	return 0;
+}
+
 int jiveL_surface_draw_text(lua_State *L) {
 	/*
 	  class
@@ -9,6 +9,11 @@
 #include "jive.h"
 #include "version.h"
 
+#include <sys/stat.h>
+#if HAVE_FSYNC && !defined(FSYNC_WORKAROUND_ENABLED)
+#include <dirent.h>
+#endif
+
 
 static char *mac_address;
 static char *uuid;
@@ -300,26 +305,58 @@ int jive_find_file(const char *path, char *fullpath) {
 
 
 /*
- * 
- */
-static int system_atomic_write(lua_State *L)
-{
-	const char *fname, *fdata;
+Files are written by a writer thread, so a slow fsync doesn't block the
+ui. Writes to the same file within WRITER_DEBOUNCE ms of each other are
+coalesced into one, so applets storing settings on every change write
+their file once, but no write is delayed more than WRITER_MAX_DELAY ms.
+Each file has at most one queued job: a replace supersedes everything
+queued before it, and appends are added to the job's data. The queue is
+written out at exit, see jive_quit. A write that can't be queued, with no
+writer thread or no memory, is done at once by the caller. Failed writes
+are logged and reported by System:flushWrites.
+*/
+#define WRITER_DEBOUNCE 1000
+#define WRITER_MAX_DELAY 5000
+
+struct write_job {
+	struct write_job *next;
+	char *path;
+	bool replace;	/* replace the file, else append to it */
+	char *data;
+	size_t len, size;
+	u32_t first, due;
+};
+
+static struct {
+	bool started;
+	SDL_mutex *lock;
+	SDL_cond *cond;		/* signalled when a job is queued or a flush starts */
+	SDL_cond *idle;		/* broadcast when the queue is written */
+	struct write_job *head;
+	bool writing;
+	int flush;		/* number of threads waiting for a flush */
+	int failed;		/* writes failed since System:flushWrites */
+	char error[256];	/* the last failure */
+} writer;
+
+static LOG_CATEGORY *log_writer;
+
+
+static bool writer_replace(const char *fname, const char *fdata, size_t len) {
 	char *tname;
-	size_t n, len;
+	size_t n;
 	FILE *fp;
 #if HAVE_FSYNC && !defined(FSYNC_WORKAROUND_ENABLED)
 	DIR *dp;
 #endif
-	fname = lua_tostring(L, 2);
-	fdata = lua_tolstring(L, 3, &len);
 
 	tname = alloca(strlen(fname) + 5);
 	strcpy(tname, fname);
 	strcat(tname, ".new");
 	
 	if (!(fp = fopen(tname, "w"))) {
-		return luaL_error(L, "fopen: %s", strerror(errno));
+		LOG_ERROR(log_writer, "%s: fopen: %s", tname, strerror(errno));
+		return false;
 	}
 
 	n = 0;
@@ -327,36 +364,42 @@ static int system_atomic_write(lua_State *L)
 		n += fwrite(fdata + n, 1, len - n, fp);
 
 		if (ferror(fp)) {
+			LOG_ERROR(log_writer, "%s: fwrite: %s", tname, strerror(errno));
 			fclose(fp);
-			return luaL_error(L, "fwrite: %s", strerror(errno));
+			return false;
 		}
 	}
 
 	if (fflush(fp) != 0) {
+		LOG_ERROR(log_writer, "%s: fflush: %s", tname, strerror(errno));
 		fclose(fp);
-		return luaL_error(L, "fflush: %s", strerror(errno));
+		return false;
 	}
 #if HAVE_FSYNC && !defined(FSYNC_WORKAROUND_ENABLED)
 	if (fsync(fileno(fp)) != 0) {
+		LOG_ERROR(log_writer, "%s: fsync: %s", tname, strerror(errno));
 		fclose(fp);
-		return luaL_error(L, "fsync: %s", strerror(errno));
+		return false;
 	}
 #endif
 	if (fclose(fp) != 0) {
-		return luaL_error(L, "fclose: %s", strerror(errno));
+		LOG_ERROR(log_writer, "%s: fclose: %s", tname, strerror(errno));
+		return false;
 	}
 
 #if defined(WIN32)
 	/* windows systems must delete old file first */
 	if (_access_s(fname, 0) == 0) {
 		if (remove(fname) != 0) {
-			return luaL_error(L, "remove old file: %s", strerror(errno));
+			LOG_ERROR(log_writer, "%s: remove old file: %s", fname, strerror(errno));
+			return false;
 		}
 	}
 #endif
 
 	if (rename(tname, fname) != 0) {
-		return luaL_error(L, "rename: %s", strerror(errno));
+		LOG_ERROR(log_writer, "%s: rename: %s", tname, strerror(errno));
+		return false;
 	}
 
 #ifdef FSYNC_WORKAROUND_ENABLED
@@ -364,23 +407,353 @@ static int system_atomic_write(lua_State *L)
 	sync();
 #elif HAVE_FSYNC
 	if (!(dp = opendir(dirname(tname)))) {
-		return luaL_error(L, "opendir: %s", strerror(errno));
+		LOG_ERROR(log_writer, "%s: opendir: %s", fname, strerror(errno));
+		return false;
 	}
 	
 	if (fsync(dirfd(dp)) != 0) {
+		LOG_ERROR(log_writer, "%s: fsync: %s", fname, strerror(errno));
 		closedir(dp);
-		return luaL_error(L, "fsync: %s", strerror(errno));
+		return false;
 	}
 
 	if (closedir(dp) != 0) {
-		return luaL_error(L, "closedir: %s", strerror(errno));
+		LOG_ERROR(log_writer, "%s: closedir: %s", fname, strerror(errno));
+		return false;
 	}
 #endif
 
+	return true;
+}
+
+
+/* appends to fname, or leaves it as it was */
+static bool writer_append(const char *fname, const char *fdata, size_t len) {
+	struct stat sb;
+	ssize_t n;
+	int fd;
+
+	if ((fd = open(fname, O_WRONLY | O_CREAT | O_APPEND, 0644)) < 0) {
+		LOG_ERROR(log_writer, "%s: open: %s", fname, strerror(errno));
+		return false;
+	}
+
+	if (fstat(fd, &sb) != 0) {
+		LOG_ERROR(log_writer, "%s: fstat: %s", fname, strerror(errno));
+		close(fd);
+		return false;
+	}
+
+	while (len > 0) {
+		n = write(fd, fdata, len);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			goto err;
+		}
+
+		fdata += n;
+		len -= n;
+	}
+
+#if HAVE_FSYNC && !defined(FSYNC_WORKAROUND_ENABLED)
+	if (fsync(fd) != 0) {
+		goto err;
+	}
+#endif
+
+	close(fd);
+	return true;
+
+ err:
+	LOG_ERROR(log_writer, "%s: write: %s", fname, strerror(errno));
+
+	if (ftruncate(fd, sb.st_size) != 0) {
+		LOG_ERROR(log_writer, "%s: ftruncate: %s", fname, strerror(errno));
+	}
+	close(fd);
+	return false;
+}
+
+
+/* remembers a failed write for System:flushWrites */
+static void writer_failed(const char *fname) {
+	if (writer.lock) {
+		SDL_LockMutex(writer.lock);
+	}
+
+	writer.failed++;
+	snprintf(writer.error, sizeof(writer.error), "%s: write failed, see the log", fname);
+
+	if (writer.lock) {
+		SDL_UnlockMutex(writer.lock);
+	}
+}
+
+
+/* writes fdata to fname now */
+static void writer_now(const char *fname, const char *fdata, size_t len, bool replace) {
+	bool ok;
+
+	if (replace) {
+		ok = writer_replace(fname, fdata, len);
+	}
+	else {
+		ok = writer_append(fname, fdata, len);
+	}
+
+	if (!ok) {
+		writer_failed(fname);
+	}
+}
+
+
+static void writer_write(struct write_job *job) {
+	u32_t start = jive_jiffies();
+
+	writer_now(job->path, job->data, job->len, job->replace);
+
+	LOG_DEBUG(log_writer, "%s %s: %d bytes in %d ms", job->replace ? "wrote" : "appended", job->path, (int) job->len, (int) (jive_jiffies() - start));
+
+	free(job->path);
+	free(job->data);
+	free(job);
+}
+
+
+static int writer_thread(void *unused) {
+	struct write_job *job, **p, **next;
+	u32_t now;
+
+	SDL_LockMutex(writer.lock);
+
+	while (true) {
+		if (!writer.head) {
+			SDL_CondWait(writer.cond, writer.lock);
+			continue;
+		}
+
+		/* the job due first */
+		now = jive_jiffies();
+		next = &writer.head;
+		for (p = &writer.head; *p; p = &(*p)->next) {
+			if ((Sint32) ((*p)->due - (*next)->due) < 0) {
+				next = p;
+			}
+		}
+
+		job = *next;
+		if (!writer.flush && (Sint32) (job->due - now) > 0) {
+			SDL_CondWaitTimeout(writer.cond, writer.lock, job->due - now);
+			continue;
+		}
+
+		*next = job->next;
+		writer.writing = true;
+
+		SDL_UnlockMutex(writer.lock);
+		writer_write(job);
+		SDL_LockMutex(writer.lock);
+
+		writer.writing = false;
+		if (!writer.head) {
+			SDL_CondBroadcast(writer.idle);
+		}
+	}
+
+	return 0;
+}
+
+
+static bool writer_start(void) {
+	if (writer.started) {
+		return writer.lock != NULL;
+	}
+	writer.started = true;
+
+	log_writer = LOG_CATEGORY_GET("jivelite");
+
+	writer.lock = SDL_CreateMutex();
+	writer.cond = SDL_CreateCond();
+	writer.idle = SDL_CreateCond();
+
+	if (SDL_CreateThread(writer_thread, NULL) == NULL) {
+		LOG_ERROR(log_writer, "create writer_thread failed, writing files synchronously");
+
+		SDL_DestroyCond(writer.idle);
+		SDL_DestroyCond(writer.cond);
+		SDL_DestroyMutex(writer.lock);
+		writer.lock = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+
+static void writer_queue(const char *fname, const char *fdata, size_t len, bool replace) {
+	struct write_job *job;
+	u32_t now = jive_jiffies();
+
+	if (!writer_start()) {
+		writer_now(fname, fdata, len, replace);
+		return;
+	}
+
+	SDL_LockMutex(writer.lock);
+
+	for (job = writer.head; job; job = job->next) {
+		if (strcmp(job->path, fname) == 0) {
+			break;
+		}
+	}
+
+	if (job) {
+		if (replace) {
+			job->replace = true;
+			job->len = 0;
+		}
+		job->due = MIN(now + WRITER_DEBOUNCE, job->first + WRITER_MAX_DELAY);
+	}
+	else {
+		job = calloc(1, sizeof(struct write_job));
+		if (job) {
+			job->path = strdup(fname);
+		}
+		if (!job || !job->path) {
+			free(job);
+			goto err;
+		}
+
+		job->replace = replace;
+		job->first = now;
+		job->due = now + WRITER_DEBOUNCE;
+
+		job->next = writer.head;
+		writer.head = job;
+	}
+
+	if (job->len + len > job->size) {
+		size_t size = MAX(job->len + len, job->size * 2);
+		char *data;
+
+		data = realloc(job->data, size);
+		if (!data) {
+			goto err;
+		}
+
+		job->data = data;
+		job->size = size;
+	}
+	memcpy(job->data + job->len, fdata, len);
+	job->len += len;
+
+	SDL_CondSignal(writer.cond);
+	SDL_UnlockMutex(writer.lock);
+	return;
+
+ err:
+	SDL_UnlockMutex(writer.lock);
+
+	/* write it after what is already queued for the file */
+	LOG_ERROR(log_writer, "%s: out of memory queueing write, writing now", fname);
+
+	system_flush_files();
+	writer_now(fname, fdata, len, replace);
+}
+
+
+/* queues fname to be replaced with fdata */
+void system_write_file(const char *fname, const char *fdata, size_t len) {
+	writer_queue(fname, fdata, len, true);
+}
+
+
+/* queues fdata to be appended to fname */
+void system_append_file(const char *fname, const char *fdata, size_t len) {
+	writer_queue(fname, fdata, len, false);
+}
+
+
+/* writes all queued files now, and waits until they are written */
+void system_flush_files(void) {
+	if (!writer.lock) {
+		return;
+	}
+
+	SDL_LockMutex(writer.lock);
+
+	writer.flush++;
+	SDL_CondSignal(writer.cond);
+
+	while (writer.head || writer.writing) {
+		SDL_CondWait(writer.idle, writer.lock);
+	}
+
+	writer.flush--;
+
+	SDL_UnlockMutex(writer.lock);
+}
+
+
+/*
+ * System:atomicWrite(fname, fdata)
+ *
+ * Replaces fname with fdata. The file is written later by the writer
+ * thread, so write errors are not raised here. They are logged, and
+ * returned by the next System:flushWrites.
+ */
+static int system_atomic_write(lua_State *L)
+{
+	const char *fname, *fdata;
+	size_t len;
+
+	fname = luaL_checkstring(L, 2);
+	fdata = luaL_checklstring(L, 3, &len);
+
+	system_write_file(fname, fdata, len);
+
 	return 0;
 }
 
 
+/*
+ * ok, err = System:flushWrites()
+ *
+ * Waits until the files queued by atomicWrite are written. Returns true,
+ * or nil and the last error if any write failed since the last call.
+ */
+static int system_flush_writes(lua_State *L)
+{
+	char error[sizeof(writer.error)];
+	int failed;
+
+	system_flush_files();
+
+	if (writer.lock) {
+		SDL_LockMutex(writer.lock);
+	}
+
+	failed = writer.failed;
+	writer.failed = 0;
+	strcpy(error, writer.error);
+
+	if (writer.lock) {
+		SDL_UnlockMutex(writer.lock);
+	}
+
+	if (failed) {
+		lua_pushnil(L);
+		lua_pushstring(L, error);
+		return 2;
+	}
+
+	lua_pushboolean(L, 1);
+	return 1;
+}
+
+
 static const struct luaL_Reg jive_system_methods[] = {
 	{ "getArch", system_lua_get_arch },
 	{ "getMachine", system_lua_get_machine },
@@ -391,6 +764,7 @@ static const struct luaL_Reg jive_system_methods[] = {
 	{ "getUserDir", system_get_user_dir },
 	{ "findFile", system_find_file },
 	{ "atomicWrite", system_atomic_write },
+	{ "flushWrites", system_flush_writes },
 	{ "init", system_init },
 	{ NULL, NULL }
 };
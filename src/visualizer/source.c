@@ -0,0 +1,403 @@
+/*
+** Copyright 2010 Logitech. All Rights Reserved.
+**
+** This file is licensed under BSD. Please see the LICENSE file for details.
+*/
+
+/*
+ * Alternate sample sources for the visualizers, so they can be benchmarked
+ * and regression tested without a running squeezelite. The source is
+ * selected with the JIVE_VIS_SOURCE environment variable:
+ *
+ *   sine:<freq>[,<freq>]   sine wave, optionally a different right channel
+ *   square:<freq>          square wave
+ *   noise                  white noise from a fixed seed
+ *   wav:<path>             16 bit PCM wav file, mono or stereo, looped
+ *   pipe:<path>            raw 16 bit little endian stereo at 44.1kHz
+ *
+ * Generated and wav sources advance by a fixed number of samples per
+ * animation frame, so the visualizer output only depends on the frame
+ * number. Pipe sources are read as data arrives.
+ */
+
+#include "../common.h"
+#include "../jive.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "visualizer.h"
+
+#define DEFAULT_RATE 44100
+
+static enum {
+	SOURCE_SINE,
+	SOURCE_SQUARE,
+	SOURCE_NOISE,
+	SOURCE_WAV,
+	SOURCE_PIPE,
+} source_type;
+
+static struct vis_t source_vis;
+
+static Uint32 source_frame;
+
+// stereo frames generated per animation frame
+static u32_t source_frame_samples;
+
+// sample position, used by generators and wav playback
+static u32_t source_pos;
+
+// generator parameters
+static double source_freq[2];
+static u32_t source_seed;
+
+// wav file, mapped read only and used in place
+static u8_t *wav_map;
+static size_t wav_map_len;
+static s16_t *wav_data;
+static u32_t wav_frames;
+static u16_t wav_channels;
+
+// pipe, read non blocking
+static int pipe_fd = -1;
+static u8_t pipe_partial[4];
+static size_t pipe_partial_len;
+
+static LOG_CATEGORY *log_vis;
+
+
+static inline u32_t _le32(const u8_t *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((u32_t) p[3] << 24);
+}
+
+static inline u16_t _le16(const u8_t *p) {
+	return p[0] | (p[1] << 8);
+}
+
+
+static bool _wav_open(const char *path) {
+	struct stat st;
+	u8_t *p, *end;
+	u16_t format = 0, bits = 0;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		LOG_ERROR(log_vis, "Can't open %s: %s", path, strerror(errno));
+		return false;
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_size < 44) {
+		close(fd);
+		return false;
+	}
+
+	wav_map_len = st.st_size;
+	wav_map = mmap(NULL, wav_map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (wav_map == MAP_FAILED) {
+		wav_map = NULL;
+		return false;
+	}
+
+	if (memcmp(wav_map, "RIFF", 4) != 0 || memcmp(wav_map + 8, "WAVE", 4) != 0) {
+		LOG_ERROR(log_vis, "%s is not a wav file", path);
+		goto err;
+	}
+
+	p = wav_map + 12;
+	end = wav_map + wav_map_len;
+
+	while (p + 8 <= end) {
+		u32_t len = _le32(p + 4);
+
+		if (memcmp(p, "fmt ", 4) == 0 && len >= 16 && p + 8 + 16 <= end) {
+			format = _le16(p + 8);
+			wav_channels = _le16(p + 10);
+			source_vis.rate = _le32(p + 12);
+			bits = _le16(p + 22);
+		}
+		else if (memcmp(p, "data", 4) == 0) {
+			if (p + 8 + len > end) {
+				len = end - (p + 8);
+			}
+			wav_data = (s16_t *) (p + 8);
+			wav_frames = len / (2 * MAX(wav_channels, 1));
+			break;
+		}
+
+		p += 8 + len + (len & 1);
+	}
+
+	if (format != 1 || bits != 16 || wav_channels < 1 || wav_channels > 2 || !wav_data || !wav_frames) {
+		LOG_ERROR(log_vis, "%s must be 16 bit PCM mono or stereo", path);
+		goto err;
+	}
+
+	return true;
+
+ err:
+	munmap(wav_map, wav_map_len);
+	wav_map = NULL;
+	wav_data = NULL;
+	return false;
+}
+
+
+static bool _pipe_open(const char *path) {
+	pipe_fd = open(path, O_RDONLY | O_NONBLOCK);
+	if (pipe_fd < 0) {
+		LOG_ERROR(log_vis, "Can't open %s: %s", path, strerror(errno));
+		return false;
+	}
+
+	source_vis.rate = DEFAULT_RATE;
+	return true;
+}
+
+
+static void _generate(s16_t *ptr, u32_t frames) {
+	u32_t i;
+	int ch;
+
+	for (i = 0; i < frames; i++, source_pos++) {
+		for (ch = 0; ch < 2; ch++) {
+			double phase = fmod(source_pos * source_freq[ch] / source_vis.rate, 1.0);
+
+			switch (source_type) {
+			case SOURCE_SINE:
+				*ptr++ = (s16_t) (32767.0 * sin(2 * M_PI * phase));
+				break;
+
+			case SOURCE_SQUARE:
+				*ptr++ = (phase < 0.5) ? 32767 : -32767;
+				break;
+
+			default:
+				source_seed = source_seed * 1103515245 + 12345;
+				*ptr++ = (s16_t) (source_seed >> 16);
+				break;
+			}
+		}
+	}
+}
+
+
+// Copy frames of the looped wav file from pos as interleaved stereo
+static void _copy_wav(s16_t *ptr, u32_t pos, u32_t frames) {
+	while (frames) {
+		u32_t n;
+
+		pos %= wav_frames;
+		n = MIN(frames, wav_frames - pos);
+
+		if (wav_channels == 2) {
+			memcpy(ptr, wav_data + pos * 2, n * 2 * sizeof(s16_t));
+			ptr += n * 2;
+		}
+		else {
+			u32_t i;
+
+			for (i = 0; i < n; i++) {
+				*ptr++ = wav_data[pos + i];
+				*ptr++ = wav_data[pos + i];
+			}
+		}
+
+		pos += n;
+		frames -= n;
+	}
+}
+
+
+// Append generated frames of stereo samples to the ring, in at most two
+// segments
+static void _fill(struct vis_t *vis, u32_t frames) {
+	frames = MIN(frames, vis->buf_size / 2);
+
+	while (frames) {
+		u32_t n = MIN(frames, (vis->buf_size - vis->buf_index) / 2);
+
+		_generate(vis->buffer + vis->buf_index, n);
+
+		vis->buf_index = (vis->buf_index + n * 2) % vis->buf_size;
+		frames -= n;
+	}
+}
+
+
+static void _read_pipe(struct vis_t *vis) {
+	for (;;) {
+		u8_t *dst = (u8_t *) (vis->buffer + vis->buf_index);
+		size_t space = (vis->buf_size - vis->buf_index) * sizeof(s16_t);
+		ssize_t r;
+
+		// complete a stereo frame split over the previous read
+		if (pipe_partial_len) {
+			r = read(pipe_fd, pipe_partial + pipe_partial_len, 4 - pipe_partial_len);
+			if (r <= 0) {
+				return;
+			}
+			pipe_partial_len += r;
+			if (pipe_partial_len < 4) {
+				return;
+			}
+			memcpy(dst, pipe_partial, 4);
+			pipe_partial_len = 0;
+			vis->buf_index = (vis->buf_index + 2) % vis->buf_size;
+			continue;
+		}
+
+		r = read(pipe_fd, dst, space);
+		if (r <= 0) {
+			return;
+		}
+
+		vis->buf_index = (vis->buf_index + (r / 4) * 2) % vis->buf_size;
+
+		pipe_partial_len = r % 4;
+		memcpy(pipe_partial, dst + r - pipe_partial_len, pipe_partial_len);
+	}
+}
+
+
+// Matches the source name at the start of spec, up to the ':' or the end
+static bool _is_source(const char *spec, const char *name) {
+	size_t len = strlen(name);
+
+	return strncmp(spec, name, len) == 0 && (spec[len] == '\0' || spec[len] == ':');
+}
+
+
+// Parses <freq>[,<freq>] for the generators, defaulting to 1kHz
+static bool _parse_freq(const char *arg) {
+	char *end;
+
+	source_freq[0] = source_freq[1] = 1000.0;
+	if (!*arg) {
+		return true;
+	}
+
+	source_freq[0] = source_freq[1] = strtod(arg, &end);
+	if (end != arg && *end == ',') {
+		arg = end + 1;
+		source_freq[1] = strtod(arg, &end);
+	}
+
+	if (end == arg || *end != '\0' || source_freq[0] <= 0 || source_freq[1] <= 0) {
+		return false;
+	}
+	return true;
+}
+
+
+struct vis_t *vis_source_open(const char *spec) {
+	const char *arg;
+
+	log_vis = LOG_CATEGORY_GET("jivelite.vis");
+
+	memset(&source_vis, 0, sizeof(source_vis));
+	pthread_rwlock_init(&source_vis.rwlock, NULL);
+
+	source_vis.buf_size = VIS_BUF_SIZE;
+	source_vis.rate = DEFAULT_RATE;
+	source_pos = 0;
+	source_seed = 1;
+	source_frame = jive_frame;
+
+	arg = strchr(spec, ':');
+	arg = arg ? arg + 1 : "";
+
+	if (_is_source(spec, "sine") || _is_source(spec, "square")) {
+		source_type = _is_source(spec, "sine") ? SOURCE_SINE : SOURCE_SQUARE;
+		if (!_parse_freq(arg)) {
+			LOG_ERROR(log_vis, "Bad frequency in visualizer source %s", spec);
+			return NULL;
+		}
+	}
+	else if (_is_source(spec, "noise") && !*arg) {
+		source_type = SOURCE_NOISE;
+	}
+	else if (_is_source(spec, "wav") && *arg) {
+		source_type = SOURCE_WAV;
+		if (!_wav_open(arg)) {
+			return NULL;
+		}
+	}
+	else if (_is_source(spec, "pipe") && *arg) {
+		source_type = SOURCE_PIPE;
+		if (!_pipe_open(arg)) {
+			return NULL;
+		}
+	}
+	else {
+		LOG_ERROR(log_vis, "Unknown visualizer source %s", spec);
+		return NULL;
+	}
+
+	LOG_INFO(log_vis, "Visualizer source %s at %dHz", spec, source_vis.rate);
+
+	source_frame_samples = source_vis.rate / JIVE_FRAME_RATE;
+
+	// start with a full buffer so the first frame has data to show
+	if (source_type == SOURCE_WAV) {
+		source_pos = (source_vis.buf_size / 2) % wav_frames;
+	}
+	else if (source_type != SOURCE_PIPE) {
+		_fill(&source_vis, source_vis.buf_size / 2);
+	}
+
+	source_vis.running = true;
+	return &source_vis;
+}
+
+
+void vis_source_update(struct vis_t *vis) {
+	pthread_rwlock_wrlock(&vis->rwlock);
+
+	if (source_type == SOURCE_PIPE) {
+		_read_pipe(vis);
+	}
+	else if (source_frame != jive_frame) {
+		u32_t frames = (jive_frame - source_frame) * source_frame_samples;
+
+		source_frame = jive_frame;
+
+		// wav samples are read in place by vis_source_samples
+		if (source_type == SOURCE_WAV) {
+			source_pos = (source_pos + frames) % wav_frames;
+		}
+		else {
+			_fill(vis, frames);
+		}
+	}
+
+	vis->updated = time(NULL);
+
+	pthread_rwlock_unlock(&vis->rwlock);
+}
+
+
+// Returns the most recent len interleaved samples of a wav source. Stereo
+// files are read in place from the mapping, mono files and windows that
+// wrap around the end of the loop are copied to buf. Returns NULL for the
+// other sources, which are read from the ring.
+s16_t *vis_source_samples(s16_t *buf, u32_t len) {
+	u32_t frames = len / 2;
+	u32_t pos;
+
+	if (source_type != SOURCE_WAV) {
+		return NULL;
+	}
+
+	pos = (source_pos + wav_frames - frames % wav_frames) % wav_frames;
+
+	if (wav_channels == 2 && pos + frames <= wav_frames) {
+		return wav_data + pos * 2;
+	}
+
+	_copy_wav(buf, pos, frames);
+	return buf;
+}
@@ -125,6 +125,29 @@ float avg_power[2 * MAX_SUBBANDS];
 
 kiss_fft_cfg cfg = NULL;
 
+// Pre-rendered sprite strips used to draw each channel in a single call.
+// The bar strip is the full height bar, a bar is drawn by blitting the
+// bottom part of it.
+static struct spectrum_sprites {
+	JiveSurface *bar_strip;
+	JiveSurface *cap_strip;
+
+	int x, y;
+	int bars_in_bin;
+	int bar_width;
+	int bar_space;
+	int bin_space;
+	int bar_height;
+	int cap_height;
+	int cap_space;
+
+	int cap[MAX_SUBBANDS];
+} sprites[2];
+
+// Bins for the current frame, shared by both channels
+static int frame_bins[2][MAX_SUBBANDS];
+static Uint32 frame_bins_frame;
+
 // Parameters on the lua stack for the spectrum analyzer:
 //   2 - Channels: stereo == 0, mono == 1
 // Left channel parameters:
@@ -165,10 +188,15 @@ int visualizer_spectrum_init( lua_State *L) {
 //		printf( "* clip_subbands[1]: %d\n", clip_subbands[1]);
 	}
 
+	// A widget laid out with no size gives a zero width, keep at
+	// least one subband so the sizes below stay valid.
+	bar_size[0] = MAX(bar_size[0], 1);
+	bar_size[1] = MAX(bar_size[1], 1);
+
 	// Approximate the number of subbands we'll display based
 	// on the width available and the size of the histogram
 	// bars.
-	num_subbands = channel_width[0] / bar_size[0];
+	num_subbands = MAX(channel_width[0] / bar_size[0], 1);
 
 //	printf( "bar_size[0] %d num_subbands %d\n", bar_size[0], num_subbands);
 
@@ -335,30 +363,22 @@ int visualizer_spectrum_init( lua_State *L) {
 }
 
 
-int visualizer_spectrum( lua_State *L) {
-	int sample_bin_ch0[MAX_SUBBANDS];
-	int sample_bin_ch1[MAX_SUBBANDS];
+// Compute the histogram bins for the current frame. Returns false, with
+// all bins set to zero, if audio isn't running.
+bool vis_spectrum_bins( int *sample_bin_ch0, int *sample_bin_ch1) {
+	struct vis_snapshot *snap;
 
 	int i;
 	int w;
 	int ch;
 
-	vis_check();
+	snap = vis_get_snapshot( sample_window * 2 * num_windows);
 
 	// Shortcut if audio isn't running
-	if( !vis_get_playing()) {
-		lua_newtable( L);
-		for( i = 0; i < num_bars[0]; i++) {
-			lua_pushinteger( L, 0);
-			lua_rawseti( L, -2, i + 1);
-		}
-
-		lua_newtable( L);
-		for( i = 0; i < num_bars[1]; i++) {
-			lua_pushinteger( L, 0);
-			lua_rawseti( L, -2, i + 1);
-		}
-		return 2;
+	if( !snap->playing || snap->len < (u32_t) (sample_window * 2 * num_windows)) {
+		memset( sample_bin_ch0, 0, sizeof(int) * MAX_SUBBANDS);
+		memset( sample_bin_ch1, 0, sizeof(int) * MAX_SUBBANDS);
+		return false;
 	}
 
 	// Init avg_power
@@ -373,12 +393,9 @@ int visualizer_spectrum( lua_State *L) {
 		int avg_ptr;
 		int s;
 
-		int16_t *ptr;
-		size_t samples_until_wrap;
+		s16_t *ptr;
 
 		int sample;
-
-		int offs;
 #if 0
 // Test case
 		{
@@ -392,13 +409,7 @@ int visualizer_spectrum( lua_State *L) {
 			}
 		}
 #else
-		vis_lock();
-
-		offs = vis_get_buffer_idx() - (sample_window * 2) - (sample_window * 2 * w);
-		while (offs < 0) offs += vis_get_buffer_len();
-
-		ptr = vis_get_buffer() + offs;
-		samples_until_wrap = vis_get_buffer_len() - offs;
+		ptr = snap->buffer + snap->len - (sample_window * 2) - (sample_window * 2 * w);
 
 		for( i = 0; i < sample_window; i++) {
 			sample = (*ptr++) >> 7;
@@ -406,15 +417,7 @@ int visualizer_spectrum( lua_State *L) {
 
 			sample = (*ptr++) >> 7;
 			fin_buf[i].i = (float) (filter_window[i] * sample);
-
-			samples_until_wrap -=2;
-			if( samples_until_wrap <= 0) {
-				ptr = vis_get_buffer();
-				samples_until_wrap = vis_get_buffer_len();
-			}
 		}
-
-		vis_unlock();
 #endif
 
 		kiss_fft( cfg, fin_buf, fout_buf);
@@ -529,6 +532,23 @@ int visualizer_spectrum( lua_State *L) {
 		}
 	}
 
+	return true;
+}
+
+
+int vis_spectrum_num_bars( int ch) {
+	return num_bars[ch];
+}
+
+
+int visualizer_spectrum( lua_State *L) {
+	int sample_bin_ch0[MAX_SUBBANDS];
+	int sample_bin_ch1[MAX_SUBBANDS];
+
+	int i;
+
+	vis_spectrum_bins( sample_bin_ch0, sample_bin_ch1);
+
 
 	lua_newtable( L);
 	for( i = 0; i < num_bars[0]; i++) {
@@ -552,3 +572,114 @@ int visualizer_spectrum( lua_State *L) {
 
 	return 2;
 }
+
+
+// Parameters on the lua stack for the spectrum sprites:
+//   2 - Channel: 1 or 2
+//   3 - Bar strip surface, full bar height
+//   4 - Cap strip surface, or nil for no caps
+//   5, 6 - x, y of the bottom left of the channel
+//   7 - Bars in bin
+//   8 - Bar width in pixels
+//   9 - Space between bars in pixels
+//  10 - Space between bins in pixels
+//  11 - Height in pixels of the largest bin value
+//  12 - Cap height in pixels
+//  13 - Space between bar and cap in pixels
+
+int visualizer_spectrum_sprites( lua_State *L) {
+	int ch = luaL_checkinteger( L, 2) - 1;
+	struct spectrum_sprites *sp;
+
+	luaL_argcheck( L, ch == 0 || ch == 1, 2, "invalid channel");
+	sp = &sprites[ch];
+
+	if( sp->bar_strip) {
+		jive_surface_free( sp->bar_strip);
+		sp->bar_strip = NULL;
+	}
+	if( sp->cap_strip) {
+		jive_surface_free( sp->cap_strip);
+		sp->cap_strip = NULL;
+	}
+
+	// the strips are optional, nil for a bar or cap too small to draw
+	if( !lua_isnoneornil( L, 3)) {
+		sp->bar_strip = jive_surface_ref( *(JiveSurface **)luaL_checkudata( L, 3, "JiveSurface"));
+	}
+	if( !lua_isnoneornil( L, 4)) {
+		sp->cap_strip = jive_surface_ref( *(JiveSurface **)luaL_checkudata( L, 4, "JiveSurface"));
+	}
+
+	sp->x = luaL_checkinteger( L, 5);
+	sp->y = luaL_checkinteger( L, 6);
+	sp->bars_in_bin = MAX( luaL_optinteger( L, 7, 1), 1);
+	sp->bar_width = MAX( luaL_optinteger( L, 8, 1), 1);
+	sp->bar_space = luaL_optinteger( L, 9, 0);
+	sp->bin_space = luaL_optinteger( L, 10, 0);
+	sp->bar_height = MAX( luaL_optinteger( L, 11, VIS_MAX_BIN_VALUE), 0);
+	sp->cap_height = luaL_optinteger( L, 12, 0);
+	sp->cap_space = luaL_optinteger( L, 13, 0);
+
+	memset( sp->cap, 0, sizeof( sp->cap));
+
+	return 0;
+}
+
+
+// Draw a whole channel of the spectrum with clipped blits from the sprite
+// strips. The bins are computed once per frame for both channels.
+
+int visualizer_spectrum_draw( lua_State *L) {
+	int ch = luaL_checkinteger( L, 2) - 1;
+	JiveSurface *dst = *(JiveSurface **)luaL_checkudata( L, 3, "JiveSurface");
+	struct spectrum_sprites *sp;
+	int *bins;
+	int i, k, x;
+
+	luaL_argcheck( L, ch == 0 || ch == 1, 2, "invalid channel");
+	sp = &sprites[ch];
+
+	if( !dst || !sp->bar_strip) {
+		return 0;
+	}
+
+	if( frame_bins_frame != jive_frame) {
+		frame_bins_frame = jive_frame;
+		vis_spectrum_bins( frame_bins[0], frame_bins[1]);
+	}
+	bins = frame_bins[ch];
+
+	x = sp->x;
+	for( i = 0; i < num_bars[ch]; i++) {
+		int val = ( channel_flipped[ch] == 0) ? bins[i] : bins[num_bars[ch] - 1 - i];
+		int h = ( val * sp->bar_height) / VIS_MAX_BIN_VALUE;
+
+		if( h >= sp->cap[i]) {
+			sp->cap[i] = h;
+		} else if( sp->cap[i] > 0) {
+			sp->cap[i] -= MAX( sp->bar_height / VIS_MAX_BIN_VALUE, 1);
+			if( sp->cap[i] < 0) {
+				sp->cap[i] = 0;
+			}
+		}
+
+		for( k = 0; k < sp->bars_in_bin; k++) {
+			int bx = x + k * ( sp->bar_width + sp->bar_space);
+
+			if( h > 0) {
+				jive_surface_blit_clip( sp->bar_strip, 0, sp->bar_height - h, sp->bar_width, h,
+					dst, bx, sp->y - h + 1);
+			}
+
+			if( sp->cap_strip && sp->cap_height > 0) {
+				jive_surface_blit_clip( sp->cap_strip, 0, 0, sp->bar_width, sp->cap_height,
+					dst, bx, sp->y - sp->cap[i] - sp->cap_space - sp->cap_height + 1);
+			}
+		}
+
+		x += sp->bar_width * sp->bars_in_bin + sp->bar_space * ( sp->bars_in_bin - 1) + sp->bin_space;
+	}
+
+	return 0;
+}
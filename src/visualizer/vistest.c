@@ -0,0 +1,186 @@
+/*
+** Copyright 2010 Logitech. All Rights Reserved.
+**
+** This file is licensed under BSD. Please see the LICENSE file for details.
+*/
+
+/*
+ * Regression test for the vu meter engine, driven by the synthetic sample
+ * sources in source.c:
+ *
+ *   vistest <source> <rms dBFS> <peak dBFS>
+ *   vistest bench <source>
+ *
+ * The source is played for a few seconds of simulated frames and the meter
+ * must settle within a tolerance of the expected levels on both channels.
+ * A second meter with different ballistics runs alongside the first, and a
+ * third is created part way through, to check meters do not share state.
+ *
+ * The bench mode times the per frame snapshot and meter update over a
+ * full size sample window.
+ */
+
+#include "../common.h"
+#include "../jive.h"
+
+#include "visualizer.h"
+
+#define TEST_FRAMES 90
+#define TEST_FRAME_MS 33
+#define TEST_WINDOW 1024
+#define TOLERANCE_DB 0.2
+#define BENCH_FRAMES 10000
+
+Uint32 jive_frame = 0;
+
+static int failures = 0;
+
+
+int jive_frame_rate(void) {
+	return JIVE_FRAME_RATE_DEFAULT;
+}
+
+
+char *platform_get_mac_address() {
+	return NULL;
+}
+
+
+/* no logconf.lua */
+int jive_find_file(const char *path, char *fullpath) {
+	return 0;
+}
+
+
+/* the spectrum and waterfall are linked in for their lua bindings, but
+ * nothing is drawn */
+JiveSurface *jive_surface_ref(JiveSurface *srf) {
+	return srf;
+}
+
+
+void jive_surface_free(JiveSurface *srf) {
+}
+
+
+SDL_Surface *jive_surface_get_sdl(JiveSurface *srf) {
+	return NULL;
+}
+
+
+void jive_surface_blit_clip(JiveSurface *src, Uint16 sx, Uint16 sy, Uint16 sw, Uint16 sh,
+			    JiveSurface* dst, Uint16 dx, Uint16 dy) {
+}
+
+
+static void check(const char *what, double value, double expected) {
+	bool ok = fabs(value - expected) <= TOLERANCE_DB;
+
+	printf("%s %s: %.2f dB, expected %.2f dB\n", ok ? "ok" : "FAIL", what, value, expected);
+	if (!ok) {
+		failures++;
+	}
+}
+
+
+static int bench(const char *source) {
+	struct vis_meter meter;
+	struct timespec start, end;
+	double us;
+	int i;
+
+	setenv("JIVE_VIS_SOURCE", source, 1);
+
+	vis_meter_init(&meter, 24, -40, -6, 20, 300, 1000);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < BENCH_FRAMES; i++) {
+		jive_frame++;
+		vis_get_snapshot(VIS_BUF_SIZE);
+		vis_meter_update(&meter, VIS_BUF_SIZE / 2, jive_frame * TEST_FRAME_MS);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (!vis_get_playing()) {
+		printf("FAIL source %s did not open\n", source);
+		return 1;
+	}
+
+	us = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+	printf("%s: %.1f us per frame\n", source, us / BENCH_FRAMES);
+
+	return 0;
+}
+
+
+int main(int argc, char **argv) {
+	struct vis_meter fast, slow, late, saved;
+	double rms, peak;
+	Uint32 now = 1;
+	int i, ch;
+
+	if (argc == 3 && strcmp(argv[1], "bench") == 0) {
+		return bench(argv[2]);
+	}
+
+	if (argc != 4) {
+		fprintf(stderr, "usage: %s <source> <rms dBFS> <peak dBFS>\n", argv[0]);
+		fprintf(stderr, "       %s bench <source>\n", argv[0]);
+		return 2;
+	}
+
+	rms = atof(argv[2]);
+	peak = atof(argv[3]);
+
+	setenv("JIVE_VIS_SOURCE", argv[1], 1);
+
+	vis_meter_init(&fast, 24, -40, -6, 20, 300, 1000);
+	vis_meter_init(&slow, 24, -40, -6, 150, 300, 0);
+
+	for (i = 0; i < TEST_FRAMES; i++) {
+		jive_frame++;
+		now += TEST_FRAME_MS;
+
+		if (i == TEST_FRAMES / 2) {
+			saved = fast;
+			vis_meter_init(&late, 24, -40, -6, 20, 300, 1000);
+
+			if (memcmp(&saved, &fast, sizeof(fast)) != 0) {
+				printf("FAIL creating a meter changed another meter\n");
+				failures++;
+			}
+		}
+
+		vis_meter_update(&fast, TEST_WINDOW, now);
+		vis_meter_update(&slow, TEST_WINDOW, now);
+		if (i >= TEST_FRAMES / 2) {
+			vis_meter_update(&late, TEST_WINDOW, now);
+		}
+
+		// a second update in the same frame must not apply the ballistics twice
+		saved = slow;
+		vis_meter_update(&slow, TEST_WINDOW, now + TEST_FRAME_MS);
+
+		if (memcmp(&saved, &slow, sizeof(slow)) != 0) {
+			printf("FAIL meter updated twice in frame %d\n", jive_frame);
+			failures++;
+		}
+	}
+
+	if (!vis_get_playing()) {
+		printf("FAIL source %s did not open\n", argv[1]);
+		return 1;
+	}
+
+	for (ch = 0; ch < 2; ch++) {
+		check(ch ? "right rms" : "left rms", fast.ch[ch].rms_db, rms);
+		check(ch ? "right peak" : "left peak", fast.ch[ch].peak_db, peak);
+		check(ch ? "right hold" : "left hold", fast.ch[ch].hold_db, rms);
+		check(ch ? "right slow rms" : "left slow rms", slow.ch[ch].rms_db, rms);
+		check(ch ? "right late rms" : "left late rms", late.ch[ch].rms_db, rms);
+	}
+
+	return failures ? 1 : 0;
+}
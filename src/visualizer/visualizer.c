@@ -6,22 +6,20 @@
 #include <stdio.h>
 #include <sys/mman.h>
 
-#define VIS_BUF_SIZE 16384
-
-static struct vis_t {
-	pthread_rwlock_t rwlock;
-	u32_t buf_size;
-	u32_t buf_index;
-	bool running;
-	u32_t rate;
-	time_t updated;
-	s16_t buffer[VIS_BUF_SIZE];
-} * vis_mmap = NULL;
+#include "visualizer.h"
+
+static struct vis_t *vis_mmap = NULL;
 
 static bool running = false; // cached version of running so now playing status can be read without lock
 static int vis_fd = -1;
 static char *mac_address = NULL;
 
+// alternate sample source selected with JIVE_VIS_SOURCE, for headless testing
+static bool vis_source = false;
+
+static struct vis_snapshot snapshot;
+static u32_t snapshot_samples = 0; // largest window requested so far
+
 static void _reopen(void) {
 	char shm_path[40];
 
@@ -56,7 +54,26 @@ static void _reopen(void) {
 // this allows squeezelite to be restarted and to map a different block of memory
 void vis_check(void) {
 	static time_t lastopen = 0;
-	time_t now = time(NULL);
+	static bool source_checked = false;
+	time_t now;
+
+	if (!source_checked) {
+		const char *spec = getenv("JIVE_VIS_SOURCE");
+
+		source_checked = true;
+		if (spec && *spec) {
+			vis_mmap = vis_source_open(spec);
+			vis_source = (vis_mmap != NULL);
+		}
+	}
+
+	if (vis_source) {
+		vis_source_update(vis_mmap);
+		running = vis_mmap->running;
+		return;
+	}
+
+	now = time(NULL);
 
 	if (!vis_mmap) {
 		if (now - lastopen > 5) {
@@ -114,14 +131,97 @@ u32_t vis_get_buffer_idx(void) {
 	return vis_mmap->buf_index;
 }
 
+// copy the most recent samples from the ring buffer at most once per frame.
+// the tail is copied in at most two contiguous segments so the visualizers
+// can read the snapshot without any wrap checks. wav sources are read in
+// place when the samples are contiguous in the file.
+struct vis_snapshot *vis_get_snapshot(u32_t samples) {
+	u32_t buf_len, idx, start, first;
+
+	if (samples > VIS_BUF_SIZE) {
+		samples = VIS_BUF_SIZE;
+	}
+
+	if (snapshot.frame == jive_frame && snapshot_samples >= samples) {
+		return &snapshot;
+	}
+
+	if (samples > snapshot_samples) {
+		snapshot_samples = samples;
+	}
+
+	snapshot.frame = jive_frame;
+	snapshot.len = 0;
+	snapshot.buffer = snapshot.data;
+
+	vis_check();
+
+	snapshot.playing = vis_get_playing();
+	if (!snapshot.playing) {
+		return &snapshot;
+	}
+
+	vis_lock();
+
+	snapshot.rate = vis_mmap->rate;
+
+	buf_len = vis_mmap->buf_size;
+	if (buf_len > VIS_BUF_SIZE) {
+		buf_len = VIS_BUF_SIZE;
+	}
+	if (buf_len == 0) {
+		vis_unlock();
+		return &snapshot;
+	}
+	idx = vis_mmap->buf_index % buf_len;
+
+	snapshot.len = MIN(snapshot_samples, buf_len);
+
+	if (vis_source) {
+		s16_t *samples = vis_source_samples(snapshot.data, snapshot.len);
+
+		if (samples) {
+			snapshot.buffer = samples;
+			vis_unlock();
+			return &snapshot;
+		}
+	}
+
+	start = (idx + buf_len - snapshot.len) % buf_len;
+	first = MIN(snapshot.len, buf_len - start);
+
+	memcpy(snapshot.buffer, vis_mmap->buffer + start, first * sizeof(s16_t));
+	if (first < snapshot.len) {
+		memcpy(snapshot.buffer + first, vis_mmap->buffer, (snapshot.len - first) * sizeof(s16_t));
+	}
+
+	vis_unlock();
+
+	return &snapshot;
+}
+
 extern int visualizer_spectrum_init(lua_State *L);
 extern int visualizer_spectrum(lua_State *L);
+extern int visualizer_spectrum_sprites(lua_State *L);
+extern int visualizer_spectrum_draw(lua_State *L);
 extern int visualizer_vumeter(lua_State *L);
+extern int visualizer_vumeter_init(lua_State *L);
+extern int visualizer_vumeter_bars(lua_State *L);
+extern int visualizer_vumeter_db(lua_State *L);
+extern int visualizer_waterfall_init(lua_State *L);
+extern int visualizer_waterfall(lua_State *L);
 
 static const struct luaL_Reg visualizer_f[] = {
 	{ "vumeter", visualizer_vumeter },
+	{ "vumeter_init", visualizer_vumeter_init },
+	{ "vumeter_bars", visualizer_vumeter_bars },
+	{ "vumeter_db", visualizer_vumeter_db },
 	{ "spectrum", visualizer_spectrum },
 	{ "spectrum_init", visualizer_spectrum_init },
+	{ "spectrum_sprites", visualizer_spectrum_sprites },
+	{ "spectrum_draw", visualizer_spectrum_draw },
+	{ "waterfall", visualizer_waterfall },
+	{ "waterfall_init", visualizer_waterfall_init },
 	{ NULL, NULL }
 };
 
@@ -1,3 +1,50 @@
+#define VIS_BUF_SIZE 16384
+
+/* maximum number of spectrum bins per channel, and the maximum bin value */
+#define VIS_MAX_BINS 512
+#define VIS_MAX_BIN_VALUE 31
+
+/* sample buffer shared with squeezelite */
+struct vis_t {
+	pthread_rwlock_t rwlock;
+	u32_t buf_size;
+	u32_t buf_index;
+	bool running;
+	u32_t rate;
+	time_t updated;
+	s16_t buffer[VIS_BUF_SIZE];
+};
+
+/* per frame copy of the most recent samples, shared by all visualizers */
+struct vis_snapshot {
+	Uint32 frame;		/* jive_frame the snapshot was taken in */
+	bool playing;
+	u32_t rate;
+	u32_t len;		/* interleaved stereo samples, oldest first */
+	s16_t *buffer;		/* data, or the source samples read in place */
+	s16_t data[VIS_BUF_SIZE];
+};
+
+/* vu meter ballistics, one per meter widget */
+struct vis_meter {
+	int bars;		/* levels map to 0..bars */
+	float floor_db;		/* levels in dBFS of the lowest and highest bar */
+	float ceil_db;
+	float attack_ms;	/* ballistic time constants */
+	float release_ms;
+	Uint32 hold_ms;
+
+	struct vis_meter_channel {
+		float rms_db;	/* rms level after ballistics */
+		float peak_db;	/* sample peak of the last window */
+		float hold_db;	/* peak hold of the rms level */
+		Uint32 hold_until;
+	} ch[2];
+
+	Uint32 frame;		/* jive_frame of the last update */
+	Uint32 last;		/* jiffies of the last update */
+};
+
 extern void vis_check(void);
 extern void vis_lock(void);
 extern void vis_unlock(void);
@@ -8,3 +55,15 @@ extern u32_t vis_get_rate(void);
 extern s16_t *vis_get_buffer(void);
 extern u32_t vis_get_buffer_len(void);
 extern u32_t vis_get_buffer_idx(void);
+
+extern struct vis_snapshot *vis_get_snapshot(u32_t samples);
+
+extern bool vis_spectrum_bins(int *sample_bin_ch0, int *sample_bin_ch1);
+extern int vis_spectrum_num_bars(int ch);
+
+extern void vis_meter_init(struct vis_meter *meter, int bars, float floor_db, float ceil_db, float attack_ms, float release_ms, Uint32 hold_ms);
+extern void vis_meter_update(struct vis_meter *meter, size_t num_samples, Uint32 now);
+
+extern struct vis_t *vis_source_open(const char *spec);
+extern void vis_source_update(struct vis_t *vis);
+extern s16_t *vis_source_samples(s16_t *buf, u32_t len);
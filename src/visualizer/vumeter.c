@@ -11,31 +11,37 @@
 
 #define VUMETER_DEFAULT_SAMPLE_WINDOW 1024 * 2
 
+// Full scale of a 16 bit sample, squared for the rms computation
+#define FULL_SCALE 32768.0
+#define FULL_SCALE_SQ (FULL_SCALE * FULL_SCALE)
+
+// Ballistics are clamped to this interval so a long pause between frames
+// does not make the meter jump
+#define MAX_FRAME_INTERVAL 1000
+
+#define METER_MT "jive.vis.meter"
+
 int visualizer_vumeter(lua_State *L) {
 	long long sample_accumulator[2];
-	int16_t *ptr;
+	struct vis_snapshot *snap;
+	s16_t *ptr;
 	s16_t sample;
 	s32_t sample_sq;
-	size_t i, num_samples, samples_until_wrap;
-
-	int offs;
+	size_t i, num_samples;
 
 	num_samples = luaL_optinteger(L, 2, VUMETER_DEFAULT_SAMPLE_WINDOW);
+	if (num_samples > VIS_BUF_SIZE / 2) {
+		num_samples = VIS_BUF_SIZE / 2;
+	}
 
 	sample_accumulator[0] = 0;
 	sample_accumulator[1] = 0;
 
-	vis_check();
+	snap = vis_get_snapshot(num_samples * 2);
 
-	if (vis_get_playing()) {
+	if (snap->playing && snap->len >= num_samples * 2) {
 
-		vis_lock();
-
-		offs = vis_get_buffer_idx() - (num_samples * 2);
-		while (offs < 0) offs += vis_get_buffer_len();
-
-		ptr = vis_get_buffer() + offs;
-		samples_until_wrap = vis_get_buffer_len() - offs;
+		ptr = snap->buffer + snap->len - (num_samples * 2);
 
 		for (i=0; i<num_samples; i++) {
 			sample = (*ptr++) >> 8;
@@ -45,19 +51,13 @@ int visualizer_vumeter(lua_State *L) {
 			sample = (*ptr++) >> 8;
 			sample_sq = sample * sample;
 			sample_accumulator[1] += sample_sq;
-
-			samples_until_wrap -= 2;
-			if (samples_until_wrap <= 0) {
-				ptr = vis_get_buffer();
-				samples_until_wrap = vis_get_buffer_len();
-			}
 		}
-
-		vis_unlock();
 	}
 
-	sample_accumulator[0] /= num_samples;
-	sample_accumulator[1] /= num_samples;
+	if (num_samples) {
+		sample_accumulator[0] /= num_samples;
+		sample_accumulator[1] /= num_samples;
+	}
 
 	lua_newtable(L);
 	lua_pushinteger(L, sample_accumulator[0]);
@@ -67,3 +67,211 @@ int visualizer_vumeter(lua_State *L) {
 
 	return 1;
 }
+
+
+// Sum of squares and absolute peak of interleaved stereo samples. The loop
+// is unrolled over four frames with independent accumulators so the compiler
+// can vectorize it.
+static void meter_sum_squares(s16_t *ptr, size_t num_samples, s64_t sum[2], s32_t peak[2]) {
+	s64_t l0 = 0, l1 = 0, r0 = 0, r1 = 0;
+	s32_t lp = 0, rp = 0;
+	size_t i;
+
+	for (i = 0; i + 4 <= num_samples; i += 4, ptr += 8) {
+		s32_t a = ptr[0], b = ptr[1], c = ptr[2], d = ptr[3];
+		s32_t e = ptr[4], f = ptr[5], g = ptr[6], h = ptr[7];
+
+		l0 += a * a;
+		r0 += b * b;
+		l1 += c * c;
+		r1 += d * d;
+		l0 += e * e;
+		r0 += f * f;
+		l1 += g * g;
+		r1 += h * h;
+
+		lp = MAX(lp, MAX(MAX(abs(a), abs(c)), MAX(abs(e), abs(g))));
+		rp = MAX(rp, MAX(MAX(abs(b), abs(d)), MAX(abs(f), abs(h))));
+	}
+
+	for (; i < num_samples; i++, ptr += 2) {
+		s32_t a = ptr[0], b = ptr[1];
+
+		l0 += a * a;
+		r0 += b * b;
+
+		lp = MAX(lp, abs(a));
+		rp = MAX(rp, abs(b));
+	}
+
+	sum[0] = l0 + l1;
+	sum[1] = r0 + r1;
+	peak[0] = lp;
+	peak[1] = rp;
+}
+
+
+static float meter_coef(float interval, float time_ms) {
+	if (time_ms <= 0) {
+		return 1.0;
+	}
+	return 1.0 - exp(-interval / time_ms);
+}
+
+
+static int meter_db_to_bar(struct vis_meter *meter, float db) {
+	int bar = (int) ((db - meter->floor_db) * meter->bars / (meter->ceil_db - meter->floor_db));
+
+	if (bar < 0) return 0;
+	if (bar > meter->bars) return meter->bars;
+	return bar;
+}
+
+
+void vis_meter_init(struct vis_meter *meter, int bars, float floor_db, float ceil_db, float attack_ms, float release_ms, Uint32 hold_ms) {
+	int ch;
+
+	memset(meter, 0, sizeof(*meter));
+
+	meter->bars = MAX(bars, 1);
+	meter->floor_db = floor_db;
+	meter->ceil_db = MAX(ceil_db, floor_db + 1.0);
+	meter->attack_ms = attack_ms;
+	meter->release_ms = release_ms;
+	meter->hold_ms = hold_ms;
+
+	for (ch = 0; ch < 2; ch++) {
+		meter->ch[ch].rms_db = floor_db;
+		meter->ch[ch].peak_db = floor_db;
+		meter->ch[ch].hold_db = floor_db;
+	}
+}
+
+
+// Update the meter ballistics from the current frame snapshot. Levels are
+// only recomputed once per frame, whichever Lua function asks first.
+void vis_meter_update(struct vis_meter *meter, size_t num_samples, Uint32 now) {
+	struct vis_snapshot *snap;
+	s64_t sum[2] = { 0, 0 };
+	s32_t peak[2] = { 0, 0 };
+	Uint32 interval;
+	int ch;
+
+	if (num_samples > VIS_BUF_SIZE / 2) {
+		num_samples = VIS_BUF_SIZE / 2;
+	}
+
+	snap = vis_get_snapshot(num_samples * 2);
+
+	if (meter->last && snap->frame == meter->frame) {
+		return;
+	}
+	meter->frame = snap->frame;
+
+	interval = meter->last ? MIN(now - meter->last, MAX_FRAME_INTERVAL) : MAX_FRAME_INTERVAL;
+	meter->last = now;
+
+	if (snap->playing && num_samples && snap->len >= num_samples * 2) {
+		meter_sum_squares(snap->buffer + snap->len - (num_samples * 2), num_samples, sum, peak);
+	}
+
+	for (ch = 0; ch < 2; ch++) {
+		struct vis_meter_channel *m = &meter->ch[ch];
+		float rms_db, coef;
+
+		if (sum[ch] > 0) {
+			rms_db = 10.0 * log10((double) sum[ch] / num_samples / FULL_SCALE_SQ);
+		} else {
+			rms_db = meter->floor_db;
+		}
+		rms_db = MAX(rms_db, meter->floor_db);
+
+		if (peak[ch] > 0) {
+			m->peak_db = MAX(20.0 * log10(peak[ch] / FULL_SCALE), meter->floor_db);
+		} else {
+			m->peak_db = meter->floor_db;
+		}
+
+		coef = meter_coef(interval, (rms_db > m->rms_db) ? meter->attack_ms : meter->release_ms);
+		m->rms_db += (rms_db - m->rms_db) * coef;
+
+		if (m->rms_db >= m->hold_db) {
+			m->hold_db = m->rms_db;
+			m->hold_until = now + meter->hold_ms;
+		} else if ((Sint32) (now - m->hold_until) >= 0) {
+			m->hold_db += (m->rms_db - m->hold_db) * meter_coef(interval, meter->release_ms);
+		}
+	}
+}
+
+
+// Parameters on the lua stack for the meter engine:
+//   2 - Number of bars
+//   3 - Level in dBFS of the lowest bar
+//   4 - Level in dBFS of the highest bar
+//   5 - Attack time in ms
+//   6 - Release time in ms
+//   7 - Peak hold time in ms
+//
+// Returns a meter holding the ballistics state, so each widget keeps its
+// own levels. Pass it to vumeter_bars and vumeter_db.
+
+int visualizer_vumeter_init(lua_State *L) {
+	struct vis_meter *meter;
+
+	meter = lua_newuserdata(L, sizeof(struct vis_meter));
+	vis_meter_init(meter,
+		       luaL_optinteger(L, 2, 24),
+		       luaL_optnumber(L, 3, -40.0),
+		       luaL_optnumber(L, 4, -6.0),
+		       luaL_optnumber(L, 5, 20.0),
+		       luaL_optnumber(L, 6, 300.0),
+		       luaL_optinteger(L, 7, 1000));
+
+	luaL_newmetatable(L, METER_MT);
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
+
+// Parameters on the lua stack:
+//   2 - Meter from vumeter_init
+//   3 - Sample window, optional
+//
+// Returns the bar and peak hold cap indices for the left and right channels:
+//   bar1, cap1, bar2, cap2
+
+int visualizer_vumeter_bars(lua_State *L) {
+	struct vis_meter *meter = luaL_checkudata(L, 2, METER_MT);
+
+	vis_meter_update(meter, luaL_optinteger(L, 3, VUMETER_DEFAULT_SAMPLE_WINDOW), jive_jiffies());
+
+	lua_pushinteger(L, meter_db_to_bar(meter, meter->ch[0].rms_db));
+	lua_pushinteger(L, meter_db_to_bar(meter, meter->ch[0].hold_db));
+	lua_pushinteger(L, meter_db_to_bar(meter, meter->ch[1].rms_db));
+	lua_pushinteger(L, meter_db_to_bar(meter, meter->ch[1].hold_db));
+
+	return 4;
+}
+
+
+// Parameters on the lua stack:
+//   2 - Meter from vumeter_init
+//   3 - Sample window, optional
+//
+// Returns the rms and peak levels in dBFS for the left and right channels:
+//   rms1, peak1, rms2, peak2
+
+int visualizer_vumeter_db(lua_State *L) {
+	struct vis_meter *meter = luaL_checkudata(L, 2, METER_MT);
+
+	vis_meter_update(meter, luaL_optinteger(L, 3, VUMETER_DEFAULT_SAMPLE_WINDOW), jive_jiffies());
+
+	lua_pushnumber(L, meter->ch[0].rms_db);
+	lua_pushnumber(L, meter->ch[0].peak_db);
+	lua_pushnumber(L, meter->ch[1].rms_db);
+	lua_pushnumber(L, meter->ch[1].peak_db);
+
+	return 4;
+}
@@ -0,0 +1,204 @@
+/*
+** Copyright 2010 Logitech. All Rights Reserved.
+**
+** This file is licensed under BSD. Please see the LICENSE file for details.
+*/
+
+#include "../common.h"
+#include "../jive.h"
+
+#include "visualizer.h"
+
+/////////////////////////////////////////////////////////
+//
+// Package constants
+//
+/////////////////////////////////////////////////////////
+
+#define NUM_COLORS (VIS_MAX_BIN_VALUE + 1)
+
+#define MAX_ROWS 1024
+
+// Colormaps are defined by control points at bin values, the lookup table
+// is interpolated between them.
+struct colormap_point {
+	int val;
+	Uint8 r, g, b;
+};
+
+static struct colormap_point colormap_heat[] = {
+	{ 0, 0x00, 0x00, 0x00 },
+	{ 8, 0x30, 0x00, 0x60 },
+	{ 16, 0xc0, 0x00, 0x40 },
+	{ 24, 0xff, 0x80, 0x00 },
+	{ 31, 0xff, 0xff, 0xc0 },
+	{ -1, 0, 0, 0 }
+};
+
+static struct colormap_point colormap_ice[] = {
+	{ 0, 0x00, 0x00, 0x00 },
+	{ 12, 0x00, 0x20, 0x80 },
+	{ 24, 0x00, 0xa0, 0xff },
+	{ 31, 0xff, 0xff, 0xff },
+	{ -1, 0, 0, 0 }
+};
+
+static struct colormap_point colormap_gray[] = {
+	{ 0, 0x00, 0x00, 0x00 },
+	{ 31, 0xff, 0xff, 0xff },
+	{ -1, 0, 0, 0 }
+};
+
+static struct {
+	const char *name;
+	struct colormap_point *points;
+} colormaps[] = {
+	{ "heat", colormap_heat },
+	{ "ice", colormap_ice },
+	{ "gray", colormap_gray },
+	{ NULL, NULL }
+};
+
+/////////////////////////////////////////////////////////
+//
+// Package state variables
+//
+/////////////////////////////////////////////////////////
+
+// Ring buffered history surface, one column is written per frame
+static JiveSurface *history = NULL;
+
+// Next column to write, this is also the oldest column on screen
+static int column;
+
+// Colormap lookup table, in the pixel format of the history surface
+static Uint32 color_lut[NUM_COLORS];
+
+// Lookup table from surface row to spectrum bin, low frequencies at the bottom
+static int row_bin[MAX_ROWS];
+
+static Uint32 last_frame;
+
+
+static void _build_lut(SDL_PixelFormat *format, struct colormap_point *points) {
+	int i, v;
+
+	for (i = 0; points[i + 1].val >= 0; i++) {
+		struct colormap_point *a = &points[i];
+		struct colormap_point *b = &points[i + 1];
+		int span = b->val - a->val;
+
+		for (v = a->val; v <= b->val; v++) {
+			int t = v - a->val;
+
+			color_lut[v] = SDL_MapRGB(format,
+				a->r + ((b->r - a->r) * t) / span,
+				a->g + ((b->g - a->g) * t) / span,
+				a->b + ((b->b - a->b) * t) / span);
+		}
+	}
+}
+
+
+static inline void _put_pixel(SDL_Surface *s, int x, int y, Uint32 color) {
+	Uint8 *p = (Uint8 *)s->pixels + y * s->pitch + x * s->format->BytesPerPixel;
+
+	switch (s->format->BytesPerPixel) {
+	case 1:
+		*p = color;
+		break;
+
+	case 2:
+		*(Uint16 *)p = color;
+		break;
+
+	case 3:
+		p[0] = color & 0xff;
+		p[1] = (color >> 8) & 0xff;
+		p[2] = (color >> 16) & 0xff;
+		break;
+
+	case 4:
+		*(Uint32 *)p = color;
+		break;
+	}
+}
+
+
+// Parameters on the lua stack for the waterfall:
+//   2 - History surface, its height should match the spectrum_init width
+//   3 - Colormap name: heat, ice or gray
+
+int visualizer_waterfall_init(lua_State *L) {
+	JiveSurface *srf = *(JiveSurface **)luaL_checkudata(L, 2, "JiveSurface");
+	const char *name = luaL_optstring(L, 3, "heat");
+	SDL_Surface *sdl;
+	int i, bins;
+
+	if (history) {
+		jive_surface_free(history);
+		history = NULL;
+	}
+
+	sdl = srf ? jive_surface_get_sdl(srf) : NULL;
+	if (!sdl) {
+		return 0;
+	}
+
+	history = jive_surface_ref(srf);
+	column = 0;
+
+	for (i = 0; colormaps[i].name; i++) {
+		if (strcmp(colormaps[i].name, name) == 0) {
+			break;
+		}
+	}
+	_build_lut(sdl->format, colormaps[i].name ? colormaps[i].points : colormap_heat);
+
+	bins = vis_spectrum_num_bars(0);
+	for (i = 0; i < sdl->h && i < MAX_ROWS; i++) {
+		row_bin[i] = ((sdl->h - 1 - i) * bins) / sdl->h;
+	}
+
+	SDL_FillRect(sdl, NULL, color_lut[0]);
+
+	return 0;
+}
+
+
+// Appends one spectrum column per frame to the history surface. Returns
+// the oldest column, the history is drawn with two blits starting from it.
+
+int visualizer_waterfall(lua_State *L) {
+	int sample_bin_ch0[VIS_MAX_BINS];
+	int sample_bin_ch1[VIS_MAX_BINS];
+	SDL_Surface *sdl;
+	int y, h;
+
+	sdl = history ? jive_surface_get_sdl(history) : NULL;
+	if (!sdl) {
+		lua_pushinteger(L, 0);
+		return 1;
+	}
+
+	if (last_frame != jive_frame) {
+		last_frame = jive_frame;
+
+		vis_spectrum_bins(sample_bin_ch0, sample_bin_ch1);
+
+		h = MIN(sdl->h, MAX_ROWS);
+
+		SDL_LockSurface(sdl);
+		for (y = 0; y < h; y++) {
+			_put_pixel(sdl, column, y, color_lut[sample_bin_ch0[row_bin[y]]]);
+		}
+		SDL_UnlockSurface(sdl);
+
+		if (++column >= sdl->w) {
+			column = 0;
+		}
+	}
+
+	lua_pushinteger(L, column);
+	return 1;
+}